@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Mempool.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Simple.h>
+#include <afina/allocator/SlabCache.h>
+
+/**
+ * Allocator::Simple under two workloads:
+ * - churn: fixed number of live values of random size, each operation frees a random one and
+ *   allocates a new one. Compared against malloc/free
+ * - cache: values are added until arena is full, then the oldest ones are evicted to make room,
+ *   either right away or after defrag didn't help. Reports how much of the arena holds live values
+ *   at the moment allocation fails, that is fragmentation storage would see
+ * - mempool: every thread replaces random objects of its own Mempool of 64 byte objects, all pools
+ *   share an arena. Compared against malloc/free from the same number of threads
+ *
+ * Usage: runAllocatorBench [operations] [arena MiB]
+ */
+
+using namespace Afina;
+
+using clock_type = std::chrono::steady_clock;
+
+// Cache workload defrags arena only if live values take less than that part of it
+static constexpr double kDefragThreshold = 0.85;
+
+// Value sizes skewed towards small ones, as keys and values of a cache usually are
+static std::size_t random_size(unsigned &seed) {
+    seed = seed * 1103515245 + 12345;
+    unsigned r = seed >> 8;
+    return 16 + (r % 64) * (1 + (r >> 12) % 32);
+}
+
+static double elapsed_ns(clock_type::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start).count();
+}
+
+static void churn(std::size_t operations, std::size_t arena_size) {
+    const std::size_t live = 10000;
+    std::vector<char> arena(arena_size);
+    Allocator::Simple allocator(arena.data(), arena.size());
+
+    unsigned seed = 1;
+    std::vector<Allocator::Pointer> pointers(live);
+    std::vector<void *> raw(live);
+    for (std::size_t i = 0; i < live; i++) {
+        pointers[i] = allocator.alloc(random_size(seed));
+        raw[i] = std::malloc(random_size(seed));
+    }
+
+    seed = 2;
+    auto start = clock_type::now();
+    for (std::size_t i = 0; i < operations; i++) {
+        seed = seed * 1103515245 + 12345;
+        Allocator::Pointer &p = pointers[(seed >> 4) % live];
+        allocator.free(p);
+        p = allocator.alloc(random_size(seed));
+    }
+    double simple = elapsed_ns(start) / operations;
+
+    seed = 2;
+    start = clock_type::now();
+    for (std::size_t i = 0; i < operations; i++) {
+        seed = seed * 1103515245 + 12345;
+        void *&p = raw[(seed >> 4) % live];
+        std::free(p);
+        p = std::malloc(random_size(seed));
+    }
+    double libc = elapsed_ns(start) / operations;
+
+    for (void *p : raw) {
+        std::free(p);
+    }
+    std::fprintf(stderr, "churn: %zu live values  simple=%-8.1f malloc=%-8.1f (ns/free+alloc)\n", live, simple, libc);
+}
+
+static void cache(std::size_t operations, std::size_t arena_size, bool use_defrag) {
+    std::vector<char> arena(arena_size);
+    Allocator::Simple allocator(arena.data(), arena.size());
+
+    struct Value {
+        Allocator::Pointer p;
+        std::size_t size;
+    };
+    std::deque<Value> values;
+    std::size_t live_bytes = 0;
+
+    unsigned seed = 3;
+    std::size_t failures = 0, evictions = 0, defrags = 0;
+    double utilization = 0, defrag_ns = 0;
+    auto start = clock_type::now();
+    for (std::size_t i = 0; i < operations; i++) {
+        std::size_t size = random_size(seed);
+        bool failed = false, defragged = false;
+        while (true) {
+            try {
+                values.push_back(Value{allocator.alloc(size), size});
+                std::memset(values.back().p.get(), 0, size);
+                live_bytes += size;
+                break;
+            } catch (Allocator::AllocError &) {
+            }
+
+            if (!failed) {
+                failed = true;
+                failures++;
+                utilization += double(live_bytes) / arena_size;
+            }
+
+            // Compaction is worth it only if there is enough free space in total to gain from
+            if (use_defrag && !defragged && live_bytes < arena_size * kDefragThreshold) {
+                auto defrag_start = clock_type::now();
+                allocator.defrag();
+                defrag_ns += elapsed_ns(defrag_start);
+                defrags++;
+                defragged = true;
+                continue;
+            }
+
+            // Evict the oldest one
+            live_bytes -= values.front().size;
+            allocator.free(values.front().p);
+            values.pop_front();
+            evictions++;
+        }
+    }
+    double total = elapsed_ns(start);
+
+    std::fprintf(stderr,
+                 "cache: defrag=%-3s %-8.1f ns/set  evictions=%-8zu defrags=%-6zu defrag avg=%-8.1f us  "
+                 "arena used on failure=%.1f%%\n",
+                 use_defrag ? "yes" : "no", total / operations, evictions, defrags,
+                 defrags > 0 ? defrag_ns / defrags / 1000 : 0.0, failures > 0 ? 100 * utilization / failures : 0.0);
+}
+
+// Runs body on given number of threads, returns ns per operation of the slowest one
+template <typename F> static double on_threads(int threads, std::size_t operations, F body) {
+    std::vector<double> results(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&results, &body, operations, t]() {
+            auto start = clock_type::now();
+            body(t);
+            results[t] = elapsed_ns(start) / operations;
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+    return *std::max_element(results.begin(), results.end());
+}
+
+static void mempool(std::size_t operations, std::size_t arena_size) {
+    const std::size_t live = 10000, size = 64;
+    Allocator::Arena arena(arena_size);
+
+    for (int threads : {1, 2, 4, 8}) {
+        double pool = on_threads(threads, operations, [&arena, operations](int t) {
+            Allocator::SlabCache cache(arena);
+            Allocator::Mempool pool(cache, size);
+            std::vector<void *> objects(live);
+            for (void *&p : objects) {
+                p = pool.alloc();
+            }
+
+            unsigned seed = t + 1;
+            for (std::size_t i = 0; i < operations; i++) {
+                seed = seed * 1103515245 + 12345;
+                void *&p = objects[(seed >> 4) % live];
+                pool.free(p);
+                p = pool.alloc();
+            }
+            for (void *p : objects) {
+                pool.free(p);
+            }
+        });
+
+        double libc = on_threads(threads, operations, [operations](int t) {
+            std::vector<void *> objects(live);
+            for (void *&p : objects) {
+                p = std::malloc(size);
+            }
+
+            unsigned seed = t + 1;
+            for (std::size_t i = 0; i < operations; i++) {
+                seed = seed * 1103515245 + 12345;
+                void *&p = objects[(seed >> 4) % live];
+                std::free(p);
+                p = std::malloc(size);
+            }
+            for (void *p : objects) {
+                std::free(p);
+            }
+        });
+
+        std::fprintf(stderr, "mempool: %d threads  mempool=%-8.1f malloc=%-8.1f (ns/free+alloc)\n", threads, pool,
+                     libc);
+    }
+}
+
+int main(int argc, char **argv) {
+    std::size_t operations = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::size_t arena_size = (argc > 2 ? std::stoul(argv[2]) : 64) * 1024 * 1024;
+
+    churn(operations, arena_size);
+    cache(operations, arena_size / 8, false);
+    cache(operations, arena_size / 8, true);
+    mempool(operations, arena_size);
+    return 0;
+}
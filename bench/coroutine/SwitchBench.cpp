@@ -0,0 +1,152 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <setjmp.h>
+#include <string>
+#include <vector>
+
+#include <afina/coroutine/Engine.h>
+
+/**
+ * Latency of switch between two coroutines that ping-pong at the given stack depth: Engine that switches
+ * registers against a minimal engine that copies stack in and out on each switch with setjmp/longjmp.
+ *
+ * Usage: runCoroutineBench [switches]
+ */
+
+using namespace Afina;
+
+// Puts about depth kilobytes on stack before calling f
+template <typename F> __attribute__((noinline)) void on_depth(int depth, F &f) {
+    volatile char buffer[1024];
+    buffer[0] = 0;
+    if (depth > 0) {
+        on_depth(depth - 1, f);
+    } else {
+        f();
+    }
+    buffer[1] = buffer[0];
+}
+
+namespace StackCopy {
+
+// Coroutines share region of the thread stack below this address, inactive ones keep copy of it
+static char *bottom;
+
+struct Routine {
+    jmp_buf env;
+    char *low = nullptr;
+    std::vector<char> copy;
+};
+
+static Routine routines[2];
+static jmp_buf finish;
+static std::size_t remaining;
+static int depth;
+
+__attribute__((noinline)) static void Store(Routine &routine) {
+    char here;
+    routine.low = &here;
+    routine.copy.assign(routine.low, bottom);
+}
+
+__attribute__((noinline)) static void Restore(Routine &routine) {
+    // Frame of restore must not be overwritten by the copy, go deeper if it could
+    volatile char here;
+    if (const_cast<char *>(&here) >= routine.low - 1024) {
+        volatile char pad[1024];
+        pad[0] = 0;
+        Restore(routine);
+    }
+    std::memcpy(routine.low, routine.copy.data(), routine.copy.size());
+    longjmp(routine.env, 1);
+}
+
+static void Switch(Routine &from, Routine &to) {
+    if (setjmp(from.env) == 0) {
+        Store(from);
+        Restore(to);
+    }
+}
+
+static void Body(int self) {
+    auto loop = [self] {
+        while (remaining > 0) {
+            remaining--;
+            Switch(routines[self], routines[1 - self]);
+        }
+        longjmp(finish, 1);
+    };
+    on_depth(depth, loop);
+}
+
+__attribute__((noinline)) static void Run() {
+    if (setjmp(finish) != 0) {
+        return;
+    }
+
+    // The second routine starts right here once first one switches to it
+    if (setjmp(routines[1].env) != 0) {
+        Body(1);
+    }
+    Store(routines[1]);
+    Body(0);
+}
+
+static void Bench(std::size_t switches, int depth_kb) {
+    char marker;
+    bottom = &marker;
+    remaining = switches;
+    depth = depth_kb;
+    Run();
+}
+
+} // namespace StackCopy
+
+namespace Registers {
+
+static void Ping(Coroutine::Engine &engine, void *&other, int depth, std::size_t &remaining) {
+    auto loop = [&] {
+        while (remaining > 0) {
+            remaining--;
+            engine.sched(other);
+        }
+    };
+    on_depth(depth, loop);
+}
+
+static void Main(Coroutine::Engine &engine, int depth, std::size_t &remaining) {
+    static void *a, *b;
+    a = engine.run(Ping, engine, b, static_cast<int>(depth), remaining);
+    b = engine.run(Ping, engine, a, static_cast<int>(depth), remaining);
+    engine.sched(a);
+}
+
+static void Bench(std::size_t switches, int depth_kb) {
+    Coroutine::Engine engine;
+    engine.start(Main, engine, static_cast<int>(depth_kb), switches);
+}
+
+} // namespace Registers
+
+template <typename F> static double measure(F bench, std::size_t switches, int depth_kb) {
+    // Warm up stacks and caches
+    bench(switches / 10, depth_kb);
+
+    auto start = std::chrono::steady_clock::now();
+    bench(switches, depth_kb);
+    auto total = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return double(total.count()) / switches;
+}
+
+int main(int argc, char **argv) {
+    std::size_t switches = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    for (int depth_kb : {0, 1, 4, 16, 64}) {
+        double registers = measure(Registers::Bench, switches, depth_kb);
+        double stack_copy = measure(StackCopy::Bench, switches, depth_kb);
+        std::fprintf(stderr, "depth=%-3d KiB  registers=%-8.1f stack copy=%-8.1f (ns/switch)\n", depth_kb, registers,
+                     stack_copy);
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/Executor.h>
+
+/**
+ * Throughput of Executor::Execute with many producers outside of the pool. Each task carries a capture
+ * of 64 bytes, benchmark counts heap allocations made while tasks are submitted.
+ *
+ * Usage: runExecutorBench [tasks] [pool threads]
+ */
+
+using namespace Afina;
+
+static std::atomic<uint64_t> allocations(0);
+
+void *operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = std::malloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+struct Payload {
+    uint64_t words[7];
+};
+
+static void run(std::size_t producers, std::size_t tasks, std::size_t threads) {
+    Executor executor("bench", threads, threads, 1 << 16, 1000);
+    std::atomic<uint64_t> sum(0);
+    std::atomic<uint64_t> refused(0);
+    std::atomic<bool> go(false);
+
+    std::vector<std::thread> workers;
+    for (std::size_t p = 0; p < producers; p++) {
+        workers.emplace_back([&, p] {
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+
+            Payload payload = {{p, 1, 2, 3, 4, 5, 6}};
+            auto task = [&sum, payload] { sum.fetch_add(payload.words[1], std::memory_order_relaxed); };
+            for (std::size_t i = p; i < tasks; i += producers) {
+                while (!executor.Execute(task)) {
+                    refused.fetch_add(1, std::memory_order_relaxed);
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    uint64_t allocations_before = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto &t : workers) {
+        t.join();
+    }
+    auto submitted = std::chrono::steady_clock::now();
+    uint64_t submit_allocations = allocations.load() - allocations_before;
+    while (sum.load() < tasks) {
+        std::this_thread::yield();
+    }
+    auto done = std::chrono::steady_clock::now();
+    executor.Stop(true);
+
+    auto usec = [&start](std::chrono::steady_clock::time_point t) {
+        return std::max<double>(1, std::chrono::duration_cast<std::chrono::microseconds>(t - start).count());
+    };
+    std::fprintf(stderr, "producers=%-3zu submit=%-6.1f ns/task executed=%-10.0f tasks/s refused=%-8lu mallocs=%lu\n",
+                 producers, usec(submitted) * 1e3 / tasks, tasks * 1e6 / usec(done),
+                 static_cast<unsigned long>(refused.load()), static_cast<unsigned long>(submit_allocations));
+}
+
+int main(int argc, char **argv) {
+    std::size_t tasks = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::size_t threads = argc > 2 ? std::stoul(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+
+    for (std::size_t producers = 1; producers <= 64; producers *= 2) {
+        run(producers, tasks, threads);
+    }
+    return 0;
+}
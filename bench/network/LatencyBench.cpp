@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <afina/network/Config.h>
+
+#include "logging/ServiceImpl.h"
+#include "network/mt_nonblocking/ServerImpl.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+/**
+ * Round trip latency of small gets over loopback TCP and unix socket of the same server.
+ *
+ * Usage: runNetworkBench [requests] [port]
+ */
+
+using namespace Afina;
+
+static int connect_tcp(uint16_t port) {
+    int sfd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (sfd == -1 || connect(sfd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        throw std::runtime_error("Failed to connect over TCP: " + std::string(strerror(errno)));
+    }
+
+    int opts = 1;
+    setsockopt(sfd, IPPROTO_TCP, TCP_NODELAY, &opts, sizeof(opts));
+    return sfd;
+}
+
+static int connect_unix(const std::string &path) {
+    int sfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (sfd == -1 || connect(sfd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        throw std::runtime_error("Failed to connect over unix socket: " + std::string(strerror(errno)));
+    }
+    return sfd;
+}
+
+// Sends request and reads until response ends with given marker
+static void roundtrip(int sfd, const std::string &request, const std::string &marker) {
+    if (send(sfd, request.data(), request.size(), 0) != static_cast<ssize_t>(request.size())) {
+        throw std::runtime_error("Failed to send request");
+    }
+
+    char buffer[4096];
+    std::size_t got = 0;
+    while (got < marker.size() || std::memcmp(buffer + got - marker.size(), marker.data(), marker.size()) != 0) {
+        ssize_t n = recv(sfd, buffer + got, sizeof(buffer) - got, 0);
+        if (n <= 0) {
+            throw std::runtime_error("Connection closed by server");
+        }
+        got += n;
+    }
+}
+
+static void run(const std::string &title, int sfd, std::size_t requests) {
+    roundtrip(sfd, "set bench 0 0 10\r\n0123456789\r\n", "\r\n");
+
+    // Warm up caches and branch predictors
+    for (std::size_t i = 0; i < requests / 10; i++) {
+        roundtrip(sfd, "get bench\r\n", "END\r\n");
+    }
+
+    std::vector<uint64_t> latency(requests);
+    auto total_start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < requests; i++) {
+        auto start = std::chrono::steady_clock::now();
+        roundtrip(sfd, "get bench\r\n", "END\r\n");
+        latency[i] =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    auto total = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - total_start);
+    std::sort(latency.begin(), latency.end());
+
+    auto pct = [&latency](double p) { return latency[std::min(latency.size() - 1, std::size_t(latency.size() * p))]; };
+    std::fprintf(stderr, "%-5s rps=%-8.0f min=%-6.1f p50=%-6.1f p90=%-6.1f p99=%-6.1f p99.9=%-6.1f max=%.1f (usec)\n",
+                 title.c_str(), requests * 1e6 / total.count(), latency.front() / 1e3, pct(0.5) / 1e3, pct(0.9) / 1e3,
+                 pct(0.99) / 1e3, pct(0.999) / 1e3, latency.back() / 1e3);
+}
+
+int main(int argc, char **argv) {
+    std::size_t requests = argc > 1 ? std::stoul(argv[1]) : 100000;
+    uint16_t port = argc > 2 ? std::stoul(argv[2]) : 18080;
+
+    // Commands trace themselves to stdout, keep that out of the way
+    if (std::freopen("/dev/null", "w", stdout) == nullptr) {
+        std::perror("freopen");
+        return 1;
+    }
+
+    auto log_config = std::make_shared<Logging::Config>();
+    Logging::Appender &console = log_config->appenders["console"];
+    console.type = Logging::Appender::Type::STDERR;
+    console.color = false;
+
+    Logging::Logger &logger = log_config->loggers["root"];
+    logger.level = Logging::Logger::Level::ERROR;
+    logger.appenders.push_back("console");
+    logger.format = "[%H:%M:%S %z] [thread %t] [%n] [%l] %v";
+
+    auto logging = std::make_shared<Logging::ServiceImpl>(log_config);
+    auto storage = std::make_shared<Backend::ThreadSafeSimplLRU>();
+
+    Network::Config config;
+    config.unix_socket = "/tmp/afina-bench-" + std::to_string(getpid()) + ".sock";
+    config.tcp_nodelay = true;
+    auto server = std::make_shared<Network::MTnonblock::ServerImpl>(storage, logging, config);
+
+    logging->Start();
+    storage->Start();
+    server->Start(port, 1, 1);
+
+    try {
+        int tcp = connect_tcp(port);
+        run("tcp", tcp, requests);
+        close(tcp);
+
+        int uds = connect_unix(config.unix_socket);
+        run("unix", uds, requests);
+        close(uds);
+    } catch (std::runtime_error &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+    }
+
+    server->Stop();
+    server->Join();
+    storage->Stop();
+    logging->Stop();
+    return 0;
+}
@@ -1,24 +1,40 @@
 #ifndef AFINA_THREADPOOL_H
 #define AFINA_THREADPOOL_H
 
-#include <afina/logging/Service.h>
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <thread>
+#include <vector>
+
+#include <afina/Task.h>
 
 namespace Afina {
+template <typename T> class MpmcQueue;
 
 /**
  * # Thread pool
+ * Work stealing pool: each thread has its own deque of tasks, tasks submitted from pool threads go to
+ * the deque of the submitting thread, tasks submitted from outside go to the shared injection queue.
+ * Thread looks for work in its own deque first, then in the injection queue and then steals from deques
+ * of other threads, so in the common case threads don't touch any shared lock at all.
+ *
+ * Memory for tasks is allocated once pool is created: there is a cell for each task pool could have
+ * queued or running at once, free cells and the injection queue are lock-free rings. So submitting a
+ * task never allocates memory unless task itself is too large to be kept inline, see Task.h
+ *
+ * Pool keeps statistics: queue length, threads, rejected tasks and histograms of time tasks have spent
+ * in queue and running. Each thread records its own histograms, they are merged only once statistics
+ * are requested, see PublishMetrics
+ *
+ * Pool keeps at least low_watermark threads and grows up to hight_watermark ones if all threads are busy
+ * once new task arrives. Thread that has got nothing to do for idle_time milliseconds exits unless pool
+ * is at the low watermark already. Idle threads sleep on futex and are woken up one per submitted task
  */
-class Executor;
-void perform(Executor *executor);
 class Executor {
-
 public:
     enum class State {
         // Threadpool is fully operational, tasks could be added and get executed
@@ -34,7 +50,7 @@ public:
 
     Executor(const std::string name, size_t low_watermark, size_t hight_watermark, size_t max_queue_size,
              int idle_time);
-    ~Executor() = default;
+    ~Executor();
 
     /**
      * Signal thread pool to stop, it will stop accepting new jobs and close threads just after each become
@@ -44,6 +60,12 @@ public:
      */
     void Stop(bool await = false);
 
+    /**
+     * Registers pool statistics in Metrics, names start with the given prefix. Statistics are removed
+     * once pool is destroyed
+     */
+    void PublishMetrics(const std::string &prefix);
+
     /**
      * Add function to be executed on the threadpool. Method returns true in case if task has been placed
      * onto execution queue, i.e scheduled for execution and false otherwise.
@@ -52,74 +74,150 @@ public:
      * execution finished by itself
      */
     template <typename F, typename... Types> bool Execute(F &&func, Types... args) {
-        // Prepare "task"
-        auto exec = std::bind(std::forward<F>(func), std::forward<Types>(args)...);
-        {
-            {
-                std::unique_lock<std::mutex> lock(this->_executor_mutex);
-                if (_state != State::kRun || _tasks.size() == _max_queue_size) {
-                    return false;
-                }
-                if (!number_free_thread) {
-                    //                        std::unique_lock<std::mutex> threads_lock(_executor_mutex);
-                    if (_threads.size() < _hight_watermark) {
-                        _threads.emplace_back(std::thread(&perform, this));
-
-                    }
-                }
-                // Enqueue new task
-                _tasks.push(exec);
-            }
+        if (_state.load(std::memory_order_acquire) != State::kRun) {
+            return false;
+        }
+
+        return Submit(Task(std::bind(std::forward<F>(func), std::forward<Types>(args)...)));
+    }
 
+    /**
+     * Same for the task that is built already. Task is left as it was if it hasn't been placed onto the
+     * queue, so that caller could run it by itself
+     */
+    bool Execute(Task &&task) {
+        if (_state.load(std::memory_order_acquire) != State::kRun) {
+            return false;
         }
-        _empty_condition.notify_one();
-        return true;
+        return Submit(std::move(task));
     }
 
 private:
+    // Pool thread state, see Executor.cpp
+    struct Worker;
+
+    // Storage of a task, see Executor.cpp
+    struct Cell;
+
     // No copy/move/assign allowed
-    Executor(const Executor &);            // = delete;
-    Executor(Executor &&);                 // = delete;
-    Executor &operator=(const Executor &); // = delete;
-    Executor &operator=(Executor &&);      // = delete;
+    Executor(const Executor &) = delete;
+    Executor(Executor &&) = delete;
+    Executor &operator=(const Executor &) = delete;
+    Executor &operator=(Executor &&) = delete;
 
     /**
-     * Main function that all pool threads are running. It polls internal task queue and execute tasks
+     * Moves task into a free cell and enqueues it, task isn't touched if it is refused
      */
-    friend void perform(Executor *executor);
+    bool Submit(Task &&task);
 
     /**
-     * Mutex to protect state below from concurrent modification
+     * Main function that all pool threads are running. It polls task queues and execute tasks
      */
-    std::mutex _executor_mutex;
+    void Perform(Worker *worker);
 
     /**
-     * Conditional variable to await new data in case of empty queue
+     * Looks for a task: in own deque, in the injection queue, in deques of other threads
      */
-    std::condition_variable _empty_condition;
-    std::condition_variable _stop_condition;
+    Cell *Find(Worker *worker);
 
     /**
-     * Vector of actual threads that perorm execution
+     * Starts new thread unless pool has reached the high watermark already. _threads_mutex must be held
      */
-    std::vector<std::thread> _threads;
+    bool Spawn();
 
     /**
-     * Task queue
+     * Makes idle thread to exit if pool is above the low watermark or is stopping. Returns false if
+     * thread must go on
      */
-    std::queue<std::function<void()>> _tasks;
+    bool Retire(Worker *worker);
 
     /**
-     * Flag to stop bg threads
+     * Sleeps until woken up or idle time passes, returns true in the later case
      */
-    State _state;
+    bool Sleep(int epoch);
 
+    /**
+     * Wakes up to n sleeping threads
+     */
+    void Wakeup(int n);
+
+    /**
+     * Idle threads accounting: thread announces it is idle and stops being idle, submitter claims idle
+     * thread to run its task. Returns false if there is no idle thread left to claim
+     */
+    void EnterIdle();
+    void LeaveIdle();
+    bool ClaimIdle();
+
+    /**
+     * Slot of the pool current thread belongs to, nullptr outside of any pool
+     */
+    static Worker *&Current();
+
+    const std::string _name;
     const size_t _low_watermark;
     const size_t _hight_watermark;
     const size_t _max_queue_size;
     const int _idle_time;
-    std::atomic_size_t number_free_thread;
-    void del_thread(std::thread::id id);
+
+    std::atomic<State> _state;
+
+    /**
+     * Slot per thread pool could have, slot is reused once its thread exits
+     */
+    std::vector<std::unique_ptr<Worker>> _workers;
+
+    /**
+     * Protects thread start/exit, number of threads is changed under the lock only
+     */
+    std::mutex _threads_mutex;
+    std::condition_variable _stop_condition;
+    std::atomic<std::size_t> _threads;
+
+    /**
+     * Storage of all tasks, cells not used by any task are kept in the free ring
+     */
+    std::unique_ptr<Cell[]> _cells;
+    std::unique_ptr<MpmcQueue<Cell *>> _free;
+
+    /**
+     * Tasks submitted by threads outside of the pool
+     */
+    std::unique_ptr<MpmcQueue<Cell *>> _injection;
+
+    /**
+     * Submit calls that have seen the pool running but haven't enqueued their task yet
+     */
+    std::atomic<std::size_t> _submitting;
+
+    /**
+     * Tasks scheduled but not started yet
+     */
+    std::atomic<std::size_t> _queued;
+
+    /**
+     * Statistics besides ones each thread keeps: maximum number of queued tasks and number of tasks
+     * refused because queue was full
+     */
+    std::atomic<std::size_t> _queued_max;
+    std::atomic<uint64_t> _rejected;
+
+    /**
+     * Names of metrics published, see PublishMetrics
+     */
+    std::vector<std::string> _metrics;
+
+    /**
+     * Threads waiting for tasks, either about to sleep or sleeping already. Lower half is number
+     * of threads nobody has claimed yet, upper half is number of claims not seen by threads yet, so
+     * that each idle thread is counted by submitters only once
+     */
+    std::atomic<uint64_t> _idle;
+
+    /**
+     * Futex idle threads sleep on, changed each time they should wake up
+     */
+    std::atomic<int> _epoch;
 };
 
 } // namespace Afina
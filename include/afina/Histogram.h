@@ -0,0 +1,143 @@
+#ifndef AFINA_HISTOGRAM_H
+#define AFINA_HISTOGRAM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+
+/**
+ * # Histogram of latencies
+ * HDR-like histogram with fixed relative precision: each power of two range of values is split into
+ * kSubBuckets linear buckets, so value is reported with error of at most 1/kSubBuckets (~3%) while
+ * the whole range up to 2^kMaxExponent (~18 minutes in nanoseconds) takes a few kilobytes.
+ *
+ * Record is a relaxed increment of one counter and, only for a new maximum, a CAS on it. Histogram could
+ * be shared by threads, but the cheapest way is a histogram per thread merged once somebody asks for
+ * statistics
+ */
+class Histogram {
+public:
+    static constexpr unsigned kSubBucketBits = 5;
+    static constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+    static constexpr unsigned kMaxExponent = 40;
+    static constexpr std::size_t kBuckets = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+    Histogram() { Reset(); }
+
+    Histogram(const Histogram &other) {
+        Reset();
+        Merge(other);
+    }
+
+    Histogram &operator=(const Histogram &other) {
+        if (this != &other) {
+            Reset();
+            Merge(other);
+        }
+        return *this;
+    }
+
+    /**
+     * Adds value, values above the range are counted in the last bucket
+     */
+    void Record(uint64_t value) {
+        _counts[Index(value)].fetch_add(1, std::memory_order_relaxed);
+        RaiseMax(value);
+    }
+
+    /**
+     * Adds all values of the other histogram, might miss values being recorded concurrently
+     */
+    void Merge(const Histogram &other) {
+        for (std::size_t i = 0; i < kBuckets; i++) {
+            uint64_t n = other._counts[i].load(std::memory_order_relaxed);
+            if (n > 0) {
+                _counts[i].fetch_add(n, std::memory_order_relaxed);
+            }
+        }
+        RaiseMax(other._max.load(std::memory_order_relaxed));
+    }
+
+    void Reset() {
+        for (auto &count : _counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        _max.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * Value below which given fraction of values lies, e.g Percentile(0.99). Reports the upper bound
+     * of the bucket, but never more than the maximum value seen
+     */
+    uint64_t Percentile(double fraction) const {
+        uint64_t total = count();
+        if (total == 0) {
+            return 0;
+        }
+
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * total + 0.5));
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBuckets; i++) {
+            seen += _counts[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return std::min(UpperBound(i), max());
+            }
+        }
+        return max();
+    }
+
+    /**
+     * Number of values recorded
+     */
+    uint64_t count() const {
+        uint64_t total = 0;
+        for (auto &count : _counts) {
+            total += count.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    uint64_t max() const { return _max.load(std::memory_order_relaxed); }
+
+private:
+    static std::size_t Index(uint64_t value) {
+        if (value < kSubBuckets) {
+            return value;
+        }
+
+        unsigned exponent = 63 - __builtin_clzll(value);
+        if (exponent > kMaxExponent) {
+            return kBuckets - 1;
+        }
+        uint64_t sub = (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+        return (exponent - kSubBucketBits + 1) * kSubBuckets + sub;
+    }
+
+    // Concurrent recorders don't lose the maximum, the loop runs only while value is above it
+    void RaiseMax(uint64_t value) {
+        uint64_t max = _max.load(std::memory_order_relaxed);
+        while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    static uint64_t UpperBound(std::size_t index) {
+        if (index < kSubBuckets) {
+            return index;
+        }
+
+        unsigned exponent = index / kSubBuckets + kSubBucketBits - 1;
+        uint64_t sub = index % kSubBuckets;
+        uint64_t lower = (uint64_t(1) << exponent) + (sub << (exponent - kSubBucketBits));
+        return lower + (uint64_t(1) << (exponent - kSubBucketBits)) - 1;
+    }
+
+    std::atomic<uint64_t> _counts[kBuckets];
+    std::atomic<uint64_t> _max;
+};
+
+} // namespace Afina
+
+#endif // AFINA_HISTOGRAM_H
@@ -0,0 +1,71 @@
+#ifndef AFINA_METRICS_H
+#define AFINA_METRICS_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+
+/**
+ * # Registry of server counters
+ * Components publish named gauges here while they are running, `stats` command
+ * reports current value of each one. Gauge is evaluated only when somebody asks
+ * for statistics, so it is cheap to keep registered gauge around.
+ *
+ * Registry is process wide and threadsafe
+ */
+class Metrics {
+public:
+    using Gauge = std::function<uint64_t()>;
+
+    static Metrics &Instance() {
+        static Metrics instance;
+        return instance;
+    }
+
+    /**
+     * Register gauge under the given name, replaces previous one if there was any
+     */
+    void Register(const std::string &name, Gauge gauge) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _gauges[name] = std::move(gauge);
+    }
+
+    /**
+     * Removes gauge, must be called before object gauge reads from is destroyed
+     */
+    void Unregister(const std::string &name) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _gauges.erase(name);
+    }
+
+    /**
+     * Evaluates all registered gauges, result is ordered by name
+     */
+    std::vector<std::pair<std::string, uint64_t>> Collect() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<std::pair<std::string, uint64_t>> result;
+        result.reserve(_gauges.size());
+        for (auto &gauge : _gauges) {
+            result.emplace_back(gauge.first, gauge.second());
+        }
+        return result;
+    }
+
+private:
+    Metrics() = default;
+    Metrics(const Metrics &) = delete;
+    Metrics &operator=(const Metrics &) = delete;
+
+    mutable std::mutex _mutex;
+    std::map<std::string, Gauge> _gauges;
+};
+
+} // namespace Afina
+
+#endif // AFINA_METRICS_H
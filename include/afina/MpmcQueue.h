@@ -0,0 +1,122 @@
+#ifndef AFINA_MPMC_QUEUE_H
+#define AFINA_MPMC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace Afina {
+
+/**
+ * # Bounded multiple producers multiple consumers queue
+ * Lock-free ring buffer by Dmitry Vyukov: each cell has a sequence number that tells whether the cell
+ * is ready to be written or read at the given position, producers and consumers claim positions with
+ * a single CAS each. Queue never allocates memory once created.
+ *
+ * Push/Pop could fail while another thread is in the middle of operation on the same cell, i.e queue
+ * could look full or empty for a moment even if it is not
+ */
+template <typename T> class MpmcQueue {
+public:
+    /**
+     * @param capacity maximum number of elements, rounded up to the power of two
+     */
+    explicit MpmcQueue(std::size_t capacity) : _head(0), _tail(0) {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _cells.reset(new Cell[size]);
+        for (std::size_t i = 0; i < size; i++) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        _mask = size - 1;
+    }
+
+    /**
+     * Enqueue element, returns false if queue is full
+     */
+    bool Push(T value) {
+        std::size_t tail = _tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = _cells[tail & _mask];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence - tail);
+            if (diff == 0) {
+                if (_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // Cell still holds element pushed one lap ago
+                return false;
+            } else {
+                tail = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Dequeue element, returns false if queue is empty
+     */
+    bool Pop(T &value) {
+        std::size_t head = _head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = _cells[head & _mask];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence - (head + 1));
+            if (diff == 0) {
+                if (_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.sequence.store(head + _mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // Nothing has been pushed at the position yet
+                return false;
+            } else {
+                head = _head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Number of elements in queue including ones being pushed right now, might be outdated once returned
+     */
+    std::size_t size() const {
+        std::size_t head = _head.load(std::memory_order_acquire);
+        std::size_t tail = _tail.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    /**
+     * Maximum number of elements queue could hold
+     */
+    std::size_t capacity() const { return _mask + 1; }
+
+private:
+    static constexpr std::size_t kCacheLine = 64;
+
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> _cells;
+    std::size_t _mask;
+    char _pad0[kCacheLine - sizeof(std::unique_ptr<Cell[]>) - sizeof(std::size_t)];
+
+    // Next position to read, advanced by consumers
+    std::atomic<std::size_t> _head;
+    char _pad1[kCacheLine - sizeof(std::atomic<std::size_t>)];
+
+    // Next position to write, advanced by producers
+    std::atomic<std::size_t> _tail;
+    char _pad2[kCacheLine - sizeof(std::atomic<std::size_t>)];
+};
+
+} // namespace Afina
+
+#endif // AFINA_MPMC_QUEUE_H
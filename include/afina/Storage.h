@@ -1,6 +1,9 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
 #include <string>
 
 namespace Afina {
@@ -84,6 +87,33 @@ public:
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) = 0;
+
+    using Visitor = std::function<void(const std::string &key, const std::string &value)>;
+
+    /**
+     * Iterates storage in small steps, so that thread safe implementation holds its lock only while
+     * a batch is visited. Iteration starts with empty cursor, each call visits about batch items
+     * following the cursor and moves it forward. Method returns false once there is nothing left.
+     *
+     * Changes are allowed between calls: items present during the whole iteration are visited at
+     * least once, items added, changed or deleted meanwhile may or may not be. Visitor must not
+     * call storage back.
+     *
+     * Storages that can't be iterated throw std::logic_error
+     *
+     * @param cursor opaque position, empty at the beginning
+     * @param batch number of items to visit in one call
+     * @param visit called for each item
+     */
+    virtual bool Scan(std::string &cursor, std::size_t batch, const Visitor &visit) {
+        throw std::logic_error("Storage doesn't support iteration");
+    }
+
+    /**
+     * Makes every change applied so far durable by the storage itself, e.g syncs its files. Returns
+     * false if storage keeps nothing on disk, that is the default
+     */
+    virtual bool Checkpoint() { return false; }
 };
 
 } // namespace Afina
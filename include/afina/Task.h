@@ -0,0 +1,125 @@
+#ifndef AFINA_TASK_H
+#define AFINA_TASK_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Afina {
+
+/**
+ * # Move only callable without arguments
+ * Replacement of std::function<void()> for the thread pool: callable is kept in the inline buffer if it
+ * fits there and could be moved without exceptions, so constructing and moving task never allocates
+ * memory. Larger callables are placed on the heap, that is the only case task calls operator new.
+ *
+ * Buffer is sized so that the whole task takes exactly two cache lines
+ */
+class Task {
+public:
+    static constexpr std::size_t kInlineSize = 128 - sizeof(void *);
+
+    Task() noexcept : _ops(nullptr) {}
+
+    template <typename F,
+              typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, Task>::value>::type>
+    Task(F &&func) : _ops(nullptr) {
+        Assign(std::forward<F>(func));
+    }
+
+    Task(Task &&other) noexcept : _ops(nullptr) { MoveFrom(other); }
+
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    ~Task() { Reset(); }
+
+    /**
+     * Runs callable, task must not be empty
+     */
+    void operator()() { _ops->invoke(_storage); }
+
+    /**
+     * Destroys callable, task becomes empty
+     */
+    void Reset() noexcept {
+        if (_ops != nullptr) {
+            _ops->destroy(_storage);
+            _ops = nullptr;
+        }
+    }
+
+    explicit operator bool() const noexcept { return _ops != nullptr; }
+
+    /**
+     * Whether callable of the given type is kept inline
+     */
+    template <typename F> static constexpr bool IsInline() {
+        return sizeof(F) <= kInlineSize && alignof(F) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible<F>::value;
+    }
+
+private:
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    // Type erased operations, one static table per callable type
+    struct Ops {
+        void (*invoke)(void *storage);
+        void (*move)(void *to, void *from) noexcept;
+        void (*destroy)(void *storage) noexcept;
+    };
+
+    template <typename F> struct InlineOps {
+        static void Invoke(void *storage) { (*static_cast<F *>(storage))(); }
+        static void Move(void *to, void *from) noexcept {
+            new (to) F(std::move(*static_cast<F *>(from)));
+            static_cast<F *>(from)->~F();
+        }
+        static void Destroy(void *storage) noexcept { static_cast<F *>(storage)->~F(); }
+        static const Ops table;
+    };
+
+    template <typename F> struct HeapOps {
+        static void Invoke(void *storage) { (**static_cast<F **>(storage))(); }
+        static void Move(void *to, void *from) noexcept { *static_cast<F **>(to) = *static_cast<F **>(from); }
+        static void Destroy(void *storage) noexcept { delete *static_cast<F **>(storage); }
+        static const Ops table;
+    };
+
+    template <typename F> typename std::enable_if<IsInline<typename std::decay<F>::type>()>::type Assign(F &&func) {
+        using T = typename std::decay<F>::type;
+        new (_storage) T(std::forward<F>(func));
+        _ops = &InlineOps<T>::table;
+    }
+
+    template <typename F> typename std::enable_if<!IsInline<typename std::decay<F>::type>()>::type Assign(F &&func) {
+        using T = typename std::decay<F>::type;
+        *reinterpret_cast<T **>(_storage) = new T(std::forward<F>(func));
+        _ops = &HeapOps<T>::table;
+    }
+
+    void MoveFrom(Task &other) noexcept {
+        if (other._ops != nullptr) {
+            other._ops->move(_storage, other._storage);
+            _ops = other._ops;
+            other._ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char _storage[kInlineSize];
+    const Ops *_ops;
+};
+
+template <typename F> const Task::Ops Task::InlineOps<F>::table = {&Invoke, &Move, &Destroy};
+template <typename F> const Task::Ops Task::HeapOps<F>::table = {&Invoke, &Move, &Destroy};
+
+} // namespace Afina
+
+#endif // AFINA_TASK_H
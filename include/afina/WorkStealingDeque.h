@@ -0,0 +1,128 @@
+#ifndef AFINA_WORK_STEALING_DEQUE_H
+#define AFINA_WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Afina {
+
+/**
+ * # Chase-Lev work stealing deque
+ * Bounded lock-free deque of pointers. Owner thread pushes and takes elements at the bottom end in
+ * LIFO order, any other thread could steal elements from the top end in FIFO order. Owner never
+ * contends with thieves unless there is a single element left.
+ *
+ * Implementation follows "Correct and Efficient Work-Stealing for Weak Memory Models" by Le, Pop,
+ * Cohen and Zappa Nardelli, except that buffer doesn't grow: Push fails once deque is full and
+ * caller has to put element elsewhere.
+ *
+ * Deque doesn't own elements, only one thread at a time could be the owner
+ */
+template <typename T> class WorkStealingDeque {
+public:
+    /**
+     * @param capacity maximum number of elements, rounded up to the power of two
+     */
+    explicit WorkStealingDeque(std::size_t capacity) : _top(0), _bottom(0) {
+        std::size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _buffer.reset(new std::atomic<T *>[size]);
+        _mask = size - 1;
+    }
+
+    /**
+     * Adds element to the bottom end, returns false if deque is full. Owner side
+     */
+    bool Push(T *value) {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_acquire);
+        if (b - t > static_cast<int64_t>(_mask)) {
+            return false;
+        }
+
+        _buffer[b & _mask].store(value, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * Removes element from the bottom end, returns nullptr if deque is empty. Owner side
+     */
+    T *Take() {
+        int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+        _bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = _top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // Empty
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T *value = _buffer[b & _mask].load(std::memory_order_relaxed);
+        if (t == b) {
+            // The last element, race with thieves for it
+            if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                value = nullptr;
+            }
+            _bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    /**
+     * Removes element from the top end, returns nullptr if deque is empty or another thread has won
+     * the race for the element. Could be called by any thread
+     */
+    T *Steal() {
+        int64_t t = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = _bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+
+        T *value = _buffer[t & _mask].load(std::memory_order_relaxed);
+        if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return value;
+    }
+
+    /**
+     * Number of elements in deque, might be outdated once returned
+     */
+    std::size_t size() const {
+        int64_t b = _bottom.load(std::memory_order_relaxed);
+        int64_t t = _top.load(std::memory_order_relaxed);
+        return b > t ? b - t : 0;
+    }
+
+    /**
+     * Maximum number of elements deque could hold
+     */
+    std::size_t capacity() const { return _mask + 1; }
+
+private:
+    static constexpr std::size_t kCacheLine = 64;
+
+    std::unique_ptr<std::atomic<T *>[]> _buffer;
+    std::size_t _mask;
+
+    // Next element to steal, advanced by thieves and by owner taking the last element
+    std::atomic<int64_t> _top;
+    char _pad0[kCacheLine - sizeof(std::atomic<int64_t>)];
+
+    // Next free slot, written by owner only
+    std::atomic<int64_t> _bottom;
+};
+
+} // namespace Afina
+
+#endif // AFINA_WORK_STEALING_DEQUE_H
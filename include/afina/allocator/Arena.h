@@ -0,0 +1,84 @@
+#ifndef AFINA_ALLOCATOR_ARENA_H
+#define AFINA_ALLOCATOR_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Source of slabs shared by all threads
+ * Maps the whole area once and hands it out as slabs of the same size aligned to that size, so that
+ * owner of any address inside of a slab could be found by masking the address. Slabs never handed
+ * out yet are taken by bumping an offset, returned ones are kept in a stack and reused first.
+ *
+ * Both map and unmap are lock-free: the offset is a counter, the stack head is CASed along with a
+ * tag that changes on every pop, so slab taken and returned meanwhile doesn't confuse another thread.
+ * Memory is committed by the kernel only once touched
+ */
+class Arena {
+public:
+    static constexpr std::size_t kDefaultSlabSize = 64 * 1024;
+
+    /**
+     * @param size of the area, rounded down to slabs
+     * @param slab_size power of two, at least page size
+     */
+    explicit Arena(std::size_t size, std::size_t slab_size = kDefaultSlabSize);
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * Takes a slab, returns nullptr once arena is exhausted. Threadsafe
+     */
+    void *map();
+
+    /**
+     * Returns slab taken by map. Threadsafe
+     */
+    void unmap(void *slab);
+
+    std::size_t slab_size() const { return _slab_size; }
+
+    /**
+     * Slab address belongs to
+     */
+    void *slab_of(const void *p) const {
+        return reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(p) & ~(_slab_size - 1));
+    }
+
+    /**
+     * Number of slabs given out and not returned
+     */
+    std::size_t used() const { return _used.load(std::memory_order_relaxed); }
+
+    std::size_t capacity() const { return _slabs; }
+
+private:
+    char *Slab(uint32_t index) const { return _begin + std::size_t(index) * _slab_size; }
+
+    // Mapping itself, it is larger than the slabs by alignment
+    void *_mapping;
+    std::size_t _mapping_size;
+
+    char *_begin;
+    const std::size_t _slab_size;
+    std::size_t _slabs;
+
+    // Slabs below that index have been handed out at least once
+    std::atomic<uint32_t> _bump;
+
+    // Stack of returned slabs: index + 1 in the low half, 0 for empty stack, tag in the high half.
+    // Each slab in the stack keeps index + 1 of the next one in its first word
+    std::atomic<uint64_t> _free;
+
+    std::atomic<std::size_t> _used;
+};
+
+} // namespace Allocator
+} // namespace Afina
+#endif // AFINA_ALLOCATOR_ARENA_H
@@ -0,0 +1,82 @@
+#ifndef AFINA_ALLOCATOR_MAPPING_H
+#define AFINA_ALLOCATOR_MAPPING_H
+
+#include <cstddef>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Anonymous memory mapping
+ * Area for allocators that manage fixed amount of memory. By default kernel commits pages once they
+ * are touched, so the first access to each page faults. Flags allow to pay that upfront and to back
+ * area by huge pages, so that large area doesn't thrash TLB.
+ *
+ * Area could be backed by a memory file instead of anonymous memory, then other process that gets the
+ * file descriptor maps the same memory, see kShared.
+ *
+ * Unmapped on destruction
+ */
+class Mapping {
+public:
+    // Commit all pages right away
+    static constexpr unsigned kPopulate = 1;
+
+    // Use huge pages: reserved ones (MAP_HUGETLB) if system has enough of them, transparent ones
+    // (MADV_HUGEPAGE) otherwise. Size is rounded up to huge page then
+    static constexpr unsigned kHugePages = 2;
+
+    // Back area by memory file, see fd(). Area is placed away from where kernel puts mappings by
+    // default, so that the same address is likely free in a freshly started process
+    static constexpr unsigned kShared = 4;
+
+    /**
+     * @param node NUMA node pages should come from, -1 for the default policy of the thread that
+     * touches them first
+     *
+     * Throws std::runtime_error if memory couldn't be mapped
+     */
+    explicit Mapping(std::size_t size, unsigned flags = 0, int node = -1);
+
+    /**
+     * Maps memory file of a shared area created by this or other process at exactly the given address,
+     * takes ownership of fd. Throws std::runtime_error if address is taken
+     */
+    Mapping(int fd, void *address);
+
+    ~Mapping();
+
+    Mapping(const Mapping &) = delete;
+    Mapping &operator=(const Mapping &) = delete;
+
+    void *data() const { return _data; }
+
+    /**
+     * Usable size, at least the requested one
+     */
+    std::size_t size() const { return _size; }
+
+    /**
+     * Area is backed by reserved huge pages
+     */
+    bool hugetlb() const { return _hugetlb; }
+
+    /**
+     * Memory file of the shared area, -1 for anonymous one
+     */
+    int fd() const { return _fd; }
+
+private:
+    // Mapping itself, could be larger than the area because of alignment
+    void *_mapping;
+    std::size_t _mapping_size;
+
+    void *_data;
+    std::size_t _size;
+    bool _hugetlb;
+    int _fd;
+};
+
+} // namespace Allocator
+} // namespace Afina
+#endif // AFINA_ALLOCATOR_MAPPING_H
@@ -0,0 +1,166 @@
+#ifndef AFINA_ALLOCATOR_MEMPOOL_H
+#define AFINA_ALLOCATOR_MEMPOOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <thread>
+#include <utility>
+
+namespace Afina {
+namespace Allocator {
+
+// Forward declaration, see SlabCache.h
+class SlabCache;
+
+/**
+ * # Pool of objects of the same size
+ * The top of arena -> slab cache -> mempool chain. Objects are cut from slabs of the thread slab
+ * cache, free objects of a slab are linked into its own list, slabs that have free objects go first
+ * in the pool list. Allocation takes the first slab's object, slab left without any objects returns
+ * to the cache. Slab of any object is found by the address, so there are no per object headers.
+ *
+ * Pool belongs to the thread that created it and uses no synchronization on alloc and on free from
+ * that thread. Any other thread may free objects as well: such objects are pushed into a lock-free
+ * stack, and the owner takes them back once it runs out of free objects
+ */
+class Mempool {
+public:
+    /**
+     * @param object_size rounded up to std::max_align_t alignment, must fit into a slab along with
+     * its header
+     */
+    Mempool(SlabCache &cache, std::size_t object_size);
+
+    /**
+     * Returns all slabs back to the cache, objects still allocated become invalid. Must be called
+     * by the owner once no other thread could free objects of the pool
+     */
+    ~Mempool();
+
+    Mempool(const Mempool &) = delete;
+    Mempool &operator=(const Mempool &) = delete;
+
+    /**
+     * Allocates object, returns nullptr once arena is exhausted. Owner thread only
+     */
+    void *alloc();
+
+    /**
+     * Frees object allocated by alloc. Any thread
+     */
+    void free(void *object);
+
+    std::size_t object_size() const { return _object_size; }
+
+    /**
+     * Objects allocated and not freed yet, objects freed by other threads are counted until the owner
+     * takes them back
+     */
+    std::size_t used() const { return _used; }
+
+    /**
+     * Slabs pool holds
+     */
+    std::size_t slabs() const { return _slabs; }
+
+private:
+    struct Slab {
+        Slab *prev;
+        Slab *next;
+
+        // Objects freed, each keeps address of the next one in its first word
+        void *free;
+
+        // Objects in use
+        std::size_t used;
+
+        // Objects never allocated yet start at that index
+        std::size_t carved;
+    };
+
+    /**
+     * Object freed by other thread, waiting for the owner
+     */
+    struct Returned {
+        Returned *next;
+    };
+
+    /**
+     * Slab to allocate from once the first one is full: returned objects or new slab from the cache
+     */
+    Slab *Refill();
+
+    /**
+     * Frees object on the owner thread
+     */
+    void Release(void *object);
+
+    void PushFront(Slab *slab);
+    void PushBack(Slab *slab);
+    void Unlink(Slab *slab);
+
+    SlabCache &_cache;
+    const std::size_t _slab_size;
+    const std::size_t _object_size;
+
+    // Objects start at that offset of slab
+    const std::size_t _offset;
+    const std::size_t _capacity;
+
+    const std::thread::id _owner;
+
+    // Slabs with free objects go first, full ones after them
+    Slab *_head;
+    Slab *_tail;
+
+    std::size_t _slabs;
+    std::size_t _used;
+
+    // Objects freed by other threads
+    std::atomic<Returned *> _returned;
+};
+
+/**
+ * # Mempool of objects of type T
+ * Constructs objects in place and destroys them before releasing memory
+ */
+template <typename T> class ObjectPool {
+public:
+    static_assert(alignof(T) <= alignof(std::max_align_t), "Object is overaligned for mempool");
+
+    explicit ObjectPool(SlabCache &cache) : _pool(cache, sizeof(T)) {}
+
+    /**
+     * Allocates and constructs object, throws std::bad_alloc once arena is exhausted. Owner thread only
+     */
+    template <typename... Args> T *create(Args &&... args) {
+        void *p = _pool.alloc();
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        try {
+            return new (p) T(std::forward<Args>(args)...);
+        } catch (...) {
+            _pool.free(p);
+            throw;
+        }
+    }
+
+    /**
+     * Destroys object created by create. Any thread
+     */
+    void destroy(T *object) {
+        object->~T();
+        _pool.free(object);
+    }
+
+    std::size_t used() const { return _pool.used(); }
+
+private:
+    Mempool _pool;
+};
+
+} // namespace Allocator
+} // namespace Afina
+#endif // AFINA_ALLOCATOR_MEMPOOL_H
@@ -0,0 +1,76 @@
+#ifndef AFINA_ALLOCATOR_NUMA_H
+#define AFINA_ALLOCATOR_NUMA_H
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # NUMA nodes of the host
+ * Read from sysfs, so that server doesn't depend on libnuma. Kernel without NUMA support has no
+ * nodes there, such host is seen as a single node 0 with all online cpus. Only nodes that have
+ * cpus are taken into account, memory only nodes can't run workers
+ */
+class NumaTopology {
+public:
+    /**
+     * Topology of this host, read once
+     */
+    static const NumaTopology &System();
+
+    /**
+     * Reads topology from the given directory laid out as /sys/devices/system/node is. Throws
+     * std::runtime_error if cpu list can't be parsed
+     */
+    explicit NumaTopology(const std::string &root);
+
+    /**
+     * Node ids in ascending order, ids could have gaps
+     */
+    const std::vector<int> &nodes() const { return _nodes; }
+
+    /**
+     * Cpus of the node, empty if there is no such node
+     */
+    const std::vector<int> &cpus(int node) const;
+
+    /**
+     * Node the cpu belongs to, -1 if unknown
+     */
+    int node_of(int cpu) const;
+
+private:
+    std::vector<int> _nodes;
+    std::map<int, std::vector<int>> _cpus;
+};
+
+/**
+ * Node of the cpu current thread runs on
+ */
+int current_numa_node();
+
+/**
+ * Asks kernel to take pages of the area from the given node, while it has free memory. Area must be
+ * page aligned and not populated yet, pages already committed stay where they are. Throws
+ * std::runtime_error on failure
+ */
+void bind_memory(void *area, std::size_t size, int node);
+
+/**
+ * Restricts current thread to cpus of the node. Throws std::runtime_error on failure
+ */
+void pin_thread(int node);
+
+/**
+ * Pins current thread to the node that goes i-th when threads are spread over host nodes round robin,
+ * returns the node
+ */
+int pin_thread_round_robin(std::size_t i);
+
+} // namespace Allocator
+} // namespace Afina
+#endif // AFINA_ALLOCATOR_NUMA_H
@@ -7,6 +7,14 @@ namespace Allocator {
 // to avoid expensive macros calculations and increase compile speed
 class Simple;
 
+/**
+ * Handle of memory allocated by Simple. Allocator could move memory around, e.g on defrag or
+ * realloc, so handle points to a descriptor in the allocator table rather than to the memory itself,
+ * get() goes through the descriptor and always returns the current address.
+ *
+ * Copies of the pointer share descriptor, once memory is freed through one of them the rest become
+ * dangling, just like raw pointers do
+ */
 class Pointer {
 public:
     Pointer();
@@ -17,7 +25,15 @@ public:
     Pointer &operator=(const Pointer &);
     Pointer &operator=(Pointer &&);
 
-    void *get() const { return 0; }
+    void *get() const { return _slot != nullptr ? *_slot : nullptr; }
+
+private:
+    friend class Simple;
+
+    explicit Pointer(void **slot) : _slot(slot) {}
+
+    // Descriptor in the allocator table, nullptr for empty pointer
+    void **_slot;
 };
 
 } // namespace Allocator
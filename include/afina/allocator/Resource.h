@@ -0,0 +1,91 @@
+#ifndef AFINA_ALLOCATOR_RESOURCE_H
+#define AFINA_ALLOCATOR_RESOURCE_H
+
+#include <cstddef>
+
+#include <afina/allocator/Slab.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Source of raw memory
+ * The same interface as std::pmr::memory_resource has, which is C++17 only. Containers use it
+ * through PolymorphicAllocator, see StdAllocator.h, so that the same container type could take
+ * memory from different sources.
+ *
+ * Allocation failure is reported by std::bad_alloc, just like operator new does
+ */
+class MemoryResource {
+public:
+    virtual ~MemoryResource() {}
+
+    void *allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+        return do_allocate(bytes, alignment);
+    }
+
+    void deallocate(void *p, std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+        do_deallocate(p, bytes, alignment);
+    }
+
+    /**
+     * Memory allocated by one resource could be released by other one
+     */
+    bool is_equal(const MemoryResource &other) const noexcept { return do_is_equal(other); }
+
+protected:
+    virtual void *do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+    virtual void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) = 0;
+    virtual bool do_is_equal(const MemoryResource &other) const noexcept { return this == &other; }
+};
+
+/**
+ * Resource using global operator new and delete
+ */
+MemoryResource *new_delete_resource() noexcept;
+
+/**
+ * # Resource on top of Allocator::Slab
+ * Memory comes from the fixed area only, so containers using it can't take more than the area has.
+ * Each allocation takes a chunk of the smallest class that fits. Blocks larger than a slab page are
+ * taken from upstream resource if there is one, otherwise they fail just like exhausted area does.
+ *
+ * Not threadsafe
+ */
+class SlabResource final : public MemoryResource {
+public:
+    /**
+     * @param upstream resource for blocks larger than page, nullptr to fail such blocks
+     */
+    SlabResource(void *base, std::size_t size, std::size_t page_size = Slab::kDefaultPageSize,
+                 MemoryResource *upstream = nullptr);
+
+    /**
+     * Bytes taken by blocks currently allocated: chunk sizes rather than requested sizes, and blocks
+     * of upstream
+     */
+    std::size_t used() const { return _used; }
+
+    const Slab &slab() const { return _slab; }
+
+    /**
+     * Non virtual versions, used by StdAllocator<T, SlabResource>
+     */
+    void *allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+    void deallocate(void *p, std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+
+protected:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override { return allocate(bytes, alignment); }
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override {
+        deallocate(p, bytes, alignment);
+    }
+
+private:
+    Slab _slab;
+    MemoryResource *_upstream;
+    std::size_t _used;
+};
+
+} // namespace Allocator
+} // namespace Afina
+#endif // AFINA_ALLOCATOR_RESOURCE_H
@@ -1,8 +1,8 @@
 #ifndef AFINA_ALLOCATOR_SIMPLE_H
 #define AFINA_ALLOCATOR_SIMPLE_H
 
-#include <string>
 #include <cstddef>
+#include <string>
 
 namespace Afina {
 namespace Allocator {
@@ -18,44 +18,111 @@ class Pointer;
  * Allocator instance doesn't take ownership of wrapped memmory and do not delete it
  * on destruction. So caller must take care of resource cleaup after allocator stop
  * being needs
+ *
+ * Area layout: blocks grow from the beginning, table of descriptors Pointer refers to grows from the
+ * end, space between them is not used yet. Each block starts with a header: payload size and the
+ * descriptor of its owner, free blocks have no owner and are linked into a list ordered by address,
+ * so that freed block is merged with free neighbours right away. Free block next to the unused space
+ * returns to it.
+ *
+ * Allocation takes the smallest free block that fits (best fit), unused space is used only if none
+ * fits. Both are O(number of free blocks). Payloads are aligned as std::max_align_t.
+ *
+ * Memory moves on defrag, so standard containers can't use it, see StdAllocator.h for those.
+ *
+ * Not threadsafe
  */
-// TODO: Implements interface to allow usage as C++ allocators
 class Simple {
 public:
     Simple(void *base, const size_t size);
 
     /**
-     * TODO: semantics
+     * Allocates N bytes. Throws AllocError of NoMemory type if there is no free block large enough,
+     * defrag might help then
      * @param N size_t
      */
     Pointer alloc(size_t N);
 
     /**
-     * TODO: semantics
+     * Changes size of memory pointer refers to keeping its content, as much as fits into the new size.
+     * Block is resized in place if possible, otherwise content moves elsewhere, pointer and its copies
+     * stay valid anyway. Empty pointer gets new memory. Throws AllocError of NoMemory type if there
+     * is no space, pointer is left intact then
      * @param p Pointer
      * @param N size_t
      */
     void realloc(Pointer &p, size_t N);
 
     /**
-     * TODO: semantics
+     * Releases memory and makes pointer empty, noop for empty pointer. Throws AllocError of
+     * InvalidFree type if pointer doesn't refer to memory allocated here
      * @param p Pointer
      */
     void free(Pointer &p);
 
     /**
-     * TODO: semantics
+     * Moves all allocated blocks to the beginning of the area preserving their order, so that all
+     * free space becomes one piece. Pointers remain valid, addresses they return change
      */
     void defrag();
 
     /**
-     * TODO: semantics
+     * Human readable layout of the area: blocks with their offsets and sizes, unused space and table
      */
     std::string dump() const;
 
 private:
+    struct Block;
+
+    /**
+     * Descriptor for a new pointer: either released one or a new one from the unused space. Returns
+     * nullptr if there are none
+     */
+    void **TakeSlot();
+    void ReleaseSlot(void **slot);
+
+    /**
+     * Block with payload of at least size bytes taken out of free list or unused space, nullptr if
+     * there is no such block
+     */
+    Block *TakeBlock(size_t size);
+
+    /**
+     * Splits tail of the block off if it is large enough to be a block itself
+     */
+    void Trim(Block *block, size_t size);
+
+    /**
+     * Returns block to the free list merging it with free neighbours
+     */
+    void Release(Block *block);
+
+    /**
+     * Removes free block from the free list, prev is its predecessor there
+     */
+    void Unlink(Block *block, Block *prev);
+
+    /**
+     * Block the pointer refers to, throws AllocError if there is none
+     */
+    Block *Resolve(const Pointer &p) const;
+
+    Block *Next(Block *block) const;
+
     void *_base;
     const size_t _base_len;
+
+    // Blocks occupy [_begin, _end), table occupies [_table, area end)
+    char *_begin;
+    char *_end;
+    void **_table;
+    void **_table_end;
+
+    // Free blocks ordered by address
+    Block *_free;
+
+    // Released descriptors, each keeps address of the next one tagged with the lowest bit
+    void **_free_slots;
 };
 
 } // namespace Allocator
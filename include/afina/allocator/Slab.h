@@ -0,0 +1,199 @@
+#ifndef AFINA_ALLOCATOR_SLAB_H
+#define AFINA_ALLOCATOR_SLAB_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Slab allocator
+ * Wraps given memory area and splits it into pages of the same size. Each page, once needed, is given
+ * to a size class and cut into chunks of the class size. Class sizes grow geometrically starting from
+ * the minimal chunk, the last class takes the whole page. Allocation takes a chunk of the class from
+ * its free list, both allocation and release are O(1) and never fragment memory outside of a chunk.
+ * Chunks are aligned as std::max_align_t.
+ *
+ * Page stays with its class until it is explicitly moved to another one, see reassign. Owner of
+ * allocated memory decides which chunks to sacrifice once class runs out of them, e.g by evicting
+ * the least recently used items of that class.
+ *
+ * Allocator instance doesn't take ownership of wrapped memory. Its own state is kept on the heap, or
+ * at the beginning of the area for allocators created by Embedded: then the area holds everything,
+ * and another process that maps it at the same address picks allocator up with Attach.
+ *
+ * Not threadsafe
+ */
+class Slab {
+public:
+    static constexpr std::size_t kDefaultPageSize = 1024 * 1024;
+    static constexpr std::size_t kDefaultMinChunk = 64;
+
+    /**
+     * @param page_size size of a page, the largest chunk that could be allocated
+     * @param min_chunk size of the smallest class, rounded up to std::max_align_t alignment
+     * @param factor ratio between sizes of neighbouring classes
+     */
+    Slab(void *base, std::size_t size, std::size_t page_size = kDefaultPageSize,
+         std::size_t min_chunk = kDefaultMinChunk, double factor = 1.25);
+
+    /**
+     * Allocator that keeps its state in the area, pages take what is left. Chunks are addressed by
+     * pointers, so the area must stay at the same address for the allocator lifetime
+     */
+    static Slab Embedded(void *base, std::size_t size, std::size_t page_size = kDefaultPageSize,
+                         std::size_t min_chunk = kDefaultMinChunk, double factor = 1.25);
+
+    /**
+     * Allocator created by Embedded on the same area earlier, in this or other process. Takes no time
+     * regardless of number of chunks allocated. Throws std::runtime_error if area doesn't have
+     * allocator state or it is of different size
+     */
+    static Slab Attach(void *base, std::size_t size);
+
+    Slab(Slab &&) = default;
+
+    /**
+     * Number of size classes, classes are numbered from 0 in the order of growing chunk size
+     */
+    unsigned classes() const { return _header->classes; }
+
+    /**
+     * Size of chunks of the class
+     */
+    std::size_t chunk_size(unsigned cls) const { return _classes[cls].size; }
+
+    /**
+     * The smallest class with chunks of at least size bytes. Throws AllocError of NoMemory type if
+     * size exceeds the page
+     */
+    unsigned class_of(std::size_t size) const;
+
+    /**
+     * Class the chunk belongs to
+     */
+    unsigned class_of(void *chunk) const { return _pages[PageOf(chunk)].cls; }
+
+    /**
+     * Takes a chunk of the class. Returns nullptr if class has no free chunks and there are no spare
+     * pages to give it
+     */
+    void *alloc(unsigned cls);
+
+    /**
+     * Returns chunk to the free list of its class. Throws AllocError of InvalidFree type if chunk
+     * isn't allocated here
+     */
+    void free(void *chunk);
+
+    /**
+     * Moves the page chunk lives on to another class, so that class starved for memory could get it
+     * from class that has plenty. Every chunk allocated on that page is passed to evict first, after
+     * that it isn't allocated anymore, so evict must forget it rather than call free
+     */
+    void reassign(void *chunk, unsigned cls, const std::function<void(void *)> &evict);
+
+    /**
+     * Pages given to the class and chunks allocated from it
+     */
+    std::size_t pages(unsigned cls) const { return _classes[cls].pages; }
+    std::size_t used(unsigned cls) const { return _classes[cls].used; }
+
+    /**
+     * Pages not given to any class yet
+     */
+    std::size_t spare_pages() const { return _header->spare; }
+
+    /**
+     * Human readable state of classes: chunk sizes, pages and chunks in use
+     */
+    std::string dump() const;
+
+private:
+    // State of the allocator, followed by arrays of classes, pages, spare page stack and bitmap
+    struct Header {
+        uint64_t magic;
+        std::size_t size;
+        std::size_t page_size;
+        std::size_t pages;
+        std::size_t bitmap_words;
+        unsigned classes;
+
+        // Pages on the spare stack
+        std::size_t spare;
+
+        // Offset of the first page from the area beginning
+        std::size_t begin;
+    };
+
+    // Free chunk keeps links to neighbours in the free list of its class
+    struct Chunk {
+        Chunk *prev;
+        Chunk *next;
+    };
+
+    struct Class {
+        std::size_t size;
+
+        // Free chunks of all pages of the class
+        Chunk *free;
+
+        std::size_t pages;
+        std::size_t used;
+    };
+
+    struct Page {
+        // Class page is given to, classes() for spare page
+        unsigned cls;
+
+        // Chunks in use
+        std::size_t used;
+    };
+
+    Slab() = default;
+
+    /**
+     * Lays state out either in the area or in a heap block
+     */
+    void Init(void *base, std::size_t size, std::size_t page_size, std::size_t min_chunk, double factor,
+              bool embedded);
+
+    /**
+     * Points arrays to their places following the header, base is the area beginning
+     */
+    void Locate(char *base);
+
+    std::size_t PageOf(void *chunk) const;
+
+    /**
+     * Gives spare page to the class, all page chunks become free
+     */
+    void Split(std::size_t page, unsigned cls);
+
+    void Push(Class &c, Chunk *chunk);
+    void Unlink(Class &c, Chunk *chunk);
+
+    // State of heap based allocator
+    std::unique_ptr<char[]> _heap;
+
+    Header *_header;
+    Class *_classes;
+    Page *_pages;
+
+    // Pages not given to any class
+    std::size_t *_spare;
+
+    // Bit per chunk of the smallest class per page, set for allocated chunks
+    uint64_t *_bitmap;
+
+    // Pages occupy [_begin, _begin + _header->pages * _header->page_size)
+    char *_begin;
+};
+
+} // namespace Allocator
+} // namespace Afina
+#endif // AFINA_ALLOCATOR_SLAB_H
@@ -0,0 +1,63 @@
+#ifndef AFINA_ALLOCATOR_SLAB_CACHE_H
+#define AFINA_ALLOCATOR_SLAB_CACHE_H
+
+#include <cstddef>
+
+namespace Afina {
+namespace Allocator {
+
+// Forward declaration, see Arena.h
+class Arena;
+
+/**
+ * # Slabs of a single thread
+ * Takes slabs from the shared arena and keeps a few released ones for reuse, so that pools that
+ * grow and shrink don't hit the arena all the time. Belongs to one thread and has no
+ * synchronization at all, every thread that allocates is supposed to have its own cache.
+ *
+ * Slabs left in cache return to the arena on destruction
+ */
+class SlabCache {
+public:
+    static constexpr std::size_t kDefaultKeep = 4;
+
+    /**
+     * @param keep number of released slabs to hold
+     */
+    explicit SlabCache(Arena &arena, std::size_t keep = kDefaultKeep);
+    ~SlabCache();
+
+    SlabCache(const SlabCache &) = delete;
+    SlabCache &operator=(const SlabCache &) = delete;
+
+    /**
+     * Takes slab, returns nullptr once arena is exhausted
+     */
+    void *get();
+
+    /**
+     * Releases slab taken with get
+     */
+    void put(void *slab);
+
+    Arena &arena() const { return _arena; }
+
+    /**
+     * Slabs taken from the arena, including kept ones
+     */
+    std::size_t slabs() const { return _slabs; }
+
+private:
+    Arena &_arena;
+    const std::size_t _keep;
+
+    // Released slabs, each one keeps address of the next one in its first word
+    void *_free;
+    std::size_t _free_count;
+
+    std::size_t _slabs;
+};
+
+} // namespace Allocator
+} // namespace Afina
+#endif // AFINA_ALLOCATOR_SLAB_CACHE_H
@@ -0,0 +1,98 @@
+#ifndef AFINA_ALLOCATOR_STD_ALLOCATOR_H
+#define AFINA_ALLOCATOR_STD_ALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <afina/allocator/Resource.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Allocator for standard containers
+ * Satisfies Allocator requirements, memory comes from the given resource, which must outlive both
+ * the allocator and containers using it. Resource type is a template parameter: concrete one, e.g
+ * SlabResource, is called directly, MemoryResource goes through virtual calls but allows containers
+ * of the same type to use different resources, see PolymorphicAllocator.
+ *
+ * Allocators are equal if they use the same resource. Resource isn't propagated on container copy
+ * assignment, move or swap, just like std::pmr::polymorphic_allocator does, so that container keeps
+ * taking memory from where it was created
+ */
+template <typename T, typename Resource = MemoryResource> class StdAllocator {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+
+    template <typename U> struct rebind { using other = StdAllocator<U, Resource>; };
+
+    explicit StdAllocator(Resource *resource) noexcept : _resource(resource) {}
+
+    template <typename U> StdAllocator(const StdAllocator<U, Resource> &other) noexcept : _resource(other.resource()) {}
+
+    /**
+     * Throws std::bad_alloc if resource has no memory
+     */
+    T *allocate(std::size_t n) { return static_cast<T *>(_resource->allocate(n * sizeof(T), alignof(T))); }
+
+    void deallocate(T *p, std::size_t n) { _resource->deallocate(p, n * sizeof(T), alignof(T)); }
+
+    /**
+     * Constructs object in place. Objects that use allocator of the same kind, e.g strings stored in
+     * a vector, get this one as the last argument, so that nested containers take memory from the
+     * same resource
+     */
+    template <typename U, typename... Args> void construct(U *p, Args &&... args) {
+        using uses = std::integral_constant<bool, std::uses_allocator<U, StdAllocator>::value &&
+                                                      std::is_constructible<U, Args..., const StdAllocator &>::value>;
+        Construct(uses(), p, std::forward<Args>(args)...);
+    }
+
+    template <typename U> void destroy(U *p) { p->~U(); }
+
+    /**
+     * Copy of container takes memory from the same resource as the original
+     */
+    StdAllocator select_on_container_copy_construction() const { return *this; }
+
+    Resource *resource() const noexcept { return _resource; }
+
+private:
+    template <typename U, typename... Args> void Construct(std::true_type, U *p, Args &&... args) {
+        new (p) U(std::forward<Args>(args)..., *this);
+    }
+
+    template <typename U, typename... Args> void Construct(std::false_type, U *p, Args &&... args) {
+        new (p) U(std::forward<Args>(args)...);
+    }
+
+    Resource *_resource;
+};
+
+template <typename T, typename U, typename Resource>
+bool operator==(const StdAllocator<T, Resource> &a, const StdAllocator<U, Resource> &b) noexcept {
+    return a.resource() == b.resource();
+}
+
+template <typename T, typename U, typename Resource>
+bool operator!=(const StdAllocator<T, Resource> &a, const StdAllocator<U, Resource> &b) noexcept {
+    return !(a == b);
+}
+
+/**
+ * Allocator that chooses memory source at runtime
+ */
+template <typename T> using PolymorphicAllocator = StdAllocator<T, MemoryResource>;
+
+} // namespace Allocator
+} // namespace Afina
+#endif // AFINA_ALLOCATOR_STD_ALLOCATOR_H
@@ -0,0 +1,118 @@
+#ifndef AFINA_COROUTINE_CHANNEL_H
+#define AFINA_COROUTINE_CHANNEL_H
+
+#include <cstddef>
+#include <deque>
+#include <stdexcept>
+#include <utility>
+
+#include <afina/coroutine/Engine.h>
+#include <afina/coroutine/WaitList.h>
+
+namespace Afina {
+namespace Coroutine {
+
+/**
+ * # Bounded channel between routines
+ * Queue of at most capacity values: sender blocks while channel is full, receiver while it is empty,
+ * so a fast producer is paced by its consumers. Values are received in the order they were sent.
+ *
+ * Once channel is closed senders fail right away and receivers get what is left, then fail as well.
+ * All routines blocked on channel are woken up by close
+ */
+template <typename T> class Channel {
+public:
+    Channel(Engine &engine, std::size_t capacity)
+        : _capacity(capacity), _closed(false), _senders(engine), _receivers(engine) {
+        if (capacity == 0) {
+            throw std::runtime_error("Channel capacity must be positive");
+        }
+    }
+
+    Channel(const Channel &) = delete;
+    Channel &operator=(const Channel &) = delete;
+
+    /**
+     * Puts value into channel, blocks while it is full. Returns false if channel is closed
+     */
+    bool send(T value) {
+        while (!_closed && _buffer.size() >= _capacity) {
+            _senders.wait();
+        }
+        return Put(std::move(value));
+    }
+
+    /**
+     * Puts value into channel if there is space, never blocks
+     */
+    bool try_send(T value) {
+        if (_buffer.size() >= _capacity) {
+            return false;
+        }
+        return Put(std::move(value));
+    }
+
+    /**
+     * Takes value out of channel, blocks while it is empty. Returns false once channel is closed and
+     * drained
+     */
+    bool recv(T &value) {
+        while (!_closed && _buffer.empty()) {
+            _receivers.wait();
+        }
+        return Take(value);
+    }
+
+    /**
+     * Takes value out of channel if there is one, never blocks
+     */
+    bool try_recv(T &value) { return Take(value); }
+
+    /**
+     * No more values could be sent, wakes up everybody waiting
+     */
+    void close() {
+        _closed = true;
+        _senders.notify_all();
+        _receivers.notify_all();
+    }
+
+    bool closed() const { return _closed; }
+
+    std::size_t size() const { return _buffer.size(); }
+
+    std::size_t capacity() const { return _capacity; }
+
+private:
+    bool Put(T &&value) {
+        if (_closed) {
+            return false;
+        }
+        _buffer.push_back(std::move(value));
+        _receivers.notify_one();
+        return true;
+    }
+
+    bool Take(T &value) {
+        if (_buffer.empty()) {
+            return false;
+        }
+        value = std::move(_buffer.front());
+        _buffer.pop_front();
+        _senders.notify_one();
+        return true;
+    }
+
+    const std::size_t _capacity;
+    bool _closed;
+    std::deque<T> _buffer;
+
+    // Routines waiting for space and for values
+    WaitList _senders;
+    WaitList _receivers;
+};
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_CHANNEL_H
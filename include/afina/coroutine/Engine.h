@@ -1,11 +1,15 @@
 #ifndef AFINA_COROUTINE_ENGINE_H
 #define AFINA_COROUTINE_ENGINE_H
 
+#include <cstddef>
 #include <cstdint>
-#include <iostream>
-#include <map>
-#include <setjmp.h>
+#include <exception>
+#include <functional>
 #include <tuple>
+#include <utility>
+#include <vector>
+
+#include <afina/Task.h>
 
 namespace Afina {
 namespace Coroutine {
@@ -13,70 +17,29 @@ namespace Coroutine {
 /**
  * # Entry point of coroutine library
  * Allows to run coroutine and schedule its execution. Not threadsafe
+ *
+ * Each coroutine runs on its own stack mmap'ed with a guard page below it, so that stack overflow
+ * crashes instead of corrupting memory. Switch between coroutines saves callee saved registers on the
+ * current stack and restores them from the other one, so it costs the same regardless of stack depth.
+ * Stacks of finished coroutines are kept for reuse.
+ *
+ * Coroutine could be blocked, then engine doesn't schedule it until somebody unblocks it. Once all
+ * coroutines are blocked engine calls idle hook, which is supposed to wait for some event and unblock
+ * coroutines waiting for it, e.g epoll_wait on descriptors coroutines are waiting for.
  */
 class Engine final {
-private:
-    /**
-     * A single coroutine instance which could be scheduled for execution
-     * should be allocated on heap
-     */
-    struct context;
-    typedef struct context {
-        // coroutine stack start address
-        char *Low = nullptr;
-
-        // coroutine stack end address
-        char *Hight = nullptr;
-
-        // coroutine stack copy buffer
-        std::tuple<char *, uint32_t> Stack = std::make_tuple(nullptr, 0);
-
-        // Saved coroutine context (registers)
-        jmp_buf Environment;
-
-        // To include routine in the different lists, such as "alive", "blocked", e.t.c
-        struct context *prev = nullptr;
-        struct context *next = nullptr;
-    } context;
-
-    /**
-     * Where coroutines stack begins
-     */
-    char *StackBottom;
-
-    /**const int&
-     * Current coroutine
-     */
-    context *cur_routine;
-
-    /**
-     * List of routines ready to be scheduled. Note that suspended routine ends up here as well
-     */
-    context *alive;
-
-    /**
-     * Context to be returned finally
-     */
-    context *idle_ctx;
-
-protected:
-    /**
-     * Save stack of the current coroutine in the given context
-     */
-    void Store(context &ctx);
-
-    /**
-     * Restore stack of the given context and pass control to coroutinne
-     */
-    void Restore(context &ctx);
+public:
+    static constexpr std::size_t kDefaultStackSize = 128 * 1024;
 
     /**
-     * Suspend current coroutine execution and execute given context
+     * @param stack_size size of each coroutine stack, rounded up to pages. Memory is committed only
+     * once it is touched
+     * @param idle function to call once all coroutines are blocked. Without it engine throws
+     * std::runtime_error from start if that happens
      */
-    // void Enter(context& ctx);
+    explicit Engine(std::size_t stack_size = kDefaultStackSize, std::function<void()> idle = nullptr);
+    ~Engine();
 
-public:
-    Engine() : StackBottom(0), cur_routine(nullptr), alive(nullptr) {}
     Engine(Engine &&) = delete;
     Engine(const Engine &) = delete;
 
@@ -99,103 +62,169 @@ public:
      */
     void sched(void *routine);
 
+    /**
+     * Blocks given routine, current one if not specified, so it won't be scheduled until unblocked.
+     * Blocking current routine passes control to some other one which is ready to run, or to the idle
+     * hook if there are none
+     */
+    void block(void *routine = nullptr);
+
+    /**
+     * Makes blocked routine ready to run again. Doesn't pass control to it
+     */
+    void unblock(void *routine);
+
+    /**
+     * Routine being executed, nullptr outside of coroutines, e.g in idle hook
+     */
+    void *current() const { return cur_routine; }
+
+    /**
+     * Replaces idle hook given to constructor, e.g by an event loop that has to know engine itself
+     */
+    void set_idle(std::function<void()> idle) { idle_hook = std::move(idle); }
+
     /**
      * Entry point into the engine. Prepare all internal mechanics and starts given function which is
      * considered as main.
      *
      * Once control returns back to caller of start all coroutines are done execution, in other words,
-     * this function doesn't return control until all coroutines are done.
+     * this function doesn't return control until all coroutines are done. Exception escaped any of
+     * coroutines is rethrown from here once that happens
      *
      * @param pointer to the main coroutine
      * @param arguments to be passed to the main coroutine
      */
     template <typename... Ta> void start(void (*main)(Ta...), Ta &&... args) {
-        // To acquire stack begin, create variable on stack and remember its address
-        char StackStartsHere;
-        this->StackBottom = &StackStartsHere;
-
-        // Start routine execution
-        void *pc = run(main, std::forward<Ta>(args)...);
-        idle_ctx = new context();
-
-        if (setjmp(idle_ctx->Environment) > 0) {
-            // Here: correct finish of the coroutine section
-            yield();
-        } else if (pc != nullptr) {
-            Store(*idle_ctx);
-            sched(pc);
-        }
-
-        // Shutdown runtime
-        delete idle_ctx;
-        this->StackBottom = 0;
+        Start(Task(Invocation<Ta...>(main, std::forward<Ta>(args)...)));
     }
 
     /**
      * Register new coroutine. It won't receive control until scheduled explicitely or implicitly. In case of some
-     * errors function returns -1
+     * errors function returns nullptr
      */
     template <typename... Ta> void *run(void (*func)(Ta...), Ta &&... args) {
-        if (this->StackBottom == 0) {
+        if (idle_ctx == nullptr) {
             // Engine wasn't initialized yet
             return nullptr;
         }
+        return Spawn(Task(Invocation<Ta...>(func, std::forward<Ta>(args)...)));
+    }
 
-        // New coroutine context that carries around all information enough to call function
-        context *pc = new context();
-
-        // Store current state right here, i.e just before enter new coroutine, later, once it gets scheduled
-        // execution starts here. Note that we have to acquire stack of the current function call to ensure
-        // that function parameters will be passed along
-        if (setjmp(pc->Environment) > 0) {
-            // Created routine got control in order to start execution. Note that all variables, such as
-            // context pointer, arguments and a pointer to the function comes from restored stack
-
-            // invoke routine
-            func(std::forward<Ta>(args)...);
-
-            // Routine has completed its execution, time to delete it. Note that we should be extremely careful in where
-            // to pass control after that. We never want to go backward by stack as that would mean to go backward in
-            // time. Function run() has already return once (when setjmp returns 0), so return second return from run
-            // would looks a bit awkward
-            if (pc->prev != nullptr) {
-                pc->prev->next = pc->next;
-            }
-
-            if (pc->next != nullptr) {
-                pc->next->prev = pc->prev;
-            }
-
-            if (alive == cur_routine) {
-                alive = alive->next;
-            }
-
-            // current coroutine finished, and the pointer is not relevant now
-            cur_routine = nullptr;
-            pc->prev = pc->next = nullptr;
-            delete std::get<0>(pc->Stack);
-            delete pc;
-
-            // We cannot return here, as this function "returned" once already, so here we must select some other
-            // coroutine to run. As current coroutine is completed and can't be scheduled anymore, it is safe to
-            // just give up and ask scheduler code to select someone else, control will never returns to this one
-            Restore(*idle_ctx);
-        }
+private:
+    /**
+     * A single coroutine instance which could be scheduled for execution, see Engine.cpp
+     */
+    struct context;
 
-        // setjmp remembers position from which routine could starts execution, but to make it correctly
-        // it is neccessary to save arguments, pointer to body function, pointer to context, e.t.c - i.e
-        // save stack.
-        Store(*pc);
+    /**
+     * Function along with its arguments. Arguments are kept as declared by function, so that reference
+     * parameters refer to objects of the caller
+     */
+    template <typename... Ta> class Invocation {
+    public:
+        template <typename... Args> Invocation(void (*func)(Ta...), Args &&... args)
+            : _func(func), _args(std::forward<Args>(args)...) {}
+
+        void operator()() { Call(std::index_sequence_for<Ta...>()); }
 
-        // Add routine as alive double-linked list
-        pc->next = alive;
-        alive = pc;
-        if (pc->next != nullptr) {
-            pc->next->prev = pc;
+    private:
+        template <std::size_t... I> void Call(std::index_sequence<I...>) {
+            _func(std::forward<Ta>(std::get<I>(_args))...);
         }
 
-        return pc;
-    }
+        void (*_func)(Ta...);
+        std::tuple<Ta...> _args;
+    };
+
+    /**
+     * Runs main coroutine and all coroutines it starts till the end
+     */
+    void Start(Task &&main);
+
+    /**
+     * Creates coroutine running the given function, returns its handle
+     */
+    void *Spawn(Task &&body);
+
+    /**
+     * Frees routines left once scheduler has failed, e.g all of them are blocked and there is no idle
+     * hook. Their stacks are dropped without unwinding
+     */
+    void Discard();
+
+    /**
+     * Suspends current coroutine (or scheduler) and passes control to the given one
+     */
+    void Enter(context *routine);
+
+    /**
+     * Suspends current coroutine and passes control back to scheduler
+     */
+    void Leave();
+
+    /**
+     * Double linked lists of routines
+     */
+    static void Link(context *&list, context *routine);
+    static void Unlink(context *&list, context *routine);
+
+    /**
+     * First function of any coroutine, runs its body and switches to scheduler once done
+     */
+    static void Entry(void *routine);
+
+    /**
+     * Stack of the configured size with the guard page, reuses stacks of finished coroutines
+     */
+    char *AllocateStack();
+    void ReleaseStack(char *stack);
+
+    /**
+     * Size of coroutine stack, not counting guard page
+     */
+    const std::size_t stack_size;
+    const std::size_t page_size;
+
+    /**
+     * Called by scheduler once every routine is blocked
+     */
+    std::function<void()> idle_hook;
+
+    /**
+     * Stacks of finished coroutines
+     */
+    std::vector<char *> free_stacks;
+
+    /**
+     * Current coroutine, nullptr while scheduler is running
+     */
+    context *cur_routine;
+
+    /**
+     * List of routines ready to be scheduled. Note that suspended routine ends up here as well
+     */
+    context *alive;
+
+    /**
+     * List of routines waiting for somebody to unblock them
+     */
+    context *blocked;
+
+    /**
+     * Context to be returned finally: thread stack start was called on, where scheduler runs
+     */
+    context *idle_ctx;
+
+    /**
+     * Coroutine that has just finished, scheduler releases it
+     */
+    context *finished;
+
+    /**
+     * The first exception escaped coroutine
+     */
+    std::exception_ptr error;
 };
 
 } // namespace Coroutine
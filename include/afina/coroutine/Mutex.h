@@ -0,0 +1,86 @@
+#ifndef AFINA_COROUTINE_MUTEX_H
+#define AFINA_COROUTINE_MUTEX_H
+
+#include <afina/coroutine/Engine.h>
+#include <afina/coroutine/WaitList.h>
+
+namespace Afina {
+namespace Coroutine {
+
+/**
+ * # Coroutine mutex
+ * Routine that finds mutex locked blocks in the engine until owner unlocks it, other routines run
+ * meanwhile. Unlock passes ownership to the routine waiting longest, so a routine releasing and
+ * taking mutex in a loop can't starve others. Works with std::lock_guard and std::unique_lock.
+ *
+ * Serializes routines of one engine only, it has nothing to do with threads
+ */
+class Mutex {
+public:
+    explicit Mutex(Engine &engine) : _waiters(engine), _owner(nullptr) {}
+
+    Mutex(const Mutex &) = delete;
+    Mutex &operator=(const Mutex &) = delete;
+
+    /**
+     * Locks mutex, blocks current routine while mutex is owned by another one. Throws
+     * std::logic_error if called outside of routine or current routine owns mutex already
+     */
+    void lock();
+
+    /**
+     * Locks mutex if it is free, never blocks. Throws std::logic_error if called outside of routine
+     */
+    bool try_lock();
+
+    /**
+     * Unlocks mutex owned by the current routine, throws std::logic_error otherwise
+     */
+    void unlock();
+
+private:
+    WaitList _waiters;
+
+    // Routine holding mutex, nullptr if it is free
+    void *_owner;
+};
+
+/**
+ * # Coroutine condition variable
+ * Routine waiting for condition is blocked in the engine until notified. There are no spurious
+ * wakeups, still condition could change between notify and the moment waiter gets mutex back, so
+ * checking it in a loop (or using predicate overload) is the way to go
+ */
+class ConditionVariable {
+public:
+    explicit ConditionVariable(Engine &engine) : _waiters(engine) {}
+
+    ConditionVariable(const ConditionVariable &) = delete;
+    ConditionVariable &operator=(const ConditionVariable &) = delete;
+
+    /**
+     * Unlocks mutex, blocks until notified and locks mutex back
+     */
+    void wait(Mutex &mutex);
+
+    /**
+     * Waits until predicate holds
+     */
+    template <typename Predicate> void wait(Mutex &mutex, Predicate pred) {
+        while (!pred()) {
+            wait(mutex);
+        }
+    }
+
+    void notify_one() { _waiters.notify_one(); }
+
+    void notify_all() { _waiters.notify_all(); }
+
+private:
+    WaitList _waiters;
+};
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_MUTEX_H
@@ -0,0 +1,113 @@
+#ifndef AFINA_COROUTINE_POLLER_H
+#define AFINA_COROUTINE_POLLER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <afina/coroutine/Engine.h>
+
+namespace Afina {
+namespace Coroutine {
+
+/**
+ * # Event loop of the engine
+ * Lets routines sleep and wait for descriptors to get ready. Poller becomes idle hook of the engine:
+ * once all routines are blocked it does epoll_wait until the nearest deadline and unblocks routines
+ * whose descriptors got ready or whose time has come. Deadlines are kept in a binary heap, so a
+ * wait costs O(log n) regardless of timeout value.
+ *
+ * Descriptor is in epoll only while somebody waits for it, several routines could wait for the same
+ * descriptor, e.g one reads while the other writes. If all routines are blocked and there is nothing
+ * to wait for poller throws std::runtime_error out of engine start as it is a deadlock.
+ *
+ * Poller must outlive engine start, as everything in engine it is not threadsafe
+ */
+class Poller {
+public:
+    /**
+     * Installs poller as idle hook of the engine
+     */
+    explicit Poller(Engine &engine);
+    ~Poller();
+
+    Poller(const Poller &) = delete;
+    Poller &operator=(const Poller &) = delete;
+
+    /**
+     * Blocks current routine for at least given number of milliseconds
+     */
+    void sleep(uint32_t timeout_ms);
+
+    /**
+     * Blocks current routine until descriptor gets one of events (EPOLLIN, EPOLLOUT, ...) or timeout
+     * expires, negative timeout waits forever. Returns events reported by epoll, EPOLLERR and EPOLLHUP
+     * are reported always, 0 means timeout. Throws std::runtime_error if descriptor can't be polled
+     */
+    uint32_t wait(int fd, uint32_t events, int timeout_ms = -1);
+
+    /**
+     * Waits for events once and unblocks routines, that is what engine calls once it is idle
+     */
+    void poll();
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t kNotScheduled = static_cast<std::size_t>(-1);
+
+    /**
+     * Routine sleeping until deadline, position in the heap is kept to cancel it
+     */
+    struct Timer {
+        clock::time_point deadline;
+        void *routine = nullptr;
+        std::size_t index = kNotScheduled;
+    };
+
+    /**
+     * Routine waiting for a descriptor, waiters of the same descriptor are linked together
+     */
+    struct Waiter {
+        int fd;
+        uint32_t events;
+        uint32_t revents = 0;
+        void *routine = nullptr;
+        Waiter *prev = nullptr;
+        Waiter *next = nullptr;
+        bool linked = false;
+    };
+
+    void Schedule(Timer &timer);
+    void Cancel(Timer &timer);
+    void SiftUp(std::size_t index);
+    void SiftDown(std::size_t index);
+    void Swap(std::size_t a, std::size_t b);
+
+    /**
+     * Adds waiter to the list of its descriptor and updates epoll interest accordingly
+     */
+    void Watch(Waiter &waiter);
+    void Unwatch(Waiter &waiter);
+
+    /**
+     * Events all waiters of the list are interested in
+     */
+    static uint32_t Interest(const Waiter *head);
+
+    Engine &_engine;
+    int _epoll_fd;
+
+    // Timers ordered by deadline, the nearest one is the first
+    std::vector<Timer *> _heap;
+
+    // Waiters by descriptor
+    std::unordered_map<int, Waiter *> _waiters;
+};
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_POLLER_H
@@ -0,0 +1,88 @@
+#ifndef AFINA_COROUTINE_WAIT_LIST_H
+#define AFINA_COROUTINE_WAIT_LIST_H
+
+#include <stdexcept>
+
+#include <afina/coroutine/Engine.h>
+
+namespace Afina {
+namespace Coroutine {
+
+/**
+ * # Routines blocked on something
+ * FIFO of routines waiting for some condition, the building block of coroutine synchronization
+ * primitives. Routine blocks in wait until somebody notifies it. Nodes live on stacks of waiting
+ * routines, so list never allocates.
+ *
+ * As everything in engine list is not threadsafe, all routines using it must run on the same engine
+ */
+class WaitList {
+public:
+    explicit WaitList(Engine &engine) : _engine(engine), _head(nullptr), _tail(nullptr) {}
+
+    WaitList(const WaitList &) = delete;
+    WaitList &operator=(const WaitList &) = delete;
+
+    /**
+     * Blocks current routine until it is notified. Throws std::logic_error if called outside of routine
+     */
+    void wait() {
+        void *self = _engine.current();
+        if (self == nullptr) {
+            throw std::logic_error("Only routine could wait");
+        }
+
+        Node node{self, nullptr};
+        if (_tail != nullptr) {
+            _tail->next = &node;
+        } else {
+            _head = &node;
+        }
+        _tail = &node;
+        _engine.block();
+    }
+
+    /**
+     * Makes the routine waiting longest ready to run. Returns that routine, nullptr if nobody waits
+     */
+    void *notify_one() {
+        Node *node = _head;
+        if (node == nullptr) {
+            return nullptr;
+        }
+
+        _head = node->next;
+        if (_head == nullptr) {
+            _tail = nullptr;
+        }
+        _engine.unblock(node->routine);
+        return node->routine;
+    }
+
+    /**
+     * Makes all waiting routines ready to run
+     */
+    void notify_all() {
+        while (notify_one() != nullptr) {
+        }
+    }
+
+    bool empty() const { return _head == nullptr; }
+
+    Engine &engine() const { return _engine; }
+
+private:
+    struct Node {
+        void *routine;
+        Node *next;
+    };
+
+    Engine &_engine;
+    Node *_head;
+    Node *_tail;
+};
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_WAIT_LIST_H
@@ -8,6 +8,11 @@
 namespace Afina {
 namespace Execute {
 
+/**
+ * # Report server statistics
+ * Prints every gauge registered in Afina::Metrics as "STAT <name> <value>"
+ * line, response is terminated by "END"
+ */
 class Stats : public Command {
 public:
     Stats() {}
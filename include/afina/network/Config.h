@@ -0,0 +1,108 @@
+#ifndef AFINA_NETWORK_CONFIG_H
+#define AFINA_NETWORK_CONFIG_H
+
+#include <cstdint>
+#include <string>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Network layer settings
+ * Shared by all server implementations, each one applies settings it supports
+ */
+class Config {
+public:
+    /*
+     * TCP port to listen on, 0 disables TCP
+     */
+    uint16_t port = 8080;
+
+    /*
+     * UDP port to serve get requests on using memcached UDP framing, 0 disables UDP
+     */
+    uint16_t udp_port = 0;
+
+    /*
+     * Path of unix socket to listen on besides TCP port, empty to disable. Setting port to 0 leaves
+     * unix socket only
+     */
+    std::string unix_socket;
+
+    /*
+     * Permissions of unix socket file
+     */
+    uint32_t unix_mode = 0700;
+
+    /*
+     * Length of the queue of connections waiting to be accepted, kernel caps it by net.core.somaxconn
+     */
+    int backlog = 1024;
+
+    /*
+     * Threads accepting new connections, for servers that have dedicated acceptors
+     */
+    uint32_t acceptors = 2;
+
+    /*
+     * Threads serving connections. For thread per connection servers that is maximum number of
+     * clients served at once
+     */
+    uint32_t workers = 2;
+
+    /*
+     * Threads executing commands for mt_nonblock server, so that slow command doesn't stall other
+     * connections served by the same I/O thread. 0 executes commands right on I/O threads
+     */
+    uint32_t executor_threads = 0;
+
+    /*
+     * Pin workers to NUMA nodes round robin, so that worker runs on cpus of one node and takes memory
+     * from it. Applies to servers with a fixed set of worker threads
+     */
+    bool numa = false;
+
+    /*
+     * Send responses right away rather than wait to coalesce them with following ones
+     */
+    bool tcp_nodelay = false;
+
+    /*
+     * Seconds kernel waits for the first data on a new connection before server gets it on accept,
+     * so connections that don't send anything never wake server up. 0 disables
+     */
+    uint32_t defer_accept = 0;
+
+    /*
+     * Socket receive/send buffer sizes in bytes, 0 leaves system defaults
+     */
+    uint32_t rcvbuf = 0;
+    uint32_t sndbuf = 0;
+
+    /*
+     * Microseconds to busy poll device queue on blocking reads instead of sleeping, 0 disables.
+     * Values above net.core.busy_read require CAP_NET_ADMIN
+     */
+    uint32_t busy_poll = 0;
+
+    /*
+     * Milliseconds client has to complete command once it started to send it. In blocking servers
+     * that is maximum time single read could wait for data. 0 disables timeout
+     */
+    uint32_t read_timeout = 5000;
+
+    /*
+     * Milliseconds connection could stay without any command in progress. 0 disables timeout
+     */
+    uint32_t idle_timeout = 0;
+
+    /*
+     * Milliseconds client has to read next part of responses once it is ready. 0 disables timeout
+     */
+    uint32_t write_timeout = 0;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_CONFIG_H
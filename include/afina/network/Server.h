@@ -4,6 +4,8 @@
 #include <memory>
 #include <vector>
 
+#include <afina/network/Config.h>
+
 namespace Afina {
 class Storage;
 namespace Logging {
@@ -17,8 +19,9 @@ namespace Network {
  */
 class Server {
 public:
-    Server(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
-        : pStorage(ps), pLogging(pl) {}
+    Server(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+           const Config &cfg = Config())
+        : pStorage(ps), pLogging(pl), config(cfg) {}
     virtual ~Server() {}
 
     /**
@@ -55,6 +58,11 @@ protected:
      * Logging service to be used in order to report application progress
      */
     std::shared_ptr<Afina::Logging::Service> pLogging;
+
+    /**
+     * Settings server should apply to sockets and connections
+     */
+    Config config;
 };
 
 } // namespace Network
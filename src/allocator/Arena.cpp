@@ -0,0 +1,81 @@
+#include <afina/allocator/Arena.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Allocator {
+
+// See Arena.h
+Arena::Arena(std::size_t size, std::size_t slab_size)
+    : _slab_size(slab_size), _bump(0), _free(0), _used(0) {
+    std::size_t page = sysconf(_SC_PAGESIZE);
+    if (slab_size < page || (slab_size & (slab_size - 1)) != 0) {
+        throw std::runtime_error("Slab size must be a power of two not less than page");
+    }
+
+    _slabs = size / slab_size;
+    if (_slabs > UINT32_MAX - 1) {
+        throw std::runtime_error("Arena is too large for its slab size");
+    }
+
+    // One extra slab to align the first one
+    _mapping_size = (_slabs + 1) * slab_size;
+    _mapping = mmap(nullptr, _mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (_mapping == MAP_FAILED) {
+        throw std::runtime_error("Failed to map arena: " + std::string(strerror(errno)));
+    }
+    _begin = reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(_mapping) + slab_size - 1) & ~(slab_size - 1));
+}
+
+// See Arena.h
+Arena::~Arena() { munmap(_mapping, _mapping_size); }
+
+// See Arena.h
+void *Arena::map() {
+    uint64_t head = _free.load(std::memory_order_acquire);
+    while (static_cast<uint32_t>(head) != 0) {
+        char *slab = Slab(static_cast<uint32_t>(head) - 1);
+
+        // Slab could be popped and reused by somebody else meanwhile, then value read is garbage, but
+        // tag has changed as well so CAS fails
+        uint32_t next = reinterpret_cast<std::atomic<uint32_t> *>(slab)->load(std::memory_order_relaxed);
+        uint64_t tag = (head >> 32) + 1;
+        if (_free.compare_exchange_weak(head, (tag << 32) | next, std::memory_order_acquire,
+                                        std::memory_order_acquire)) {
+            _used.fetch_add(1, std::memory_order_relaxed);
+            return slab;
+        }
+    }
+
+    uint32_t index = _bump.load(std::memory_order_relaxed);
+    do {
+        if (index >= _slabs) {
+            return nullptr;
+        }
+    } while (!_bump.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+
+    _used.fetch_add(1, std::memory_order_relaxed);
+    return Slab(index);
+}
+
+// See Arena.h
+void Arena::unmap(void *slab) {
+    uint32_t index = (static_cast<char *>(slab) - _begin) / _slab_size;
+    auto &next = *reinterpret_cast<std::atomic<uint32_t> *>(slab);
+
+    uint64_t head = _free.load(std::memory_order_relaxed);
+    do {
+        next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+    } while (!_free.compare_exchange_weak(head, (head & ~uint64_t(UINT32_MAX)) | (index + 1),
+                                          std::memory_order_release, std::memory_order_relaxed));
+    _used.fetch_sub(1, std::memory_order_relaxed);
+}
+
+} // namespace Allocator
+} // namespace Afina
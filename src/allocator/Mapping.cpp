@@ -0,0 +1,153 @@
+#include <afina/allocator/Mapping.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <afina/allocator/Numa.h>
+
+namespace Afina {
+namespace Allocator {
+
+// Huge page size on x86-64, transparent huge pages are always of that size
+static constexpr std::size_t kHugePageSize = 2 * 1024 * 1024;
+
+// Shared areas are placed from here on: far above heap and far below where kernel maps libraries and
+// anonymous memory
+static constexpr uintptr_t kSharedBase = uintptr_t(0x200000000000);
+
+// See Mapping.h
+Mapping::Mapping(std::size_t size, unsigned flags, int node) : _hugetlb(false), _fd(-1) {
+    bool huge = (flags & kHugePages) != 0;
+    bool shared = (flags & kShared) != 0;
+
+    // Pages must be committed after policy is set, otherwise they are taken as regular ones from
+    // the node of the current thread
+    bool late_populate = (flags & kPopulate) != 0 && ((huge && !shared) || node >= 0);
+    int mmap_flags = shared ? MAP_SHARED : MAP_PRIVATE | MAP_ANONYMOUS;
+    if ((flags & kPopulate) != 0 && !late_populate) {
+        mmap_flags |= MAP_POPULATE;
+    }
+
+    _size = size;
+    if (huge) {
+        _size = (size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    }
+    _mapping_size = _size;
+    _mapping = MAP_FAILED;
+    void *hint = nullptr;
+
+    if (shared) {
+        // Reserved huge pages back the file if there are any, transparent ones are up to shmem_enabled
+        if (huge) {
+            _fd = memfd_create("afina", MFD_CLOEXEC | MFD_HUGETLB);
+            _hugetlb = _fd >= 0 && ftruncate(_fd, _size) == 0;
+            if (_fd >= 0 && !_hugetlb) {
+                close(_fd);
+                _fd = -1;
+            }
+        }
+        if (_fd < 0) {
+            _fd = memfd_create("afina", MFD_CLOEXEC);
+            if (_fd < 0 || ftruncate(_fd, _size) != 0) {
+                int err = errno;
+                if (_fd >= 0) {
+                    close(_fd);
+                }
+                throw std::runtime_error("Failed to create memory file: " + std::string(strerror(err)));
+            }
+        }
+        hint = reinterpret_cast<void *>(kSharedBase);
+    } else if (huge) {
+        _mapping = mmap(nullptr, _size, PROT_READ | PROT_WRITE, mmap_flags | MAP_HUGETLB, -1, 0);
+        _hugetlb = _mapping != MAP_FAILED;
+
+        // No reserved huge pages: transparent ones need area aligned to huge page
+        if (!_hugetlb) {
+            _mapping_size = _size + kHugePageSize;
+        }
+    }
+
+    if (_mapping == MAP_FAILED) {
+        _mapping = mmap(hint, _mapping_size, PROT_READ | PROT_WRITE, mmap_flags, _fd, 0);
+        if (_mapping == MAP_FAILED) {
+            int err = errno;
+            if (_fd >= 0) {
+                close(_fd);
+            }
+            throw std::runtime_error("Failed to map " + std::to_string(_size) + " bytes: " + strerror(err));
+        }
+    }
+
+    // Shared area is aligned by the hint, file offsets of huge pages must match addresses anyway
+    _data = _mapping;
+    if (huge && !_hugetlb) {
+        if (!shared) {
+            uintptr_t aligned = (reinterpret_cast<uintptr_t>(_mapping) + kHugePageSize - 1) & ~(kHugePageSize - 1);
+            _data = reinterpret_cast<void *>(aligned);
+        }
+
+        // Not an error if kernel has no THP support, area is still usable
+        madvise(_data, _size, MADV_HUGEPAGE);
+    }
+
+    if (node >= 0) {
+        try {
+            bind_memory(_mapping, _mapping_size, node);
+        } catch (...) {
+            munmap(_mapping, _mapping_size);
+            if (_fd >= 0) {
+                close(_fd);
+            }
+            throw;
+        }
+    }
+
+    if (late_populate) {
+        for (std::size_t offset = 0; offset < _size; offset += 4096) {
+            static_cast<volatile char *>(_data)[offset] = 0;
+        }
+    }
+}
+
+// See Mapping.h
+Mapping::Mapping(int fd, void *address) : _hugetlb(false), _fd(fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        throw std::runtime_error("Failed to stat memory file: " + std::string(strerror(err)));
+    }
+
+    // Kernels before 4.17 take the address as a hint only, so the result is checked anyway
+    _size = _mapping_size = st.st_size;
+    _mapping = mmap(address, _size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+    if (_mapping != address) {
+        int err = errno;
+        if (_mapping != MAP_FAILED) {
+            munmap(_mapping, _size);
+            err = EEXIST;
+        }
+        close(fd);
+        throw std::runtime_error("Failed to map memory file at " + std::to_string(uintptr_t(address)) + ": " +
+                                 strerror(err));
+    }
+    _data = _mapping;
+}
+
+// See Mapping.h
+Mapping::~Mapping() {
+    munmap(_mapping, _mapping_size);
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+} // namespace Allocator
+} // namespace Afina
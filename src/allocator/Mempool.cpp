@@ -0,0 +1,163 @@
+#include <afina/allocator/Mempool.h>
+
+#include <cstdint>
+#include <stdexcept>
+
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/SlabCache.h>
+
+namespace Afina {
+namespace Allocator {
+
+static constexpr std::size_t kAlign = alignof(std::max_align_t);
+
+static std::size_t round_up(std::size_t size) { return (size + kAlign - 1) & ~(kAlign - 1); }
+
+// See Mempool.h
+Mempool::Mempool(SlabCache &cache, std::size_t object_size)
+    : _cache(cache), _slab_size(cache.arena().slab_size()),
+      _object_size(round_up(object_size < sizeof(void *) ? sizeof(void *) : object_size)),
+      _offset(round_up(sizeof(Slab))), _capacity(_slab_size > _offset ? (_slab_size - _offset) / _object_size : 0),
+      _owner(std::this_thread::get_id()), _head(nullptr), _tail(nullptr), _slabs(0), _used(0), _returned(nullptr) {
+    if (_capacity == 0) {
+        throw std::runtime_error("Object doesn't fit into slab");
+    }
+}
+
+// See Mempool.h
+Mempool::~Mempool() {
+    while (_head != nullptr) {
+        Slab *slab = _head;
+        Unlink(slab);
+        _cache.put(slab);
+    }
+}
+
+// See Mempool.h
+void *Mempool::alloc() {
+    Slab *slab = _head;
+    if (slab == nullptr || slab->used == _capacity) {
+        slab = Refill();
+        if (slab == nullptr) {
+            return nullptr;
+        }
+    }
+
+    void *object;
+    if (slab->free != nullptr) {
+        object = slab->free;
+        slab->free = *static_cast<void **>(object);
+    } else {
+        object = reinterpret_cast<char *>(slab) + _offset + slab->carved * _object_size;
+        slab->carved++;
+    }
+
+    slab->used++;
+    _used++;
+    if (slab->used == _capacity) {
+        // Full slabs go to the end, so that the first one always has free objects if any has
+        Unlink(slab);
+        PushBack(slab);
+    }
+    return object;
+}
+
+// See Mempool.h
+void Mempool::free(void *object) {
+    if (std::this_thread::get_id() == _owner) {
+        Release(object);
+        return;
+    }
+
+    Returned *returned = static_cast<Returned *>(object);
+    returned->next = _returned.load(std::memory_order_relaxed);
+    while (!_returned.compare_exchange_weak(returned->next, returned, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    }
+}
+
+// See Mempool.h
+Mempool::Slab *Mempool::Refill() {
+    // Owner takes the whole stack at once, so there is no ABA problem
+    Returned *returned = _returned.exchange(nullptr, std::memory_order_acquire);
+    while (returned != nullptr) {
+        Returned *next = returned->next;
+        Release(returned);
+        returned = next;
+    }
+    if (_head != nullptr && _head->used < _capacity) {
+        return _head;
+    }
+
+    Slab *slab = static_cast<Slab *>(_cache.get());
+    if (slab == nullptr) {
+        return nullptr;
+    }
+    slab->free = nullptr;
+    slab->used = 0;
+    slab->carved = 0;
+    PushFront(slab);
+    _slabs++;
+    return slab;
+}
+
+// See Mempool.h
+void Mempool::Release(void *object) {
+    Slab *slab = static_cast<Slab *>(_cache.arena().slab_of(object));
+    *static_cast<void **>(object) = slab->free;
+    slab->free = object;
+    _used--;
+
+    if (slab->used-- == _capacity) {
+        Unlink(slab);
+        PushFront(slab);
+    }
+
+    // Empty slab goes back to cache unless it is the only one with free objects
+    if (slab->used == 0 && (slab != _head || (slab->next != nullptr && slab->next->used < _capacity))) {
+        Unlink(slab);
+        _cache.put(slab);
+        _slabs--;
+    }
+}
+
+// See Mempool.h
+void Mempool::PushFront(Slab *slab) {
+    slab->prev = nullptr;
+    slab->next = _head;
+    if (_head != nullptr) {
+        _head->prev = slab;
+    } else {
+        _tail = slab;
+    }
+    _head = slab;
+}
+
+// See Mempool.h
+void Mempool::PushBack(Slab *slab) {
+    slab->next = nullptr;
+    slab->prev = _tail;
+    if (_tail != nullptr) {
+        _tail->next = slab;
+    } else {
+        _head = slab;
+    }
+    _tail = slab;
+}
+
+// See Mempool.h
+void Mempool::Unlink(Slab *slab) {
+    if (slab->prev != nullptr) {
+        slab->prev->next = slab->next;
+    } else {
+        _head = slab->next;
+    }
+    if (slab->next != nullptr) {
+        slab->next->prev = slab->prev;
+    } else {
+        _tail = slab->prev;
+    }
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -0,0 +1,158 @@
+#include <afina/allocator/Numa.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Allocator {
+
+// From linux/mempolicy.h, which isn't always installed
+static constexpr int kMpolPreferred = 1;
+
+// Parses cpu list like "0-3,8,10-11"
+static std::vector<int> parse_cpu_list(const std::string &list) {
+    std::vector<int> cpus;
+    std::istringstream in(list);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+
+        std::size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        } catch (std::exception &) {
+            throw std::runtime_error("Invalid cpu list: " + list);
+        }
+    }
+    return cpus;
+}
+
+// See Numa.h
+const NumaTopology &NumaTopology::System() {
+    static NumaTopology topology("/sys/devices/system/node");
+    return topology;
+}
+
+// See Numa.h
+NumaTopology::NumaTopology(const std::string &root) {
+    DIR *dir = opendir(root.c_str());
+    if (dir != nullptr) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            int node;
+            char tail;
+            if (sscanf(entry->d_name, "node%d%c", &node, &tail) != 1) {
+                continue;
+            }
+
+            std::ifstream file(root + "/" + entry->d_name + "/cpulist");
+            std::string list;
+            if (!std::getline(file, list)) {
+                continue;
+            }
+            std::vector<int> cpus = parse_cpu_list(list);
+            if (!cpus.empty()) {
+                _cpus[node] = std::move(cpus);
+            }
+        }
+        closedir(dir);
+    }
+
+    if (_cpus.empty()) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        for (int cpu = 0; cpu < online; cpu++) {
+            _cpus[0].push_back(cpu);
+        }
+    }
+
+    for (auto &node : _cpus) {
+        _nodes.push_back(node.first);
+    }
+}
+
+// See Numa.h
+const std::vector<int> &NumaTopology::cpus(int node) const {
+    static const std::vector<int> none;
+    auto it = _cpus.find(node);
+    return it == _cpus.end() ? none : it->second;
+}
+
+// See Numa.h
+int NumaTopology::node_of(int cpu) const {
+    for (auto &node : _cpus) {
+        for (int c : node.second) {
+            if (c == cpu) {
+                return node.first;
+            }
+        }
+    }
+    return -1;
+}
+
+// See Numa.h
+int current_numa_node() {
+    unsigned cpu, node;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+        return 0;
+    }
+    return node;
+}
+
+// See Numa.h
+void bind_memory(void *area, std::size_t size, int node) {
+    // Mask must cover the node, kernel looks at maxnode - 1 bits of it
+    std::vector<unsigned long> mask(node / (8 * sizeof(unsigned long)) + 1, 0);
+    mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+    unsigned long maxnode = mask.size() * 8 * sizeof(unsigned long) + 1;
+
+    // Preferred rather than strict binding: once node runs out of memory pages come from other nodes
+    // instead of OOM killer
+    if (syscall(SYS_mbind, area, size, kMpolPreferred, mask.data(), maxnode, 0) != 0) {
+        throw std::runtime_error("Failed to bind memory to node " + std::to_string(node) + ": " + strerror(errno));
+    }
+}
+
+// See Numa.h
+void pin_thread(int node) {
+    const std::vector<int> &cpus = NumaTopology::System().cpus(node);
+    if (cpus.empty()) {
+        throw std::runtime_error("No cpus on node " + std::to_string(node));
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        throw std::runtime_error("Failed to pin thread to node " + std::to_string(node) + ": " + strerror(err));
+    }
+}
+
+// See Numa.h
+int pin_thread_round_robin(std::size_t i) {
+    const std::vector<int> &nodes = NumaTopology::System().nodes();
+    int node = nodes[i % nodes.size()];
+    pin_thread(node);
+    return node;
+}
+
+} // namespace Allocator
+} // namespace Afina
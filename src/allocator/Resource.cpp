@@ -0,0 +1,77 @@
+#include <afina/allocator/Resource.h>
+
+#include <new>
+
+namespace Afina {
+namespace Allocator {
+
+namespace {
+
+class NewDeleteResource final : public MemoryResource {
+protected:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (alignment > alignof(std::max_align_t)) {
+            throw std::bad_alloc();
+        }
+        return ::operator new(bytes);
+    }
+
+    void do_deallocate(void *p, std::size_t, std::size_t) override { ::operator delete(p); }
+
+    // All instances share the same heap
+    bool do_is_equal(const MemoryResource &other) const noexcept override {
+        return dynamic_cast<const NewDeleteResource *>(&other) != nullptr;
+    }
+};
+
+} // namespace
+
+// See Resource.h
+MemoryResource *new_delete_resource() noexcept {
+    static NewDeleteResource resource;
+    return &resource;
+}
+
+// See Resource.h
+SlabResource::SlabResource(void *base, std::size_t size, std::size_t page_size, MemoryResource *upstream)
+    : _slab(base, size, page_size, alignof(std::max_align_t)), _upstream(upstream), _used(0) {}
+
+// See Resource.h
+void *SlabResource::allocate(std::size_t bytes, std::size_t alignment) {
+    if (alignment > alignof(std::max_align_t)) {
+        throw std::bad_alloc();
+    }
+
+    std::size_t largest = _slab.chunk_size(_slab.classes() - 1);
+    if (bytes > largest) {
+        if (_upstream == nullptr) {
+            throw std::bad_alloc();
+        }
+        void *p = _upstream->allocate(bytes, alignment);
+        _used += bytes;
+        return p;
+    }
+
+    unsigned cls = _slab.class_of(bytes == 0 ? 1 : bytes);
+    void *p = _slab.alloc(cls);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    _used += _slab.chunk_size(cls);
+    return p;
+}
+
+// See Resource.h
+void SlabResource::deallocate(void *p, std::size_t bytes, std::size_t alignment) {
+    if (bytes > _slab.chunk_size(_slab.classes() - 1)) {
+        _upstream->deallocate(p, bytes, alignment);
+        _used -= bytes;
+        return;
+    }
+
+    _used -= _slab.chunk_size(_slab.class_of(p));
+    _slab.free(p);
+}
+
+} // namespace Allocator
+} // namespace Afina
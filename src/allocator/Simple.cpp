@@ -1,40 +1,302 @@
 #include <afina/allocator/Simple.h>
 
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+#include <afina/allocator/Error.h>
 #include <afina/allocator/Pointer.h>
 
 namespace Afina {
 namespace Allocator {
 
-Simple::Simple(void *base, size_t size) : _base(base), _base_len(size) {}
-
-/**
- * TODO: semantics
- * @param N size_t
- */
-Pointer Simple::alloc(size_t N) { return Pointer(); }
-
-/**
- * TODO: semantics
- * @param p Pointer
- * @param N size_t
- */
-void Simple::realloc(Pointer &p, size_t N) {}
-
-/**
- * TODO: semantics
- * @param p Pointer
- */
-void Simple::free(Pointer &p) {}
-
-/**
- * TODO: semantics
- */
-void Simple::defrag() {}
-
-/**
- * TODO: semantics
- */
-std::string Simple::dump() const { return ""; }
+// Payload alignment, block header size is a multiple of it
+static constexpr size_t kAlign = alignof(std::max_align_t);
+
+// Free block keeps link to the next one in payload, so payload is never smaller
+static constexpr size_t kMinPayload = kAlign;
+
+// See Simple.h
+struct Simple::Block {
+    // Payload bytes following the header
+    size_t size;
+
+    // Descriptor of the pointer owning block, nullptr for free block
+    void **slot;
+
+    char *payload() { return reinterpret_cast<char *>(this) + sizeof(Block); }
+
+    // Valid for free blocks only
+    Block *&next() { return *reinterpret_cast<Block **>(payload()); }
+};
+
+static size_t round_up(size_t size) { return size < kMinPayload ? kMinPayload : (size + kAlign - 1) & ~(kAlign - 1); }
+
+Simple::Simple(void *base, size_t size) : _base(base), _base_len(size), _free(nullptr), _free_slots(nullptr) {
+    static_assert(sizeof(Block) % kAlign == 0, "Block header breaks payload alignment");
+
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(base) + kAlign - 1) & ~(kAlign - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(base) + size) & ~(alignof(void *) - 1);
+    if (begin > end) {
+        begin = end;
+    }
+
+    _begin = _end = reinterpret_cast<char *>(begin);
+    _table = _table_end = reinterpret_cast<void **>(end);
+}
+
+// See Simple.h
+Pointer Simple::alloc(size_t N) {
+    if (N > _base_len) {
+        throw AllocError(AllocErrorType::NoMemory, "Requested size exceeds the area");
+    }
+
+    void **slot = TakeSlot();
+    if (slot == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No space for pointer descriptor");
+    }
+
+    Block *block = TakeBlock(round_up(N));
+    if (block == nullptr) {
+        ReleaseSlot(slot);
+        throw AllocError(AllocErrorType::NoMemory, "No free block of " + std::to_string(N) + " bytes");
+    }
+
+    block->slot = slot;
+    *slot = block->payload();
+    return Pointer(slot);
+}
+
+// See Simple.h
+void Simple::realloc(Pointer &p, size_t N) {
+    if (p._slot == nullptr) {
+        p = alloc(N);
+        return;
+    }
+    if (N > _base_len) {
+        throw AllocError(AllocErrorType::NoMemory, "Requested size exceeds the area");
+    }
+
+    Block *block = Resolve(p);
+    size_t size = round_up(N);
+    if (size <= block->size) {
+        Trim(block, size);
+        return;
+    }
+
+    // Grow in place: either into unused space or into the free block next to this one
+    Block *next = Next(block);
+    if (reinterpret_cast<char *>(next) == _end) {
+        if (static_cast<size_t>(reinterpret_cast<char *>(_table) - block->payload()) >= size) {
+            block->size = size;
+            _end = block->payload() + size;
+            return;
+        }
+    } else if (next->slot == nullptr && block->size + sizeof(Block) + next->size >= size) {
+        Block *prev = nullptr;
+        for (Block *b = _free; b != next; b = b->next()) {
+            prev = b;
+        }
+        Unlink(next, prev);
+        block->size += sizeof(Block) + next->size;
+        Trim(block, size);
+        return;
+    }
+
+    // Move content elsewhere, descriptor stays the same
+    Block *moved = TakeBlock(size);
+    if (moved == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No free block of " + std::to_string(N) + " bytes");
+    }
+    std::memcpy(moved->payload(), block->payload(), block->size);
+    moved->slot = block->slot;
+    *moved->slot = moved->payload();
+    Release(block);
+}
+
+// See Simple.h
+void Simple::free(Pointer &p) {
+    if (p._slot == nullptr) {
+        return;
+    }
+
+    Block *block = Resolve(p);
+    ReleaseSlot(block->slot);
+    Release(block);
+    p._slot = nullptr;
+}
+
+// See Simple.h
+void Simple::defrag() {
+    char *dst = _begin;
+    for (char *src = _begin; src < _end;) {
+        Block *block = reinterpret_cast<Block *>(src);
+        size_t total = sizeof(Block) + block->size;
+        if (block->slot != nullptr) {
+            if (src != dst) {
+                std::memmove(dst, src, total);
+                block = reinterpret_cast<Block *>(dst);
+                *block->slot = block->payload();
+            }
+            dst += total;
+        }
+        src += total;
+    }
+
+    _end = dst;
+    _free = nullptr;
+}
+
+// See Simple.h
+std::string Simple::dump() const {
+    std::ostringstream out;
+    for (char *at = _begin; at < _end;) {
+        Block *block = reinterpret_cast<Block *>(at);
+        out << (block->slot != nullptr ? "used " : "free ") << block->size << " @" << (at - _begin) << "\n";
+        at = block->payload() + block->size;
+    }
+    out << "unused " << (reinterpret_cast<char *>(_table) - _end) << " @" << (_end - _begin) << "\n";
+    out << "descriptors " << (_table_end - _table) << "\n";
+    return out.str();
+}
+
+// See Simple.h
+void **Simple::TakeSlot() {
+    if (_free_slots != nullptr) {
+        void **slot = _free_slots;
+        _free_slots = reinterpret_cast<void **>(reinterpret_cast<uintptr_t>(*slot) & ~uintptr_t(1));
+        return slot;
+    }
+
+    if (reinterpret_cast<char *>(_table) - _end < static_cast<ptrdiff_t>(sizeof(void *))) {
+        return nullptr;
+    }
+    return --_table;
+}
+
+// See Simple.h
+void Simple::ReleaseSlot(void **slot) {
+    // Payloads are aligned, so the tag tells released descriptor from a live one
+    *slot = reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(_free_slots) | 1);
+    _free_slots = slot;
+}
+
+// See Simple.h
+Simple::Block *Simple::TakeBlock(size_t size) {
+    Block *best = nullptr, *best_prev = nullptr;
+    for (Block *b = _free, *prev = nullptr; b != nullptr; prev = b, b = b->next()) {
+        if (b->size >= size && (best == nullptr || b->size < best->size)) {
+            best = b;
+            best_prev = prev;
+            if (b->size == size) {
+                break;
+            }
+        }
+    }
+
+    if (best != nullptr) {
+        Unlink(best, best_prev);
+        best->slot = nullptr;
+        Trim(best, size);
+        return best;
+    }
+
+    if (static_cast<size_t>(reinterpret_cast<char *>(_table) - _end) < sizeof(Block) + size) {
+        return nullptr;
+    }
+    Block *block = reinterpret_cast<Block *>(_end);
+    block->size = size;
+    block->slot = nullptr;
+    _end = block->payload() + size;
+    return block;
+}
+
+// See Simple.h
+void Simple::Trim(Block *block, size_t size) {
+    if (block->size < size + sizeof(Block) + kMinPayload) {
+        return;
+    }
+
+    Block *rest = reinterpret_cast<Block *>(block->payload() + size);
+    rest->size = block->size - size - sizeof(Block);
+    block->size = size;
+    Release(rest);
+}
+
+// See Simple.h
+void Simple::Release(Block *block) {
+    block->slot = nullptr;
+
+    // Neighbours in the free list
+    Block *prev = nullptr, *next = _free;
+    while (next != nullptr && next < block) {
+        prev = next;
+        next = next->next();
+    }
+
+    // The last block goes back to unused space together with free block before it
+    if (reinterpret_cast<char *>(Next(block)) == _end) {
+        _end = reinterpret_cast<char *>(block);
+        if (prev != nullptr && Next(prev) == block) {
+            Block *prev_prev = nullptr;
+            for (Block *b = _free; b != prev; b = b->next()) {
+                prev_prev = b;
+            }
+            Unlink(prev, prev_prev);
+            _end = reinterpret_cast<char *>(prev);
+        }
+        return;
+    }
+
+    block->next() = next;
+    if (prev != nullptr) {
+        prev->next() = block;
+    } else {
+        _free = block;
+    }
+
+    if (next != nullptr && Next(block) == next) {
+        block->size += sizeof(Block) + next->size;
+        block->next() = next->next();
+    }
+    if (prev != nullptr && Next(prev) == block) {
+        prev->size += sizeof(Block) + block->size;
+        prev->next() = block->next();
+    }
+}
+
+// See Simple.h
+void Simple::Unlink(Block *block, Block *prev) {
+    if (prev != nullptr) {
+        prev->next() = block->next();
+    } else {
+        _free = block->next();
+    }
+}
+
+// See Simple.h
+Simple::Block *Simple::Resolve(const Pointer &p) const {
+    void **slot = p._slot;
+    uintptr_t at = reinterpret_cast<uintptr_t>(slot);
+    if (at < reinterpret_cast<uintptr_t>(_table) || at >= reinterpret_cast<uintptr_t>(_table_end) ||
+        at % sizeof(void *) != 0) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer doesn't belong to the allocator");
+    }
+
+    char *payload = static_cast<char *>(*slot);
+    if ((reinterpret_cast<uintptr_t>(payload) & 1) != 0 || payload < _begin + sizeof(Block) || payload >= _end) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer has been freed already");
+    }
+
+    Block *block = reinterpret_cast<Block *>(payload - sizeof(Block));
+    if (block->slot != slot) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer has been freed already");
+    }
+    return block;
+}
+
+// See Simple.h
+Simple::Block *Simple::Next(Block *block) const { return reinterpret_cast<Block *>(block->payload() + block->size); }
 
 } // namespace Allocator
 } // namespace Afina
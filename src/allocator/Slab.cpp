@@ -0,0 +1,244 @@
+#include <afina/allocator/Slab.h>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Allocator {
+
+// Chunk alignment, chunk sizes are multiples of it
+static constexpr std::size_t kAlign = alignof(std::max_align_t);
+
+static std::size_t round_up(std::size_t size) { return (size + kAlign - 1) & ~(kAlign - 1); }
+
+// Marks area with embedded allocator state
+static constexpr uint64_t kMagic = 0x31424C53414E4641ULL;
+
+// See Slab.h
+Slab::Slab(void *base, std::size_t size, std::size_t page_size, std::size_t min_chunk, double factor) {
+    Init(base, size, page_size, min_chunk, factor, false);
+}
+
+// See Slab.h
+Slab Slab::Embedded(void *base, std::size_t size, std::size_t page_size, std::size_t min_chunk, double factor) {
+    Slab slab;
+    slab.Init(base, size, page_size, min_chunk, factor, true);
+    return slab;
+}
+
+// See Slab.h
+Slab Slab::Attach(void *base, std::size_t size) {
+    Slab slab;
+    slab._header = reinterpret_cast<Header *>(round_up(reinterpret_cast<uintptr_t>(base)));
+    if (size < sizeof(Header) + kAlign || slab._header->magic != kMagic || slab._header->size != size) {
+        throw std::runtime_error("Area has no slab allocator state");
+    }
+    slab.Locate(static_cast<char *>(base));
+    return slab;
+}
+
+// See Slab.h
+void Slab::Init(void *base, std::size_t size, std::size_t page_size, std::size_t min_chunk, double factor,
+                bool embedded) {
+    page_size = round_up(page_size);
+    min_chunk = std::max(round_up(min_chunk), round_up(sizeof(Chunk)));
+    if (factor <= 1.0 || page_size < min_chunk) {
+        throw std::runtime_error("Invalid slab geometry");
+    }
+
+    // Classes up to half of the page, the last one is the whole page
+    std::vector<std::size_t> sizes;
+    for (std::size_t chunk = min_chunk; chunk <= page_size / 2;) {
+        sizes.push_back(chunk);
+        chunk = std::max(round_up(static_cast<std::size_t>(chunk * factor)), chunk + kAlign);
+    }
+    sizes.push_back(page_size);
+
+    std::size_t bitmap_words = (page_size / min_chunk + 63) / 64;
+    std::size_t fixed = round_up(sizeof(Header)) + round_up(sizes.size() * sizeof(Class));
+    std::size_t per_page = sizeof(Page) + sizeof(std::size_t) + bitmap_words * sizeof(uint64_t);
+
+    uintptr_t begin = round_up(reinterpret_cast<uintptr_t>(base));
+    uintptr_t end = reinterpret_cast<uintptr_t>(base) + size;
+    std::size_t available = begin < end ? end - begin : 0;
+    std::size_t pages;
+    char *state;
+    if (embedded) {
+        pages = available > fixed + kAlign ? (available - fixed - kAlign) / (page_size + per_page) : 0;
+        state = reinterpret_cast<char *>(begin);
+        begin += round_up(fixed + pages * per_page);
+    } else {
+        pages = available / page_size;
+        _heap.reset(new char[fixed + pages * per_page + kAlign]);
+        state = reinterpret_cast<char *>(round_up(reinterpret_cast<uintptr_t>(_heap.get())));
+    }
+
+    _header = reinterpret_cast<Header *>(state);
+    *_header = Header{kMagic, size, page_size, pages, bitmap_words, static_cast<unsigned>(sizes.size()), pages,
+                      begin - reinterpret_cast<uintptr_t>(base)};
+    Locate(static_cast<char *>(base));
+
+    for (unsigned i = 0; i < sizes.size(); i++) {
+        _classes[i] = Class{sizes[i], nullptr, 0, 0};
+    }
+    for (std::size_t i = 0; i < pages; i++) {
+        _pages[i] = Page{classes(), 0};
+        _spare[i] = pages - 1 - i;
+    }
+    std::fill(_bitmap, _bitmap + pages * bitmap_words, 0);
+}
+
+// See Slab.h
+void Slab::Locate(char *base) {
+    char *p = reinterpret_cast<char *>(_header) + round_up(sizeof(Header));
+    _classes = reinterpret_cast<Class *>(p);
+    p += round_up(_header->classes * sizeof(Class));
+    _pages = reinterpret_cast<Page *>(p);
+    p += _header->pages * sizeof(Page);
+    _spare = reinterpret_cast<std::size_t *>(p);
+    p += _header->pages * sizeof(std::size_t);
+    _bitmap = reinterpret_cast<uint64_t *>(p);
+    _begin = base + _header->begin;
+}
+
+// See Slab.h
+unsigned Slab::class_of(std::size_t size) const {
+    if (size > _header->page_size) {
+        throw AllocError(AllocErrorType::NoMemory, "Requested size exceeds the page");
+    }
+
+    Class *it = std::lower_bound(_classes, _classes + classes(), size,
+                                 [](const Class &c, std::size_t size) { return c.size < size; });
+    return it - _classes;
+}
+
+// See Slab.h
+void *Slab::alloc(unsigned cls) {
+    Class &c = _classes[cls];
+    if (c.free == nullptr) {
+        if (_header->spare == 0) {
+            return nullptr;
+        }
+        _header->spare--;
+        Split(_spare[_header->spare], cls);
+    }
+
+    Chunk *chunk = c.free;
+    Unlink(c, chunk);
+
+    std::size_t offset = reinterpret_cast<char *>(chunk) - _begin;
+    std::size_t page = offset / _header->page_size;
+    std::size_t index = offset % _header->page_size / c.size;
+    _bitmap[page * _header->bitmap_words + index / 64] |= uint64_t(1) << (index % 64);
+    _pages[page].used++;
+    c.used++;
+    return chunk;
+}
+
+// See Slab.h
+void Slab::free(void *p) {
+    char *chunk = static_cast<char *>(p);
+    if (chunk < _begin || chunk >= _begin + _header->pages * _header->page_size) {
+        throw AllocError(AllocErrorType::InvalidFree, "Chunk doesn't belong to the slab");
+    }
+
+    std::size_t offset = chunk - _begin;
+    std::size_t page = offset / _header->page_size;
+    if (_pages[page].cls == classes()) {
+        throw AllocError(AllocErrorType::InvalidFree, "Chunk is on a spare page");
+    }
+
+    Class &c = _classes[_pages[page].cls];
+    std::size_t index = offset % _header->page_size / c.size;
+    uint64_t &word = _bitmap[page * _header->bitmap_words + index / 64];
+    uint64_t bit = uint64_t(1) << (index % 64);
+    if (offset % _header->page_size % c.size != 0 || (word & bit) == 0) {
+        throw AllocError(AllocErrorType::InvalidFree, "Chunk isn't allocated");
+    }
+
+    word &= ~bit;
+    _pages[page].used--;
+    c.used--;
+    Push(c, reinterpret_cast<Chunk *>(chunk));
+}
+
+// See Slab.h
+void Slab::reassign(void *p, unsigned cls, const std::function<void(void *)> &evict) {
+    std::size_t page = PageOf(p);
+    Class &from = _classes[_pages[page].cls];
+    char *start = _begin + page * _header->page_size;
+    uint64_t *bitmap = &_bitmap[page * _header->bitmap_words];
+
+    for (std::size_t i = 0; i < _header->page_size / from.size; i++) {
+        char *chunk = start + i * from.size;
+        if ((bitmap[i / 64] & (uint64_t(1) << (i % 64))) != 0) {
+            evict(chunk);
+        } else {
+            Unlink(from, reinterpret_cast<Chunk *>(chunk));
+        }
+    }
+
+    from.used -= _pages[page].used;
+    from.pages--;
+    std::fill(bitmap, bitmap + _header->bitmap_words, 0);
+    Split(page, cls);
+}
+
+// See Slab.h
+std::string Slab::dump() const {
+    std::stringstream out;
+    for (unsigned i = 0; i < classes(); i++) {
+        const Class &c = _classes[i];
+        if (c.pages > 0) {
+            out << "class " << i << ": chunk " << c.size << ", pages " << c.pages << ", used " << c.used << "/"
+                << c.pages * (_header->page_size / c.size) << std::endl;
+        }
+    }
+    out << "spare pages " << _header->spare << "/" << _header->pages << std::endl;
+    return out.str();
+}
+
+// See Slab.h
+std::size_t Slab::PageOf(void *chunk) const { return (static_cast<char *>(chunk) - _begin) / _header->page_size; }
+
+// See Slab.h
+void Slab::Split(std::size_t page, unsigned cls) {
+    Class &c = _classes[cls];
+    _pages[page] = Page{cls, 0};
+    c.pages++;
+
+    // Pushed backwards, so that chunks are taken in address order
+    char *start = _begin + page * _header->page_size;
+    for (std::size_t i = _header->page_size / c.size; i > 0; i--) {
+        Push(c, reinterpret_cast<Chunk *>(start + (i - 1) * c.size));
+    }
+}
+
+// See Slab.h
+void Slab::Push(Class &c, Chunk *chunk) {
+    chunk->prev = nullptr;
+    chunk->next = c.free;
+    if (c.free != nullptr) {
+        c.free->prev = chunk;
+    }
+    c.free = chunk;
+}
+
+// See Slab.h
+void Slab::Unlink(Class &c, Chunk *chunk) {
+    if (chunk->prev != nullptr) {
+        chunk->prev->next = chunk->next;
+    } else {
+        c.free = chunk->next;
+    }
+    if (chunk->next != nullptr) {
+        chunk->next->prev = chunk->prev;
+    }
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -0,0 +1,51 @@
+#include <afina/allocator/SlabCache.h>
+
+#include <afina/allocator/Arena.h>
+
+namespace Afina {
+namespace Allocator {
+
+// See SlabCache.h
+SlabCache::SlabCache(Arena &arena, std::size_t keep)
+    : _arena(arena), _keep(keep), _free(nullptr), _free_count(0), _slabs(0) {}
+
+// See SlabCache.h
+SlabCache::~SlabCache() {
+    while (_free != nullptr) {
+        void *slab = _free;
+        _free = *static_cast<void **>(slab);
+        _arena.unmap(slab);
+    }
+}
+
+// See SlabCache.h
+void *SlabCache::get() {
+    if (_free != nullptr) {
+        void *slab = _free;
+        _free = *static_cast<void **>(slab);
+        _free_count--;
+        return slab;
+    }
+
+    void *slab = _arena.map();
+    if (slab != nullptr) {
+        _slabs++;
+    }
+    return slab;
+}
+
+// See SlabCache.h
+void SlabCache::put(void *slab) {
+    if (_free_count < _keep) {
+        *static_cast<void **>(slab) = _free;
+        _free = slab;
+        _free_count++;
+        return;
+    }
+
+    _arena.unmap(slab);
+    _slabs--;
+}
+
+} // namespace Allocator
+} // namespace Afina
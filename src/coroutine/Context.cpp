@@ -0,0 +1,114 @@
+#include "Context.h"
+
+#include <cstdint>
+#include <stdexcept>
+
+namespace Afina {
+namespace Coroutine {
+
+#if defined(__x86_64__) && !defined(AFINA_COROUTINE_UCONTEXT)
+
+extern "C" {
+void afina_coroutine_switch(void **from_sp, void *to_sp);
+void afina_coroutine_trampoline();
+}
+
+// System V ABI: rbx, rbp, r12-r15, MXCSR control bits and x87 control word belong to the caller,
+// everything else is clobbered by any call anyway. Stack of suspended context looks like:
+//
+//     sp ->  MXCSR, x87 CW (16 bytes), r15, r14, r13, r12, rbx, rbp, return address
+//
+// New context starts in trampoline that passes r12 as the first argument to function in r13
+asm(R"(
+    .text
+    .globl afina_coroutine_switch
+    .type afina_coroutine_switch, @function
+afina_coroutine_switch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $16, %rsp
+    stmxcsr 8(%rsp)
+    fnstcw 12(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr 8(%rsp)
+    fldcw 12(%rsp)
+    addq $16, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size afina_coroutine_switch, .-afina_coroutine_switch
+
+    .globl afina_coroutine_trampoline
+    .type afina_coroutine_trampoline, @function
+afina_coroutine_trampoline:
+    movq %r12, %rdi
+    callq *%r13
+    ud2
+    .size afina_coroutine_trampoline, .-afina_coroutine_trampoline
+)");
+
+// See Context.h
+void MakeContext(Context &ctx, char *stack, std::size_t size, void (*entry)(void *), void *arg) {
+    // Trampoline must start with 16 bytes aligned stack, so that entry sees it as after a regular call
+    uintptr_t top = (reinterpret_cast<uintptr_t>(stack) + size) & ~uintptr_t(15);
+    uint64_t *sp = reinterpret_cast<uint64_t *>(top);
+
+    *--sp = 0; // fake return address of trampoline
+    *--sp = 0; // alignment
+    *--sp = reinterpret_cast<uint64_t>(&afina_coroutine_trampoline);
+    *--sp = 0;                                 // rbp
+    *--sp = 0;                                 // rbx
+    *--sp = reinterpret_cast<uint64_t>(arg);   // r12
+    *--sp = reinterpret_cast<uint64_t>(entry); // r13
+    *--sp = 0;                                 // r14
+    *--sp = 0;                                 // r15
+
+    // Default MXCSR (all exceptions masked, round to nearest) and x87 control word
+    *--sp = (uint64_t(0x037F) << 32) | 0x1F80;
+    *--sp = 0;
+    ctx.sp = sp;
+}
+
+// See Context.h
+void SwitchContext(Context &from, Context &to) { afina_coroutine_switch(&from.sp, to.sp); }
+
+#else
+
+// makecontext passes int arguments only, pointers are split into halves
+static void Trampoline(unsigned int entry_hi, unsigned int entry_lo, unsigned int arg_hi, unsigned int arg_lo) {
+    auto entry = reinterpret_cast<void (*)(void *)>((uintptr_t(entry_hi) << 32) | entry_lo);
+    auto arg = reinterpret_cast<void *>((uintptr_t(arg_hi) << 32) | arg_lo);
+    entry(arg);
+}
+
+// See Context.h
+void MakeContext(Context &ctx, char *stack, std::size_t size, void (*entry)(void *), void *arg) {
+    if (getcontext(&ctx.uc) != 0) {
+        throw std::runtime_error("Failed to get context");
+    }
+    ctx.uc.uc_stack.ss_sp = stack;
+    ctx.uc.uc_stack.ss_size = size;
+    ctx.uc.uc_link = nullptr;
+
+    uint64_t e = reinterpret_cast<uintptr_t>(entry);
+    uint64_t a = reinterpret_cast<uintptr_t>(arg);
+    makecontext(&ctx.uc, reinterpret_cast<void (*)()>(&Trampoline), 4, static_cast<unsigned int>(e >> 32),
+                static_cast<unsigned int>(e), static_cast<unsigned int>(a >> 32), static_cast<unsigned int>(a));
+}
+
+// See Context.h
+void SwitchContext(Context &from, Context &to) { swapcontext(&from.uc, &to.uc); }
+
+#endif
+
+} // namespace Coroutine
+} // namespace Afina
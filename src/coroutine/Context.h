@@ -0,0 +1,45 @@
+#ifndef AFINA_COROUTINE_CONTEXT_H
+#define AFINA_COROUTINE_CONTEXT_H
+
+#include <cstddef>
+
+#if !defined(__x86_64__) || defined(AFINA_COROUTINE_UCONTEXT)
+#include <ucontext.h>
+#endif
+
+namespace Afina {
+namespace Coroutine {
+
+/**
+ * # Execution context
+ * Registers of suspended execution. On x86-64 context switch is a handful of instructions that push
+ * callee saved registers onto the current stack and pop them from the other one, so context is just
+ * a stack pointer. Elsewhere swapcontext(3) is used, it is much slower as it saves signal mask with
+ * a syscall. Defining AFINA_COROUTINE_UCONTEXT forces the latter, e.g for debugging.
+ *
+ * Context of the thread own stack needs no preparation, it is filled once execution is switched away
+ * from it
+ */
+struct Context {
+#if defined(__x86_64__) && !defined(AFINA_COROUTINE_UCONTEXT)
+    void *sp = nullptr;
+#else
+    ucontext_t uc;
+#endif
+};
+
+/**
+ * Prepares context to start execution of entry(arg) on the given stack. Entry must never return,
+ * it has to switch to some other context once done
+ */
+void MakeContext(Context &ctx, char *stack, std::size_t size, void (*entry)(void *), void *arg);
+
+/**
+ * Saves current execution into "from" and resumes "to"
+ */
+void SwitchContext(Context &from, Context &to);
+
+} // namespace Coroutine
+} // namespace Afina
+
+#endif // AFINA_COROUTINE_CONTEXT_H
@@ -1,19 +1,303 @@
 #include <afina/coroutine/Engine.h>
 
-#include <setjmp.h>
-#include <stdio.h>
-#include <string.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Context.h"
 
 namespace Afina {
 namespace Coroutine {
 
-void Engine::Store(context &ctx) {}
+// Stacks of finished coroutines kept for reuse, the rest is unmapped
+static constexpr std::size_t kMaxFreeStacks = 64;
+
+// See Engine.h
+struct Engine::context {
+    // Engine coroutine belongs to
+    Engine *engine = nullptr;
+
+    // Registers of suspended coroutine
+    Context regs;
+
+    // Lowest address of the stack mapping, guard page included. nullptr for the thread own stack
+    char *stack = nullptr;
+
+    // Function coroutine runs
+    Task body;
+
+    // Coroutine that has passed control to this one with sched, if it is still alive
+    context *caller = nullptr;
+
+    // Routine is in the blocked list rather than in the alive one
+    bool blocked = false;
+
+    // To include routine in the different lists, such as "alive", "blocked", e.t.c
+    context *prev = nullptr;
+    context *next = nullptr;
+};
+
+static std::size_t round_to_pages(std::size_t size) {
+    std::size_t page = sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+}
+
+// See Engine.h
+Engine::Engine(std::size_t stack_size_, std::function<void()> idle)
+    : stack_size(round_to_pages(stack_size_)), page_size(sysconf(_SC_PAGESIZE)), idle_hook(std::move(idle)),
+      cur_routine(nullptr), alive(nullptr), blocked(nullptr), idle_ctx(nullptr), finished(nullptr) {}
+
+// See Engine.h
+Engine::~Engine() {
+    for (char *stack : free_stacks) {
+        munmap(stack, stack_size + page_size);
+    }
+}
+
+// See Engine.h
+void Engine::yield() {
+    context *next = alive;
+    if (cur_routine != nullptr && cur_routine->next != nullptr) {
+        // Round robin, so that yielding routines don't pass control back and forth between each other only
+        next = cur_routine->next;
+    }
+
+    if (next != nullptr && next != cur_routine) {
+        Enter(next);
+    }
+}
+
+// See Engine.h
+void Engine::sched(void *routine_) {
+    context *routine = static_cast<context *>(routine_);
+    if (routine == nullptr) {
+        if (cur_routine != nullptr && cur_routine->caller != nullptr) {
+            Enter(cur_routine->caller);
+        } else {
+            yield();
+        }
+        return;
+    }
+
+    if (routine == cur_routine || routine->blocked) {
+        return;
+    }
+    routine->caller = cur_routine;
+    Enter(routine);
+}
+
+// See Engine.h
+void Engine::block(void *routine_) {
+    context *routine = routine_ != nullptr ? static_cast<context *>(routine_) : cur_routine;
+    if (routine == nullptr || routine->blocked) {
+        return;
+    }
+
+    Unlink(alive, routine);
+    Link(blocked, routine);
+    routine->blocked = true;
+    if (routine != cur_routine) {
+        return;
+    }
+
+    // Somebody else runs meanwhile, scheduler calls idle hook if there is nobody
+    if (alive != nullptr) {
+        Enter(alive);
+    } else {
+        Leave();
+    }
+}
+
+// See Engine.h
+void Engine::unblock(void *routine_) {
+    context *routine = static_cast<context *>(routine_);
+    if (routine == nullptr || !routine->blocked) {
+        return;
+    }
+
+    Unlink(blocked, routine);
+    Link(alive, routine);
+    routine->blocked = false;
+}
+
+// See Engine.h
+void Engine::Start(Task &&main) {
+    if (idle_ctx != nullptr) {
+        throw std::runtime_error("Engine is running already");
+    }
+
+    context idle;
+    idle_ctx = &idle;
+    error = nullptr;
+
+    try {
+        context *next = static_cast<context *>(Spawn(std::move(main)));
+
+        // Scheduler: runs whatever is alive until nothing is. Coroutines pass control between each other
+        // directly, scheduler gets it back only once some coroutine finishes or all of them are blocked
+        while (alive != nullptr || blocked != nullptr) {
+            if (alive == nullptr) {
+                if (!idle_hook) {
+                    throw std::runtime_error("All coroutines are blocked");
+                }
+                idle_hook();
+                continue;
+            }
+
+            Enter(next != nullptr && !next->blocked ? next : alive);
+            next = nullptr;
+            if (finished == nullptr) {
+                continue;
+            }
+
+            next = finished->caller;
+            for (context *list : {alive, blocked}) {
+                for (context *routine = list; routine != nullptr; routine = routine->next) {
+                    if (routine->caller == finished) {
+                        routine->caller = nullptr;
+                    }
+                }
+            }
+            ReleaseStack(finished->stack);
+            delete finished;
+            finished = nullptr;
+        }
+    } catch (...) {
+        Discard();
+        throw;
+    }
+
+    idle_ctx = nullptr;
+    if (error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+// See Engine.h
+void *Engine::Spawn(Task &&body) {
+    context *pc = new context();
+    try {
+        pc->stack = AllocateStack();
+    } catch (...) {
+        delete pc;
+        throw;
+    }
+    pc->engine = this;
+    pc->body = std::move(body);
+    MakeContext(pc->regs, pc->stack + page_size, stack_size, &Engine::Entry, pc);
+
+    // Add routine as alive double-linked list
+    Link(alive, pc);
+    return pc;
+}
+
+// See Engine.h
+void Engine::Discard() {
+    for (context **list : {&alive, &blocked}) {
+        while (*list != nullptr) {
+            context *routine = *list;
+            Unlink(*list, routine);
+            ReleaseStack(routine->stack);
+            delete routine;
+        }
+    }
+    cur_routine = nullptr;
+    idle_ctx = nullptr;
+    finished = nullptr;
+    error = nullptr;
+}
+
+// See Engine.h
+void Engine::Enter(context *routine) {
+    context *from = cur_routine != nullptr ? cur_routine : idle_ctx;
+    cur_routine = routine;
+    SwitchContext(from->regs, routine->regs);
+}
+
+// See Engine.h
+void Engine::Leave() {
+    context *from = cur_routine;
+    cur_routine = nullptr;
+    SwitchContext(from->regs, idle_ctx->regs);
+}
+
+// See Engine.h
+void Engine::Link(context *&list, context *routine) {
+    routine->prev = nullptr;
+    routine->next = list;
+    if (list != nullptr) {
+        list->prev = routine;
+    }
+    list = routine;
+}
+
+// See Engine.h
+void Engine::Unlink(context *&list, context *routine) {
+    if (routine->prev != nullptr) {
+        routine->prev->next = routine->next;
+    }
+    if (routine->next != nullptr) {
+        routine->next->prev = routine->prev;
+    }
+    if (list == routine) {
+        list = routine->next;
+    }
+    routine->prev = routine->next = nullptr;
+}
+
+// See Engine.h
+void Engine::Entry(void *routine) {
+    context *pc = static_cast<context *>(routine);
+    Engine *engine = pc->engine;
+    try {
+        pc->body();
+    } catch (...) {
+        if (!engine->error) {
+            engine->error = std::current_exception();
+        }
+    }
+    pc->body.Reset();
+    Unlink(engine->alive, pc);
+
+    // Stack is still in use, so scheduler is the one to release it. Control never returns here
+    engine->finished = pc;
+    engine->Leave();
+}
 
-void Engine::Restore(context &ctx) {}
+// See Engine.h
+char *Engine::AllocateStack() {
+    if (!free_stacks.empty()) {
+        char *stack = free_stacks.back();
+        free_stacks.pop_back();
+        return stack;
+    }
 
-void Engine::yield() {}
+    void *stack = mmap(nullptr, stack_size + page_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED) {
+        throw std::runtime_error("Failed to allocate coroutine stack: " + std::string(strerror(errno)));
+    }
+    if (mprotect(stack, page_size, PROT_NONE) != 0) {
+        munmap(stack, stack_size + page_size);
+        throw std::runtime_error("Failed to protect coroutine stack: " + std::string(strerror(errno)));
+    }
+    return static_cast<char *>(stack);
+}
 
-void Engine::sched(void *routine_) {}
+// See Engine.h
+void Engine::ReleaseStack(char *stack) {
+    if (free_stacks.size() < kMaxFreeStacks) {
+        free_stacks.push_back(stack);
+    } else {
+        munmap(stack, stack_size + page_size);
+    }
+}
 
 } // namespace Coroutine
 } // namespace Afina
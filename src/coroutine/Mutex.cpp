@@ -0,0 +1,56 @@
+#include <afina/coroutine/Mutex.h>
+
+#include <stdexcept>
+
+namespace Afina {
+namespace Coroutine {
+
+// See Mutex.h
+void Mutex::lock() {
+    void *self = _waiters.engine().current();
+    if (self == nullptr) {
+        throw std::logic_error("Mutex could be locked by routines only");
+    }
+    if (_owner == self) {
+        throw std::logic_error("Mutex is locked by the current routine already");
+    }
+    if (_owner == nullptr) {
+        _owner = self;
+        return;
+    }
+
+    // Unlock hands mutex over, so once routine is here again it is the owner
+    _waiters.wait();
+}
+
+// See Mutex.h
+bool Mutex::try_lock() {
+    void *self = _waiters.engine().current();
+    if (self == nullptr) {
+        throw std::logic_error("Mutex could be locked by routines only");
+    }
+    if (_owner != nullptr) {
+        return false;
+    }
+    _owner = self;
+    return true;
+}
+
+// See Mutex.h
+void Mutex::unlock() {
+    if (_owner != _waiters.engine().current()) {
+        throw std::logic_error("Mutex is not locked by the current routine");
+    }
+    _owner = _waiters.notify_one();
+}
+
+// See Mutex.h
+void ConditionVariable::wait(Mutex &mutex) {
+    // Nothing runs between unlock and wait, so notify can't slip in between
+    mutex.unlock();
+    _waiters.wait();
+    mutex.lock();
+}
+
+} // namespace Coroutine
+} // namespace Afina
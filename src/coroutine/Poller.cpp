@@ -0,0 +1,231 @@
+#include <afina/coroutine/Poller.h>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Coroutine {
+
+// Events epoll reports regardless of interest
+static constexpr uint32_t kAlwaysReported = EPOLLERR | EPOLLHUP;
+
+// See Poller.h
+Poller::Poller(Engine &engine) : _engine(engine) {
+    _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll_fd == -1) {
+        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+    }
+    _engine.set_idle([this] { poll(); });
+}
+
+// See Poller.h
+Poller::~Poller() {
+    _engine.set_idle(nullptr);
+    close(_epoll_fd);
+}
+
+// See Poller.h
+void Poller::sleep(uint32_t timeout_ms) {
+    Timer timer;
+    timer.deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+    timer.routine = _engine.current();
+    Schedule(timer);
+    _engine.block();
+    Cancel(timer);
+}
+
+// See Poller.h
+uint32_t Poller::wait(int fd, uint32_t events, int timeout_ms) {
+    Waiter waiter;
+    waiter.fd = fd;
+    waiter.events = events;
+    waiter.routine = _engine.current();
+    Watch(waiter);
+
+    Timer timer;
+    if (timeout_ms >= 0) {
+        timer.deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+        timer.routine = waiter.routine;
+        Schedule(timer);
+    }
+
+    // Whichever comes first unblocks routine, the other one is cancelled here
+    _engine.block();
+    Cancel(timer);
+    if (waiter.linked) {
+        Unwatch(waiter);
+    }
+    return waiter.revents;
+}
+
+// See Poller.h
+void Poller::poll() {
+    if (_heap.empty() && _waiters.empty()) {
+        throw std::runtime_error("All coroutines are blocked and there is nothing to wait for");
+    }
+
+    int timeout = -1;
+    if (!_heap.empty()) {
+        // Round up, otherwise poller wakes up a bit early and spins until deadline
+        auto left = std::chrono::duration_cast<std::chrono::microseconds>(_heap[0]->deadline - clock::now());
+        timeout = left.count() <= 0 ? 0 : static_cast<int>((left.count() + 999) / 1000);
+    }
+
+    std::array<struct epoll_event, 64> mod_list;
+    int nmod = epoll_wait(_epoll_fd, &mod_list[0], mod_list.size(), timeout);
+    if (nmod == -1 && errno != EINTR) {
+        throw std::runtime_error("Failed to wait for events: " + std::string(strerror(errno)));
+    }
+
+    for (int i = 0; i < nmod; i++) {
+        auto it = _waiters.find(mod_list[i].data.fd);
+        if (it == _waiters.end()) {
+            continue;
+        }
+
+        // Waiters which got their events leave the list, so that descriptor doesn't report them again
+        Waiter *waiter = it->second;
+        while (waiter != nullptr) {
+            Waiter *next = waiter->next;
+            uint32_t revents = mod_list[i].events & (waiter->events | kAlwaysReported);
+            if (revents != 0) {
+                waiter->revents = revents;
+                Unwatch(*waiter);
+                _engine.unblock(waiter->routine);
+            }
+            waiter = next;
+        }
+    }
+
+    clock::time_point now = clock::now();
+    while (!_heap.empty() && _heap[0]->deadline <= now) {
+        Timer *timer = _heap[0];
+        Cancel(*timer);
+        _engine.unblock(timer->routine);
+    }
+}
+
+// See Poller.h
+void Poller::Schedule(Timer &timer) {
+    timer.index = _heap.size();
+    _heap.push_back(&timer);
+    SiftUp(timer.index);
+}
+
+// See Poller.h
+void Poller::Cancel(Timer &timer) {
+    if (timer.index == kNotScheduled) {
+        return;
+    }
+
+    std::size_t index = timer.index;
+    Swap(index, _heap.size() - 1);
+    _heap.pop_back();
+    timer.index = kNotScheduled;
+    if (index < _heap.size()) {
+        SiftDown(index);
+        SiftUp(index);
+    }
+}
+
+// See Poller.h
+void Poller::SiftUp(std::size_t index) {
+    while (index > 0) {
+        std::size_t parent = (index - 1) / 2;
+        if (_heap[parent]->deadline <= _heap[index]->deadline) {
+            break;
+        }
+        Swap(parent, index);
+        index = parent;
+    }
+}
+
+// See Poller.h
+void Poller::SiftDown(std::size_t index) {
+    while (true) {
+        std::size_t least = index;
+        for (std::size_t child = 2 * index + 1; child <= 2 * index + 2 && child < _heap.size(); child++) {
+            if (_heap[child]->deadline < _heap[least]->deadline) {
+                least = child;
+            }
+        }
+        if (least == index) {
+            break;
+        }
+        Swap(least, index);
+        index = least;
+    }
+}
+
+// See Poller.h
+void Poller::Swap(std::size_t a, std::size_t b) {
+    std::swap(_heap[a], _heap[b]);
+    _heap[a]->index = a;
+    _heap[b]->index = b;
+}
+
+// See Poller.h
+void Poller::Watch(Waiter &waiter) {
+    auto it = _waiters.find(waiter.fd);
+    Waiter *head = it != _waiters.end() ? it->second : nullptr;
+
+    struct epoll_event event;
+    event.events = waiter.events | Interest(head);
+    event.data.fd = waiter.fd;
+    if (epoll_ctl(_epoll_fd, head == nullptr ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, waiter.fd, &event)) {
+        throw std::runtime_error("Failed to add file descriptor to epoll: " + std::string(strerror(errno)));
+    }
+
+    waiter.next = head;
+    if (head != nullptr) {
+        head->prev = &waiter;
+    }
+    _waiters[waiter.fd] = &waiter;
+    waiter.linked = true;
+}
+
+// See Poller.h
+uint32_t Poller::Interest(const Waiter *head) {
+    uint32_t events = 0;
+    for (; head != nullptr; head = head->next) {
+        events |= head->events;
+    }
+    return events;
+}
+
+// See Poller.h
+void Poller::Unwatch(Waiter &waiter) {
+    auto it = _waiters.find(waiter.fd);
+    if (waiter.prev != nullptr) {
+        waiter.prev->next = waiter.next;
+    }
+    if (waiter.next != nullptr) {
+        waiter.next->prev = waiter.prev;
+    }
+    if (it->second == &waiter) {
+        it->second = waiter.next;
+    }
+    waiter.prev = waiter.next = nullptr;
+    waiter.linked = false;
+
+    // Descriptor could be closed by routine once it is done waiting, so it leaves epoll right away
+    if (it->second == nullptr) {
+        _waiters.erase(it);
+        epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, waiter.fd, nullptr);
+    } else {
+        struct epoll_event event;
+        event.events = Interest(it->second);
+        event.data.fd = waiter.fd;
+        epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, waiter.fd, &event);
+    }
+}
+
+} // namespace Coroutine
+} // namespace Afina
@@ -1,3 +1,4 @@
+#include <afina/Metrics.h>
 #include <afina/Storage.h>
 #include <afina/execute/Stats.h>
 
@@ -8,7 +9,27 @@
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+/* memcached protocol:
+
+Each statistics item sent by the server looks like this:
+
+STAT <name> <value>\r\n
+
+After all the items have been transmitted, the server sends the string
+"END\r\n"
+to indicate the end of response.
+
+*/
+
+void Stats::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::stringstream outStream;
+    for (auto &stat : Metrics::Instance().Collect()) {
+        outStream << "STAT " << stat.first << " " << stat.second << "\r\n";
+    }
+    outStream << "END"; // networking layer should add the last \r\n
+
+    out = outStream.str();
+}
 
 } // namespace Execute
 } // namespace Afina
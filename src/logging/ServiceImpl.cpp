@@ -180,7 +180,10 @@ void ServiceImpl::Start() {
 }
 
 // See ServiceImpl.h
-void ServiceImpl::Stop() {}
+void ServiceImpl::Stop() {
+    // Loggers are registered globally, so that service could be started once again
+    spdlog::drop_all();
+}
 
 // See ServiceImpl.h
 std::shared_ptr<spdlog::logger> ServiceImpl::select(const std::string &name) noexcept {
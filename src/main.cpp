@@ -1,38 +1,127 @@
 #include <chrono>
+#include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <sstream>
 
 #include <atomic>
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
 #include <semaphore.h>
 #include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
 #include <thread>
+#include <unistd.h>
+#include <vector>
 
 #include <cxxopts.hpp>
 
 #include <afina/Storage.h>
 #include <afina/Version.h>
+#include <afina/allocator/Mapping.h>
+#include <afina/allocator/Numa.h>
 #include <afina/logging/Service.h>
+#include <afina/network/Config.h>
 #include <afina/network/Server.h>
 #include <network/mt_blocking_with_thread_poop/ServerImpl.h>
 
 #include "logging/ServiceImpl.h"
+#include "network/Handoff.h"
+#include "network/Socket.h"
+#include "network/coro/ServerImpl.h"
 #include "network/mt_blocking/ServerImpl.h"
 #include "network/mt_nonblocking/ServerImpl.h"
 #include "network/st_blocking/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
+#include "network/udp/ServerImpl.h"
 
+#include "storage/BitcaskStorage.h"
+#include "storage/ShardedSlabLRU.h"
 #include "storage/SimpleLRU.h"
+#include "storage/SnapshotStorage.h"
+#include "storage/SlabLRU.h"
 #include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/ThreadSafeSlabLRU.h"
+#include "storage/WalStorage.h"
 
 using namespace Afina;
 
+// Environment variable with descriptor of the channel to the previous process
+static const char kHandoffVariable[] = "AFINA_HANDOFF_FD";
+
+// Milliseconds processes wait for each other during restart
+static const int kHandoffTimeout = 30000;
+
+/**
+ * Application settings: command line options with fallback to config file. Config file consists of
+ * "name = value" lines where name is the long name of command line option, # starts a comment
+ */
+class Settings {
+public:
+    Settings(const cxxopts::Options &options) : _options(options) {}
+
+    // Read config file, throws std::runtime_error if it couldn't be parsed
+    void Load(const std::string &path) {
+        std::ifstream file(path);
+        if (!file) {
+            throw std::runtime_error("Failed to open config file " + path);
+        }
+
+        std::string line;
+        for (int lineno = 1; std::getline(file, line); lineno++) {
+            line = line.substr(0, line.find('#'));
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+
+            std::size_t eq = line.find('=');
+            if (eq == std::string::npos) {
+                throw std::runtime_error(path + ":" + std::to_string(lineno) + ": expected name = value");
+            }
+            _file[Trim(line.substr(0, eq))] = Trim(line.substr(eq + 1));
+        }
+    }
+
+    // Fill value from command line or config file, returns false if option is given nowhere
+    template <typename T> bool Get(const std::string &name, T &value) const {
+        if (_options.count(name) > 0) {
+            value = _options[name].as<T>();
+            return true;
+        }
+
+        auto it = _file.find(name);
+        if (it == _file.end()) {
+            return false;
+        }
+
+        std::istringstream is(it->second);
+        if (!(is >> std::boolalpha >> value) || !(is >> std::ws).eof()) {
+            throw std::runtime_error("Invalid value of " + name + ": " + it->second);
+        }
+        return true;
+    }
+
+private:
+    static std::string Trim(const std::string &s) {
+        std::size_t begin = s.find_first_not_of(" \t\r");
+        std::size_t end = s.find_last_not_of(" \t\r");
+        return begin == std::string::npos ? std::string() : s.substr(begin, end - begin + 1);
+    }
+
+    const cxxopts::Options &_options;
+    std::map<std::string, std::string> _file;
+};
+
 /**
  * Whole application class
  */
 class Application {
 public:
-    // Loading application config
-    void Configure(const cxxopts::Options &options) {
+    // Loading application config, handoff is the channel to the previous process if this one replaces it
+    void Configure(const Settings &options, int handoff) {
         // Step 0: logger config
         logConfig.reset(new Logging::Config);
         Logging::Appender &console = logConfig->appenders["console"];
@@ -47,37 +136,173 @@ public:
 
         // Step 1: configure storage
         std::string storage_type = "st_lru";
-        if (options.count("storage") > 0) {
-            storage_type = options["storage"].as<std::string>();
+        options.Get("storage", storage_type);
+
+        std::string memory = "64m";
+        options.Get("memory", memory);
+        std::size_t max_size = ParseSize(memory);
+
+        // Only slab storages own an area that could be mapped upfront
+        unsigned map_flags = 0;
+        bool prealloc = false, hugepages = false;
+        options.Get("prealloc", prealloc);
+        options.Get("hugepages", hugepages);
+        if (prealloc) {
+            map_flags |= Afina::Allocator::Mapping::kPopulate;
+        }
+        if (hugepages) {
+            map_flags |= Afina::Allocator::Mapping::kHugePages;
+        }
+        if (map_flags != 0 && storage_type != "st_slab" && storage_type != "mt_slab") {
+            throw std::runtime_error("--prealloc and --hugepages need slab storage");
+        }
+
+        // Shard per node, workers pinned to nodes round robin
+        bool numa = false;
+        options.Get("numa", numa);
+        if (numa && storage_type != "mt_slab") {
+            throw std::runtime_error("--numa needs mt_slab storage");
+        }
+        network_config.numa = numa;
+
+        // Cache memory and listening sockets are handed to the next process of the binary on SIGUSR2
+        options.Get("warm-restart", warm_restart);
+        if (warm_restart) {
+            if (storage_type != "st_slab" && storage_type != "mt_slab") {
+                throw std::runtime_error("--warm-restart needs slab storage");
+            }
+            if (numa) {
+                throw std::runtime_error("--warm-restart can't be used with --numa");
+            }
+            map_flags |= Afina::Allocator::Mapping::kShared;
+        }
+
+        // Step 2: Configure network, before storage is created: taking cache over from the previous
+        // process must be the last thing that could fail
+        std::string network_type = "st_block";
+        options.Get("network", network_type);
+
+        options.Get("port", network_config.port);
+        options.Get("udp-port", network_config.udp_port);
+        options.Get("unix-socket", network_config.unix_socket);
+        std::string unix_mode;
+        if (options.Get("unix-mode", unix_mode)) {
+            std::size_t parsed = 0;
+            network_config.unix_mode = std::stoul(unix_mode, &parsed, 8);
+            if (parsed != unix_mode.size()) {
+                throw std::runtime_error("Invalid value of unix-mode: " + unix_mode);
+            }
+        }
+        options.Get("backlog", network_config.backlog);
+        options.Get("acceptors", network_config.acceptors);
+        options.Get("workers", network_config.workers);
+        options.Get("executor-threads", network_config.executor_threads);
+        options.Get("tcp-nodelay", network_config.tcp_nodelay);
+        options.Get("defer-accept", network_config.defer_accept);
+        options.Get("rcvbuf", network_config.rcvbuf);
+        options.Get("sndbuf", network_config.sndbuf);
+        options.Get("busy-poll", network_config.busy_poll);
+        options.Get("read-timeout", network_config.read_timeout);
+        options.Get("idle-timeout", network_config.idle_timeout);
+        options.Get("write-timeout", network_config.write_timeout);
+        if (network_config.acceptors == 0 || network_config.workers == 0) {
+            throw std::runtime_error("Network needs at least one acceptor and one worker");
+        }
+
+        if (warm_restart && network_type != "st_nonblock" && network_type != "mt_nonblock" && network_type != "coro") {
+            throw std::runtime_error("--warm-restart needs non blocking network");
         }
 
-        if (storage_type == "st_lru") {
-            storage = std::make_shared<Afina::Backend::SimpleLRU>();
+        // Step 3: create storage
+        std::shared_ptr<Afina::Backend::SlabLRU> slab;
+        if (handoff >= 0) {
+            slab = TakeOver(handoff, storage_type);
+        }
+        if (slab) {
+            storage = slab;
+        } else if (numa) {
+            storage = std::make_shared<Afina::Backend::ShardedSlabLRU>(
+                max_size, map_flags, Afina::Allocator::NumaTopology::System().nodes());
+        } else if (storage_type == "st_lru") {
+            storage = std::make_shared<Afina::Backend::SimpleLRU>(max_size);
         } else if (storage_type == "mt_lru") {
-            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
+            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>(max_size);
+        } else if (storage_type == "st_slab") {
+            storage = slab = std::make_shared<Afina::Backend::SlabLRU>(max_size, map_flags);
+        } else if (storage_type == "mt_slab") {
+            storage = slab = std::make_shared<Afina::Backend::ThreadSafeSlabLRU>(max_size, map_flags);
+        } else if (storage_type == "bitcask") {
+            // Values are on disk, memory limit applies to the index of keys
+            std::string data_dir, segment_size = "64m";
+            if (!options.Get("data-dir", data_dir)) {
+                throw std::runtime_error("bitcask storage needs --data-dir");
+            }
+            options.Get("segment-size", segment_size);
+            storage = std::make_shared<Afina::Backend::BitcaskStorage>(data_dir, max_size, ParseSize(segment_size));
         } else {
             throw std::runtime_error("Unknown storage type");
         }
 
-        // Step 2: Configure network
-        std::string network_type = "st_block";
-        if (options.count("network") > 0) {
-            network_type = options["network"].as<std::string>();
+        // Persistence wraps whatever storage is chosen, snapshot is taken from its own thread
+        std::string snapshot;
+        if (options.Get("snapshot", snapshot)) {
+            if (storage_type != "mt_lru" && storage_type != "mt_slab") {
+                throw std::runtime_error("--snapshot needs thread safe storage");
+            }
+            // Final dump would be taken while the next process already changes the cache
+            if (warm_restart) {
+                throw std::runtime_error("--snapshot can't be used with --warm-restart");
+            }
+            uint32_t interval = 0;
+            bool load = false;
+            options.Get("snapshot-interval", interval);
+            options.Get("snapshot-load", load);
+            storage = std::make_shared<Afina::Backend::SnapshotStorage>(
+                storage, snapshot, std::chrono::seconds(interval), load, std::thread::hardware_concurrency());
+        }
+
+        // Durable mode: changes are acknowledged once they are in the log on disk
+        std::string wal;
+        if (options.Get("wal", wal)) {
+            if (storage_type != "mt_lru" && storage_type != "mt_slab" && storage_type != "bitcask") {
+                throw std::runtime_error("--wal needs thread safe storage");
+            }
+            if (warm_restart || !snapshot.empty()) {
+                throw std::runtime_error("--wal can't be used with --warm-restart and --snapshot");
+            }
+            uint32_t interval = 0;
+            std::string batch = "1m";
+            options.Get("wal-interval", interval);
+            options.Get("wal-batch", batch);
+            storage = std::make_shared<Afina::Backend::WalStorage>(storage, wal, std::chrono::microseconds(interval),
+                                                                   ParseSize(batch));
+        }
+
+        if (warm_restart) {
+            shared_cache = slab;
         }
 
+        // Step 4: create servers
         if (network_type == "st_block") {
-            server = std::make_shared<Afina::Network::STblocking::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::STblocking::ServerImpl>(storage, logService, network_config);
         } else if (network_type == "mt_block") {
-            server = std::make_shared<Afina::Network::MTblocking::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::MTblocking::ServerImpl>(storage, logService, network_config);
         } else if (network_type == "st_nonblock") {
-            server = std::make_shared<Afina::Network::STnonblock::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::STnonblock::ServerImpl>(storage, logService, network_config);
         } else if (network_type == "mt_nonblock") {
-            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService, network_config);
         } else if (network_type == "mt_thread_pool_block") {
-            server = std::make_shared<Afina::Network::MT_thread_pool::ServerImpl>(storage, logService);
+            server =
+                std::make_shared<Afina::Network::MT_thread_pool::ServerImpl>(storage, logService, network_config);
+        } else if (network_type == "coro") {
+            server = std::make_shared<Afina::Network::Coro::ServerImpl>(storage, logService, network_config);
         } else {
             throw std::runtime_error("Unknown network type");
         }
+
+        if (network_config.udp_port != 0) {
+            udp_server = std::make_shared<Afina::Network::UDP::ServerImpl>(storage, logService, network_config);
+        }
     }
 
     // Start services in correct order
@@ -89,10 +314,20 @@ public:
         log->warn("Start storage");
         storage->Start();
 
-        // TODO: configure network service
-        const uint16_t port = 8080;
-        log->warn("Start network on {}", port);
-        server->Start(port, 2, 2);
+        log->warn("Start network on {}", network_config.port);
+        server->Start(network_config.port, network_config.acceptors, network_config.workers);
+        if (udp_server) {
+            log->warn("Start udp network on {}", network_config.udp_port);
+            udp_server->Start(network_config.udp_port, 1, network_config.workers);
+        }
+
+        // Previous process exits once it knows sockets are served again
+        if (handoff_channel >= 0) {
+            Afina::Network::close_inherited_sockets();
+            Afina::Network::send_handoff(handoff_channel, "started");
+            close(handoff_channel);
+            handoff_channel = -1;
+        }
     }
 
     // Stop services in correct order
@@ -100,17 +335,195 @@ public:
         auto log = logService->select("root");
         log->warn("Stop application");
         server->Stop();
+        if (udp_server) {
+            udp_server->Stop();
+            udp_server->Join();
+        }
+        server->Join();
+        storage->Stop();
+        logService->Stop();
+    }
+
+    bool CanRestart() const { return warm_restart; }
+
+    // Replaces the process by a new instance of the binary, that takes cache memory and listening
+    // sockets over, so restart takes the same time whatever the cache holds. Returns false if new
+    // process failed to start, this one keeps serving then
+    bool Restart(char **argv) {
+        auto log = logService->select("root");
+        log->warn("Restart application");
+
+        int channel[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, channel) != 0) {
+            log->error("Failed to create handoff channel: {}", strerror(errno));
+            return false;
+        }
+
+        // Path and environment are prepared before fork, child may only call async signal safe functions.
+        // Binary is looked up by path, not as /proc/self/exe, so that the process keeps its name
+        char binary[PATH_MAX];
+        ssize_t length = readlink("/proc/self/exe", binary, sizeof(binary) - 1);
+        if (length <= 0) {
+            log->error("Failed to find binary: {}", strerror(errno));
+            close(channel[0]);
+            close(channel[1]);
+            return false;
+        }
+        binary[length] = '\0';
+
+        std::string variable = std::string(kHandoffVariable) + "=" + std::to_string(channel[1]);
+        std::vector<char *> env;
+        for (char **e = environ; *e != nullptr; e++) {
+            env.push_back(*e);
+        }
+        env.push_back(&variable[0]);
+        env.push_back(nullptr);
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            fcntl(channel[1], F_SETFD, 0);
+            execve(binary, argv, env.data());
+            _exit(127);
+        }
+        close(channel[1]);
+        if (pid < 0) {
+            log->error("Failed to start new process: {}", strerror(errno));
+            close(channel[0]);
+            return false;
+        }
+
+        // New process reports once it is configured, until then this one keeps serving
+        std::string message;
+        std::vector<int> fds;
+        if (!Afina::Network::recv_handoff(channel[0], message, fds, kHandoffTimeout) || message != "ready") {
+            log->error("New process failed to start, keep serving");
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+            close(channel[0]);
+            return false;
+        }
+
+        // Sockets stay open in the new process, connections queued meanwhile aren't lost
+        std::vector<int> sockets = Afina::Network::handover_listen_sockets();
+        server->Stop();
+        if (udp_server) {
+            udp_server->Stop();
+            udp_server->Join();
+        }
         server->Join();
         storage->Stop();
+
+        fds.assign(1, shared_cache->memory_fd());
+        fds.insert(fds.end(), sockets.begin(), sockets.end());
+        bool started = false;
+        try {
+            Afina::Network::send_handoff(channel[0], "takeover", fds);
+            if (Afina::Network::recv_handoff(channel[0], message, fds, kHandoffTimeout) && message == "started") {
+                log->warn("New process {} took over", pid);
+                started = true;
+            } else {
+                log->error("New process {} failed to take over", pid);
+            }
+        } catch (std::exception &ex) {
+            log->error("Failed to hand over to new process: {}", ex.what());
+        }
+        close(channel[0]);
+
+        if (!started) {
+            // Nobody might serve the sockets, take them back. Cache is used as is: new process could
+            // change it only if it had started serving before it was killed
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+            Afina::Network::inherit_listen_sockets(sockets);
+            storage->Start();
+            server->Start(network_config.port, network_config.acceptors, network_config.workers);
+            if (udp_server) {
+                udp_server->Start(network_config.udp_port, 1, network_config.workers);
+            }
+            Afina::Network::close_inherited_sockets();
+            log->warn("Keep serving");
+            return false;
+        }
+
+        for (int socket : sockets) {
+            close(socket);
+        }
         logService->Stop();
+        return true;
     }
 
 private:
+    // Receives cache memory and listening sockets from the previous process. Returns nullptr if its
+    // cache can't be used, e.g memory layout has changed, storage starts empty then
+    std::shared_ptr<Afina::Backend::SlabLRU> TakeOver(int handoff, const std::string &storage_type) {
+        handoff_channel = handoff;
+
+        std::string message;
+        std::vector<int> fds;
+        Afina::Network::send_handoff(handoff, "ready");
+        if (!Afina::Network::recv_handoff(handoff, message, fds, kHandoffTimeout) || message != "takeover" ||
+            fds.empty()) {
+            for (int fd : fds) {
+                close(fd);
+            }
+            throw std::runtime_error("Previous process didn't hand its state over");
+        }
+        Afina::Network::inherit_listen_sockets(std::vector<int>(fds.begin() + 1, fds.end()));
+
+        try {
+            Afina::Backend::SlabLRU::MemoryFile memory{fds[0]};
+            if (storage_type == "st_slab") {
+                return std::make_shared<Afina::Backend::SlabLRU>(memory);
+            }
+            return std::make_shared<Afina::Backend::ThreadSafeSlabLRU>(memory);
+        } catch (std::exception &ex) {
+            std::cerr << "Cache of the previous process is dropped: " << ex.what() << std::endl;
+            return nullptr;
+        }
+    }
+
+    // Size like 512, 64k, 1g
+    static std::size_t ParseSize(const std::string &value) {
+        std::size_t pos = 0;
+        unsigned long long size = 0;
+        if (value.empty() || !isdigit(value[0])) {
+            throw std::runtime_error("Invalid size: " + value);
+        }
+        try {
+            size = std::stoull(value, &pos);
+        } catch (std::exception &) {
+            throw std::runtime_error("Invalid size: " + value);
+        }
+
+        std::string suffix = value.substr(pos);
+        if (suffix == "k" || suffix == "K") {
+            size <<= 10;
+        } else if (suffix == "m" || suffix == "M") {
+            size <<= 20;
+        } else if (suffix == "g" || suffix == "G") {
+            size <<= 30;
+        } else if (!suffix.empty()) {
+            throw std::runtime_error("Invalid size: " + value);
+        }
+        if (size == 0) {
+            throw std::runtime_error("Cache size must be positive");
+        }
+        return size;
+    }
+
     std::shared_ptr<Afina::Logging::Config> logConfig;
     std::shared_ptr<Afina::Logging::Service> logService;
 
     std::shared_ptr<Afina::Storage> storage;
+
+    // Set if storage could be handed over to the next process
+    bool warm_restart = false;
+    std::shared_ptr<Afina::Backend::SlabLRU> shared_cache;
+    int handoff_channel = -1;
+
+    Afina::Network::Config network_config;
     std::shared_ptr<Afina::Network::Server> server;
+    std::shared_ptr<Afina::Network::Server> udp_server;
 };
 
 // Signal set that to notify application about time to stop
@@ -130,7 +543,55 @@ int main(int argc, char **argv) {
         // TODO: use custom cxxopts::value to print options possible values in help message
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
+        options.add_options()("m,memory", "Cache size in bytes, k, m or g suffix multiplies it by 1024^n",
+                              cxxopts::value<std::string>());
+        options.add_options()("prealloc", "Commit cache memory at start, slab storages only", cxxopts::value<bool>());
+        options.add_options()("hugepages", "Back cache memory by huge pages, slab storages only",
+                              cxxopts::value<bool>());
+        options.add_options()("numa", "Shard mt_slab storage over NUMA nodes and pin workers to nodes",
+                              cxxopts::value<bool>());
+        options.add_options()("snapshot", "File to dump cache to on stop and periodically",
+                              cxxopts::value<std::string>());
+        options.add_options()("snapshot-interval", "Seconds between snapshots, 0 to dump on stop only",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("snapshot-load", "Load snapshot on start", cxxopts::value<bool>());
+        options.add_options()("warm-restart", "On SIGUSR2 hand cache and sockets over to new process of the binary",
+                              cxxopts::value<bool>());
+        options.add_options()("data-dir", "Directory of bitcask storage files", cxxopts::value<std::string>());
+        options.add_options()("segment-size", "Size of bitcask segment files, k, m or g suffix",
+                              cxxopts::value<std::string>());
+        options.add_options()("wal", "Log file of durable mode, changes are acknowledged once they are on disk",
+                              cxxopts::value<std::string>());
+        options.add_options()("wal-interval", "Microseconds log flusher waits for more changes before sync",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("wal-batch", "Log bytes that are synced without waiting, k, m or g suffix",
+                              cxxopts::value<std::string>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
+        options.add_options()("c,config", "File with settings, command line options take precedence",
+                              cxxopts::value<std::string>());
+        options.add_options()("p,port", "TCP port to listen on, 0 disables TCP", cxxopts::value<uint16_t>());
+        options.add_options()("udp-port", "UDP port to serve get requests on, 0 disables UDP",
+                              cxxopts::value<uint16_t>());
+        options.add_options()("unix-socket", "Path of unix socket to listen on", cxxopts::value<std::string>());
+        options.add_options()("unix-mode", "Octal permissions of unix socket file", cxxopts::value<std::string>());
+        options.add_options()("backlog", "Length of the queue of not yet accepted connections",
+                              cxxopts::value<int>());
+        options.add_options()("acceptors", "Number of threads accepting connections", cxxopts::value<uint32_t>());
+        options.add_options()("workers", "Number of threads serving connections", cxxopts::value<uint32_t>());
+        options.add_options()("executor-threads", "Number of threads executing commands off I/O threads",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("tcp-nodelay", "Disable Nagle algorithm on client sockets", cxxopts::value<bool>());
+        options.add_options()("defer-accept", "Seconds to wait for the first data before accepting connection",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("rcvbuf", "Socket receive buffer size in bytes", cxxopts::value<uint32_t>());
+        options.add_options()("sndbuf", "Socket send buffer size in bytes", cxxopts::value<uint32_t>());
+        options.add_options()("busy-poll", "Microseconds to busy poll on socket reads", cxxopts::value<uint32_t>());
+        options.add_options()("read-timeout", "Milliseconds client has to send whole command, 0 to disable",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("idle-timeout", "Milliseconds connection could stay idle, 0 to disable",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("write-timeout", "Milliseconds client has to read responses, 0 to disable",
+                              cxxopts::value<uint32_t>());
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
 
@@ -144,8 +605,24 @@ int main(int argc, char **argv) {
     }
 
     // Start boot sequence
+    Settings settings(options);
     Application app;
-    app.Configure(options);
+    try {
+        if (options.count("config") > 0) {
+            settings.Load(options["config"].as<std::string>());
+        }
+
+        // Set by the previous process that hands its state over
+        int handoff = -1;
+        if (const char *channel = getenv(kHandoffVariable)) {
+            handoff = atoi(channel);
+            unsetenv(kHandoffVariable);
+        }
+        app.Configure(settings, handoff);
+    } catch (std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
 
     // POSIX specific staff
     {
@@ -163,6 +640,9 @@ int main(int argc, char **argv) {
 
         sigaction(SIGINT, &act, NULL);
         sigaction(SIGTERM, &act, NULL);
+        if (app.CanRestart()) {
+            sigaction(SIGUSR2, &act, NULL);
+        }
     }
 
     // Run app
@@ -170,9 +650,21 @@ int main(int argc, char **argv) {
         // Start services
         app.Start();
 
-        // Freeze main thread until one of signals arrive
-        while (stop_reason == 0 && ((sem_wait(&stop_semaphore) == -1) && (errno == EINTR))) {
-            continue;
+        while (true) {
+            // Freeze main thread until one of signals arrive. Each signal is waited for, so that the one
+            // that has caused failed restart doesn't wake the loop once again
+            while ((sem_wait(&stop_semaphore) == -1) && (errno == EINTR)) {
+                continue;
+            }
+            if (stop_reason != SIGUSR2) {
+                break;
+            }
+
+            // Everything is stopped already if new process took over
+            stop_reason = 0;
+            if (app.Restart(argv)) {
+                return 0;
+            }
         }
 
         // Stop services
@@ -0,0 +1,105 @@
+#include "Handoff.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/socket.h>
+
+namespace Afina {
+namespace Network {
+
+// Limits of a single message
+static constexpr std::size_t kMaxMessage = 4096;
+static constexpr std::size_t kMaxFds = 64;
+
+// See Handoff.h
+void send_handoff(int channel, const std::string &message, const std::vector<int> &fds) {
+    if (message.size() > kMaxMessage || fds.size() > kMaxFds) {
+        throw std::runtime_error("Handoff message is too large");
+    }
+
+    // Empty datagram can't carry descriptors
+    std::string data = message.empty() ? std::string(1, '\0') : message;
+    struct iovec iov;
+    iov.iov_base = const_cast<char *>(data.data());
+    iov.iov_len = data.size();
+
+    char control[CMSG_SPACE(sizeof(int) * kMaxFds)];
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (!fds.empty()) {
+        std::memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+        std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+    }
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(channel, &msg, MSG_NOSIGNAL);
+    } while (sent == -1 && errno == EINTR);
+    if (sent == -1) {
+        throw std::runtime_error("Failed to send handoff message: " + std::string(strerror(errno)));
+    }
+}
+
+// See Handoff.h
+bool recv_handoff(int channel, std::string &message, std::vector<int> &fds, int timeout_ms) {
+    struct pollfd pfd;
+    pfd.fd = channel;
+    pfd.events = POLLIN;
+    int ready;
+    do {
+        ready = poll(&pfd, 1, timeout_ms);
+    } while (ready == -1 && errno == EINTR);
+    if (ready <= 0) {
+        return false;
+    }
+
+    char data[kMaxMessage];
+    struct iovec iov;
+    iov.iov_base = data;
+    iov.iov_len = sizeof(data);
+
+    char control[CMSG_SPACE(sizeof(int) * kMaxFds)];
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do {
+        received = recvmsg(channel, &msg, MSG_CMSG_CLOEXEC);
+    } while (received == -1 && errno == EINTR);
+    if (received <= 0) {
+        return false;
+    }
+
+    fds.clear();
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            std::size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const int *received_fds = reinterpret_cast<const int *>(CMSG_DATA(cmsg));
+            fds.insert(fds.end(), received_fds, received_fds + n);
+        }
+    }
+
+    message.assign(data, received);
+    if (message == std::string(1, '\0')) {
+        message.clear();
+    }
+    return true;
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,28 @@
+#ifndef AFINA_NETWORK_HANDOFF_H
+#define AFINA_NETWORK_HANDOFF_H
+
+#include <string>
+#include <vector>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Messages between server process and its replacement
+ * Sent over unix seqpacket socket: short text along with file descriptors, which receiver gets as
+ * its own descriptors (SCM_RIGHTS). That is how listening sockets and cache memory survive restart.
+ *
+ * Throws std::runtime_error if message couldn't be sent
+ */
+void send_handoff(int channel, const std::string &message, const std::vector<int> &fds = {});
+
+/**
+ * Waits for message up to timeout_ms, received descriptors are close on exec. Returns false if peer
+ * has gone or timeout expired
+ */
+bool recv_handoff(int channel, std::string &message, std::vector<int> &fds, int timeout_ms);
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_HANDOFF_H
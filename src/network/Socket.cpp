@@ -0,0 +1,340 @@
+#include "Socket.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <mutex>
+#include <string>
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+
+namespace Afina {
+namespace Network {
+
+// Listening sockets of this process and sockets handed over by the previous one
+static std::mutex listen_mutex;
+static std::vector<int> listen_sockets;
+static std::vector<int> inherited_sockets;
+static bool handed_over = false;
+
+// Takes inherited socket bound to the same address, -1 if there is none
+static int take_inherited(const struct sockaddr *addr, socklen_t addrlen) {
+    std::lock_guard<std::mutex> lock(listen_mutex);
+    for (auto it = inherited_sockets.begin(); it != inherited_sockets.end(); it++) {
+        struct sockaddr_storage bound;
+        socklen_t boundlen = sizeof(bound);
+        if (getsockname(*it, (struct sockaddr *)&bound, &boundlen) == -1 || boundlen != addrlen ||
+            memcmp(&bound, addr, addrlen) != 0) {
+            continue;
+        }
+        int sfd = *it;
+        inherited_sockets.erase(it);
+        return sfd;
+    }
+    return -1;
+}
+
+// Settings could have changed since socket was created, blocking mode depends on the server
+static int adopt_socket(int sfd, const Config &config, bool nonblocking) {
+    try {
+        setup_listen_socket(sfd, config);
+        int flags = fcntl(sfd, F_GETFL, 0);
+        flags = nonblocking ? flags | O_NONBLOCK : flags & ~O_NONBLOCK;
+        if (fcntl(sfd, F_SETFL, flags) == -1) {
+            throw std::runtime_error("Failed to change socket blocking mode: " + std::string(strerror(errno)));
+        }
+    } catch (std::runtime_error &ex) {
+        close(sfd);
+        throw;
+    }
+    return sfd;
+}
+
+static void set_option(int sfd, int level, int name, int value, const char *title) {
+    if (setsockopt(sfd, level, name, &value, sizeof(value)) == -1) {
+        throw std::runtime_error(std::string("Failed to set ") + title + ": " + std::string(strerror(errno)));
+    }
+}
+
+// Binds socket, applies config and starts to listen. Socket is closed if anything fails
+static void listen_socket(int sfd, const struct sockaddr *addr, socklen_t addrlen, const Config &config,
+                          bool nonblocking) {
+    // Note that listen() doesn't block until incoming connections arrive. It just makes the OS aware that
+    // this process is willing to accept connections on this socket, up to backlog of them could wait
+    // to be accepted
+    try {
+        if (bind(sfd, addr, addrlen) == -1) {
+            throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+        }
+
+        setup_listen_socket(sfd, config);
+
+        if (nonblocking && fcntl(sfd, F_SETFL, fcntl(sfd, F_GETFL, 0) | O_NONBLOCK) == -1) {
+            throw std::runtime_error("Failed to make socket non blocking: " + std::string(strerror(errno)));
+        }
+
+        if (listen(sfd, config.backlog) == -1) {
+            throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+        }
+    } catch (std::runtime_error &ex) {
+        close(sfd);
+        throw;
+    }
+}
+
+static int open_tcp_socket(uint16_t port, const Config &config, bool nonblocking) {
+    struct sockaddr_in server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;         // IPv4
+    server_addr.sin_port = htons(port);       // TCP port number
+    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+
+    int sfd = take_inherited((struct sockaddr *)&server_addr, sizeof(server_addr));
+    if (sfd != -1) {
+        return adopt_socket(sfd, config, nonblocking);
+    }
+
+    sfd = socket(PF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (sfd == -1) {
+        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+    }
+
+    // When the server closes the socket, the connection must stay in the TIME_WAIT state to make sure
+    // the client received the acknowledgement that the connection has been terminated. During this time
+    // the port is unavailable to other processes unless we specify SO_REUSEADDR. Timed out connections
+    // are closed by server, so it is server side that keeps them in TIME_WAIT
+    int opts = 1;
+    if (setsockopt(sfd, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1 ||
+        setsockopt(sfd, SOL_SOCKET, SO_KEEPALIVE, &opts, sizeof(opts)) == -1) {
+        close(sfd);
+        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+    }
+
+    listen_socket(sfd, (struct sockaddr *)&server_addr, sizeof(server_addr), config, nonblocking);
+    return sfd;
+}
+
+static int open_unix_socket(const Config &config, bool nonblocking) {
+    struct sockaddr_un server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sun_family = AF_UNIX;
+    if (config.unix_socket.size() >= sizeof(server_addr.sun_path)) {
+        throw std::runtime_error("Unix socket path is too long: " + config.unix_socket);
+    }
+    std::strcpy(server_addr.sun_path, config.unix_socket.c_str());
+
+    socklen_t addrlen = offsetof(struct sockaddr_un, sun_path) + config.unix_socket.size() + 1;
+    int sfd = take_inherited((struct sockaddr *)&server_addr, addrlen);
+    if (sfd != -1) {
+        return adopt_socket(sfd, config, nonblocking);
+    }
+
+    // Socket file left by previous run would make bind fail, but anything else must stay untouched
+    struct stat st;
+    if (lstat(server_addr.sun_path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            throw std::runtime_error("File exists and it is not a socket: " + config.unix_socket);
+        }
+        unlink(server_addr.sun_path);
+    }
+
+    sfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sfd == -1) {
+        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+    }
+
+    listen_socket(sfd, (struct sockaddr *)&server_addr, sizeof(server_addr), config, nonblocking);
+    if (chmod(server_addr.sun_path, config.unix_mode) == -1) {
+        close(sfd);
+        unlink(server_addr.sun_path);
+        throw std::runtime_error("Failed to set unix socket permissions: " + std::string(strerror(errno)));
+    }
+    return sfd;
+}
+
+// See Socket.h
+void setup_listen_socket(int sfd, const Config &config) {
+    struct sockaddr_storage addr;
+    socklen_t addrlen = sizeof(addr);
+    if (getsockname(sfd, (struct sockaddr *)&addr, &addrlen) == -1) {
+        throw std::runtime_error("Socket getsockname() failed: " + std::string(strerror(errno)));
+    }
+
+    // Buffer sizes must be known before connection handshake, TCP window scale is chosen there
+    if (config.rcvbuf > 0) {
+        set_option(sfd, SOL_SOCKET, SO_RCVBUF, config.rcvbuf, "SO_RCVBUF");
+    }
+    if (config.sndbuf > 0) {
+        set_option(sfd, SOL_SOCKET, SO_SNDBUF, config.sndbuf, "SO_SNDBUF");
+    }
+
+    if (addr.ss_family != AF_INET && addr.ss_family != AF_INET6) {
+        return;
+    }
+
+    if (config.busy_poll > 0) {
+        set_option(sfd, SOL_SOCKET, SO_BUSY_POLL, config.busy_poll, "SO_BUSY_POLL");
+    }
+
+    int type = 0;
+    socklen_t typelen = sizeof(type);
+    if (getsockopt(sfd, SOL_SOCKET, SO_TYPE, &type, &typelen) == -1 || type != SOCK_STREAM) {
+        return;
+    }
+
+    if (config.tcp_nodelay) {
+        set_option(sfd, IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+    }
+    if (config.defer_accept > 0) {
+        set_option(sfd, IPPROTO_TCP, TCP_DEFER_ACCEPT, config.defer_accept, "TCP_DEFER_ACCEPT");
+    }
+}
+
+// See Socket.h
+std::vector<int> open_listen_sockets(uint16_t port, const Config &config, bool nonblocking) {
+    if (port == 0 && config.unix_socket.empty()) {
+        throw std::runtime_error("Neither TCP port nor unix socket is given to listen on");
+    }
+
+    std::vector<int> sockets;
+    if (port != 0) {
+        sockets.push_back(open_tcp_socket(port, config, nonblocking));
+    }
+
+    if (!config.unix_socket.empty()) {
+        try {
+            sockets.push_back(open_unix_socket(config, nonblocking));
+        } catch (std::runtime_error &ex) {
+            for (int sfd : sockets) {
+                close(sfd);
+            }
+            throw;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(listen_mutex);
+    listen_sockets.insert(listen_sockets.end(), sockets.begin(), sockets.end());
+    return sockets;
+}
+
+// See Socket.h
+int open_udp_socket(uint16_t port, const Config &config) {
+    struct sockaddr_in server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port);
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+
+    int sfd = socket(PF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (sfd == -1) {
+        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+    }
+
+    // Each thread gets its own socket on the same port, kernel spreads datagrams across them by
+    // hash of source address, so there is no contention on a single receive queue
+    try {
+        set_option(sfd, SOL_SOCKET, SO_REUSEADDR, 1, "SO_REUSEADDR");
+        set_option(sfd, SOL_SOCKET, SO_REUSEPORT, 1, "SO_REUSEPORT");
+        if (bind(sfd, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+            throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+        }
+        setup_listen_socket(sfd, config);
+    } catch (std::runtime_error &ex) {
+        close(sfd);
+        throw;
+    }
+    return sfd;
+}
+
+// See Socket.h
+void close_listen_sockets(std::vector<int> &sockets, const Config &config) {
+    std::lock_guard<std::mutex> lock(listen_mutex);
+    for (int sfd : sockets) {
+        listen_sockets.erase(std::remove(listen_sockets.begin(), listen_sockets.end(), sfd), listen_sockets.end());
+        close(sfd);
+    }
+    sockets.clear();
+
+    // Socket file belongs to the process sockets are handed over to
+    if (!config.unix_socket.empty() && !handed_over) {
+        unlink(config.unix_socket.c_str());
+    }
+}
+
+// See Socket.h
+std::vector<int> handover_listen_sockets() {
+    std::lock_guard<std::mutex> lock(listen_mutex);
+    std::vector<int> sockets;
+    for (int sfd : listen_sockets) {
+        int copy = fcntl(sfd, F_DUPFD_CLOEXEC, 0);
+        if (copy == -1) {
+            for (int c : sockets) {
+                close(c);
+            }
+            throw std::runtime_error("Failed to duplicate socket: " + std::string(strerror(errno)));
+        }
+        sockets.push_back(copy);
+    }
+    handed_over = true;
+    return sockets;
+}
+
+// See Socket.h
+void inherit_listen_sockets(const std::vector<int> &sockets) {
+    std::lock_guard<std::mutex> lock(listen_mutex);
+    inherited_sockets.insert(inherited_sockets.end(), sockets.begin(), sockets.end());
+    handed_over = false;
+}
+
+// See Socket.h
+void close_inherited_sockets() {
+    std::lock_guard<std::mutex> lock(listen_mutex);
+    for (int sfd : inherited_sockets) {
+        close(sfd);
+    }
+    inherited_sockets.clear();
+}
+
+// See Socket.h
+int accept_any(const std::vector<int> &sockets, struct sockaddr *addr, socklen_t *addrlen) {
+    if (sockets.size() == 1) {
+        return accept(sockets[0], addr, addrlen);
+    }
+
+    std::vector<struct pollfd> fds(sockets.size());
+    for (std::size_t i = 0; i < sockets.size(); i++) {
+        fds[i].fd = sockets[i];
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+    }
+
+    int ready;
+    while ((ready = poll(&fds[0], fds.size(), -1)) == -1 && errno == EINTR) {
+    }
+    if (ready == -1) {
+        return -1;
+    }
+
+    // Socket has been shutdown, accept reports that as well
+    for (auto &fd : fds) {
+        if (fd.revents != 0) {
+            return accept(fd.fd, addr, addrlen);
+        }
+    }
+    return -1;
+}
+
+} // namespace Network
+} // namespace Afina
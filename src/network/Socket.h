@@ -0,0 +1,74 @@
+#ifndef AFINA_NETWORK_SOCKET_H
+#define AFINA_NETWORK_SOCKET_H
+
+#include <vector>
+
+#include <sys/socket.h>
+
+#include <afina/network/Config.h>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * Applies socket level settings from config to the server socket, must be called before listen().
+ * Connections accepted on the socket inherit buffer sizes, TCP_NODELAY and busy poll settings, so
+ * there is no need to set them once again on each accepted socket. TCP specific settings are applied
+ * to TCP sockets only, busy poll to TCP and UDP ones.
+ *
+ * Throws std::runtime_error if some option couldn't be set, socket is left open
+ */
+void setup_listen_socket(int sfd, const Config &config);
+
+/**
+ * Creates sockets server accepts connections on: TCP one on the given port unless port is 0 and unix
+ * one if config has socket path. Returned sockets are bound, configured and listening.
+ *
+ * Throws std::runtime_error if any of sockets couldn't be created, none of them is left open then
+ */
+std::vector<int> open_listen_sockets(uint16_t port, const Config &config, bool nonblocking);
+
+/**
+ * Creates UDP socket bound to the given port with SO_REUSEPORT, so that several sockets could share
+ * the port. Socket is blocking and configured the same way as listening ones.
+ *
+ * Throws std::runtime_error if socket couldn't be created
+ */
+int open_udp_socket(uint16_t port, const Config &config);
+
+/**
+ * Closes sockets created by open_listen_sockets and removes unix socket file
+ */
+void close_listen_sockets(std::vector<int> &sockets, const Config &config);
+
+/**
+ * Duplicates listening sockets open at the moment, so that they outlive server stop and could be
+ * passed to another process. Connections keep queueing on them meanwhile. From now on unix socket
+ * file is left in place when sockets are closed.
+ *
+ * Throws std::runtime_error if sockets couldn't be duplicated
+ */
+std::vector<int> handover_listen_sockets();
+
+/**
+ * Gives sockets passed by previous process to open_listen_sockets: it takes socket bound to the same
+ * address rather than creates new one, so that connections queued there are not lost. Takes sockets
+ * back after failed handover as well, unix socket file belongs to this process again
+ */
+void inherit_listen_sockets(const std::vector<int> &sockets);
+
+/**
+ * Closes inherited sockets nobody has taken
+ */
+void close_inherited_sockets();
+
+/**
+ * Blocks until connection arrives on any of blocking listening sockets and accepts it. Returns -1 and
+ * sets errno if accept fails, in particular once sockets have been shutdown
+ */
+int accept_any(const std::vector<int> &sockets, struct sockaddr *addr, socklen_t *addrlen);
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_SOCKET_H
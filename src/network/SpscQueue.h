@@ -0,0 +1,97 @@
+#ifndef AFINA_NETWORK_SPSC_QUEUE_H
+#define AFINA_NETWORK_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Bounded single producer single consumer queue
+ * Lock-free ring buffer, Push must be called from one thread only and Pop from one (possibly other)
+ * thread only. Neither of them ever blocks or allocates memory.
+ *
+ * Producer and consumer positions live in separate cache lines, each side also keeps a private copy
+ * of the other side position, so that shared line is touched only once queue looks full/empty
+ */
+template <typename T> class SpscQueue {
+public:
+    /**
+     * @param capacity maximum number of elements, rounded up to the power of two
+     */
+    explicit SpscQueue(std::size_t capacity) : _head(0), _tail(0), _cached_head(0), _cached_tail(0) {
+        std::size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _buffer.resize(size);
+        _mask = size - 1;
+    }
+
+    /**
+     * Enqueue element, returns false if queue is full. Producer side
+     */
+    bool Push(const T &value) {
+        std::size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _cached_head > _mask) {
+            _cached_head = _head.load(std::memory_order_acquire);
+            if (tail - _cached_head > _mask) {
+                return false;
+            }
+        }
+
+        _buffer[tail & _mask] = value;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Dequeue element, returns false if queue is empty. Consumer side
+     */
+    bool Pop(T &value) {
+        std::size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _cached_tail) {
+            _cached_tail = _tail.load(std::memory_order_acquire);
+            if (head == _cached_tail) {
+                return false;
+            }
+        }
+
+        value = _buffer[head & _mask];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Maximum number of elements queue could hold
+     */
+    std::size_t capacity() const { return _mask + 1; }
+
+private:
+    static constexpr std::size_t kCacheLine = 64;
+
+    std::vector<T> _buffer;
+    std::size_t _mask;
+
+    // Next position to read, written by consumer only
+    std::atomic<std::size_t> _head;
+    char _pad0[kCacheLine - sizeof(std::atomic<std::size_t>)];
+
+    // Next position to write, written by producer only
+    std::atomic<std::size_t> _tail;
+    char _pad1[kCacheLine - sizeof(std::atomic<std::size_t>)];
+
+    // Last seen _head, producer side
+    std::size_t _cached_head;
+    char _pad2[kCacheLine - sizeof(std::size_t)];
+
+    // Last seen _tail, consumer side
+    std::size_t _cached_tail;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_SPSC_QUEUE_H
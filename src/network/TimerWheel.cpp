@@ -0,0 +1,74 @@
+#include "TimerWheel.h"
+
+#include <chrono>
+
+namespace Afina {
+namespace Network {
+
+static uint64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// See TimerWheel.h
+TimerWheel::TimerWheel(uint32_t tick_ms, std::size_t slots)
+    : _tick_ms(tick_ms), _slots(slots, nullptr), _current(0), _size(0) {
+    _current = NowTick();
+}
+
+// See TimerWheel.h
+void TimerWheel::Schedule(Timer *timer, uint32_t timeout_ms) {
+    if (timer->linked) {
+        Unlink(timer);
+    }
+
+    // Round up, timer must not fire earlier than requested
+    timer->expire = NowTick() + (timeout_ms + _tick_ms - 1) / _tick_ms + 1;
+
+    Timer *&head = _slots[timer->expire % _slots.size()];
+    timer->prev = nullptr;
+    timer->next = head;
+    if (head != nullptr) {
+        head->prev = timer;
+    }
+    head = timer;
+    timer->linked = true;
+    _size++;
+}
+
+// See TimerWheel.h
+void TimerWheel::Cancel(Timer *timer) {
+    if (timer->linked) {
+        Unlink(timer);
+    }
+}
+
+// See TimerWheel.h
+int TimerWheel::NextTimeout() const {
+    if (_size == 0) {
+        return -1;
+    }
+    return _tick_ms - now_ms() % _tick_ms;
+}
+
+uint64_t TimerWheel::NowTick() const { return now_ms() / _tick_ms; }
+
+void TimerWheel::Unlink(Timer *timer) {
+    if (timer->prev != nullptr) {
+        timer->prev->next = timer->next;
+    } else {
+        _slots[timer->expire % _slots.size()] = timer->next;
+    }
+
+    if (timer->next != nullptr) {
+        timer->next->prev = timer->prev;
+    }
+
+    timer->prev = timer->next = nullptr;
+    timer->linked = false;
+    _size--;
+}
+
+} // namespace Network
+} // namespace Afina
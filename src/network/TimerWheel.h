@@ -0,0 +1,112 @@
+#ifndef AFINA_NETWORK_TIMER_WHEEL_H
+#define AFINA_NETWORK_TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Hashed timing wheel
+ * Keeps deadlines of many timers with O(1) schedule/cancel. Wheel time advances in ticks, each
+ * timer is placed in a slot its deadline tick hashes to, so advancing wheel on one tick only looks
+ * at timers of a single slot. Timers farther than one wheel rotation away just stay in the slot
+ * until their round comes.
+ *
+ * Timers are intrusive, wheel doesn't own them and never allocates memory after construction.
+ * Not threadsafe, supposed to be owned by a single event loop
+ */
+class TimerWheel {
+public:
+    struct Timer {
+        // Anything owner wants to find by the timer once it expires
+        void *data = nullptr;
+
+        // Tick timer expires at
+        uint64_t expire = 0;
+
+        // Links in the slot list
+        Timer *prev = nullptr;
+        Timer *next = nullptr;
+        bool linked = false;
+    };
+
+    /**
+     * @param tick_ms wheel resolution, timers never expire earlier than requested but could be up to
+     *        one tick late
+     * @param slots number of slots in the wheel
+     */
+    TimerWheel(uint32_t tick_ms = 100, std::size_t slots = 512);
+
+    /**
+     * (Re)arm timer to expire after given number of milliseconds since now
+     */
+    void Schedule(Timer *timer, uint32_t timeout_ms);
+
+    /**
+     * Disarm timer, noop if it is not scheduled
+     */
+    void Cancel(Timer *timer);
+
+    /**
+     * Moves wheel time to now and calls func(Timer *) for each timer which has expired. Timer is
+     * already unlinked once func gets it, so func is free to delete it or schedule again
+     */
+    template <typename F> void Advance(F &&func) {
+        uint64_t now = NowTick();
+        if (now <= _current) {
+            return;
+        }
+
+        // Wheel could be advanced rarely, in such case there is no need to visit a slot more than once
+        uint64_t from = _current + 1;
+        if (now - _current > _slots.size()) {
+            from = now - _slots.size() + 1;
+        }
+        _current = now;
+
+        for (uint64_t tick = from; tick <= now; tick++) {
+            Timer *timer = _slots[tick % _slots.size()];
+            while (timer != nullptr) {
+                Timer *next = timer->next;
+                if (timer->expire <= now) {
+                    Unlink(timer);
+                    func(timer);
+                }
+                timer = next;
+            }
+        }
+    }
+
+    /**
+     * Milliseconds until next wheel tick, suitable as epoll_wait timeout. Returns -1 if there are
+     * no timers scheduled so there is no reason to wake up
+     */
+    int NextTimeout() const;
+
+    /**
+     * Number of scheduled timers
+     */
+    std::size_t size() const { return _size; }
+
+private:
+    uint64_t NowTick() const;
+    void Unlink(Timer *timer);
+
+    const uint32_t _tick_ms;
+
+    // Heads of the slot lists
+    std::vector<Timer *> _slots;
+
+    // Last tick wheel has been advanced to
+    uint64_t _current;
+
+    std::size_t _size;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_TIMER_WHEEL_H
@@ -0,0 +1,74 @@
+#include "ServerImpl.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <pthread.h>
+#include <signal.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Metrics.h>
+#include <afina/logging/Service.h>
+
+#include "Worker.h"
+#include "network/Socket.h"
+
+namespace Afina {
+namespace Network {
+namespace Coro {
+
+// See Server.h
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       const Config &cfg)
+    : Server(ps, pl, cfg) {}
+
+// See Server.h
+ServerImpl::~ServerImpl() {}
+
+// See Server.h
+void ServerImpl::Start(uint16_t port, uint32_t, uint32_t n_workers) {
+    _logger = pLogging->select("network");
+    _logger->info("Start coro network service");
+    _number_connections.store(0);
+
+    sigset_t sig_mask;
+    sigemptyset(&sig_mask);
+    sigaddset(&sig_mask, SIGPIPE);
+    if (pthread_sigmask(SIG_BLOCK, &sig_mask, NULL) != 0) {
+        throw std::runtime_error("Unable to mask SIGPIPE");
+    }
+
+    _server_sockets = open_listen_sockets(port, config, true);
+
+    _workers.reserve(n_workers);
+    for (uint32_t i = 0; i < n_workers; i++) {
+        _workers.emplace_back(new Worker(pStorage, pLogging, config, _server_sockets, &_number_connections));
+        _workers.back()->Start(i);
+    }
+
+    Metrics::Instance().Register("curr_connections", [this] { return _number_connections.load(); });
+}
+
+// See Server.h
+void ServerImpl::Stop() {
+    _logger->warn("Stop network service");
+    for (auto &w : _workers) {
+        w->Stop();
+    }
+}
+
+// See Server.h
+void ServerImpl::Join() {
+    for (auto &w : _workers) {
+        w->Join();
+    }
+    _workers.clear();
+    close_listen_sockets(_server_sockets, config);
+
+    Metrics::Instance().Unregister("curr_connections");
+}
+
+} // namespace Coro
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,57 @@
+#ifndef AFINA_NETWORK_CORO_SERVER_H
+#define AFINA_NETWORK_CORO_SERVER_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <afina/network/Server.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+namespace Coro {
+
+// Forward declaration, see Worker.h
+class Worker;
+
+/**
+ * # Network resource manager implementation
+ * Server running a coroutine per connection on a few threads, each with its own coroutine engine
+ * and epoll instance. Workers accept connections themselves, so acceptors setting is not used
+ */
+class ServerImpl : public Server {
+public:
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               const Config &cfg = Config());
+    ~ServerImpl();
+
+    // See Server.h
+    void Start(uint16_t port, uint32_t acceptors, uint32_t workers) override;
+
+    // See Server.h
+    void Stop() override;
+
+    // See Server.h
+    void Join() override;
+
+private:
+    // logger to use
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Sockets to accept connections on: TCP and/or unix one
+    std::vector<int> _server_sockets;
+
+    // Threads running coroutines
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::atomic<int> _number_connections;
+};
+
+} // namespace Coro
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_CORO_SERVER_H
@@ -0,0 +1,473 @@
+#include "Worker.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <netdb.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/allocator/Numa.h>
+#include <afina/execute/Command.h>
+#include <afina/logging/Service.h>
+
+#include "protocol/Parser.h"
+
+namespace Afina {
+namespace Network {
+namespace Coro {
+
+using clock = std::chrono::steady_clock;
+
+// Responses are sent once connection runs out of input or once that many bytes are buffered
+static constexpr std::size_t kOutputFlushSize = 64 * 1024;
+
+static clock::time_point deadline_after(uint32_t timeout_ms) {
+    if (timeout_ms == 0) {
+        return clock::time_point::max();
+    }
+    return clock::now() + std::chrono::milliseconds(timeout_ms);
+}
+
+// See Worker.h
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl, const Config &config,
+               const std::vector<int> &server_sockets, std::atomic<int> *number_connections)
+    : _pStorage(ps), _pLogging(pl), _config(config), _server_sockets(server_sockets), _epoll_fd(-1), _event_fd(-1),
+      _engine(nullptr), _waiters(nullptr), _stopping(false), _number_connections(number_connections), _i(0) {}
+
+// See Worker.h
+Worker::~Worker() {
+    if (_epoll_fd != -1) {
+        close(_epoll_fd);
+    }
+    if (_event_fd != -1) {
+        close(_event_fd);
+    }
+}
+
+// See Worker.h
+void Worker::Start(int i) {
+    assert(_epoll_fd == -1);
+    _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll_fd == -1) {
+        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+    }
+
+    _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_event_fd == -1) {
+        throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+    }
+
+    // Waiters are never at null, so it marks stop signal
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event)) {
+        throw std::runtime_error("Failed to add eventfd descriptor to epoll");
+    }
+
+    _logger = _pLogging->select("network.worker");
+    _i = i;
+    _thread = std::thread(&Worker::OnRun, this);
+}
+
+// See Worker.h
+void Worker::Stop() {
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup worker");
+    }
+}
+
+// See Worker.h
+void Worker::Join() {
+    assert(_thread.joinable());
+    _thread.join();
+}
+
+// See Worker.h
+void Worker::OnRun() {
+    _logger->trace("OnRun {}", _i);
+
+    if (_config.numa) {
+        try {
+            int node = Afina::Allocator::pin_thread_round_robin(_i);
+            _logger->debug("Worker {} runs on NUMA node {}", _i, node);
+        } catch (std::exception &ex) {
+            _logger->error("Failed to pin worker {}: {}", _i, ex.what());
+        }
+    }
+
+    // Engine returns once acceptors and all connections are done, that happens only after stop
+    Afina::Coroutine::Engine engine(kStackSize, [this] { OnIdle(); });
+    _engine = &engine;
+    try {
+        engine.start(&Worker::Main, *this);
+    } catch (std::exception &ex) {
+        _logger->error("Worker {} failed: {}", _i, ex.what());
+    }
+    _engine = nullptr;
+    _logger->warn("Worker {} stopped", _i);
+}
+
+// See Worker.h
+void Worker::OnIdle() {
+    std::array<struct epoll_event, 64> mod_list;
+    int nmod = epoll_wait(_epoll_fd, &mod_list[0], mod_list.size(), _timers.NextTimeout());
+    if (nmod == -1) {
+        if (errno == EINTR) {
+            return;
+        }
+        throw std::runtime_error("Failed to wait for events: " + std::string(strerror(errno)));
+    }
+    _logger->debug("Worker wokeup: {} events", nmod);
+
+    for (int i = 0; i < nmod; i++) {
+        struct epoll_event &current_event = mod_list[i];
+        if (current_event.data.ptr == nullptr) {
+            OnStop();
+            continue;
+        }
+
+        // Descriptor is registered once for all events, so coroutine might be busy or waiting for
+        // something else. It tries I/O before waiting anyway, so such event is not lost
+        Waiter *waiter = static_cast<Waiter *>(current_event.data.ptr);
+        if (waiter->routine != nullptr && (current_event.events & waiter->events) != 0) {
+            _timers.Cancel(&waiter->timer);
+            _engine->unblock(waiter->routine);
+        }
+    }
+
+    _timers.Advance([this](TimerWheel::Timer *timer) {
+        Waiter *waiter = static_cast<Waiter *>(timer->data);
+        waiter->timed_out = true;
+        _engine->unblock(waiter->routine);
+    });
+}
+
+// See Worker.h
+void Worker::OnStop() {
+    eventfd_t value;
+    eventfd_read(_event_fd, &value);
+    if (_stopping) {
+        return;
+    }
+
+    _logger->debug("Stop worker {}", _i);
+    uint32_t timeout = _config.write_timeout > 0 ? _config.write_timeout : kShutdownTimeout;
+    _stopping = true;
+    _shutdown_deadline = deadline_after(timeout);
+
+    // Acceptors and readers give up, writers get limited time to deliver responses
+    for (Waiter *waiter = _waiters; waiter != nullptr; waiter = waiter->next) {
+        if (waiter->routine == nullptr) {
+            continue;
+        }
+        if (waiter->events & EPOLLIN) {
+            _timers.Cancel(&waiter->timer);
+            _engine->unblock(waiter->routine);
+        } else {
+            _timers.Schedule(&waiter->timer, timeout);
+        }
+    }
+}
+
+// See Worker.h
+void Worker::Main(Worker &worker) {
+    for (int sfd : worker._server_sockets) {
+        worker._engine->run(&Worker::Accept, worker, static_cast<int>(sfd));
+    }
+}
+
+// See Worker.h
+void Worker::Accept(Worker &worker, int sfd) {
+    Waiter waiter;
+    worker.Watch(waiter, sfd, EPOLLIN | EPOLLEXCLUSIVE);
+
+    while (!worker._stopping) {
+        std::size_t n_accepted = 0;
+        while (n_accepted < kAcceptBatch) {
+            struct sockaddr_storage in_addr;
+            socklen_t in_len = sizeof in_addr;
+            int infd = accept4(sfd, (struct sockaddr *)&in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (infd == -1) {
+                if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                    worker._logger->error("Failed to accept socket: {}", strerror(errno));
+                }
+                break;
+            }
+
+            if (worker._logger->should_log(spdlog::level::debug)) {
+                char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+                if (getnameinfo((struct sockaddr *)&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf,
+                                NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
+                    worker._logger->debug("Accepted connection on descriptor {} (host={}, port={})", infd, hbuf,
+                                          sbuf);
+                }
+            }
+
+            // Connection starts once acceptor blocks or yields
+            try {
+                worker._engine->run(&Worker::Serve, worker, static_cast<int>(infd));
+            } catch (std::exception &ex) {
+                worker._logger->error("Failed to start connection coroutine: {}", ex.what());
+                close(infd);
+            }
+            n_accepted++;
+        }
+
+        // Let accepted connections run before taking more, backlog is still there
+        if (n_accepted == kAcceptBatch) {
+            worker._engine->yield();
+        } else {
+            worker.Wait(waiter, EPOLLIN, clock::time_point::max());
+        }
+    }
+    worker.Unwatch(waiter, sfd);
+}
+
+// See Worker.h
+void Worker::Serve(Worker &worker, int client_socket) {
+    Waiter waiter;
+    try {
+        worker.Watch(waiter, client_socket, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET);
+    } catch (std::runtime_error &ex) {
+        worker._logger->error("Failed to serve connection on descriptor {}: {}", client_socket, ex.what());
+        close(client_socket);
+        return;
+    }
+    (*worker._number_connections)++;
+
+    // Here is connection state
+    // - parser: parse state of the stream
+    // - command_to_execute: last command parsed out of stream
+    // - arg_remains: how many bytes to read from stream to get command argument
+    // - argument_for_command: buffer stores argument
+    // - output: responses not sent yet
+    // - command_deadline: time client has to complete command it has started to send
+    std::size_t arg_remains = 0;
+    Protocol::Parser parser;
+    std::string argument_for_command;
+    std::unique_ptr<Execute::Command> command_to_execute;
+    std::string output;
+    bool command_started = false;
+    clock::time_point command_deadline;
+    try {
+        std::size_t readed_bytes = 0;
+        bool need_input = false; // parser needs more than is buffered
+        char client_buffer[4096];
+        while (true) {
+            if (need_input || readed_bytes == 0) {
+                // Responses to everything client has sent so far go out at once
+                if (!output.empty()) {
+                    if (!worker.Write(waiter, client_socket, output)) {
+                        worker._logger->debug("Write timeout on descriptor {}", client_socket);
+                        break;
+                    }
+                    output.clear();
+                }
+
+                // Commands which are already read are done, no more
+                if (worker._stopping) {
+                    break;
+                }
+
+                clock::time_point deadline =
+                    command_started ? command_deadline : deadline_after(worker._config.idle_timeout);
+                if (readed_bytes == sizeof(client_buffer)) {
+                    throw std::runtime_error("Command is too long");
+                }
+                std::size_t n = worker.Read(waiter, client_socket, client_buffer + readed_bytes,
+                                            sizeof(client_buffer) - readed_bytes, deadline);
+                if (n == 0) {
+                    worker._logger->debug("Connection on descriptor {} closed", client_socket);
+                    break;
+                }
+                readed_bytes += n;
+                need_input = false;
+                if (!command_started) {
+                    command_started = true;
+                    command_deadline = deadline_after(worker._config.read_timeout);
+                }
+            }
+
+            // There is no command yet
+            if (!command_to_execute) {
+                std::size_t parsed = 0;
+                if (parser.Parse(client_buffer, readed_bytes, parsed)) {
+                    command_to_execute = parser.Build(arg_remains);
+                    if (arg_remains > 0) {
+                        arg_remains += 2;
+                    }
+                }
+
+                // Parsed might fails to consume any bytes from input stream. In real life that could happens,
+                // for example, because we are working with UTF-16 chars and only 1 byte left in stream
+                if (parsed == 0) {
+                    need_input = true;
+                    continue;
+                }
+                std::memmove(client_buffer, client_buffer + parsed, readed_bytes - parsed);
+                readed_bytes -= parsed;
+            }
+
+            // There is command, but we still wait for argument to arrive...
+            if (command_to_execute && arg_remains > 0) {
+                std::size_t to_read = std::min(arg_remains, readed_bytes);
+                argument_for_command.append(client_buffer, to_read);
+
+                std::memmove(client_buffer, client_buffer + to_read, readed_bytes - to_read);
+                arg_remains -= to_read;
+                readed_bytes -= to_read;
+            }
+
+            // Thre is command & argument - RUN!
+            if (command_to_execute && arg_remains == 0) {
+                std::string result;
+                try {
+                    command_to_execute->Execute(*worker._pStorage, argument_for_command, result);
+                } catch (std::exception &ex) {
+                    result = std::string("SERVER_ERROR ") + ex.what();
+                }
+                output += result;
+                output += "\r\n";
+
+                // Prepare for the next command, rest of the input is its beginning
+                command_to_execute.reset();
+                argument_for_command.resize(0);
+                parser.Reset();
+                command_started = readed_bytes > 0;
+                command_deadline = deadline_after(worker._config.read_timeout);
+
+                if (output.size() >= kOutputFlushSize) {
+                    if (!worker.Write(waiter, client_socket, output)) {
+                        worker._logger->debug("Write timeout on descriptor {}", client_socket);
+                        break;
+                    }
+                    output.clear();
+                }
+            }
+        }
+    } catch (std::runtime_error &ex) {
+        worker._logger->error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
+    }
+
+    // We are done with this connection
+    worker.Unwatch(waiter, client_socket);
+    close(client_socket);
+    (*worker._number_connections)--;
+}
+
+// See Worker.h
+std::size_t Worker::Read(Waiter &waiter, int socket, char *buffer, std::size_t size,
+                         std::chrono::steady_clock::time_point deadline) {
+    while (!_stopping) {
+        ssize_t n = read(socket, buffer, size);
+        if (n >= 0) {
+            return n;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            throw std::runtime_error(std::string(strerror(errno)));
+        }
+        if (!Wait(waiter, EPOLLIN | EPOLLRDHUP, deadline)) {
+            _logger->debug("Read timeout on descriptor {}", socket);
+            return 0;
+        }
+    }
+    return 0;
+}
+
+// See Worker.h
+bool Worker::Write(Waiter &waiter, int socket, const std::string &buffer) {
+    std::size_t sent = 0;
+    while (sent < buffer.size()) {
+        ssize_t n = send(socket, buffer.data() + sent, buffer.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += n;
+            continue;
+        }
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            throw std::runtime_error("Failed to send response: " + std::string(strerror(errno)));
+        }
+
+        // Any progress moves deadline forward, but stop gives limited time for the whole output
+        clock::time_point deadline = _stopping ? _shutdown_deadline : deadline_after(_config.write_timeout);
+        if (!Wait(waiter, EPOLLOUT, deadline)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// See Worker.h
+bool Worker::Wait(Waiter &waiter, uint32_t events, std::chrono::steady_clock::time_point deadline) {
+    if (deadline != clock::time_point::max()) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count();
+        if (left <= 0) {
+            return false;
+        }
+        _timers.Schedule(&waiter.timer, left);
+    }
+
+    waiter.routine = _engine->current();
+    waiter.events = events | EPOLLERR | EPOLLHUP;
+    waiter.timed_out = false;
+    _engine->block();
+
+    waiter.routine = nullptr;
+    _timers.Cancel(&waiter.timer);
+    return !waiter.timed_out;
+}
+
+// See Worker.h
+void Worker::Watch(Waiter &waiter, int fd, uint32_t events) {
+    struct epoll_event event;
+    event.events = events;
+    event.data.ptr = &waiter;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &event)) {
+        throw std::runtime_error("Failed to add file descriptor to epoll: " + std::string(strerror(errno)));
+    }
+
+    waiter.timer.data = &waiter;
+    waiter.prev = nullptr;
+    waiter.next = _waiters;
+    if (_waiters != nullptr) {
+        _waiters->prev = &waiter;
+    }
+    _waiters = &waiter;
+}
+
+// See Worker.h
+void Worker::Unwatch(Waiter &waiter, int fd) {
+    epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    _timers.Cancel(&waiter.timer);
+
+    if (waiter.prev != nullptr) {
+        waiter.prev->next = waiter.next;
+    }
+    if (waiter.next != nullptr) {
+        waiter.next->prev = waiter.prev;
+    }
+    if (_waiters == &waiter) {
+        _waiters = waiter.next;
+    }
+}
+
+} // namespace Coro
+} // namespace Network
+} // namespace Afina
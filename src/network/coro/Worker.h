@@ -0,0 +1,200 @@
+#ifndef AFINA_NETWORK_CORO_WORKER_H
+#define AFINA_NETWORK_CORO_WORKER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/coroutine/Engine.h>
+#include <afina/network/Config.h>
+
+#include "network/TimerWheel.h"
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+namespace Logging {
+class Service;
+}
+
+namespace Network {
+namespace Coro {
+
+/**
+ * # Thread running coroutines
+ * Each connection is served by a coroutine written as plain blocking code: read, execute, write.
+ * Once socket isn't ready coroutine blocks in the engine and other ones run meanwhile. When every
+ * coroutine is blocked engine calls epoll_wait, which unblocks coroutines whose sockets got ready
+ * or whose timers have expired.
+ *
+ * Worker accepts connections itself: listening sockets are shared by all workers, each worker has
+ * a coroutine per listening socket that waits for it with EPOLLEXCLUSIVE so that a new connection
+ * wakes up one worker only. Connection stays on the worker which accepted it
+ */
+class Worker {
+public:
+    /**
+     * @param server_sockets nonblocking listening sockets, owned by the caller
+     */
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl, const Config &config,
+           const std::vector<int> &server_sockets, std::atomic<int> *number_connections);
+    ~Worker();
+
+    /**
+     * Spawns background thread running the engine
+     */
+    void Start(int i);
+
+    /**
+     * Signals worker to stop. Worker stops accepting connections and reading commands, connections
+     * are closed once responses to commands already read are sent out
+     */
+    void Stop();
+
+    /**
+     * Blocks calling thread until background one is done
+     */
+    void Join();
+
+private:
+    Worker(Worker &) = delete;
+    Worker &operator=(Worker &) = delete;
+
+    /**
+     * Coroutine waiting for a descriptor, epoll event of the descriptor points to it
+     */
+    struct Waiter {
+        // Blocked coroutine, nullptr if it isn't waiting now
+        void *routine = nullptr;
+
+        // Events coroutine waits for
+        uint32_t events = 0;
+
+        // Deadline of the wait
+        TimerWheel::Timer timer;
+        bool timed_out = false;
+
+        // Links in the list of waiters of the worker
+        Waiter *prev = nullptr;
+        Waiter *next = nullptr;
+    };
+
+    /**
+     * Method executing by background thread
+     */
+    void OnRun();
+
+    /**
+     * Idle hook of the engine: waits for events and unblocks coroutines interested in them
+     */
+    void OnIdle();
+
+    /**
+     * Stops accepting connections and wakes up everybody waiting for input
+     */
+    void OnStop();
+
+    /**
+     * The first coroutine, starts acceptors
+     */
+    static void Main(Worker &worker);
+
+    /**
+     * Coroutine accepting connections on a listening socket
+     */
+    static void Accept(Worker &worker, int sfd);
+
+    /**
+     * Coroutine serving a connection until it is closed
+     */
+    static void Serve(Worker &worker, int socket);
+
+    /**
+     * Reads into buffer, blocks until there is something to read. Returns number of bytes read, 0 on
+     * EOF, deadline or stop, throws std::runtime_error on error
+     */
+    std::size_t Read(Waiter &waiter, int socket, char *buffer, std::size_t size,
+                     std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * Writes the whole buffer out, blocks while socket is not ready. Returns false on timeout, throws
+     * std::runtime_error on error
+     */
+    bool Write(Waiter &waiter, int socket, const std::string &buffer);
+
+    /**
+     * Blocks current coroutine until one of events arrives. Returns false once deadline passes,
+     * time_point::max() waits forever
+     */
+    bool Wait(Waiter &waiter, uint32_t events, std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * Adds descriptor to epoll with events pointing to the waiter
+     */
+    void Watch(Waiter &waiter, int fd, uint32_t events);
+    void Unwatch(Waiter &waiter, int fd);
+
+    // Milliseconds client has to read responses after server started to stop, unless write
+    // timeout is given
+    static constexpr uint32_t kShutdownTimeout = 5000;
+
+    // Stack of each coroutine. Memory is committed once touched, so that is mostly a limit
+    static constexpr std::size_t kStackSize = 64 * 1024;
+
+    // Connections accepted in a row before acceptor lets other coroutines run
+    static constexpr std::size_t kAcceptBatch = 32;
+
+    // afina services
+    std::shared_ptr<Afina::Storage> _pStorage;
+
+    // afina services
+    std::shared_ptr<Afina::Logging::Service> _pLogging;
+
+    // Logger to be used
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Timeouts to apply
+    const Config _config;
+
+    // Sockets to accept connections on
+    const std::vector<int> _server_sockets;
+
+    // Thread running the engine
+    std::thread _thread;
+
+    // EPOLL descriptor using for events processing
+    int _epoll_fd;
+
+    // Custom event "device" used to stop worker
+    int _event_fd;
+
+    // Engine running coroutines of the worker, lives on the worker thread
+    Afina::Coroutine::Engine *_engine;
+
+    // Deadlines of waits
+    TimerWheel _timers;
+
+    // Coroutines that have registered descriptors in epoll
+    Waiter *_waiters;
+
+    // Set once worker got stop signal, the deadline for connections to flush their output
+    bool _stopping;
+    std::chrono::steady_clock::time_point _shutdown_deadline;
+
+    std::atomic<int> *_number_connections;
+    int _i;
+};
+
+} // namespace Coro
+} // namespace Network
+} // namespace Afina
+#endif // AFINA_NETWORK_CORO_WORKER_H
@@ -21,6 +21,7 @@
 #include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
 
+#include "network/Socket.h"
 #include "protocol/Parser.h"
 
 namespace Afina {
@@ -28,7 +29,9 @@ namespace Network {
 namespace MTblocking {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       const Config &cfg)
+    : Server(ps, pl, cfg) {
     _max_thread = std::thread::hardware_concurrency();
 }
 
@@ -47,35 +50,9 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+    _server_sockets = open_listen_sockets(port, config, false);
 
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket");
-    }
-
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed");
-    }
-
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed");
-    }
-
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket listen() failed");
-    }
-
-    // for test
-    _max_thread = 3;
+    _max_thread = n_workers;
     running.store(true);
     _thread = std::thread(&ServerImpl::OnRun, this);
 }
@@ -83,9 +60,12 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
 // See Server.h
 void ServerImpl::Stop() {
     running.store(false);
-    shutdown(_server_socket, SHUT_RDWR);
+    for (int sfd : _server_sockets) {
+        shutdown(sfd, SHUT_RDWR);
+    }
     {
         std::lock_guard<std::mutex> lock_network(_networ_mutex);
+        _network_cond_var.notify_all();
         for (std::pair<const int, std::thread> & element : _worker_index) {
             shutdown(element.first, SHUT_RD);
         }
@@ -104,7 +84,7 @@ void ServerImpl::Join() {
 
     assert(_thread.joinable());
     _thread.join();
-    close(_server_socket);
+    close_listen_sockets(_server_sockets, config);
 }
 
 void ServerImpl::_Worker(int client_socket) {
@@ -197,9 +177,9 @@ void ServerImpl::_Worker(int client_socket) {
         std::lock_guard<std::mutex> lock_network(_networ_mutex);
         _worker_index[client_socket].detach();
         _worker_index.erase(client_socket);
-        if (_worker_index.empty()){
-            _network_cond_var.notify_one();
-        }
+
+        // Either acceptor waits for a free thread or Join waits for all of them
+        _network_cond_var.notify_all();
     }
 }
 
@@ -215,13 +195,22 @@ void ServerImpl::OnRun() {
     std::string argument_for_command;
     std::unique_ptr<Execute::Command> command_to_execute;
     while (running.load()) {
+        // Don't take connections we have no thread for, they wait in the listen backlog meanwhile
+        {
+            std::unique_lock<std::mutex> lock_network(_networ_mutex);
+            while (running.load() && _worker_index.size() >= _max_thread) {
+                _network_cond_var.wait(lock_network);
+            }
+        }
+
         _logger->debug("waiting for connection...");
 
         // The call to accept() blocks until the incoming connection arrives
         int client_socket;
-        struct sockaddr client_addr;
+        struct sockaddr_storage client_addr;
         socklen_t client_addr_len = sizeof(client_addr);
-        if ((client_socket = accept(_server_socket, (struct sockaddr *)&client_addr, &client_addr_len)) == -1) {
+        client_socket = accept_any(_server_sockets, (struct sockaddr *)&client_addr, &client_addr_len);
+        if (client_socket == -1) {
             continue;
         }
 
@@ -230,25 +219,31 @@ void ServerImpl::OnRun() {
             std::string host = "unknown", port = "-1";
 
             char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
-            if (getnameinfo(&client_addr, client_addr_len, hbuf, sizeof(hbuf), sbuf, sizeof(sbuf),
-                            NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
+            if (getnameinfo((struct sockaddr *)&client_addr, client_addr_len, hbuf, sizeof(hbuf), sbuf,
+                            sizeof(sbuf), NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
                 host = hbuf;
                 port = sbuf;
             }
             _logger->debug("Accepted connection on descriptor {} (host={}, port={})\n", client_socket, host, port);
         }
 
-        // Configure read timeout
-        {
+        // Configure read/write timeouts
+        if (config.read_timeout > 0) {
             struct timeval tv;
-            tv.tv_sec = 5; // TODO: make it configurable
-            tv.tv_usec = 0;
+            tv.tv_sec = config.read_timeout / 1000;
+            tv.tv_usec = (config.read_timeout % 1000) * 1000;
             setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof tv);
         }
+        if (config.write_timeout > 0) {
+            struct timeval tv;
+            tv.tv_sec = config.write_timeout / 1000;
+            tv.tv_usec = (config.write_timeout % 1000) * 1000;
+            setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, (const char *)&tv, sizeof tv);
+        }
 
         {
             std::lock_guard<std::mutex> lock_network(_networ_mutex);
-            if (_worker_index.size() != _max_thread) {
+            if (running.load()) {
                 _worker_index.insert(
                     std::pair<int, std::thread>(client_socket, std::thread(&ServerImpl::_Worker, this, client_socket)));
             } else {
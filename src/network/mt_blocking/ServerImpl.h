@@ -6,6 +6,7 @@
 #include <map>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include <afina/network/Server.h>
 
@@ -23,11 +24,12 @@ namespace MTblocking {
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               const Config &cfg = Config());
     ~ServerImpl();
 
     // See Server.h
-    void Start(uint16_t port, uint32_t, uint32_t) override;
+    void Start(uint16_t port, uint32_t, uint32_t workers) override;
 
     // See Server.h
     void Stop() override;
@@ -50,8 +52,8 @@ private:
     // bounds
     std::atomic<bool> running;
 
-    // Server socket to accept connections on
-    int _server_socket;
+    // Sockets to accept connections on: TCP and/or unix one
+    std::vector<int> _server_sockets;
 
     // Thread to run network on
     std::thread _thread;
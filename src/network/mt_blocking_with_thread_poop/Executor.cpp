@@ -1,85 +1,351 @@
-//
-// Created by alexmal on 17.10.18.
-//
+#include <afina/Executor.h>
 
 #include <algorithm>
+#include <cerrno>
 #include <chrono>
-#include <iostream>
+#include <climits>
+#include <ctime>
 
-#include <afina/Executor.h>
-#include <afina/logging/Service.h>
+#include <afina/Histogram.h>
+#include <afina/Metrics.h>
+#include <afina/MpmcQueue.h>
+#include <afina/WorkStealingDeque.h>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 namespace Afina {
-void perform(Executor *executor) {
+
+// Tasks thread could have in its own deque, the rest goes to the injection queue
+static constexpr std::size_t kDequeCapacity = 1024;
+
+// Claim of idle thread, see Executor::_idle
+static constexpr uint64_t kClaim = uint64_t(1) << 32;
+
+// See Executor.h
+struct Executor::Cell {
+    Task task;
+
+    // When task has been submitted
+    std::chrono::steady_clock::time_point submitted;
+};
+
+// See Executor.h
+struct Executor::Worker {
+    Worker(Executor *owner, std::size_t i) : executor(owner), index(i), deque(kDequeCapacity), running(false) {}
+
+    Executor *const executor;
+    const std::size_t index;
+    WorkStealingDeque<Cell> deque;
+
+    // Nanoseconds tasks spent in queue and running, written by the thread using slot only
+    Histogram wait;
+    Histogram run;
+
+    // Thread currently or lastly using the slot, guarded by _threads_mutex
+    std::thread thread;
+    bool running;
+};
+
+// See Executor.h
+Executor::Executor(const std::string name, size_t low_watermark, size_t hight_watermark, size_t max_queue_size,
+                   int idle_time)
+    : _name(name), _low_watermark(low_watermark), _hight_watermark(std::max<size_t>(1, hight_watermark)),
+      _max_queue_size(max_queue_size), _idle_time(idle_time), _state(State::kRun), _threads(0), _submitting(0),
+      _queued(0), _queued_max(0), _rejected(0), _idle(0), _epoch(0) {
+    // Each running thread holds the cell of its task as well as each queued task does
+    std::size_t cells = _max_queue_size + _hight_watermark;
+    _cells.reset(new Cell[cells]);
+    _free.reset(new MpmcQueue<Cell *>(cells));
+    for (std::size_t i = 0; i < cells; i++) {
+        _free->Push(&_cells[i]);
+    }
+    _injection.reset(new MpmcQueue<Cell *>(_max_queue_size));
+
+    _workers.reserve(_hight_watermark);
+    for (std::size_t i = 0; i < _hight_watermark; i++) {
+        _workers.emplace_back(new Worker(this, i));
+    }
+
+    std::lock_guard<std::mutex> lock(_threads_mutex);
+    for (std::size_t i = 0; i < _low_watermark; i++) {
+        Spawn();
+    }
+}
+
+// See Executor.h
+Executor::~Executor() {
+    Stop(true);
+    for (auto &name : _metrics) {
+        Metrics::Instance().Unregister(name);
+    }
+}
+
+// See Executor.h
+void Executor::Stop(bool await) {
+    State expected = State::kRun;
+    _state.compare_exchange_strong(expected, State::kStopping);
+    Wakeup(INT_MAX);
+
+    if (await) {
+        // Task accepted before stop could still need a thread to be started
+        while (_submitting.load() > 0) {
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(_threads_mutex);
+        _stop_condition.wait(lock, [this] { return _threads.load() == 0; });
+        for (auto &worker : _workers) {
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+        }
+        _state.store(State::kStopped);
+    }
+}
+
+// See Executor.h
+void Executor::PublishMetrics(const std::string &prefix) {
+    Metrics &metrics = Metrics::Instance();
+    auto publish = [this, &metrics, &prefix](const std::string &name, Metrics::Gauge gauge) {
+        _metrics.push_back(prefix + "_" + name);
+        metrics.Register(_metrics.back(), std::move(gauge));
+    };
+
+    publish("queue_length", [this] { return _queued.load(); });
+    publish("queue_length_max", [this] { return _queued_max.load(); });
+    publish("queue_limit", [this] { return _max_queue_size; });
+    publish("rejected", [this] { return _rejected.load(); });
+    publish("threads", [this] { return _threads.load(); });
+    publish("threads_low_watermark", [this] { return _low_watermark; });
+    publish("threads_high_watermark", [this] { return _hight_watermark; });
+
+    // Histograms are merged on each request, that is cheap comparing to the stats command itself
+    auto merge = [this](Histogram Worker::*histogram) {
+        Histogram result;
+        for (auto &worker : _workers) {
+            result.Merge((*worker).*histogram);
+        }
+        return result;
+    };
+    for (auto &kind : {std::make_pair("wait", &Worker::wait), std::make_pair("run", &Worker::run)}) {
+        Histogram Worker::*histogram = kind.second;
+        std::string name = std::string(kind.first) + "_ns_";
+        publish(std::string(kind.first) + "_count", [merge, histogram] { return merge(histogram).count(); });
+        publish(name + "p50", [merge, histogram] { return merge(histogram).Percentile(0.5); });
+        publish(name + "p90", [merge, histogram] { return merge(histogram).Percentile(0.9); });
+        publish(name + "p99", [merge, histogram] { return merge(histogram).Percentile(0.99); });
+        publish(name + "p999", [merge, histogram] { return merge(histogram).Percentile(0.999); });
+        publish(name + "max", [merge, histogram] { return merge(histogram).max(); });
+    }
+}
+
+// See Executor.h
+bool Executor::Submit(Task &&task) {
+    // Threads don't exit on stop while there is somebody who could still enqueue task, see Retire
+    _submitting++;
+    if (_state.load() != State::kRun) {
+        _submitting--;
+        return false;
+    }
+    std::size_t queued = _queued.fetch_add(1);
+    if (queued >= _max_queue_size) {
+        _queued--;
+        _submitting--;
+        _rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Maximum is rarely changed once pool has warmed up, so usually that is a single load
+    std::size_t queued_max = _queued_max.load(std::memory_order_relaxed);
+    while (queued + 1 > queued_max && !_queued_max.compare_exchange_weak(queued_max, queued + 1)) {
+    }
+
+    // Cell is guaranteed to exist, but thread returning it might be in the middle of push
+    Cell *cell;
+    while (!_free->Pop(cell)) {
+        std::this_thread::yield();
+    }
+    cell->task = std::move(task);
+    cell->submitted = std::chrono::steady_clock::now();
+
+    // Pool thread keeps its tasks to itself, others could steal them if they have nothing to do
+    Worker *current = Current();
+    if (current == nullptr || current->executor != this || !current->deque.Push(cell)) {
+        while (!_injection->Push(cell)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Task is published before idle threads are counted, see Perform for the other side
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ClaimIdle()) {
+        Wakeup(1);
+    } else if (_threads.load() < _hight_watermark) {
+        std::lock_guard<std::mutex> lock(_threads_mutex);
+        Spawn();
+    }
+    _submitting--;
+    return true;
+}
+
+// See Executor.h
+void Executor::Perform(Worker *worker) {
+    Current() = worker;
     for (;;) {
-        std::function<void()> task;
-
-        {
-            std::unique_lock<std::mutex> lock(executor->_executor_mutex);
-            executor->number_free_thread++;
-            if (executor->_empty_condition.wait_for(lock, std::chrono::milliseconds(executor->_idle_time), [executor] {
-                    return executor->_state != Executor::State::kRun || !executor->_tasks.empty();
-                })) {
-                executor->number_free_thread--;
-                if (executor->_state != Executor::State::kRun && executor->_tasks.empty()) {
-                    auto id = std::this_thread::get_id();
-                    executor->del_thread(id);
-                    return;
-                }
-                task = std::move(executor->_tasks.front());
-                executor->_tasks.pop();
-            } else {
-                executor->number_free_thread--;
-                if (executor->_threads.size() > executor->_low_watermark) {
-                    auto id = std::this_thread::get_id();
-                    executor->del_thread(id);
+        Cell *cell = Find(worker);
+        if (cell == nullptr) {
+            // Thread announces that it is going to sleep and then looks for task once again: task submitted
+            // before that is found by the second look, task submitted after that changes epoch and wakes
+            // thread up
+            int epoch = _epoch.load();
+            EnterIdle();
+            cell = Find(worker);
+            if (cell == nullptr) {
+                bool timeout = _state.load() == State::kRun && Sleep(epoch);
+                if ((timeout || _state.load() != State::kRun) && Retire(worker)) {
                     return;
                 }
+                LeaveIdle();
                 continue;
             }
+            LeaveIdle();
         }
-        task();
-    }
-};
 
-Executor::Executor(const std::string name, size_t low_watermark, size_t hight_watermark, size_t max_queue_size,
-                   int idle_time)
-    : _low_watermark(low_watermark), _hight_watermark(hight_watermark), _max_queue_size(max_queue_size),
-      _idle_time(idle_time) {
-    {
-        std::unique_lock<std::mutex> lock(this->_executor_mutex);
-        number_free_thread = 0;
-        _state = State ::kRun;
-        _threads.reserve(_hight_watermark);
-        for (int i = 0; i < _low_watermark; i++) {
-            _threads.emplace_back(std::thread(&perform, this));
+        _queued--;
+        auto start = std::chrono::steady_clock::now();
+        worker->wait.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(start - cell->submitted).count());
+
+        cell->task();
+        cell->task.Reset();
+        worker->run.Record(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        while (!_free->Push(cell)) {
+            std::this_thread::yield();
         }
     }
 }
 
-void Executor::Stop(bool await) {
-    {
-        std::unique_lock<std::mutex> lock(_executor_mutex);
-        _state = Executor::State::kStopping;
-        _empty_condition.notify_all();
-        _stop_condition.wait(lock, [this] { return _threads.empty(); });
-        _state = Executor::State::kStopped;
+// See Executor.h
+Executor::Cell *Executor::Find(Worker *worker) {
+    Cell *cell = worker->deque.Take();
+    if (cell != nullptr) {
+        return cell;
+    }
+
+    if (_injection->Pop(cell)) {
+        return cell;
+    }
+
+    // Steal starting from the neighbour, so that thieves don't line up after the same victim
+    for (std::size_t i = 1; i < _workers.size(); i++) {
+        Worker *victim = _workers[(worker->index + i) % _workers.size()].get();
+        do {
+            cell = victim->deque.Steal();
+        } while (cell == nullptr && victim->deque.size() > 0);
 
+        if (cell != nullptr) {
+            return cell;
+        }
     }
+    return nullptr;
+}
 
+// See Executor.h
+bool Executor::Spawn() {
+    if (_state.load() == State::kStopped || _threads.load() >= _hight_watermark) {
+        return false;
+    }
 
+    for (auto &worker : _workers) {
+        if (worker->running) {
+            continue;
+        }
 
+        // Previous thread of the slot has exited already or is about to, it doesn't need the lock anymore
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+        worker->running = true;
+        _threads++;
+        worker->thread = std::thread(&Executor::Perform, this, worker.get());
+        return true;
+    }
+    return false;
 }
 
-void Executor::del_thread(std::thread::id id) {
-    auto iter = std::find_if(_threads.begin(), _threads.end(), [=](std::thread &t) { return (t.get_id() == id); });
-    if (iter != _threads.end()) {
-        iter->detach();
-        _threads.erase(iter);
+// See Executor.h
+bool Executor::Retire(Worker *worker) {
+    std::lock_guard<std::mutex> lock(_threads_mutex);
+    bool stopping = _state.load() != State::kRun;
+    if (!stopping && _threads.load() <= _low_watermark) {
+        return false;
     }
-    if (_threads.empty()) {
-        _stop_condition.notify_one();
+
+    // Once thread is not counted anymore submitter either sees it has missed the task or spawns new thread
+    LeaveIdle();
+    _threads--;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_injection->size() > 0 || (stopping && _submitting.load() > 0)) {
+        EnterIdle();
+        _threads++;
+        return false;
+    }
+
+    worker->running = false;
+    if (_threads.load() == 0) {
+        _stop_condition.notify_all();
     }
+    return true;
+}
+
+// See Executor.h
+bool Executor::Sleep(int epoch) {
+    struct timespec timeout;
+    timeout.tv_sec = _idle_time / 1000;
+    timeout.tv_nsec = (_idle_time % 1000) * 1000000L;
+
+    // Returns right away if epoch has changed already
+    long result =
+        syscall(SYS_futex, reinterpret_cast<int *>(&_epoch), FUTEX_WAIT_PRIVATE, epoch, &timeout, nullptr, 0);
+    return result == -1 && errno == ETIMEDOUT;
+}
+
+// See Executor.h
+void Executor::Wakeup(int n) {
+    _epoch++;
+    syscall(SYS_futex, reinterpret_cast<int *>(&_epoch), FUTEX_WAKE_PRIVATE, n, nullptr, nullptr, 0);
+}
+
+// See Executor.h
+void Executor::EnterIdle() { _idle++; }
+
+// See Executor.h
+void Executor::LeaveIdle() {
+    uint64_t idle = _idle.load();
+    uint64_t next;
+    do {
+        // Somebody has claimed an idle thread already, that was this one as good as any other
+        next = (idle >> 32) > 0 ? idle - kClaim : idle - 1;
+    } while (!_idle.compare_exchange_weak(idle, next));
+}
+
+// See Executor.h
+bool Executor::ClaimIdle() {
+    uint64_t idle = _idle.load();
+    do {
+        if ((idle & 0xffffffff) == 0) {
+            return false;
+        }
+    } while (!_idle.compare_exchange_weak(idle, idle - 1 + kClaim));
+    return true;
+}
+
+// See Executor.h
+Executor::Worker *&Executor::Current() {
+    static thread_local Worker *current = nullptr;
+    return current;
 }
 
 } // namespace Afina
@@ -4,6 +4,7 @@
 
 #include "ServerImpl.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iostream>
@@ -25,6 +26,7 @@
 #include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
 
+#include "network/Socket.h"
 #include "protocol/Parser.h"
 
 namespace Afina {
@@ -32,8 +34,9 @@ namespace Network {
 namespace MT_thread_pool {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl)
-    : Server(ps, pl), _executor("Thread pool", 2, 3, 2, 5000) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       const Config &cfg)
+    : Server(ps, pl, cfg), _executor("Thread pool", std::min<std::size_t>(2, cfg.workers), cfg.workers, 2, 5000) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
@@ -50,32 +53,8 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
-
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket");
-    }
-
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed");
-    }
-
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed");
-    }
-
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket listen() failed");
-    }
+    _server_sockets = open_listen_sockets(port, config, false);
+    _executor.PublishMetrics("thread_pool");
 
     // for test
     running.store(true);
@@ -85,7 +64,9 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
 // See Server.h
 void ServerImpl::Stop() {
     running.store(false);
-    shutdown(_server_socket, SHUT_RDWR);
+    for (int sfd : _server_sockets) {
+        shutdown(sfd, SHUT_RDWR);
+    }
     _executor.Stop();
 }
 
@@ -94,7 +75,10 @@ void ServerImpl::Join() {
 
     assert(_thread.joinable());
     _thread.join();
-    close(_server_socket);
+    close_listen_sockets(_server_sockets, config);
+
+    // Connections already accepted are served till the end
+    _executor.Stop(true);
 }
 
 void ServerImpl::_Worker(int client_socket) {
@@ -201,9 +185,10 @@ void ServerImpl::OnRun() {
 
         // The call to accept() blocks until the incoming connection arrives
         int client_socket;
-        struct sockaddr client_addr;
+        struct sockaddr_storage client_addr;
         socklen_t client_addr_len = sizeof(client_addr);
-        if ((client_socket = accept(_server_socket, (struct sockaddr *)&client_addr, &client_addr_len)) == -1) {
+        client_socket = accept_any(_server_sockets, (struct sockaddr *)&client_addr, &client_addr_len);
+        if (client_socket == -1) {
             continue;
         }
 
@@ -212,21 +197,27 @@ void ServerImpl::OnRun() {
             std::string host = "unknown", port = "-1";
 
             char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
-            if (getnameinfo(&client_addr, client_addr_len, hbuf, sizeof(hbuf), sbuf, sizeof(sbuf),
-                            NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
+            if (getnameinfo((struct sockaddr *)&client_addr, client_addr_len, hbuf, sizeof(hbuf), sbuf,
+                            sizeof(sbuf), NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
                 host = hbuf;
                 port = sbuf;
             }
             _logger->debug("Accepted connection on descriptor {} (host={}, port={})\n", client_socket, host, port);
         }
 
-        // Configure read timeout
-        {
+        // Configure read/write timeouts
+        if (config.read_timeout > 0) {
             struct timeval tv;
-            tv.tv_sec = 5; // TODO: make it configurable
-            tv.tv_usec = 0;
+            tv.tv_sec = config.read_timeout / 1000;
+            tv.tv_usec = (config.read_timeout % 1000) * 1000;
             setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof tv);
         }
+        if (config.write_timeout > 0) {
+            struct timeval tv;
+            tv.tv_sec = config.write_timeout / 1000;
+            tv.tv_usec = (config.write_timeout % 1000) * 1000;
+            setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, (const char *)&tv, sizeof tv);
+        }
 
         {
             bool exec = _executor.Execute(&ServerImpl::_Worker, this, client_socket);
@@ -11,6 +11,7 @@
 #include <map>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include <afina/network/Server.h>
 #include <afina/Executor.h>
@@ -29,7 +30,8 @@ namespace Afina {
  */
             class ServerImpl : public Server {
             public:
-                ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+                ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                           const Config &cfg = Config());
                 ~ServerImpl();
 
                 // See Server.h
@@ -56,8 +58,8 @@ namespace Afina {
                 // bounds
                 std::atomic<bool> running;
 
-                // Server socket to accept connections on
-                int _server_socket;
+                // Sockets to accept connections on: TCP and/or unix one
+                std::vector<int> _server_sockets;
 
                 // Thread to run network on
                 std::thread _thread;
@@ -1,26 +1,116 @@
 #include "Connection.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
 #include <iostream>
 #include <memory>
 
+#include <unistd.h>
+
+#include <afina/execute/Get.h>
+
+#include "Worker.h"
+
 namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
 // See Connection.h
-void Connection::Start() {
+void Connection::Start(int socket) {
     _logger->debug("Start");
-    _logger->debug("Socket = {}", _socket);
+    _logger->debug("Socket = {}", socket);
+    _socket = socket;
     _isAlive.store(true);
 
-    _event.events = EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLONESHOT;
+    _event.events = EPOLLIN | EPOLLRDHUP | EPOLLERR;
+    _event.data.fd = socket;
+}
+
+// See Connection.h
+void Connection::Release() {
+    _output_stats->buffered_bytes -= _output_bytes;
+    if (_reading_paused) {
+        _output_stats->paused_connections--;
+    }
+
+    _socket = -1;
+    _isAlive.store(false);
+    std::memset(&_event, 0, sizeof(struct epoll_event));
+
+    // Buffers keep their memory, so next client doesn't start with allocations
+    _arg_remains = 0;
+    _parser.Reset();
+    _argument_for_command.resize(0);
+    _command_to_execute.reset();
+    _readed_bytes = 0;
+    _response.clear();
+    _response_shift = 0;
+    _output_bytes = 0;
+    _reading_paused = false;
+
+    _timer_state = TimerState::kNone;
+    _command_started = false;
+    _command_done = false;
+    _shutdown = false;
+
+    // Commands still running elsewhere complete into nowhere
+    _pending.clear();
+    _flushed = 0;
+    _exclusive = false;
+    _blocked = false;
+    _generation++;
+}
+
+// See Connection.h
+void Connection::Shutdown() {
+    _logger->debug("Shutdown");
+    _shutdown = true;
+    _event.events &= ~EPOLLIN;
+}
+
+// See Connection.h
+void Connection::UpdateTimer(TimerWheel &timers, const Config &config) {
+    TimerState state;
+    uint32_t timeout;
+    if (_shutdown) {
+        state = TimerState::kShutdown;
+        timeout = config.write_timeout > 0 ? config.write_timeout : kShutdownTimeout;
+    } else if (_output_bytes > 0) {
+        state = TimerState::kWrite;
+        timeout = config.write_timeout;
+    } else if (!_pending.empty()) {
+        // It is server who is slow now
+        state = TimerState::kNone;
+        timeout = 0;
+    } else if (_readed_bytes > 0 || _command_started) {
+        state = TimerState::kRead;
+        timeout = config.read_timeout;
+    } else {
+        state = TimerState::kIdle;
+        timeout = config.idle_timeout;
+    }
+
+    // Command deadline counts since its first byte, so slow client can't prolong it by sending
+    // data byte by byte. The same goes for shutdown. Any other activity moves deadline forward
+    if ((state == TimerState::kRead && _timer_state == state && !_command_done) ||
+        (state == TimerState::kShutdown && _timer_state == state)) {
+        return;
+    }
+
+    _timer_state = state;
+    _command_done = false;
+    if (timeout > 0) {
+        timers.Schedule(&_timer, timeout);
+    } else {
+        timers.Cancel(&_timer);
+    }
 }
 
 // See Connection.h
 void Connection::OnError() {
     _logger->debug("OnError");
     _isAlive.store(false);
-    close(_event.data.fd);
 }
 
 // See Connection.h
@@ -33,103 +123,201 @@ void Connection::OnClose() {
 void Connection::DoRead() {
     _logger->debug("DoRead");
     int new_readed_bytes = -1;
-    while ((new_readed_bytes = read(_socket, _client_buffer + _readed_bytes, sizeof(_client_buffer) - _readed_bytes)) >
-           0) {
+    while (isReadable() &&
+           (new_readed_bytes = read(_socket, _client_buffer + _readed_bytes, sizeof(_client_buffer) - _readed_bytes)) >
+               0) {
         _readed_bytes += new_readed_bytes;
-        while (_readed_bytes > 0) {
-            // There is no command yet
-            if (!_command_to_execute) {
-                std::size_t parsed = 0;
-                if (_parser.Parse(_client_buffer, _readed_bytes, parsed)) {
-                    // There is no command to be launched, continue to parse input stream
-                    // Here we are, current chunk finished some command, process it
-                    _command_to_execute = _parser.Build(_arg_remains);
-                    if (_arg_remains > 0) {
-                        _arg_remains += 2;
-                    }
-                }
+        ProcessInput();
+    }
+}
+
+// See Connection.h
+void Connection::ProcessInput() {
+    _blocked = false;
+    while (canProcess()) {
+        // There is no command yet
+        if (!_command_to_execute) {
+            if (_readed_bytes == 0) {
+                break;
+            }
 
-                // Parsed might fails to consume any bytes from input stream. In real life that could happens,
-                // for example, because we are working with UTF-16 chars and only 1 byte left in stream
-                if (parsed == 0) {
-                    break;
-                } else {
-                    std::memmove(_client_buffer, _client_buffer + parsed, _readed_bytes - parsed);
-                    _readed_bytes -= parsed;
+            std::size_t parsed = 0;
+            if (_parser.Parse(_client_buffer, _readed_bytes, parsed)) {
+                // There is no command to be launched, continue to parse input stream
+                // Here we are, current chunk finished some command, process it
+                _command_to_execute = _parser.Build(_arg_remains);
+                if (_arg_remains > 0) {
+                    _arg_remains += 2;
                 }
             }
 
-            // There is command, but we still wait for argument to arrive...
-            if (_command_to_execute && _arg_remains > 0) {
-                // There is some parsed command, and now we are reading argument
-                std::size_t to_read = std::min(_arg_remains, std::size_t(_readed_bytes));
-                _argument_for_command.append(_client_buffer, to_read);
+            // Parsed might fails to consume any bytes from input stream. In real life that could happens,
+            // for example, because we are working with UTF-16 chars and only 1 byte left in stream
+            if (parsed == 0) {
+                break;
+            } else {
+                std::memmove(_client_buffer, _client_buffer + parsed, _readed_bytes - parsed);
+                _readed_bytes -= parsed;
+                _command_started = true;
+            }
+        }
 
-                std::memmove(_client_buffer, _client_buffer + to_read, _readed_bytes - to_read);
-                _arg_remains -= to_read;
-                _readed_bytes -= to_read;
+        // There is command, but we still wait for argument to arrive...
+        if (_command_to_execute && _arg_remains > 0) {
+            if (_readed_bytes == 0) {
+                break;
             }
 
-            // Thre is command & argument - RUN!
-            if (_command_to_execute && _arg_remains == 0) {
-                std::string result;
-                _command_to_execute->Execute(*_pStorage, _argument_for_command, result);
-                result += "\r\n";
-
-                // Save response
-                {
-                    std::lock_guard<std::mutex> lock_guard(_mutex);
-                    _response.push_back(result);
-                    _event.events |= EPOLLOUT;
-                }
+            // There is some parsed command, and now we are reading argument
+            std::size_t to_read = std::min(_arg_remains, std::size_t(_readed_bytes));
+            _argument_for_command.append(_client_buffer, to_read);
 
-                // Prepare for the next command
-                _command_to_execute.reset();
-                _argument_for_command.resize(0);
-                _parser.Reset();
+            std::memmove(_client_buffer, _client_buffer + to_read, _readed_bytes - to_read);
+            _arg_remains -= to_read;
+            _readed_bytes -= to_read;
+        }
+
+        // Thre is command & argument - RUN! Either on the worker executor or right here.
+        // Gets could run concurrently with each other, but any other command runs alone,
+        // so that each command sees effects of all previous ones
+        if (_command_to_execute && _arg_remains == 0) {
+            bool exclusive = dynamic_cast<Execute::Get *>(_command_to_execute.get()) == nullptr;
+            if (!_pending.empty() && (exclusive || _exclusive)) {
+                _blocked = true;
+                break;
+            }
+            _exclusive = exclusive;
+
+            // Prepare for the next command
+            _command_done = true;
+            _command_started = false;
+            _parser.Reset();
+
+            uint64_t sequence = _flushed + _pending.size();
+            _pending.emplace_back();
+
+            // Command and its argument are moved to executor, nothing is copied
+            if (_worker->CanDispatch()) {
+                _worker->Dispatch(this, sequence, std::move(_command_to_execute), std::move(_argument_for_command));
+                _argument_for_command.clear();
+                continue;
             }
-        } // while (_readed_bytes)
+
+            std::string result;
+            try {
+                std::unique_ptr<Execute::Command> command(std::move(_command_to_execute));
+                command->Execute(*_pStorage, _argument_for_command, result);
+            } catch (std::exception &ex) {
+                result = std::string("SERVER_ERROR ") + ex.what();
+            }
+            _argument_for_command.resize(0);
+            result += "\r\n";
+            Complete(sequence, std::move(result));
+        }
+    } // while (canProcess())
+    UpdateReading();
+}
+
+// See Connection.h
+void Connection::Complete(uint64_t sequence, std::string &&result) {
+    assert(sequence >= _flushed && sequence < _flushed + _pending.size());
+    Pending &pending = _pending[sequence - _flushed];
+    pending.done = true;
+    pending.result = std::move(result);
+    _exclusive = false;
+    _blocked = false;
+
+    // Move all complete responses which are next in order to output
+    bool flushed = false;
+    while (!_pending.empty() && _pending.front().done) {
+        std::string &response = _pending.front().result;
+        _output_bytes += response.size();
+        _output_stats->buffered_bytes += response.size();
+        _response.push_back(std::move(response));
+        _event.events |= EPOLLOUT;
+
+        // Client doesn't keep up with responses, stop reading until it drains output
+        if (!_reading_paused && _output_bytes >= kOutputHighWatermark) {
+            _logger->debug("Pause reading, {} bytes of output buffered", _output_bytes);
+            _reading_paused = true;
+            _output_stats->paused_connections++;
+        }
+
+        _pending.pop_front();
+        _flushed++;
+        flushed = true;
+    }
+
+    if (flushed) {
+        UpdateReading();
     }
 }
 
+// See Connection.h
+bool Connection::UpdateReading() {
+    if (!isReadable()) {
+        _event.events &= ~EPOLLIN;
+        return false;
+    }
+
+    bool resumed = !(_event.events & EPOLLIN);
+    _event.events |= EPOLLIN;
+    return resumed;
+}
+
 // See Connection.h
 void Connection::DoWrite() {
     _logger->debug("DoWrite");
-    size_t response_size;
-    std::unique_ptr<struct iovec[]> task;
-    {
-        std::lock_guard<std::mutex> lock_guard(_mutex);
-        response_size = _response.size();
-        task = std::make_unique<struct iovec[]>(response_size);
-        for (int i = 0; i < response_size; i++) {
-            task[i].iov_base = &(_response[i][0]);
-            task[i].iov_len = _response[i].size();
-        }
+    bool resumed = false;
+    if (_response.empty()) {
+        _event.events &= ~EPOLLOUT;
+        return;
     }
 
+    struct iovec task[64];
+    std::size_t task_size = std::min(_response.size(), sizeof(task) / sizeof(task[0]));
+    for (std::size_t i = 0; i < task_size; i++) {
+        task[i].iov_base = &(_response[i][0]);
+        task[i].iov_len = _response[i].size();
+    }
     task[0].iov_base = static_cast<char *>(task[0].iov_base) + _response_shift;
     task[0].iov_len -= _response_shift;
 
-    ssize_t written;
+    ssize_t written = writev(_socket, task, task_size);
+    if (written < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            _logger->error("Failed to send response");
+            OnError();
+        }
+        return;
+    }
 
-    if ((written = writev(_socket, task.get(), response_size)) > 0) {
+    _output_bytes -= written;
+    _output_stats->buffered_bytes -= written;
 
-        _response_shift += written;
+    // Drop responses that are completely sent
+    _response_shift += written;
+    auto sent = _response.begin();
+    while (sent != _response.end() && _response_shift >= sent->size()) {
+        _response_shift -= sent->size();
+        ++sent;
+    }
+    _response.erase(_response.begin(), sent);
+    if (_response.empty()) {
+        _event.events &= ~EPOLLOUT;
+    }
 
-        int i = 0;
-        while ((i < response_size) && (_response_shift - task[i].iov_len >= 0)) {
-            ++i;
-        }
-        {
-            std::lock_guard<std::mutex> lock_guard(_mutex);
-            std::vector<std::string>(_response.begin() + i, _response.end()).swap(_response);
-            if (_response.empty()) {
-                _event.events = EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLONESHOT;
-            }
-        }
-    } else {
-        _logger->error("Failed to send response");
-        OnError();
+    if (_reading_paused && _output_bytes <= kOutputLowWatermark) {
+        _logger->debug("Resume reading, {} bytes of output buffered", _output_bytes);
+        _reading_paused = false;
+        _output_stats->paused_connections--;
+        resumed = true;
+    }
+
+    // Commands might be already sitting in the client buffer, socket won't report them once again.
+    // Reading is turned back on once they are processed
+    if (resumed) {
+        ProcessInput();
     }
 }
 
@@ -3,36 +3,105 @@
 
 #include <cstring>
 
+#include <atomic>
+#include <deque>
 #include <iostream>
 #include <memory>
 #include <sys/epoll.h>
 #include <sys/uio.h>
 
+#include "network/TimerWheel.h"
 #include "protocol/Parser.h"
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
+#include <afina/network/Config.h>
 
 namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+/**
+ * # Output buffers accounting
+ * Shared by all connections of the server, published in stats
+ */
+struct OutputStats {
+    // Bytes of responses waiting to be sent to clients
+    std::atomic<std::size_t> buffered_bytes{0};
+
+    // Connections which don't read new commands until client drains responses
+    std::atomic<std::size_t> paused_connections{0};
+};
+
+// Forward declaration, see Worker.h
+class Worker;
+
 class Connection {
 public:
-    Connection(int s) : _socket(s) {
-        std::memset(&_event, 0, sizeof(struct epoll_event));
-        _event.data.ptr = this;
-    }
-    Connection(int s, std::shared_ptr<Afina::Storage> &ps, std::shared_ptr<spdlog::logger> &logger)
-        : _socket(s), _pStorage(ps), _logger(logger) {
+    // Once that many bytes of responses are waiting to be sent connection stops reading
+    // new commands, so that client pipelining faster than reading can't grow output unbounded
+    static constexpr std::size_t kOutputHighWatermark = 1024 * 1024;
+
+    // Paused connection resumes reading once client drains output down to that many bytes
+    static constexpr std::size_t kOutputLowWatermark = 256 * 1024;
+
+    // Once that many commands are executing off the I/O thread connection stops reading new ones
+    static constexpr std::size_t kMaxPending = 128;
+
+    /**
+     * Connection doesn't own services it is using, they must outlive it. Connections are reused
+     * for many sockets one after another, so construction doesn't bind connection to a socket,
+     * Start does. Worker is asked to run each command, connection runs command itself if worker
+     * refuses
+     */
+    Connection(Afina::Storage *ps, spdlog::logger *logger, OutputStats *output_stats, Worker *worker)
+        : _socket(-1), _pStorage(ps), _logger(logger), _output_stats(output_stats), _worker(worker) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
-        _event.data.ptr = this;
         _isAlive.store(false);
+        _timer.data = this;
     }
 
     inline bool isAlive() const { return _isAlive.load(); }
 
-    void Start();
+    /**
+     * Start serving given socket
+     */
+    void Start(int socket);
+
+    /**
+     * Forget about current socket and drop all of its state, so that connection could be started
+     * once again. Socket itself is closed by the owner
+     */
+    void Release();
+
+    /**
+     * Stop reading new commands, connection is done once all buffered responses are sent
+     */
+    void Shutdown();
+
+    /**
+     * Connection has been shutdown and has nothing to send anymore
+     */
+    inline bool isDrained() const { return _shutdown && _output_bytes == 0 && _pending.empty(); }
+
+    /**
+     * Number of times connection has been released, identifies socket connection is serving now,
+     * so that results of commands issued for previous sockets could be told apart
+     */
+    inline uint64_t generation() const { return _generation; }
+
+    /**
+     * Takes result of command with the given sequence number. Responses are sent in the same order
+     * commands have arrived, so result waits until all previous commands are complete. Caller should
+     * ProcessInput then, commands waiting for this one could proceed
+     */
+    void Complete(uint64_t sequence, std::string &&result);
+
+    /**
+     * Rearms connection timer according to what connection is waiting for: next command, rest
+     * of the current one or client reading responses
+     */
+    void UpdateTimer(TimerWheel &timers, const Config &config);
 
 protected:
     void OnError();
@@ -40,20 +109,42 @@ protected:
     void DoRead();
     void DoWrite();
 
+    // Executes commands parsed out of bytes already readed to the client buffer, stops at command
+    // that has to wait for commands in flight
+    void ProcessInput();
+
+    // Connection could take new commands: output isn't full and there are not too many commands
+    // in flight
+    inline bool canProcess() const { return !_reading_paused && !_shutdown && _pending.size() < kMaxPending; }
+
+    // Socket is worth reading: commands could be taken, next one isn't waiting for commands in flight
+    // and there is room in the client buffer
+    inline bool isReadable() const {
+        return canProcess() && !_blocked && _readed_bytes < static_cast<int>(sizeof(_client_buffer));
+    }
+
+    // Stops or resumes reading according to isReadable, returns true if reading has been resumed
+    bool UpdateReading();
+
 private:
+    // What connection timer is ticking for
+    enum class TimerState { kNone, kIdle, kRead, kWrite, kShutdown };
+
+    // Time to send responses once server is going to stop, if write timeout isn't configured
+    static constexpr uint32_t kShutdownTimeout = 5000;
+
     friend class Worker;
     friend class ServerImpl;
 
     int _socket;
     struct epoll_event _event;
-    std::mutex _mutex;
 
     std::atomic_bool _isAlive;
 
-    std::shared_ptr<Afina::Storage> _pStorage;
-    std::shared_ptr<spdlog::logger> _logger;
+    Afina::Storage *_pStorage;
+    spdlog::logger *_logger;
 
-    std::size_t _arg_remains;
+    std::size_t _arg_remains = 0;
     Protocol::Parser _parser;
     std::string _argument_for_command;
     std::unique_ptr<Execute::Command> _command_to_execute;
@@ -62,7 +153,40 @@ private:
     char _client_buffer[4096];
 
     std::vector<std::string> _response;
-    int _response_shift = 0;
+    std::size_t _response_shift = 0;
+
+    // Bytes in _response which are not sent yet
+    std::size_t _output_bytes = 0;
+    bool _reading_paused = false;
+    OutputStats *_output_stats;
+
+    TimerWheel::Timer _timer;
+    TimerState _timer_state = TimerState::kNone;
+
+    // Parser has consumed some bytes of a command which is not complete yet
+    bool _command_started = false;
+
+    // Some command has been executed since timer was updated last time
+    bool _command_done = false;
+    bool _shutdown = false;
+
+    // Commands issued but not added to _response yet, ordered by sequence number. First one has
+    // number _flushed, result is set once command is complete
+    struct Pending {
+        bool done = false;
+        std::string result;
+    };
+    std::deque<Pending> _pending;
+    uint64_t _flushed = 0;
+    uint64_t _generation = 0;
+
+    // Command in flight must be the only one, see ProcessInput
+    bool _exclusive = false;
+
+    // Next command waits for commands in flight, nothing is read until one of them completes
+    bool _blocked = false;
+
+    Worker *_worker;
 };
 
 } // namespace MTnonblock
@@ -18,10 +18,13 @@
 
 #include <spdlog/logger.h>
 
+#include <afina/Executor.h>
+#include <afina/Metrics.h>
 #include <afina/Storage.h>
 #include <afina/logging/Service.h>
 
 #include "Connection.h"
+#include "network/Socket.h"
 #include "Utils.h"
 #include "Worker.h"
 
@@ -30,7 +33,9 @@ namespace Network {
 namespace MTnonblock {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       const Config &cfg)
+    : Server(ps, pl, cfg) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
@@ -48,79 +53,52 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    // Create server socket
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
-
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
-    }
-
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
-    }
-
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
-    }
-
-    make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
-    }
-
-    // Start IO workers
-    _data_epoll_fd = epoll_create1(0);
-    if (_data_epoll_fd == -1) {
-        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
-    }
+    _server_sockets = open_listen_sockets(port, config, true);
 
     _event_fd = eventfd(0, EFD_NONBLOCK);
     if (_event_fd == -1) {
         throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
     }
 
-    struct epoll_event event;
-    event.events = EPOLLIN;
-    event.data.ptr = nullptr;
-    if (epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event)) {
-        throw std::runtime_error("Failed to add eventfd descriptor to epoll");
+    if (config.executor_threads > 0) {
+        _executor.reset(new Afina::Executor("Command executor", config.executor_threads, config.executor_threads,
+                                            kExecutorQueueSize, 5000));
+        _executor->PublishMetrics("executor");
     }
 
+    // Start IO workers
+    _next_worker.store(0);
     _workers.reserve(n_workers);
     for (int i = 0; i < n_workers; i++) {
-        _workers.emplace_back(pStorage, pLogging, &_number_connections);
-        _workers.back().Start(_data_epoll_fd, i);
+        _workers.emplace_back(
+            new Worker(pStorage, pLogging, config, &_output_stats, &_number_connections, n_acceptors, _executor.get()));
+        _workers.back()->Start(i);
     }
 
+    Metrics &metrics = Metrics::Instance();
+    metrics.Register("curr_connections", [this] { return _number_connections.load(); });
+    metrics.Register("output_buffered_bytes", [this] { return _output_stats.buffered_bytes.load(); });
+    metrics.Register("output_paused_connections", [this] { return _output_stats.paused_connections.load(); });
+
     // Start acceptors
     _acceptors.reserve(n_acceptors);
     for (int i = 0; i < n_acceptors; i++) {
-        _acceptors.emplace_back(&ServerImpl::OnRun, this);
+        _acceptors.emplace_back(&ServerImpl::OnRun, this, i);
     }
 }
 
 // See Server.h
 void ServerImpl::Stop() {
     _logger->warn("Stop network service");
-    close(_server_socket);
 
     // Said workers to stop
     for (auto &w : _workers) {
-        w.Stop();
+        w->Stop();
     }
 
-    // Wakeup threads that are sleep on epoll_wait
+    // Wakeup acceptors that are sleep on epoll_wait
     if (eventfd_write(_event_fd, 1)) {
-        throw std::runtime_error("Failed to wakeup workers");
+        throw std::runtime_error("Failed to wakeup acceptors");
     }
 }
 
@@ -129,26 +107,44 @@ void ServerImpl::Join() {
     for (auto &t : _acceptors) {
         t.join();
     }
+    _acceptors.clear();
+
+    // No new connections, while workers are still sending out what is already executed
+    close_listen_sockets(_server_sockets, config);
 
     for (auto &w : _workers) {
-        w.Join();
+        w->Join();
+    }
+
+    // Commands of connections closed before they were complete are still able to report back
+    if (_executor) {
+        _executor->Stop(true);
+        _executor.reset();
     }
-    //    close(_server_socket);
+    _workers.clear();
+    close(_event_fd);
+
+    Metrics &metrics = Metrics::Instance();
+    metrics.Unregister("curr_connections");
+    metrics.Unregister("output_buffered_bytes");
+    metrics.Unregister("output_paused_connections");
 }
 
 // See ServerImpl.h
-void ServerImpl::OnRun() {
+void ServerImpl::OnRun(std::size_t acceptor) {
     _logger->info("Start acceptor");
     int acceptor_epoll = epoll_create1(0);
     if (acceptor_epoll == -1) {
         throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
     }
 
-    struct epoll_event event;
-    event.events = EPOLLIN | EPOLLEXCLUSIVE;
-    event.data.fd = _server_socket;
-    if (epoll_ctl(acceptor_epoll, EPOLL_CTL_ADD, _server_socket, &event)) {
-        throw std::runtime_error("Failed to add file descriptor to epoll");
+    for (int sfd : _server_sockets) {
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLEXCLUSIVE;
+        event.data.fd = sfd;
+        if (epoll_ctl(acceptor_epoll, EPOLL_CTL_ADD, sfd, &event)) {
+            throw std::runtime_error("Failed to add file descriptor to epoll");
+        }
     }
 
     struct epoll_event event2;
@@ -158,8 +154,12 @@ void ServerImpl::OnRun() {
         throw std::runtime_error("Failed to add file descriptor to epoll");
     }
 
+    // Workers got sockets from the current batch
+    std::vector<bool> wakeup(_workers.size(), false);
+
     bool run = true;
     std::array<struct epoll_event, 64> mod_list;
+    std::array<int, kAcceptBatch> accepted;
     while (run) {
         int nmod = epoll_wait(acceptor_epoll, &mod_list[0], mod_list.size(), -1);
         _logger->debug("Acceptor wokeup: {} events", nmod);
@@ -168,57 +168,83 @@ void ServerImpl::OnRun() {
             struct epoll_event &current_event = mod_list[i];
             if (current_event.data.fd == _event_fd) {
                 _logger->debug("Break acceptor due to stop signal");
-                //                shutdown(_server_socket, SHUT_RDWR);
                 run = false;
                 continue;
             }
 
-            for (;;) {
-                struct sockaddr in_addr;
-                socklen_t in_len;
-
-                // No need to make these sockets non blocking since accept4() takes care of it.
-                in_len = sizeof in_addr;
-                int infd = accept4(_server_socket, &in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
-                if (infd == -1) {
-                    if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+            // Drain backlog in batches, workers are woken up once per batch rather than once per socket
+            std::size_t n_accepted;
+            do {
+                n_accepted = 0;
+                while (n_accepted < accepted.size()) {
+                    struct sockaddr_storage in_addr;
+                    socklen_t in_len;
+
+                    // No need to make these sockets non blocking since accept4() takes care of it.
+                    in_len = sizeof in_addr;
+                    int infd = accept4(current_event.data.fd, (struct sockaddr *)&in_addr, &in_len,
+                                       SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (infd == -1) {
+                        if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                            _logger->error("Failed to accept socket: {}", strerror(errno));
+                        }
                         break; // We have processed all incoming connections.
-                    } else {
-                        _logger->error("Failed to accept socket");
-                        break;
                     }
-                }
 
-                // Print host and service info.
-                char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
-                int retval = getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf,
-                                         NI_NUMERICHOST | NI_NUMERICSERV);
-                if (retval == 0) {
-                    _logger->info("Accepted connection on descriptor {} (host={}, port={})\n", infd, hbuf, sbuf);
+                    // Print host and service info.
+                    if (_logger->should_log(spdlog::level::debug)) {
+                        char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
+                        int retval = getnameinfo((struct sockaddr *)&in_addr, in_len, hbuf, sizeof hbuf, sbuf,
+                                                 sizeof sbuf, NI_NUMERICHOST | NI_NUMERICSERV);
+                        if (retval == 0) {
+                            _logger->debug("Accepted connection on descriptor {} (host={}, port={})\n", infd, hbuf,
+                                           sbuf);
+                        }
+                    }
+                    accepted[n_accepted++] = infd;
                 }
 
-                // Register the new FD to be monitored by epoll.
-                Connection *pc = new Connection(infd, pStorage, _logger);
-                if (pc == nullptr) {
-                    throw std::runtime_error("Failed to allocate connection");
+                // Pass connections to the least loaded workers, they will be served there till the end
+                for (std::size_t j = 0; j < n_accepted; j++) {
+                    std::size_t w = SelectWorker();
+                    if (_workers[w]->Register(acceptor, accepted[j])) {
+                        wakeup[w] = true;
+                    } else {
+                        _logger->error("Worker {} is overloaded, drop connection", w);
+                        close(accepted[j]);
+                    }
                 }
 
-                // Register connection in worker's epoll
-                pc->Start();
-                _number_connections++;
-                if (pc->isAlive()) {
-                    if (epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
-                        pc->OnError();
-                        _number_connections--;
-                        delete pc;
+                for (std::size_t w = 0; w < wakeup.size(); w++) {
+                    if (wakeup[w]) {
+                        _workers[w]->Wakeup();
+                        wakeup[w] = false;
                     }
                 }
-            }
+            } while (n_accepted == accepted.size());
         }
     }
+    close(acceptor_epoll);
     _logger->warn("Acceptor stopped");
 }
 
+// See ServerImpl.h
+std::size_t ServerImpl::SelectWorker() {
+    // Start from different worker each time, so that ties don't pile up connections on the first one
+    std::size_t start = _next_worker++ % _workers.size();
+    std::size_t result = start;
+    std::size_t min_load = _workers[start]->Load();
+    for (std::size_t i = 1; i < _workers.size() && min_load > 0; i++) {
+        std::size_t w = (start + i) % _workers.size();
+        std::size_t load = _workers[w]->Load();
+        if (load < min_load) {
+            min_load = load;
+            result = w;
+        }
+    }
+    return result;
+}
+
 } // namespace MTnonblock
 } // namespace Network
 } // namespace Afina
@@ -7,11 +7,14 @@
 
 #include <afina/network/Server.h>
 
+#include "Connection.h"
+
 namespace spdlog {
 class logger;
 }
 
 namespace Afina {
+class Executor;
 namespace Network {
 namespace MTnonblock {
 
@@ -24,7 +27,8 @@ class Worker;
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               const Config &cfg = Config());
     ~ServerImpl();
 
     // See Server.h
@@ -37,10 +41,21 @@ public:
     void Join() override;
 
 protected:
-    void OnRun();
+    /**
+     * Method is running in the connection acceptor thread
+     */
+    void OnRun(std::size_t acceptor);
     void OnNewConnection();
 
+    /**
+     * Worker with the fewest connections, new socket should go there
+     */
+    std::size_t SelectWorker();
+
 private:
+    // Max number of sockets acceptor takes from the backlog before passing them to workers
+    static constexpr std::size_t kAcceptBatch = 32;
+
     // logger to use
     std::shared_ptr<spdlog::logger> _logger;
 
@@ -49,22 +64,32 @@ private:
     // Read-only
     uint16_t listen_port;
 
-    // Socket to accept new connection on, shared between acceptors
-    int _server_socket;
+    // Sockets to accept connections on: TCP and/or unix one
+    std::vector<int> _server_sockets;
 
     // Threads that accepts new connections, each has private epoll instance
     // but share global server socket
     std::vector<std::thread> _acceptors;
 
-    // EPOLL instance shared between workers
-    int _data_epoll_fd;
-
-    // Curstom event "device" used to wakeup workers
+    // Curstom event "device" used to wakeup acceptors
     int _event_fd;
 
-    // threads serving read/write requests
-    std::vector<Worker> _workers;
+    // threads serving read/write requests, each has private epoll instance
+    std::vector<std::unique_ptr<Worker>> _workers;
     std::atomic<int> _number_connections;
+
+    // Worker to start search of the least loaded one from
+    std::atomic<uint32_t> _next_worker;
+
+    // Responses buffered in all connections
+    OutputStats _output_stats;
+
+    // Max number of commands waiting for executor thread, commands above that run on I/O threads
+    static constexpr std::size_t kExecutorQueueSize = 4096;
+
+    // Threads executing commands, so that I/O threads do only I/O. Null if commands are executed
+    // right on I/O threads
+    std::unique_ptr<Afina::Executor> _executor;
 };
 
 } // namespace MTnonblock
@@ -1,16 +1,23 @@
 #include "Worker.h"
 
 #include <cassert>
+#include <cstring>
 #include <functional>
 #include <iostream>
+#include <stdexcept>
 
 #include <netdb.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <spdlog/logger.h>
 
+#include <afina/Executor.h>
+#include <afina/allocator/Numa.h>
+#include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
 
 #include "Connection.h"
@@ -21,56 +28,246 @@ namespace Network {
 namespace MTnonblock {
 
 // See Worker.h
-Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
-               std::atomic<int> *number_connections)
-    : _pStorage(ps), _pLogging(pl), _number_connections(number_connections), isRunning(false), _epoll_fd(-1) {
-    // TODO: implementation here
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl, const Config &config,
+               OutputStats *output_stats, std::atomic<int> *number_connections, std::size_t n_acceptors,
+               Afina::Executor *executor)
+    : _pStorage(ps), _pLogging(pl), _config(config), isRunning(false), _epoll_fd(-1), _event_fd(-1), _load(0),
+      _active(0), _executor(executor), _output_stats(output_stats), _number_connections(number_connections) {
+    _incoming.reserve(n_acceptors);
+    for (std::size_t i = 0; i < n_acceptors; i++) {
+        _incoming.emplace_back(new SpscQueue<int>(kIncomingQueueSize));
+    }
 }
 
 // See Worker.h
 Worker::~Worker() {
-    // TODO: implementation here
+    if (_epoll_fd != -1) {
+        close(_epoll_fd);
+    }
+    if (_event_fd != -1) {
+        close(_event_fd);
+    }
 }
 
 // See Worker.h
-Worker::Worker(Worker &&other) { *this = std::move(other); }
+void Worker::Start(int i) {
+    if (isRunning.exchange(true) == false) {
+        assert(_epoll_fd == -1);
+        _epoll_fd = epoll_create1(0);
+        if (_epoll_fd == -1) {
+            throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+        }
 
-// See Worker.h
-Worker &Worker::operator=(Worker &&other) {
-    _pStorage = std::move(other._pStorage);
-    _pLogging = std::move(other._pLogging);
-    _logger = std::move(other._logger);
-    _thread = std::move(other._thread);
-    _epoll_fd = other._epoll_fd;
+        _event_fd = eventfd(0, EFD_NONBLOCK);
+        if (_event_fd == -1) {
+            throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+        }
 
-    other._epoll_fd = -1;
-    return *this;
-}
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = _event_fd;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event)) {
+            throw std::runtime_error("Failed to add eventfd descriptor to epoll");
+        }
 
-// See Worker.h
-void Worker::Start(int epoll_fd, int i) {
-    if (isRunning.exchange(true) == false) {
-        assert(_epoll_fd == -1);
-        _epoll_fd = epoll_fd;
         _logger = _pLogging->select("network.worker");
-//        _logger->set_level(spdlog::level::debug);
-        _thread = std::thread(&Worker::OnRun, this);
         _i = i;
+
+        _pool.reserve(kConnectionPoolSize);
+        _free.reserve(kConnectionPoolSize);
+        for (std::size_t j = 0; j < kConnectionPoolSize; j++) {
+            _pool.emplace_back(new Connection(_pStorage.get(), _logger.get(), _output_stats, this));
+            _free.push_back(_pool.back().get());
+        }
+        _thread = std::thread(&Worker::OnRun, this);
     }
 }
 
 // See Worker.h
 void Worker::Stop() {
     isRunning = false;
-    //    if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, , )) {
-    //        std::cerr << "Failed to delete connection!" << std::endl;
-    //    }
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup worker");
+    }
 }
 
 // See Worker.h
 void Worker::Join() {
     assert(_thread.joinable());
     _thread.join();
+
+    // Sockets passed after worker has stopped
+    int socket;
+    for (auto &queue : _incoming) {
+        while (queue->Pop(socket)) {
+            close(socket);
+            _load--;
+        }
+    }
+}
+
+// See Worker.h
+bool Worker::Register(std::size_t acceptor, int socket) {
+    if (!_incoming[acceptor]->Push(socket)) {
+        return false;
+    }
+
+    _load++;
+    return true;
+}
+
+// See Worker.h
+void Worker::Wakeup() {
+    if (eventfd_write(_event_fd, 1)) {
+        _logger->error("Failed to wakeup worker");
+    }
+}
+
+// See Worker.h
+void Worker::Dispatch(Connection *pc, uint64_t sequence, std::unique_ptr<Execute::Command> command,
+                      std::string argument) {
+    // Connection could be closed and reused while command is running, generation tells that
+    Afina::Storage *storage = _pStorage.get();
+    uint64_t generation = pc->generation();
+    Afina::Task task([this, storage, pc, generation, sequence, command = std::move(command),
+                      argument = std::move(argument)]() {
+        std::string result;
+        try {
+            command->Execute(*storage, argument, result);
+        } catch (std::exception &ex) {
+            result = std::string("SERVER_ERROR ") + ex.what();
+        }
+        result += "\r\n";
+        Complete(pc, generation, sequence, std::move(result));
+    });
+
+    // Overloaded executor slows the connection down: command runs on the worker
+    if (!_executor->Execute(std::move(task))) {
+        task();
+    }
+}
+
+// See Worker.h
+void Worker::Complete(Connection *pc, uint64_t generation, uint64_t sequence, std::string &&result) {
+    bool wakeup;
+    {
+        std::lock_guard<std::mutex> lock(_completed_mutex);
+        wakeup = _completed.empty();
+        _completed.push_back(Completion{pc, generation, sequence, std::move(result)});
+    }
+
+    // Worker hasn't picked up previous results yet, it is going to see this one as well
+    if (wakeup) {
+        Wakeup();
+    }
+}
+
+// See Worker.h
+void Worker::OnComplete() {
+    {
+        std::lock_guard<std::mutex> lock(_completed_mutex);
+        _completing.swap(_completed);
+    }
+
+    for (auto &completion : _completing) {
+        Connection *pconn = completion.connection;
+        if (pconn->generation() != completion.generation) {
+            continue;
+        }
+
+        auto old_mask = pconn->_event.events;
+        pconn->Complete(completion.sequence, std::move(completion.result));
+        pconn->ProcessInput();
+        Update(pconn, old_mask);
+    }
+    _completing.clear();
+}
+
+// See Worker.h
+void Worker::Update(Connection *pconn, uint32_t old_mask) {
+    // Delete closed one
+    if (!pconn->isAlive() || pconn->isDrained()) {
+        Close(pconn);
+        return;
+    }
+
+    // Or rearm connection
+    if (pconn->_event.events != old_mask && epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event)) {
+        _logger->error("Failed to change connection event mask");
+        Close(pconn);
+        return;
+    }
+    pconn->UpdateTimer(_timers, _config);
+}
+
+// See Worker.h
+void Worker::OnRegister() {
+    eventfd_t value;
+    eventfd_read(_event_fd, &value);
+
+    int socket;
+    for (auto &queue : _incoming) {
+        while (queue->Pop(socket)) {
+            Accept(socket);
+        }
+    }
+}
+
+// See Worker.h
+void Worker::Accept(int socket) {
+    if (!isRunning) {
+        close(socket);
+        _load--;
+        return;
+    }
+
+    Connection *pc = Acquire();
+    pc->Start(socket);
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
+        _logger->error("Failed to add connection to epoll");
+        close(socket);
+        _load--;
+        pc->Release();
+        _free.push_back(pc);
+        return;
+    }
+
+    if (static_cast<std::size_t>(socket) >= _table.size()) {
+        _table.resize(socket + 1, nullptr);
+    }
+    _table[socket] = pc;
+    _active++;
+    (*_number_connections)++;
+    pc->UpdateTimer(_timers, _config);
+}
+
+// See Worker.h
+void Worker::Close(Connection *pc) {
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
+        _logger->error("Failed to delete connection from epoll");
+    }
+    _timers.Cancel(&pc->_timer);
+    close(pc->_socket);
+
+    _table[pc->_socket] = nullptr;
+    _active--;
+    _load--;
+    (*_number_connections)--;
+
+    pc->Release();
+    _free.push_back(pc);
+}
+
+// See Worker.h
+Connection *Worker::Acquire() {
+    if (_free.empty()) {
+        _pool.emplace_back(new Connection(_pStorage.get(), _logger.get(), _output_stats, this));
+        return _pool.back().get();
+    }
+
+    Connection *pc = _free.back();
+    _free.pop_back();
+    return pc;
 }
 
 // See Worker.h
@@ -78,28 +275,36 @@ void Worker::OnRun() {
     assert(_epoll_fd >= 0);
     _logger->trace("OnRun");
 
-    // Process connection events
-    //
-    // Do not forget to use EPOLLEXCLUSIVE flag when register socket
-    // for events to avoid thundering herd type behavior.
-    int timeout = -1;
+    if (_config.numa) {
+        try {
+            int node = Afina::Allocator::pin_thread_round_robin(_i);
+            _logger->debug("Worker {} runs on NUMA node {}", _i, node);
+        } catch (std::exception &ex) {
+            _logger->error("Failed to pin worker {}: {}", _i, ex.what());
+        }
+    }
+
+    bool stopping = false;
     std::array<struct epoll_event, 64> mod_list;
-    while (isRunning | _number_connections->load() != 0) { //
-        int nmod = epoll_wait(_epoll_fd, &mod_list[0], mod_list.size(), timeout);
+    while (isRunning || _active > 0) {
+        int nmod = epoll_wait(_epoll_fd, &mod_list[0], mod_list.size(), _timers.NextTimeout());
         _logger->debug("Worker wokeup: {} events", nmod);
 
+        bool wakeup = false;
         for (int i = 0; i < nmod; i++) {
             struct epoll_event &current_event = mod_list[i];
 
-            // nullptr is used by server for event_fd "interface", if we got here then server
-            // signals us to wakeup to process some state change, ignore it in INNER loop, react
-            // on changes in OUTHER loop
-            if (current_event.data.ptr == nullptr) {
+            // event_fd is used by server as "interface", if we got here then server
+            // signals us to wakeup to process some state change. That is done once
+            // rest of events are handled, as it could close and reuse descriptors
+            if (current_event.data.fd == _event_fd) {
+                wakeup = true;
                 continue;
             }
 
             // Some connection gets new data
-            Connection *pconn = static_cast<Connection *>(current_event.data.ptr);
+            Connection *pconn = _table[current_event.data.fd];
+            auto old_mask = pconn->_event.events;
             if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
                 pconn->OnError();
             } else if (current_event.events & EPOLLRDHUP) {
@@ -114,25 +319,37 @@ void Worker::OnRun() {
                 }
             }
 
-            // Rearm connection
-            if (pconn->isAlive()) {
-                pconn->_event.events |= EPOLLONESHOT;
-                if (epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event)) {
-                    pconn->OnError();
-                    _number_connections->operator--();
-                    delete pconn;
+            Update(pconn, old_mask);
+        }
+
+        if (wakeup) {
+            OnRegister();
+            OnComplete();
+        }
+
+        // Server is going to stop: no new commands, send out what is already executed
+        if (!isRunning && !stopping) {
+            stopping = true;
+            for (Connection *pconn : _table) {
+                if (pconn == nullptr) {
+                    continue;
                 }
-            }
-            // Or delete closed one
-            else {
-                if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pconn->_socket, &pconn->_event)) {
-                    std::cerr << "Failed to delete connection!" << std::endl;
+
+                pconn->Shutdown();
+                if (pconn->isDrained() || epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event)) {
+                    Close(pconn);
+                } else {
+                    pconn->UpdateTimer(_timers, _config);
                 }
-                _number_connections->operator--();
-                delete pconn;
             }
         }
-        // TODO: Select timeout...
+
+        // Close connections whose client is too slow or gone silently
+        _timers.Advance([this](TimerWheel::Timer *timer) {
+            Connection *pconn = static_cast<Connection *>(timer->data);
+            _logger->debug("Connection on descriptor {} timed out", pconn->_socket);
+            Close(pconn);
+        });
     }
     _logger->warn("Worker stopped");
 }
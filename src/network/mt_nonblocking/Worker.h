@@ -3,7 +3,15 @@
 
 #include <atomic>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
+
+#include <afina/network/Config.h>
+
+#include "network/SpscQueue.h"
+#include "network/TimerWheel.h"
 
 namespace spdlog {
 class logger;
@@ -13,33 +21,47 @@ namespace Afina {
 
 // Forward declaration, see afina/Storage.h
 class Storage;
+class Executor;
 namespace Logging {
 class Service;
 }
+namespace Execute {
+class Command;
+}
 
 namespace Network {
 namespace MTnonblock {
 
+// Forward declaration, see Connection.h
+class Connection;
+struct OutputStats;
+
 /**
  * # Thread running epoll
- * On Start spaws background thread that is doing epoll on the given server
- * socket and process incoming connections and its data
+ * On Start spaws background thread that is doing epoll over its own set of connections. Each
+ * connection belongs to a single worker for its whole life, so connection state, including
+ * its timer, is never touched by two threads.
+ *
+ * Given an executor worker runs commands there and does only I/O itself: executor threads pass
+ * results back through the completion queue and connection puts them into output in order
  */
 class Worker {
 public:
-    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
-           std::atomic<int> *number_connections);
+    /**
+     * @param n_acceptors number of threads passing sockets to the worker, each gets its own queue
+     * @param executor pool to run commands on, nullptr to run them on the worker thread. Executor must
+     * be stopped before worker is destroyed
+     */
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl, const Config &config,
+           OutputStats *output_stats, std::atomic<int> *number_connections, std::size_t n_acceptors,
+           Afina::Executor *executor);
     ~Worker();
 
-    Worker(Worker &&);
-    Worker &operator=(Worker &&);
-
     /**
-     * Spaws new background thread that is doing epoll on the given server
-     * socket. Once connection accepted it must be registered and being processed
-     * on this thread
+     * Spaws new background thread that is doing epoll on the connections passed to
+     * the worker
      */
-    void Start(int epoll_fd, int i);
+    void Start(int i);
 
     /**
      * Signal background thread to stop. After that signal thread must stop to
@@ -55,12 +77,80 @@ public:
      */
     void Join();
 
+    /**
+     * Pass accepted socket to the worker, from now on worker owns it. Worker doesn't see the socket
+     * until Wakeup is called, so that acceptor could pass many sockets at the cost of one wakeup.
+     *
+     * Each acceptor must use its own number, calls with the same acceptor number must not be
+     * concurrent. Returns false if worker has too many sockets pending, caller still owns socket then
+     */
+    bool Register(std::size_t acceptor, int socket);
+
+    /**
+     * Makes worker to pick up sockets passed by Register. Method is threadsafe
+     */
+    void Wakeup();
+
+    /**
+     * Number of sockets passed to the worker and not closed yet, including ones which are not picked
+     * up by the worker thread yet
+     */
+    std::size_t Load() const { return _load.load(std::memory_order_relaxed); }
+
+    /**
+     * Schedules command of the connection on executor, result is passed to Connection::Complete on
+     * the worker thread later. If executor is overloaded command runs right away on the calling thread,
+     * its result still comes later. Worker must have executor, see CanDispatch
+     */
+    void Dispatch(Connection *pc, uint64_t sequence, std::unique_ptr<Execute::Command> command,
+                  std::string argument);
+
+    /**
+     * Worker has executor to run commands on
+     */
+    bool CanDispatch() const { return _executor != nullptr; }
+
 protected:
     /**
      * Method executing by background thread
      */
     void OnRun();
 
+    /**
+     * Starts serving sockets passed to Register
+     */
+    void OnRegister();
+
+    /**
+     * Starts serving a socket
+     */
+    void Accept(int socket);
+
+    /**
+     * Passes command result back to the worker thread. Method is threadsafe
+     */
+    void Complete(Connection *pc, uint64_t generation, uint64_t sequence, std::string &&result);
+
+    /**
+     * Hands results passed by Complete to their connections
+     */
+    void OnComplete();
+
+    /**
+     * Applies changes connection has made to its state: closes it, updates epoll mask or timer
+     */
+    void Update(Connection *pc, uint32_t old_mask);
+
+    /**
+     * Closes connection socket and returns connection to the pool
+     */
+    void Close(Connection *pc);
+
+    /**
+     * Takes connection from the pool, allocates new one only if pool is exhausted
+     */
+    Connection *Acquire();
+
 private:
     Worker(Worker &) = delete;
     Worker &operator=(Worker &) = delete;
@@ -74,6 +164,9 @@ private:
     // Logger to be used
     std::shared_ptr<spdlog::logger> _logger;
 
+    // Timeouts to apply
+    const Config _config;
+
     // Flag signals that thread should continue to operate
     std::atomic<bool> isRunning;
 
@@ -83,6 +176,47 @@ private:
     // EPOLL descriptor using for events processing
     int _epoll_fd;
 
+    // Custom event "device" used to wakeup worker
+    int _event_fd;
+
+    // Capacity of a queue between acceptor and worker
+    static constexpr std::size_t kIncomingQueueSize = 1024;
+
+    // Sockets passed to the worker but not registered in epoll yet, queue per acceptor
+    std::vector<std::unique_ptr<SpscQueue<int>>> _incoming;
+
+    // See Load
+    std::atomic<std::size_t> _load;
+
+    // Number of connections allocated on Start, pool grows beyond that on demand and never shrinks
+    static constexpr std::size_t kConnectionPoolSize = 256;
+
+    // All connections worker ever allocated, either serving a client or sitting in the free list
+    std::vector<std::unique_ptr<Connection>> _pool;
+    std::vector<Connection *> _free;
+
+    // Connections served by worker indexed by socket descriptor and their deadlines
+    std::vector<Connection *> _table;
+    std::size_t _active;
+    TimerWheel _timers;
+
+    // Result of a command executed off the worker thread
+    struct Completion {
+        Connection *connection;
+        uint64_t generation;
+        uint64_t sequence;
+        std::string result;
+    };
+
+    // See Dispatch
+    Afina::Executor *_executor;
+
+    // Results passed by executor, the second vector keeps memory of the one being processed
+    std::mutex _completed_mutex;
+    std::vector<Completion> _completed;
+    std::vector<Completion> _completing;
+
+    OutputStats *_output_stats;
     std::atomic<int> *_number_connections;
     int _i;
 };
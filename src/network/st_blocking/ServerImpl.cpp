@@ -21,6 +21,7 @@
 #include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
 
+#include "network/Socket.h"
 #include "protocol/Parser.h"
 
 namespace Afina {
@@ -28,7 +29,9 @@ namespace Network {
 namespace STblocking {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       const Config &cfg)
+    : Server(ps, pl, cfg) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
@@ -48,58 +51,7 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    // For IPv4 we use struct sockaddr_in:
-    // struct sockaddr_in {
-    //     short int          sin_family;  // Address family, AF_INET
-    //     unsigned short int sin_port;    // Port number
-    //     struct in_addr     sin_addr;    // Internet address
-    //     unsigned char      sin_zero[8]; // Same size as struct sockaddr
-    // };
-    //
-    // Note we need to convert the port to network order
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
-
-    // Arguments are:
-    // - Family: IPv4
-    // - Type: Full-duplex stream (reliable)
-    // - Protocol: TCP
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket");
-    }
-
-    // when the server closes the socket,the connection must stay in the TIME_WAIT state to
-    // make sure the client received the acknowledgement that the connection has been terminated.
-    // During this time, this port is unavailable to other processes, unless we specify this option
-    //
-    // This option let kernel knows that we are OK that multiple threads/processes are listen on the
-    // same port. In a such case kernel will balance input traffic between all listeners (except those who
-    // are closed already)
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed");
-    }
-
-    // Bind the socket to the address. In other words let kernel know data for what address we'd
-    // like to see in the socket
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed");
-    }
-
-    // Start listening. The second parameter is the "backlog", or the maximum number of
-    // connections that we'll allow to queue up. Note that listen() doesn't block until
-    // incoming connections arrive. It just makesthe OS aware that this process is willing
-    // to accept connections on this socket (which is bound to a specific IP and port)
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket listen() failed");
-    }
+    _server_sockets = open_listen_sockets(port, config, false);
 
     running.store(true);
     _thread = std::thread(&ServerImpl::OnRun, this);
@@ -108,14 +60,16 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
 // See Server.h
 void ServerImpl::Stop() {
     running.store(false);
-    shutdown(_server_socket, SHUT_RDWR);
+    for (int sfd : _server_sockets) {
+        shutdown(sfd, SHUT_RDWR);
+    }
 }
 
 // See Server.h
 void ServerImpl::Join() {
     assert(_thread.joinable());
     _thread.join();
-    close(_server_socket);
+    close_listen_sockets(_server_sockets, config);
 }
 
 // See Server.h
@@ -134,9 +88,10 @@ void ServerImpl::OnRun() {
 
         // The call to accept() blocks until the incoming connection arrives
         int client_socket;
-        struct sockaddr client_addr;
+        struct sockaddr_storage client_addr;
         socklen_t client_addr_len = sizeof(client_addr);
-        if ((client_socket = accept(_server_socket, (struct sockaddr *)&client_addr, &client_addr_len)) == -1) {
+        client_socket = accept_any(_server_sockets, (struct sockaddr *)&client_addr, &client_addr_len);
+        if (client_socket == -1) {
             continue;
         }
 
@@ -145,21 +100,27 @@ void ServerImpl::OnRun() {
             std::string host = "unknown", port = "-1";
 
             char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
-            if (getnameinfo(&client_addr, client_addr_len, hbuf, sizeof(hbuf), sbuf, sizeof(sbuf),
-                            NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
+            if (getnameinfo((struct sockaddr *)&client_addr, client_addr_len, hbuf, sizeof(hbuf), sbuf,
+                            sizeof(sbuf), NI_NUMERICHOST | NI_NUMERICSERV) == 0) {
                 host = hbuf;
                 port = sbuf;
             }
             _logger->debug("Accepted connection on descriptor {} (host={}, port={})\n", client_socket, host, port);
         }
 
-        // Configure read timeout
-        {
+        // Configure read/write timeouts
+        if (config.read_timeout > 0) {
             struct timeval tv;
-            tv.tv_sec = 5; // TODO: make it configurable
-            tv.tv_usec = 0;
+            tv.tv_sec = config.read_timeout / 1000;
+            tv.tv_usec = (config.read_timeout % 1000) * 1000;
             setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof tv);
         }
+        if (config.write_timeout > 0) {
+            struct timeval tv;
+            tv.tv_sec = config.write_timeout / 1000;
+            tv.tv_usec = (config.write_timeout % 1000) * 1000;
+            setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, (const char *)&tv, sizeof tv);
+        }
 
         // Process new connection:
         // - read commands until socket alive
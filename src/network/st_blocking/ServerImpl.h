@@ -3,6 +3,7 @@
 
 #include <atomic>
 #include <thread>
+#include <vector>
 
 #include <afina/network/Server.h>
 
@@ -20,7 +21,8 @@ namespace STblocking {
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               const Config &cfg = Config());
     ~ServerImpl();
 
     // See Server.h
@@ -47,8 +49,8 @@ private:
     // bounds
     std::atomic<bool> running;
 
-    // Server socket to accept connections on
-    int _server_socket;
+    // Sockets to accept connections on: TCP and/or unix one
+    std::vector<int> _server_sockets;
 
     // Thread to run network on
     std::thread _thread;
@@ -1,13 +1,23 @@
+#include "Connection.h"
 
-
+#include <algorithm>
+#include <cerrno>
 #include <iostream>
 
-#include "Connection.h"
+#include <unistd.h>
 
 namespace Afina {
 namespace Network {
 namespace STnonblock {
 
+// See Connection.h
+Connection::~Connection() {
+    _output_stats->buffered_bytes -= _output_bytes;
+    if (_reading_paused) {
+        _output_stats->paused_connections--;
+    }
+}
+
 // See Connection.h
 void Connection::Start() {
     //    std::cout << "Start" << std::endl;
@@ -16,115 +26,189 @@ void Connection::Start() {
     _event.events = EPOLLIN | EPOLLRDHUP | EPOLLERR;
 }
 
+// See Connection.h
+void Connection::Shutdown() {
+    _logger->debug("Shutdown");
+    _shutdown = true;
+    _event.events &= ~EPOLLIN;
+}
+
+// See Connection.h
+void Connection::UpdateTimer(TimerWheel &timers, const Config &config) {
+    TimerState state;
+    uint32_t timeout;
+    if (_shutdown) {
+        state = TimerState::kShutdown;
+        timeout = config.write_timeout > 0 ? config.write_timeout : kShutdownTimeout;
+    } else if (_output_bytes > 0) {
+        state = TimerState::kWrite;
+        timeout = config.write_timeout;
+    } else if (_readed_bytes > 0 || _command_started) {
+        state = TimerState::kRead;
+        timeout = config.read_timeout;
+    } else {
+        state = TimerState::kIdle;
+        timeout = config.idle_timeout;
+    }
+
+    // Command deadline counts since its first byte, so slow client can't prolong it by sending
+    // data byte by byte. The same goes for shutdown. Any other activity moves deadline forward
+    if ((state == TimerState::kRead && _timer_state == state && !_command_done) ||
+        (state == TimerState::kShutdown && _timer_state == state)) {
+        return;
+    }
+
+    _timer_state = state;
+    _command_done = false;
+    if (timeout > 0) {
+        timers.Schedule(&_timer, timeout);
+    } else {
+        timers.Cancel(&_timer);
+    }
+}
+
 // See Connection.h
 void Connection::OnError() {
     _logger->debug("OnError");
-
-    //    std::cout << "OnError" << std::endl;
     _isAlive = false;
-    close(_event.data.fd);
 }
 
 // See Connection.h
 void Connection::OnClose() {
     _logger->debug("OnClose");
-    //    _event.data.ptr = nullptr;
     _isAlive = false;
-    close(_event.data.fd);
 }
 
 // See Connection.h
 void Connection::DoRead() {
     _logger->debug("DoRead");
     int new_readed_bytes = -1;
-    while ((new_readed_bytes = read(_socket, _client_buffer + _readed_bytes, sizeof(_client_buffer) - _readed_bytes)) >
-           0) {
+    while (!_reading_paused &&
+           (new_readed_bytes = read(_socket, _client_buffer + _readed_bytes, sizeof(_client_buffer) - _readed_bytes)) >
+               0) {
         _readed_bytes += new_readed_bytes;
-        while (_readed_bytes > 0) {
-            // There is no command yet
-            if (!_command_to_execute) {
-                std::size_t parsed = 0;
-                if (_parser.Parse(_client_buffer, _readed_bytes, parsed)) {
-                    // There is no command to be launched, continue to parse input stream
-                    // Here we are, current chunk finished some command, process it
-                    _command_to_execute = _parser.Build(_arg_remains);
-                    if (_arg_remains > 0) {
-                        _arg_remains += 2;
-                    }
-                }
+        ProcessInput();
+    }
+}
 
-                // Parsed might fails to consume any bytes from input stream. In real life that could happens,
-                // for example, because we are working with UTF-16 chars and only 1 byte left in stream
-                if (parsed == 0) {
-                    break;
-                } else {
-                    std::memmove(_client_buffer, _client_buffer + parsed, _readed_bytes - parsed);
-                    _readed_bytes -= parsed;
+// See Connection.h
+void Connection::ProcessInput() {
+    while (_readed_bytes > 0 && !_reading_paused && !_shutdown) {
+        // There is no command yet
+        if (!_command_to_execute) {
+            std::size_t parsed = 0;
+            if (_parser.Parse(_client_buffer, _readed_bytes, parsed)) {
+                // There is no command to be launched, continue to parse input stream
+                // Here we are, current chunk finished some command, process it
+                _command_to_execute = _parser.Build(_arg_remains);
+                if (_arg_remains > 0) {
+                    _arg_remains += 2;
                 }
             }
 
-            // There is command, but we still wait for argument to arrive...
-            if (_command_to_execute && _arg_remains > 0) {
-                // There is some parsed command, and now we are reading argument
-                std::size_t to_read = std::min(_arg_remains, std::size_t(_readed_bytes));
-                _argument_for_command.append(_client_buffer, to_read);
-
-                std::memmove(_client_buffer, _client_buffer + to_read, _readed_bytes - to_read);
-                _arg_remains -= to_read;
-                _readed_bytes -= to_read;
+            // Parsed might fails to consume any bytes from input stream. In real life that could happens,
+            // for example, because we are working with UTF-16 chars and only 1 byte left in stream
+            if (parsed == 0) {
+                break;
+            } else {
+                std::memmove(_client_buffer, _client_buffer + parsed, _readed_bytes - parsed);
+                _readed_bytes -= parsed;
+                _command_started = true;
             }
+        }
 
-            // Thre is command & argument - RUN!
-            if (_command_to_execute && _arg_remains == 0) {
-                std::string result;
-                _command_to_execute->Execute(*_pStorage, _argument_for_command, result);
-                result += "\r\n";
+        // There is command, but we still wait for argument to arrive...
+        if (_command_to_execute && _arg_remains > 0) {
+            // There is some parsed command, and now we are reading argument
+            std::size_t to_read = std::min(_arg_remains, std::size_t(_readed_bytes));
+            _argument_for_command.append(_client_buffer, to_read);
 
-                // Save response
-                _response.push_back(result);
-                _event.events |= EPOLLOUT;
+            std::memmove(_client_buffer, _client_buffer + to_read, _readed_bytes - to_read);
+            _arg_remains -= to_read;
+            _readed_bytes -= to_read;
+        }
 
-                // Prepare for the next command
-                _command_to_execute.reset();
-                _argument_for_command.resize(0);
-                _parser.Reset();
+        // Thre is command & argument - RUN!
+        if (_command_to_execute && _arg_remains == 0) {
+            std::string result;
+            _command_to_execute->Execute(*_pStorage, _argument_for_command, result);
+            result += "\r\n";
+
+            // Save response
+            _output_bytes += result.size();
+            _output_stats->buffered_bytes += result.size();
+            _response.push_back(std::move(result));
+            _event.events |= EPOLLOUT;
+
+            // Client doesn't keep up with responses, stop reading until it drains output
+            if (_output_bytes >= kOutputHighWatermark) {
+                _logger->debug("Pause reading, {} bytes of output buffered", _output_bytes);
+                _reading_paused = true;
+                _event.events &= ~EPOLLIN;
+                _output_stats->paused_connections++;
             }
-        } // while (_readed_bytes)
-    }
+
+            // Prepare for the next command
+            _command_done = true;
+            _command_started = false;
+            _command_to_execute.reset();
+            _argument_for_command.resize(0);
+            _parser.Reset();
+        }
+    } // while (_readed_bytes)
 }
 
 // See Connection.h
 void Connection::DoWrite() {
     _logger->debug("DoWrite");
-    auto response_size = _response.size();
-    //    std::cout << "DoWrite" << std::endl;
-    struct iovec task[_response.size()];
-    for (int i = 0; i < _response.size(); i++) {
+    if (_response.empty()) {
+        _event.events &= ~EPOLLOUT;
+        return;
+    }
+
+    struct iovec task[64];
+    std::size_t task_size = std::min(_response.size(), sizeof(task) / sizeof(task[0]));
+    for (std::size_t i = 0; i < task_size; i++) {
         task[i].iov_base = &(_response[i][0]);
         task[i].iov_len = _response[i].size();
     }
-
     task[0].iov_base = static_cast<char *>(task[0].iov_base) + _response_shift;
     task[0].iov_len -= _response_shift;
 
-    ssize_t written;
+    ssize_t written = writev(_socket, task, task_size);
+    if (written < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            _logger->error("Failed to send response");
+            OnError();
+        }
+        return;
+    }
+
+    _output_bytes -= written;
+    _output_stats->buffered_bytes -= written;
 
-    if ((written = writev(_socket, task, response_size)) > 0) {
+    // Drop responses that are completely sent
+    _response_shift += written;
+    auto sent = _response.begin();
+    while (sent != _response.end() && _response_shift >= sent->size()) {
+        _response_shift -= sent->size();
+        ++sent;
+    }
+    _response.erase(_response.begin(), sent);
+    if (_response.empty()) {
+        _event.events &= ~EPOLLOUT;
+    }
 
-        _response_shift += written;
+    if (_reading_paused && _output_bytes <= kOutputLowWatermark) {
+        _logger->debug("Resume reading, {} bytes of output buffered", _output_bytes);
+        _reading_paused = false;
+        _output_stats->paused_connections--;
+        if (!_shutdown) {
+            _event.events |= EPOLLIN;
 
-        int i = 0;
-        while ((i < response_size) && (_response_shift - task[i].iov_len >= 0)) {
-            ++i;
+            // Commands might be already sitting in the client buffer, socket won't report them once again
+            ProcessInput();
         }
-        std::vector<std::string>(_response.begin() + i, _response.end()).swap(_response);
-        if (_response.empty()) {
-            _event.events = EPOLLIN | EPOLLRDHUP | EPOLLERR;
-        }
-    } else {
-        std::cout << written << std::endl;
-        _logger->error("Failed to send response");
-        OnError();
     }
 }
 
@@ -3,39 +3,89 @@
 
 #include <cstring>
 
+#include <atomic>
 #include <list>
 #include <memory>
 #include <sys/epoll.h>
 #include <sys/uio.h>
 
+#include "network/TimerWheel.h"
 #include "protocol/Parser.h"
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
+#include <afina/network/Config.h>
 
 namespace Afina {
 namespace Network {
 namespace STnonblock {
 
+/**
+ * # Output buffers accounting
+ * Shared by all connections of the server, published in stats
+ */
+struct OutputStats {
+    // Bytes of responses waiting to be sent to clients
+    std::atomic<std::size_t> buffered_bytes{0};
+
+    // Connections which don't read new commands until client drains responses
+    std::atomic<std::size_t> paused_connections{0};
+};
+
 class Connection {
 public:
-    Connection(int s, std::shared_ptr<Afina::Storage> &ps, std::shared_ptr<spdlog::logger> &logger)
-        : _socket(s), _pStorage(ps), _logger(logger), _isAlive(true) {
+    // Once that many bytes of responses are waiting to be sent connection stops reading
+    // new commands, so that client pipelining faster than reading can't grow output unbounded
+    static constexpr std::size_t kOutputHighWatermark = 1024 * 1024;
+
+    // Paused connection resumes reading once client drains output down to that many bytes
+    static constexpr std::size_t kOutputLowWatermark = 256 * 1024;
+
+    Connection(int s, std::shared_ptr<Afina::Storage> &ps, std::shared_ptr<spdlog::logger> &logger,
+               OutputStats *output_stats)
+        : _socket(s), _pStorage(ps), _logger(logger), _isAlive(true), _output_stats(output_stats) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
-        _event.data.ptr = this;
+        _event.data.fd = s;
+        _timer.data = this;
     }
+    ~Connection();
 
     inline bool isAlive() const { return _isAlive; }
 
     void Start();
 
+    /**
+     * Stop reading new commands, connection is done once all buffered responses are sent
+     */
+    void Shutdown();
+
+    /**
+     * Connection has been shutdown and has nothing to send anymore
+     */
+    inline bool isDrained() const { return _shutdown && _output_bytes == 0; }
+
+    /**
+     * Rearms connection timer according to what connection is waiting for: next command, rest
+     * of the current one or client reading responses
+     */
+    void UpdateTimer(TimerWheel &timers, const Config &config);
+
 protected:
     void OnError();
     void OnClose();
     void DoRead();
     void DoWrite();
 
+    // Executes commands parsed out of bytes already readed to the client buffer
+    void ProcessInput();
+
 private:
+    // What connection timer is ticking for
+    enum class TimerState { kNone, kIdle, kRead, kWrite, kShutdown };
+
+    // Time to send responses once server is going to stop, if write timeout isn't configured
+    static constexpr uint32_t kShutdownTimeout = 5000;
+
     friend class ServerImpl;
 
     int _socket;
@@ -54,7 +104,22 @@ private:
     char _client_buffer[4096];
 
     std::vector<std::string> _response;
-    int _response_shift = 0;
+    std::size_t _response_shift = 0;
+
+    // Bytes in _response which are not sent yet
+    std::size_t _output_bytes = 0;
+    bool _reading_paused = false;
+    OutputStats *_output_stats;
+
+    TimerWheel::Timer _timer;
+    TimerState _timer_state = TimerState::kNone;
+
+    // Parser has consumed some bytes of a command which is not complete yet
+    bool _command_started = false;
+
+    // Some command has been executed since timer was updated last time
+    bool _command_done = false;
+    bool _shutdown = false;
 };
 
 } // namespace STnonblock
@@ -1,5 +1,6 @@
 #include "ServerImpl.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iostream>
@@ -18,11 +19,12 @@
 
 #include <spdlog/logger.h>
 
+#include <afina/Metrics.h>
 #include <afina/Storage.h>
 #include <afina/logging/Service.h>
-#include <spdlog/logger.h>
 
 #include "Connection.h"
+#include "network/Socket.h"
 #include "Utils.h"
 
 namespace Afina {
@@ -30,7 +32,9 @@ namespace Network {
 namespace STnonblock {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       const Config &cfg)
+    : Server(ps, pl, cfg) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
@@ -48,48 +52,25 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
-    // Create server socket
-    struct sockaddr_in server_addr;
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
-
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (_server_socket == -1) {
-        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
-    }
-
-    int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
-    }
-
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
-    }
-
-    make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
-        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
-    }
+    _server_sockets = open_listen_sockets(port, config, true);
 
     _event_fd = eventfd(0, EFD_NONBLOCK);
     if (_event_fd == -1) {
         throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
     }
 
+    Metrics &metrics = Metrics::Instance();
+    metrics.Register("curr_connections", [this] { return _number_connections.load(); });
+    metrics.Register("output_buffered_bytes", [this] { return _output_stats.buffered_bytes.load(); });
+    metrics.Register("output_paused_connections", [this] { return _output_stats.paused_connections.load(); });
+
     _work_thread = std::thread(&ServerImpl::OnRun, this);
 }
 
 // See Server.h
 void ServerImpl::Stop() {
     _logger->warn("Stop network service");
-    close(_server_socket);
-        // Wakeup threads that are sleep on epoll_wait
+    // Wakeup threads that are sleep on epoll_wait
     if (eventfd_write(_event_fd, 1)) {
         throw std::runtime_error("Failed to wakeup workers");
     }
@@ -99,7 +80,11 @@ void ServerImpl::Stop() {
 void ServerImpl::Join() {
     // Wait for work to be complete
     _work_thread.join();
-//    close(_server_socket);
+
+    Metrics &metrics = Metrics::Instance();
+    metrics.Unregister("curr_connections");
+    metrics.Unregister("output_buffered_bytes");
+    metrics.Unregister("output_paused_connections");
 }
 
 // Se e ServerImpl.h
@@ -111,12 +96,14 @@ void ServerImpl::OnRun() {
         throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
     }
 
-    struct epoll_event event;
-    event.events = EPOLLIN;
-    _logger->debug("Server socket fd {}", _server_socket);
-    event.data.fd = _server_socket;
-    if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, _server_socket, &event)) {
-        throw std::runtime_error("Failed to add file descriptor to epoll");
+    for (int sfd : _server_sockets) {
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        _logger->debug("Server socket fd {}", sfd);
+        event.data.fd = sfd;
+        if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, sfd, &event)) {
+            throw std::runtime_error("Failed to add file descriptor to epoll");
+        }
     }
 
     struct epoll_event event2;
@@ -130,29 +117,48 @@ void ServerImpl::OnRun() {
 
     bool run = true;
     std::array<struct epoll_event, 64> mod_list{};
-    while (run | _number_connections != 0) {
-        int nmod = epoll_wait(epoll_descr, &mod_list[0], mod_list.size(), -1);
+    while (run || !_connections.empty()) {
+        int nmod = epoll_wait(epoll_descr, &mod_list[0], mod_list.size(), _timers.NextTimeout());
         _logger->debug("Acceptor wokeup: {} events", nmod);
         for (int i = 0; i < nmod; i++) {
             struct epoll_event &current_event = mod_list[i];
             if (current_event.data.fd == _event_fd) {
                 _logger->debug("Break acceptor due to stop signal");
-//                shutdown(_server_socket, SHUT_RDWR);
-//                if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, _server_socket, &event)) {
-//                    _logger->error("Failed to delete connection from epoll");
-//                }
                 if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, _event_fd, &event2)) {
                     _logger->error("Failed to delete connection from epoll");
                 }
                 run = false;
+
+                // No new connections
+                close_listen_sockets(_server_sockets, config);
+
+                // No new commands, send out what is already executed
+                std::vector<Connection *> connections;
+                connections.reserve(_connections.size());
+                for (auto &it : _connections) {
+                    connections.push_back(it.second);
+                }
+                for (Connection *pc : connections) {
+                    pc->Shutdown();
+                    if (pc->isDrained() || epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
+                        OnClose(epoll_descr, pc);
+                    } else {
+                        pc->UpdateTimer(_timers, config);
+                    }
+                }
                 continue;
-            } else if (current_event.data.fd == _server_socket) {
-                OnNewConnection(epoll_descr);
+            } else if (std::find(_server_sockets.begin(), _server_sockets.end(), current_event.data.fd) !=
+                       _server_sockets.end()) {
+                OnNewConnection(epoll_descr, current_event.data.fd);
                 continue;
             }
 
-            // That is some connection!
-            Connection *pc = static_cast<Connection *>(current_event.data.ptr);
+            // That is some connection! Unless it is closed already
+            auto it = _connections.find(current_event.data.fd);
+            if (it == _connections.end()) {
+                continue;
+            }
+            Connection *pc = it->second;
 
             auto old_mask = pc->_event.events;
             if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
@@ -171,37 +177,50 @@ void ServerImpl::OnRun() {
             }
 
             // Does it alive?
-            if (!pc->isAlive()) {
-                if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
-                    _logger->error("Failed to delete connection from epoll");
-                }
+            if (!pc->isAlive() || pc->isDrained()) {
+                OnClose(epoll_descr, pc);
+                continue;
+            }
 
-                close(pc->_socket);
-                //                pc->OnClose();
-                _number_connections--;
-                delete pc;
-            } else if (pc->_event.events != old_mask) {
-                if (epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
-                    _logger->error("Failed to change connection event mask");
-                    pc->OnError();
-                    close(pc->_socket);
-                    _number_connections--;
-                }
+            if (pc->_event.events != old_mask && epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
+                _logger->error("Failed to change connection event mask");
+                OnClose(epoll_descr, pc);
+                continue;
             }
+            pc->UpdateTimer(_timers, config);
         }
+
+        // Close connections whose client is too slow or gone silently
+        _timers.Advance([this, epoll_descr](TimerWheel::Timer *timer) {
+            Connection *pc = static_cast<Connection *>(timer->data);
+            _logger->debug("Connection on descriptor {} timed out", pc->_socket);
+            OnClose(epoll_descr, pc);
+        });
     }
     close(epoll_descr);
     _logger->warn("Acceptor stopped");
 }
 
-void ServerImpl::OnNewConnection(int epoll_descr) {
+void ServerImpl::OnClose(int epoll_descr, Connection *pc) {
+    if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
+        _logger->error("Failed to delete connection from epoll");
+    }
+    _timers.Cancel(&pc->_timer);
+    close(pc->_socket);
+
+    _connections.erase(pc->_socket);
+    _number_connections--;
+    delete pc;
+}
+
+void ServerImpl::OnNewConnection(int epoll_descr, int server_socket) {
     for (;;) {
-        struct sockaddr in_addr;
+        struct sockaddr_storage in_addr;
         socklen_t in_len;
 
         // No need to make these sockets non blocking since accept4() takes care of it.
         in_len = sizeof in_addr;
-        int infd = accept4(_server_socket, &in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        int infd = accept4(server_socket, (struct sockaddr *)&in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
         if (infd == -1) {
             if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
                 break; // We have processed all incoming connections.
@@ -213,28 +232,30 @@ void ServerImpl::OnNewConnection(int epoll_descr) {
 
         // Print host and service info.
         char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
-        int retval =
-            getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf, NI_NUMERICHOST | NI_NUMERICSERV);
+        int retval = getnameinfo((struct sockaddr *)&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf,
+                                 NI_NUMERICHOST | NI_NUMERICSERV);
         if (retval == 0) {
             _logger->info("Accepted connection on descriptor {} (host={}, port={})\n", infd, hbuf, sbuf);
         }
         _logger->debug("Conenection fd {}", infd);
         // Register the new FD to be monitored by epoll.
-        auto *pc = new Connection(infd, pStorage, _logger);
+        auto *pc = new Connection(infd, pStorage, _logger, &_output_stats);
         if (pc == nullptr) {
             throw std::runtime_error("Failed to allocate connection");
         }
 
         // Register connection in worker's epoll
         pc->Start();
-        _number_connections++;
-        if (pc->isAlive()) {
-            if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
-                pc->OnError();
-                _number_connections--;
-                delete pc;
-            }
+        if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
+            _logger->error("Failed to add connection to epoll");
+            close(pc->_socket);
+            delete pc;
+            continue;
         }
+
+        _connections[infd] = pc;
+        _number_connections++;
+        pc->UpdateTimer(_timers, config);
     }
 }
 
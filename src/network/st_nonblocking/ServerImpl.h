@@ -1,12 +1,15 @@
 #ifndef AFINA_NETWORK_ST_NONBLOCKING_SERVER_H
 #define AFINA_NETWORK_ST_NONBLOCKING_SERVER_H
 
+#include <atomic>
 #include <list>
 #include <set>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "Connection.h"
+#include "network/TimerWheel.h"
 #include <afina/network/Server.h>
 
 namespace spdlog {
@@ -26,7 +29,8 @@ class Worker;
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               const Config &cfg = Config());
     ~ServerImpl();
 
     // See Server.h
@@ -40,7 +44,10 @@ public:
 
 protected:
     void OnRun();
-    void OnNewConnection(int);
+    void OnNewConnection(int, int);
+
+    // Releases all connection resources
+    void OnClose(int, Connection *);
 
 private:
     // logger to use
@@ -51,8 +58,8 @@ private:
     // Read-only
     uint16_t listen_port;
 
-    // Socket to accept new connection on, shared between acceptors
-    int _server_socket;
+    // Sockets to accept connections on: TCP and/or unix one
+    std::vector<int> _server_sockets;
 
     // Curstom event "device" used to wakeup workers
     int _event_fd;
@@ -60,7 +67,14 @@ private:
     // IO thread
     std::thread _work_thread;
 
-    int _number_connections;
+    std::atomic<int> _number_connections;
+
+    // Responses buffered in all connections
+    OutputStats _output_stats;
+
+    // Connections being served and their deadlines
+    std::unordered_map<int, Connection *> _connections;
+    TimerWheel _timers;
 };
 
 } // namespace STnonblock
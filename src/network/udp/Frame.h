@@ -0,0 +1,84 @@
+#ifndef AFINA_NETWORK_UDP_FRAME_H
+#define AFINA_NETWORK_UDP_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Network {
+namespace UDP {
+
+/**
+ * # Memcached UDP frame header
+ * Each datagram starts with 8 bytes header, all fields are 16 bit unsigned integers in network
+ * byte order:
+ * - request id, chosen by client and echoed back in every frame of the response
+ * - sequence number of the frame, starting from 0
+ * - total number of frames in the message
+ * - reserved, must be 0
+ *
+ * Request must fit into a single frame, response is split into as many frames as needed
+ */
+struct FrameHeader {
+    static constexpr std::size_t kSize = 8;
+
+    uint16_t request_id = 0;
+    uint16_t sequence = 0;
+    uint16_t total = 0;
+    uint16_t reserved = 0;
+
+    /**
+     * Reads header from the beginning of datagram, returns false if datagram is too short
+     */
+    bool Read(const char *data, std::size_t size) {
+        if (size < kSize) {
+            return false;
+        }
+
+        const uint8_t *p = reinterpret_cast<const uint8_t *>(data);
+        request_id = (p[0] << 8) | p[1];
+        sequence = (p[2] << 8) | p[3];
+        total = (p[4] << 8) | p[5];
+        reserved = (p[6] << 8) | p[7];
+        return true;
+    }
+
+    /**
+     * Writes header into kSize bytes pointed by data
+     */
+    void Write(char *data) const {
+        uint8_t *p = reinterpret_cast<uint8_t *>(data);
+        p[0] = request_id >> 8;
+        p[1] = request_id & 0xff;
+        p[2] = sequence >> 8;
+        p[3] = sequence & 0xff;
+        p[4] = total >> 8;
+        p[5] = total & 0xff;
+        p[6] = reserved >> 8;
+        p[7] = reserved & 0xff;
+    }
+};
+
+/**
+ * Largest datagram server sends, same as memcached does: it fits into ethernet MTU together with
+ * IP and UDP headers
+ */
+constexpr std::size_t kMaxFrameSize = 1400;
+
+/**
+ * Response bytes carried by a single frame
+ */
+constexpr std::size_t kMaxFramePayload = kMaxFrameSize - FrameHeader::kSize;
+
+/**
+ * Number of frames needed to send response of the given size, empty response still takes a frame
+ */
+inline std::size_t frames_count(std::size_t size) {
+    return size == 0 ? 1 : (size + kMaxFramePayload - 1) / kMaxFramePayload;
+}
+
+} // namespace UDP
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_UDP_FRAME_H
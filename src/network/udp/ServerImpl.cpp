@@ -0,0 +1,249 @@
+#include "ServerImpl.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Metrics.h>
+#include <afina/Storage.h>
+#include <afina/execute/Get.h>
+#include <afina/logging/Service.h>
+
+#include "Frame.h"
+#include "network/Socket.h"
+#include "protocol/Parser.h"
+
+namespace Afina {
+namespace Network {
+namespace UDP {
+
+// See Server.h
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       const Config &cfg)
+    : Server(ps, pl, cfg), running(false), _event_fd(-1), _requests(0), _dropped(0) {}
+
+// See Server.h
+ServerImpl::~ServerImpl() {}
+
+// See Server.h
+void ServerImpl::Start(uint16_t port, uint32_t, uint32_t n_workers) {
+    _logger = pLogging->select("network.udp");
+    _logger->info("Start udp network service");
+
+    _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_event_fd == -1) {
+        throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+    }
+
+    try {
+        for (uint32_t i = 0; i < n_workers; i++) {
+            _sockets.push_back(open_udp_socket(port, config));
+        }
+    } catch (std::runtime_error &ex) {
+        for (int sfd : _sockets) {
+            close(sfd);
+        }
+        _sockets.clear();
+        close(_event_fd);
+        throw;
+    }
+
+    Metrics &metrics = Metrics::Instance();
+    metrics.Register("udp_requests", [this] { return _requests.load(); });
+    metrics.Register("udp_dropped", [this] { return _dropped.load(); });
+
+    running.store(true);
+    _workers.reserve(n_workers);
+    for (int sfd : _sockets) {
+        _workers.emplace_back(&ServerImpl::OnRun, this, sfd);
+    }
+}
+
+// See Server.h
+void ServerImpl::Stop() {
+    running.store(false);
+
+    // Event is never read, so it wakes up every worker
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup workers");
+    }
+}
+
+// See Server.h
+void ServerImpl::Join() {
+    for (auto &t : _workers) {
+        t.join();
+    }
+    _workers.clear();
+
+    for (int sfd : _sockets) {
+        close(sfd);
+    }
+    _sockets.clear();
+    close(_event_fd);
+
+    Metrics &metrics = Metrics::Instance();
+    metrics.Unregister("udp_requests");
+    metrics.Unregister("udp_dropped");
+}
+
+// See ServerImpl.h
+void ServerImpl::Process(const char *request, std::size_t size, std::string &out) {
+    Protocol::Parser parser;
+    std::size_t pos = 0;
+    try {
+        while (pos < size) {
+            std::size_t parsed = 0;
+            if (!parser.Parse(request + pos, size - pos, parsed)) {
+                // Request must fit into datagram, nothing is going to complete that command
+                out += "CLIENT_ERROR incomplete command\r\n";
+                break;
+            }
+            pos += parsed;
+
+            std::size_t body_size = 0;
+            std::unique_ptr<Execute::Command> command = parser.Build(body_size);
+            if (dynamic_cast<Execute::Get *>(command.get()) == nullptr || body_size > 0) {
+                out += "CLIENT_ERROR only get is supported over UDP\r\n";
+                break;
+            }
+
+            std::string result;
+            command->Execute(*pStorage, std::string(), result);
+            out += result;
+            out += "\r\n";
+            parser.Reset();
+        }
+    } catch (std::runtime_error &ex) {
+        _logger->debug("Failed to process request: {}", ex.what());
+        out += "ERROR\r\n";
+    }
+
+    if (frames_count(out.size()) > UINT16_MAX) {
+        out = "SERVER_ERROR response is too large for UDP\r\n";
+    }
+}
+
+// See ServerImpl.h
+void ServerImpl::OnRun(int sfd) {
+    // Receive side: datagrams of the batch, their senders and headers
+    std::vector<char> buffers(kBatchSize * kMaxRequestSize);
+    std::vector<struct sockaddr_storage> addrs(kBatchSize);
+    std::vector<struct iovec> in_iov(kBatchSize);
+    std::vector<struct mmsghdr> in_msgs(kBatchSize);
+    std::vector<FrameHeader> in_headers(kBatchSize);
+    for (std::size_t i = 0; i < kBatchSize; i++) {
+        in_iov[i].iov_base = &buffers[i * kMaxRequestSize];
+        in_iov[i].iov_len = kMaxRequestSize;
+    }
+
+    // Send side: frames of all responses in the batch, each one is a header plus a slice of response
+    std::vector<std::string> responses(kBatchSize);
+    std::vector<char> out_headers;
+    std::vector<struct iovec> out_iov;
+    std::vector<struct mmsghdr> out_msgs;
+
+    struct pollfd fds[2];
+    fds[0].fd = sfd;
+    fds[0].events = POLLIN;
+    fds[1].fd = _event_fd;
+    fds[1].events = POLLIN;
+
+    while (running.load()) {
+        for (std::size_t i = 0; i < kBatchSize; i++) {
+            std::memset(&in_msgs[i], 0, sizeof(in_msgs[i]));
+            in_msgs[i].msg_hdr.msg_name = &addrs[i];
+            in_msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+            in_msgs[i].msg_hdr.msg_iov = &in_iov[i];
+            in_msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int n = recvmmsg(sfd, &in_msgs[0], kBatchSize, MSG_DONTWAIT, nullptr);
+        if (n == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                if (poll(fds, 2, -1) == -1 && errno != EINTR) {
+                    _logger->error("Failed to wait for datagrams: {}", strerror(errno));
+                    break;
+                }
+                continue;
+            }
+            _logger->error("Failed to receive datagrams: {}", strerror(errno));
+            break;
+        }
+        _logger->debug("Got {} datagrams", n);
+
+        // Execute requests, datagrams that don't look like a single frame request are ignored
+        std::size_t frames = 0;
+        for (int i = 0; i < n; i++) {
+            responses[i].clear();
+            const char *data = static_cast<const char *>(in_iov[i].iov_base);
+            std::size_t size = in_msgs[i].msg_len;
+            if ((in_msgs[i].msg_hdr.msg_flags & MSG_TRUNC) || !in_headers[i].Read(data, size) ||
+                in_headers[i].total != 1) {
+                _dropped++;
+                in_headers[i].total = 0;
+                continue;
+            }
+
+            _requests++;
+            Process(data + FrameHeader::kSize, size - FrameHeader::kSize, responses[i]);
+            in_headers[i].total = frames_count(responses[i].size());
+            frames += in_headers[i].total;
+        }
+
+        // Slice responses into frames, payload is sent right out of response strings
+        out_headers.resize(frames * FrameHeader::kSize);
+        out_iov.resize(frames * 2);
+        out_msgs.resize(frames);
+        std::size_t f = 0;
+        for (int i = 0; i < n; i++) {
+            FrameHeader header = in_headers[i];
+            for (header.sequence = 0; header.sequence < header.total; header.sequence++, f++) {
+                header.reserved = 0;
+                header.Write(&out_headers[f * FrameHeader::kSize]);
+
+                std::size_t offset = header.sequence * kMaxFramePayload;
+                out_iov[2 * f].iov_base = &out_headers[f * FrameHeader::kSize];
+                out_iov[2 * f].iov_len = FrameHeader::kSize;
+                out_iov[2 * f + 1].iov_base = &responses[i][0] + offset;
+                out_iov[2 * f + 1].iov_len = std::min(kMaxFramePayload, responses[i].size() - offset);
+
+                std::memset(&out_msgs[f], 0, sizeof(out_msgs[f]));
+                out_msgs[f].msg_hdr.msg_name = &addrs[i];
+                out_msgs[f].msg_hdr.msg_namelen = in_msgs[i].msg_hdr.msg_namelen;
+                out_msgs[f].msg_hdr.msg_iov = &out_iov[2 * f];
+                out_msgs[f].msg_hdr.msg_iovlen = 2;
+            }
+        }
+        assert(f == frames);
+
+        // UDP gives no delivery guarantee anyway, frame that couldn't be sent is skipped
+        std::size_t sent = 0;
+        while (sent < frames) {
+            int m = sendmmsg(sfd, &out_msgs[sent], frames - sent, 0);
+            if (m == -1) {
+                if (errno != EINTR) {
+                    _logger->debug("Failed to send frame: {}", strerror(errno));
+                    sent++;
+                }
+                continue;
+            }
+            sent += m;
+        }
+    }
+    _logger->warn("UDP worker stopped");
+}
+
+} // namespace UDP
+} // namespace Network
+} // namespace Afina
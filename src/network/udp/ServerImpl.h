@@ -0,0 +1,85 @@
+#ifndef AFINA_NETWORK_UDP_SERVER_H
+#define AFINA_NETWORK_UDP_SERVER_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/network/Server.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+namespace UDP {
+
+/**
+ * # Get-only UDP server
+ * Serves get commands framed with memcached UDP header (see Frame.h), so that reads don't cost
+ * any connection state. Each worker thread owns a socket bound to the same port with SO_REUSEPORT,
+ * receives datagrams in batches with recvmmsg and sends all frames of the batch responses with
+ * sendmmsg.
+ *
+ * Server doesn't keep any state between datagrams, storage must be threadsafe if there is more
+ * than one worker
+ */
+class ServerImpl : public Server {
+public:
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               const Config &cfg = Config());
+    ~ServerImpl();
+
+    // See Server.h
+    void Start(uint16_t port, uint32_t, uint32_t n_workers) override;
+
+    // See Server.h
+    void Stop() override;
+
+    // See Server.h
+    void Join() override;
+
+protected:
+    /**
+     * Method is running in each worker thread
+     */
+    void OnRun(int sfd);
+
+    /**
+     * Executes commands of a single request payload, response is written to out
+     */
+    void Process(const char *request, std::size_t size, std::string &out);
+
+private:
+    // Datagrams received by single recvmmsg call
+    static constexpr std::size_t kBatchSize = 32;
+
+    // Largest request accepted, longer datagrams are dropped
+    static constexpr std::size_t kMaxRequestSize = 8192;
+
+    // Logger instance
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Flag to notify workers when it is time to stop
+    std::atomic<bool> running;
+
+    // Socket per worker
+    std::vector<int> _sockets;
+
+    // Custom event "device" used to wakeup workers on stop
+    int _event_fd;
+
+    std::vector<std::thread> _workers;
+
+    // Counters published via stats
+    std::atomic<uint64_t> _requests;
+    std::atomic<uint64_t> _dropped;
+};
+
+} // namespace UDP
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_UDP_SERVER_H
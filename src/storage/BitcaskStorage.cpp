@@ -0,0 +1,690 @@
+#include "BitcaskStorage.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <afina/Metrics.h>
+
+#include "Checksum.h"
+#include "File.h"
+
+namespace Afina {
+namespace Backend {
+
+static constexpr char kSegmentMagic[8] = {'A', 'F', 'B', 'C', 'S', 'E', 'G', '1'};
+static constexpr char kHintMagic[8] = {'A', 'F', 'B', 'C', 'H', 'N', 'T', '1'};
+
+// Index entry overhead besides the key: hash table node, its bucket and Location
+static constexpr std::size_t kIndexOverhead = 64;
+
+static std::string encode_record(const std::string &key, const std::string &value, uint32_t flags) {
+    BitcaskStorage::Record record{0, flags, static_cast<uint32_t>(key.size()), static_cast<uint32_t>(value.size())};
+    std::string out(sizeof(record), '\0');
+    out.reserve(sizeof(record) + key.size() + value.size());
+    out.append(key);
+    out.append(value);
+    memcpy(&out[0], &record, sizeof(record));
+    record.crc = Crc32c(out.data() + sizeof(record.crc), out.size() - sizeof(record.crc));
+    memcpy(&out[0], &record.crc, sizeof(record.crc));
+    return out;
+}
+
+static void append_hint(std::string &out, const std::string &key, uint64_t offset, uint32_t flags,
+                        uint32_t value_size) {
+    BitcaskStorage::Hint hint{offset, flags, static_cast<uint32_t>(key.size()), value_size, 0};
+    out.append(reinterpret_cast<const char *>(&hint), sizeof(hint));
+    out.append(key);
+}
+
+// Hint is replaced at once, so it is either complete or missing
+static void write_hint(const std::string &path, const std::string &entries) {
+    std::string tmp = path + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create " + tmp + ": " + strerror(errno));
+    }
+    try {
+        uint32_t crc = Crc32c(entries.data(), entries.size());
+        write_all(fd, kHintMagic, sizeof(kHintMagic), tmp);
+        write_all(fd, entries.data(), entries.size(), tmp);
+        write_all(fd, &crc, sizeof(crc), tmp);
+        if (fdatasync(fd) != 0) {
+            throw std::runtime_error("Failed to sync " + tmp + ": " + strerror(errno));
+        }
+    } catch (...) {
+        close(fd);
+        unlink(tmp.c_str());
+        throw;
+    }
+    close(fd);
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        throw std::runtime_error("Failed to replace " + path + ": " + strerror(errno));
+    }
+}
+
+// See BitcaskStorage.h
+BitcaskStorage::Segment::~Segment() { close(fd); }
+
+// See BitcaskStorage.h
+BitcaskStorage::BitcaskStorage(const std::string &dir, std::size_t max_size, std::size_t segment_size,
+                               std::chrono::milliseconds compaction_interval)
+    : _dir(dir), _max_size(max_size), _segment_size(segment_size), _compaction_interval(compaction_interval),
+      _index_bytes(0), _stopping(false), _compactions(0) {}
+
+// See BitcaskStorage.h
+BitcaskStorage::~BitcaskStorage() {
+    if (_thread.joinable() || _active) {
+        Stop();
+    }
+}
+
+// See BitcaskStorage.h
+void BitcaskStorage::Start() {
+    if (mkdir(_dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Failed to create " + _dir + ": " + strerror(errno));
+    }
+
+    // Segments go in the order of ids, leftovers of interrupted hint writes are dropped
+    std::vector<uint64_t> ids;
+    DIR *dir = opendir(_dir.c_str());
+    if (dir == nullptr) {
+        throw std::runtime_error("Failed to open " + _dir + ": " + strerror(errno));
+    }
+    for (struct dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        char *end = nullptr;
+        uint64_t id = std::strtoull(name.c_str(), &end, 10);
+        if (end != name.c_str() && std::string(end) == ".data") {
+            ids.push_back(id);
+        } else if (name.size() > 4 && name.compare(name.size() - 4, 4, ".tmp") == 0) {
+            unlink((_dir + "/" + name).c_str());
+        }
+    }
+    closedir(dir);
+    std::sort(ids.begin(), ids.end());
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _index.clear();
+    _index_bytes = 0;
+    _segments.clear();
+    for (uint64_t id : ids) {
+        std::string path = PathOf(id, ".data");
+        int fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open " + path + ": " + strerror(errno));
+        }
+        auto segment = std::make_shared<Segment>(id, fd, path);
+        uint64_t size;
+        std::vector<Entry> entries = Load(*segment, size);
+        if (size == 0) {
+            continue;
+        }
+        segment->size = size;
+        _segments[id] = segment;
+        for (auto &entry : entries) {
+            Apply(entry.key, id, entry.offset, entry.flags, entry.value_size);
+        }
+    }
+
+    // Segments of the previous run are closed, writes go to the new one
+    uint64_t id = ids.empty() ? kIdStride : (ids.back() / kIdStride + 1) * kIdStride;
+    _active = Create(id);
+    _segments[id] = _active;
+    _active_hints.clear();
+    sync_directory(_active->path);
+
+    Metrics &metrics = Metrics::Instance();
+    metrics.Register("storage_physical_bytes", [this] {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _index_bytes;
+    });
+    metrics.Register("limit_maxbytes", [this] { return _max_size; });
+    metrics.Register("bitcask_keys", [this] { return size(); });
+    metrics.Register("bitcask_segments", [this] { return segments(); });
+    metrics.Register("bitcask_disk_bytes", [this] { return disk_bytes(); });
+    metrics.Register("bitcask_dead_bytes", [this] { return dead_bytes(); });
+    metrics.Register("bitcask_compactions", [this] { return _compactions.load(); });
+
+    if (_compaction_interval.count() > 0) {
+        _stopping = false;
+        _thread = std::thread(&BitcaskStorage::OnRun, this);
+    }
+}
+
+// See BitcaskStorage.h
+void BitcaskStorage::Stop() {
+    if (_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_stop_mutex);
+            _stopping = true;
+        }
+        _stop_cv.notify_all();
+        _thread.join();
+    }
+
+    Metrics &metrics = Metrics::Instance();
+    metrics.Unregister("storage_physical_bytes");
+    metrics.Unregister("limit_maxbytes");
+    metrics.Unregister("bitcask_keys");
+    metrics.Unregister("bitcask_segments");
+    metrics.Unregister("bitcask_disk_bytes");
+    metrics.Unregister("bitcask_dead_bytes");
+    metrics.Unregister("bitcask_compactions");
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_active) {
+        // Empty segment isn't worth a file, otherwise it is closed just like on rotation
+        if (_active->size <= sizeof(kSegmentMagic)) {
+            unlink(_active->path.c_str());
+        } else {
+            fdatasync(_active->fd);
+            try {
+                write_hint(PathOf(_active->id, ".hint"), _active_hints);
+            } catch (std::exception &) {
+                // Segment is read whole on the next start
+            }
+        }
+        sync_directory(_active->path);
+    }
+    _active.reset();
+    _active_hints.clear();
+    _segments.clear();
+    _index.clear();
+    _index_bytes = 0;
+}
+
+// See BitcaskStorage.h
+bool BitcaskStorage::Put(const std::string &key, const std::string &value) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return Write(key, value, 0);
+}
+
+// See BitcaskStorage.h
+bool BitcaskStorage::PutIfAbsent(const std::string &key, const std::string &value) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_index.find(key) != _index.end()) {
+        return false;
+    }
+    return Write(key, value, 0);
+}
+
+// See BitcaskStorage.h
+bool BitcaskStorage::Set(const std::string &key, const std::string &value) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_index.find(key) == _index.end()) {
+        return false;
+    }
+    return Write(key, value, 0);
+}
+
+// See BitcaskStorage.h
+bool BitcaskStorage::Delete(const std::string &key) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_index.find(key) == _index.end()) {
+        return false;
+    }
+    return Write(key, std::string(), kTombstone);
+}
+
+// See BitcaskStorage.h
+bool BitcaskStorage::Get(const std::string &key, std::string &value) {
+    Location location;
+    std::shared_ptr<Segment> segment;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _index.find(key);
+        if (it == _index.end()) {
+            return false;
+        }
+        location = it->second;
+        segment = _segments.at(location.segment);
+    }
+
+    Read(*segment, key, location, value);
+    return true;
+}
+
+// See BitcaskStorage.h
+bool BitcaskStorage::Scan(std::string &cursor, std::size_t batch, const Visitor &visit) {
+    // Cursor is the next bucket of the index and number of buckets, whole bucket is visited at once.
+    // Rehash moves keys between buckets, so iteration starts over then
+    struct Item {
+        std::string key;
+        Location location;
+        std::shared_ptr<Segment> segment;
+    };
+    std::vector<Item> items;
+    std::size_t bucket = 0, buckets = 0;
+    bool more;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!cursor.empty()) {
+            std::size_t slash = cursor.find('/');
+            bucket = std::stoull(cursor.substr(0, slash));
+            buckets = std::stoull(cursor.substr(slash + 1));
+        }
+        if (buckets != _index.bucket_count()) {
+            bucket = 0;
+            buckets = _index.bucket_count();
+        }
+        for (; bucket < buckets && items.size() < batch; bucket++) {
+            for (auto it = _index.begin(bucket); it != _index.end(bucket); it++) {
+                items.push_back(Item{it->first, it->second, _segments.at(it->second.segment)});
+            }
+        }
+        more = bucket < buckets;
+    }
+
+    // Values are read without the lock, just like Get does
+    std::string value;
+    for (auto &item : items) {
+        Read(*item.segment, item.key, item.location, value);
+        visit(item.key, value);
+    }
+    cursor = std::to_string(bucket) + "/" + std::to_string(buckets);
+    return more;
+}
+
+// See BitcaskStorage.h
+bool BitcaskStorage::Checkpoint() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_active) {
+        throw std::runtime_error("Storage isn't started");
+    }
+    if (_active->size > sizeof(kSegmentMagic)) {
+        Rotate();
+    }
+    return true;
+}
+
+// See BitcaskStorage.h
+std::size_t BitcaskStorage::Compact() {
+    std::lock_guard<std::mutex> compaction(_compaction_mutex);
+
+    // Everything written so far is merged, new writes go to the next active segment
+    std::vector<std::shared_ptr<Segment>> inputs;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_active) {
+            return 0;
+        }
+        if (_active->size > sizeof(kSegmentMagic)) {
+            Rotate();
+        }
+        for (auto &segment : _segments) {
+            if (segment.second != _active) {
+                inputs.push_back(segment.second);
+            }
+        }
+    }
+    if (inputs.empty()) {
+        return 0;
+    }
+
+    // Merged segments go right after the inputs, still before the active one
+    uint64_t next_id = inputs.back()->id + 1;
+    std::shared_ptr<Segment> output;
+    std::string hints;
+    std::size_t copied = 0;
+    auto close_output = [&] {
+        if (fdatasync(output->fd) != 0) {
+            throw std::runtime_error("Failed to sync " + output->path + ": " + strerror(errno));
+        }
+        write_hint(PathOf(output->id, ".hint"), hints);
+        hints.clear();
+    };
+
+    for (auto &input : inputs) {
+        uint64_t size;
+        for (auto &entry : Load(*input, size)) {
+            if (entry.flags & kTombstone) {
+                continue;
+            }
+            auto current = [&] {
+                auto it = _index.find(entry.key);
+                return it != _index.end() && it->second.segment == input->id && it->second.offset == entry.offset;
+            };
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!current()) {
+                    continue;
+                }
+            }
+
+            std::string record(sizeof(Record) + entry.key.size() + entry.value_size, '\0');
+            if (!pread_all(input->fd, &record[0], record.size(), entry.offset)) {
+                throw std::runtime_error("Failed to read " + input->path + ": " + strerror(errno));
+            }
+
+            if (!output || output->size + record.size() > _segment_size) {
+                if (output) {
+                    close_output();
+                }
+                if (next_id % kIdStride == 0) {
+                    throw std::runtime_error("Too many merged segments");
+                }
+                output = Create(next_id++);
+                std::lock_guard<std::mutex> lock(_mutex);
+                _segments[output->id] = output;
+            }
+            pwrite_all(output->fd, record.data(), record.size(), output->size, output->path);
+
+            // Key could have been changed while the record was copied, the copy is dead then
+            std::lock_guard<std::mutex> lock(_mutex);
+            uint64_t offset = output->size;
+            output->size += record.size();
+            if (current()) {
+                Apply(entry.key, output->id, offset, 0, entry.value_size);
+                append_hint(hints, entry.key, offset, 0, entry.value_size);
+                copied++;
+            }
+        }
+    }
+    if (output) {
+        close_output();
+        sync_directory(output->path);
+    }
+
+    // Older segments are removed first: whatever is left after crash, newer records still win
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto &input : inputs) {
+            _segments.erase(input->id);
+        }
+    }
+    for (auto &input : inputs) {
+        unlink(PathOf(input->id, ".hint").c_str());
+        unlink(input->path.c_str());
+    }
+    sync_directory(inputs.front()->path);
+
+    _compactions++;
+    return copied;
+}
+
+// See BitcaskStorage.h
+std::size_t BitcaskStorage::size() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _index.size();
+}
+
+// See BitcaskStorage.h
+std::size_t BitcaskStorage::segments() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _segments.size();
+}
+
+// See BitcaskStorage.h
+uint64_t BitcaskStorage::disk_bytes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint64_t bytes = 0;
+    for (auto &segment : _segments) {
+        bytes += segment.second->size;
+    }
+    return bytes;
+}
+
+// See BitcaskStorage.h
+uint64_t BitcaskStorage::dead_bytes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint64_t bytes = 0;
+    for (auto &segment : _segments) {
+        bytes += segment.second->size - sizeof(kSegmentMagic) - segment.second->live;
+    }
+    return bytes;
+}
+
+// See BitcaskStorage.h
+void BitcaskStorage::OnRun() {
+    std::unique_lock<std::mutex> stop_lock(_stop_mutex);
+    while (!_stop_cv.wait_for(stop_lock, _compaction_interval, [this] { return _stopping; })) {
+        // Merge pays off once closed segments are mostly dead
+        uint64_t closed = 0, dead = 0;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto &segment : _segments) {
+                if (segment.second != _active) {
+                    closed += segment.second->size - sizeof(kSegmentMagic);
+                    dead += segment.second->size - sizeof(kSegmentMagic) - segment.second->live;
+                }
+            }
+        }
+        if (closed == 0 || dead * 2 < closed) {
+            continue;
+        }
+
+        stop_lock.unlock();
+        try {
+            Compact();
+        } catch (std::exception &) {
+            // Inputs stay in place, next attempt starts over
+        }
+        stop_lock.lock();
+    }
+}
+
+// See BitcaskStorage.h
+bool BitcaskStorage::Write(const std::string &key, const std::string &value, uint32_t flags) {
+    if (!_active) {
+        throw std::runtime_error("Storage isn't started");
+    }
+
+    std::size_t size = sizeof(Record) + key.size() + value.size();
+    if (size > _segment_size - sizeof(kSegmentMagic)) {
+        return false;
+    }
+    if (!(flags & kTombstone) && _index.find(key) == _index.end() && _index_bytes + IndexBytes(key) > _max_size) {
+        return false;
+    }
+
+    if (_active->size + size > _segment_size) {
+        Rotate();
+    }
+    std::string record = encode_record(key, value, flags);
+    pwrite_all(_active->fd, record.data(), record.size(), _active->size, _active->path);
+
+    uint64_t offset = _active->size;
+    _active->size += size;
+    append_hint(_active_hints, key, offset, flags, value.size());
+    Apply(key, _active->id, offset, flags, value.size());
+    return true;
+}
+
+// See BitcaskStorage.h
+void BitcaskStorage::Rotate() {
+    if (fdatasync(_active->fd) != 0) {
+        throw std::runtime_error("Failed to sync " + _active->path + ": " + strerror(errno));
+    }
+    try {
+        write_hint(PathOf(_active->id, ".hint"), _active_hints);
+    } catch (std::exception &) {
+        // Segment is read whole on the next start
+    }
+    _active_hints.clear();
+
+    uint64_t id = (_active->id / kIdStride + 1) * kIdStride;
+    _active = Create(id);
+    _segments[id] = _active;
+    sync_directory(_active->path);
+}
+
+// See BitcaskStorage.h
+std::shared_ptr<BitcaskStorage::Segment> BitcaskStorage::Create(uint64_t id) const {
+    std::string path = PathOf(id, ".data");
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create " + path + ": " + strerror(errno));
+    }
+    auto segment = std::make_shared<Segment>(id, fd, path);
+    write_all(fd, kSegmentMagic, sizeof(kSegmentMagic), path);
+    if (fdatasync(fd) != 0) {
+        throw std::runtime_error("Failed to sync " + path + ": " + strerror(errno));
+    }
+    segment->size = sizeof(kSegmentMagic);
+    return segment;
+}
+
+// See BitcaskStorage.h
+std::vector<BitcaskStorage::Entry> BitcaskStorage::Load(const Segment &segment, uint64_t &size) {
+    std::vector<Entry> entries;
+    struct stat st;
+    if (fstat(segment.fd, &st) != 0) {
+        throw std::runtime_error("Failed to stat " + segment.path + ": " + strerror(errno));
+    }
+    size = st.st_size;
+
+    // Crash right after the segment was created leaves it without magic, there are no records in it
+    std::string hint_path = PathOf(segment.id, ".hint");
+    if (size < sizeof(kSegmentMagic)) {
+        unlink(hint_path.c_str());
+        unlink(segment.path.c_str());
+        size = 0;
+        return entries;
+    }
+
+    // Valid hint tells everything without reading values
+    int hint_fd = open(hint_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (hint_fd >= 0) {
+        std::string hint;
+        bool valid = fstat(hint_fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(kHintMagic) + 4);
+        if (valid) {
+            hint.resize(st.st_size);
+            valid = pread_all(hint_fd, &hint[0], hint.size(), 0) &&
+                    hint.compare(0, sizeof(kHintMagic), kHintMagic, 8) == 0;
+        }
+        close(hint_fd);
+
+        uint32_t crc = 0;
+        if (valid) {
+            memcpy(&crc, &hint[hint.size() - sizeof(crc)], sizeof(crc));
+            valid = Crc32c(hint.data() + sizeof(kHintMagic), hint.size() - sizeof(kHintMagic) - sizeof(crc)) == crc;
+        }
+        for (std::size_t pos = sizeof(kHintMagic), end = hint.size() - sizeof(crc); valid && pos < end;) {
+            Hint h;
+            if (end - pos < sizeof(h)) {
+                valid = false;
+                break;
+            }
+            memcpy(&h, &hint[pos], sizeof(h));
+            pos += sizeof(h);
+            if (end - pos < h.key_size || h.offset + sizeof(Record) + h.key_size + h.value_size > size) {
+                valid = false;
+                break;
+            }
+            entries.push_back(Entry{hint.substr(pos, h.key_size), h.offset, h.flags, h.value_size});
+            pos += h.key_size;
+        }
+        if (valid) {
+            return entries;
+        }
+        entries.clear();
+    }
+
+    // No hint, segment is walked record by record
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, segment.fd, 0);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Failed to map " + segment.path + ": " + strerror(errno));
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    const char *begin = static_cast<const char *>(mapping);
+    if (memcmp(begin, kSegmentMagic, sizeof(kSegmentMagic)) != 0) {
+        munmap(mapping, size);
+        throw std::runtime_error(segment.path + " isn't a segment");
+    }
+
+    std::string hints;
+    std::size_t offset = sizeof(kSegmentMagic);
+    while (size - offset >= sizeof(Record)) {
+        Record record;
+        memcpy(&record, begin + offset, sizeof(record));
+        std::size_t length = sizeof(Record) + std::size_t(record.key_size) + record.value_size;
+        if (size - offset < length ||
+            Crc32c(begin + offset + sizeof(record.crc), length - sizeof(record.crc)) != record.crc) {
+            break;
+        }
+        std::string key(begin + offset + sizeof(Record), record.key_size);
+        append_hint(hints, key, offset, record.flags, record.value_size);
+        entries.push_back(Entry{std::move(key), offset, record.flags, record.value_size});
+        offset += length;
+    }
+    munmap(mapping, size);
+
+    // Torn record of the crashed process was never seen by anyone
+    if (offset < size && ftruncate(segment.fd, offset) != 0) {
+        throw std::runtime_error("Failed to truncate " + segment.path + ": " + strerror(errno));
+    }
+    size = offset;
+    try {
+        write_hint(hint_path, hints);
+    } catch (std::exception &) {
+        // Segment is read whole next time as well
+    }
+    return entries;
+}
+
+// See BitcaskStorage.h
+void BitcaskStorage::Read(const Segment &segment, const std::string &key, const Location &location,
+                          std::string &value) {
+    std::string record(sizeof(Record) + key.size() + location.value_size, '\0');
+    if (!pread_all(segment.fd, &record[0], record.size(), location.offset)) {
+        throw std::runtime_error("Failed to read " + segment.path + ": " + strerror(errno));
+    }
+    Record header;
+    memcpy(&header, record.data(), sizeof(header));
+    if (Crc32c(record.data() + sizeof(header.crc), record.size() - sizeof(header.crc)) != header.crc ||
+        record.compare(sizeof(header), key.size(), key) != 0) {
+        throw std::runtime_error("Record of " + segment.path + " is damaged");
+    }
+    value.assign(record, sizeof(header) + key.size(), location.value_size);
+}
+
+// See BitcaskStorage.h
+void BitcaskStorage::Apply(const std::string &key, uint64_t segment, uint64_t offset, uint32_t flags,
+                           uint32_t value_size) {
+    auto it = _index.find(key);
+    if (it != _index.end()) {
+        auto old = _segments.find(it->second.segment);
+        if (old != _segments.end()) {
+            old->second->live -= sizeof(Record) + key.size() + it->second.value_size;
+        }
+    }
+
+    if (flags & kTombstone) {
+        if (it != _index.end()) {
+            _index_bytes -= IndexBytes(key);
+            _index.erase(it);
+        }
+        return;
+    }
+
+    if (it == _index.end()) {
+        _index.emplace(key, Location{segment, offset, value_size});
+        _index_bytes += IndexBytes(key);
+    } else {
+        it->second = Location{segment, offset, value_size};
+    }
+    _segments.at(segment)->live += sizeof(Record) + key.size() + value_size;
+}
+
+// See BitcaskStorage.h
+std::string BitcaskStorage::PathOf(uint64_t id, const char *suffix) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%020llu", static_cast<unsigned long long>(id));
+    return _dir + "/" + name + suffix;
+}
+
+// See BitcaskStorage.h
+std::size_t BitcaskStorage::IndexBytes(const std::string &key) { return key.size() + kIndexOverhead; }
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,226 @@
+#ifndef AFINA_STORAGE_BITCASK_STORAGE_H
+#define AFINA_STORAGE_BITCASK_STORAGE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Persistent storage bigger than memory
+ * Log structured storage in the spirit of Bitcask: values live in append-only segment files in the
+ * data directory, memory holds only the index from key to the place of its latest record. Put appends
+ * a record to the active segment and points the index to it, Delete appends a tombstone, Get reads the
+ * record with one pread. So the dataset is limited by the disk, memory limit applies to the index.
+ *
+ * Active segment is closed once it reaches segment size: it is synced and gets a hint file, list of
+ * its keys with record positions, and new active segment is created. On start index is rebuilt from
+ * hint files, only segments without one, e.g the active segment of crashed process, are read whole.
+ * Torn record at the end of such segment is cut off.
+ *
+ * Overwritten and deleted values stay in closed segments until compaction. Background thread merges
+ * all closed segments once at least half of their bytes is dead: live records are copied to new
+ * segments with hints, then old segments are removed. Writers aren't blocked meanwhile, they append to
+ * the active segment. Segment ids define replay order, merged segments take ids right after the
+ * newest merged one, active segments go by kIdStride, so that merge result is always older than
+ * data written after the merge has begun.
+ *
+ * File layout, integers are in host byte order:
+ *  - segment NNN.data: magic "AFBCSEG1", then records: Record header, key, value
+ *  - hint NNN.hint: magic "AFBCHNT1", then entries: Hint header, key; then CRC-32C of entries
+ *
+ * Records aren't synced one by one: crash of the process loses nothing, crash of the machine loses
+ * writes since the segment was closed. Wrap it into WalStorage for durable mode.
+ *
+ * Storage is thread safe, reads run in parallel with each other and with writes
+ */
+class BitcaskStorage : public Afina::Storage {
+public:
+    static constexpr std::size_t kDefaultSegmentSize = 64 * 1024 * 1024;
+    static constexpr uint64_t kIdStride = 1 << 20;
+    static constexpr uint32_t kTombstone = 1;
+
+    struct Record {
+        // Checksum of the rest of the header, key and value
+        uint32_t crc;
+        uint32_t flags;
+        uint32_t key_size;
+        uint32_t value_size;
+    };
+
+    struct Hint {
+        uint64_t offset;
+        uint32_t flags;
+        uint32_t key_size;
+        uint32_t value_size;
+        uint32_t reserved;
+    };
+
+    /**
+     * @param dir data directory, created if missing
+     * @param max_size memory limit of the index, new keys are refused once it is reached
+     * @param segment_size size active segment is closed at
+     * @param compaction_interval time between checks whether it is time to merge, zero disables
+     * background merge
+     */
+    BitcaskStorage(const std::string &dir, std::size_t max_size, std::size_t segment_size = kDefaultSegmentSize,
+                   std::chrono::milliseconds compaction_interval = std::chrono::milliseconds(1000));
+    ~BitcaskStorage();
+
+    // Implements Afina::Storage interface: rebuilds index, starts compaction. Throws std::runtime_error
+    // if data directory can't be read
+    void Start() override;
+
+    // Implements Afina::Storage interface: closes active segment
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface: values of the batch are read after the lock is released
+    bool Scan(std::string &cursor, std::size_t batch, const Visitor &visit) override;
+
+    // Implements Afina::Storage interface: closes active segment with its hint, so nothing is read
+    // whole on the next start
+    bool Checkpoint() override;
+
+    /**
+     * Merges closed segments right away, returns number of records copied
+     */
+    std::size_t Compact();
+
+    // Number of keys
+    std::size_t size() const;
+
+    // Number of segment files including the active one
+    std::size_t segments() const;
+
+    // Bytes of segment files and bytes of them taken by overwritten and deleted records
+    uint64_t disk_bytes() const;
+    uint64_t dead_bytes() const;
+
+private:
+    struct Segment {
+        Segment(uint64_t id, int fd, const std::string &path) : id(id), fd(fd), path(path), size(0), live(0) {}
+        ~Segment();
+
+        const uint64_t id;
+        const int fd;
+        const std::string path;
+
+        // Bytes in the file and bytes of records index points to
+        uint64_t size;
+        uint64_t live;
+    };
+
+    // Where the latest record of the key is
+    struct Location {
+        uint64_t segment;
+        uint64_t offset;
+        uint32_t value_size;
+    };
+
+    // Record position as read from hint or segment
+    struct Entry {
+        std::string key;
+        uint64_t offset;
+        uint32_t flags;
+        uint32_t value_size;
+    };
+
+    void OnRun();
+
+    /**
+     * Appends record to the active segment and updates index, must be called under _mutex
+     */
+    bool Write(const std::string &key, const std::string &value, uint32_t flags);
+
+    /**
+     * Syncs active segment, writes its hint and makes new one active, must be called under _mutex
+     */
+    void Rotate();
+
+    /**
+     * New empty segment file, synced but its directory entry isn't
+     */
+    std::shared_ptr<Segment> Create(uint64_t id) const;
+
+    /**
+     * Entries of the segment, from hint if there is valid one. Segment without hint is read whole, its
+     * torn tail is cut off and hint is written. Size is set to the length of the valid part, segment
+     * shorter than its magic is removed and size is zero then. Segment itself isn't changed, so it
+     * could be loaded without _mutex
+     */
+    std::vector<Entry> Load(const Segment &segment, uint64_t &size);
+
+    /**
+     * Reads value of the record, throws std::runtime_error if it can't be read or is damaged. Segment
+     * file stays open while it is referenced, even if compaction has removed it meanwhile
+     */
+    static void Read(const Segment &segment, const std::string &key, const Location &location, std::string &value);
+
+    /**
+     * Points index to the record, accounts live bytes of the old and new place, must be called under
+     * _mutex
+     */
+    void Apply(const std::string &key, uint64_t segment, uint64_t offset, uint32_t flags, uint32_t value_size);
+
+    std::string PathOf(uint64_t id, const char *suffix) const;
+
+    static std::size_t IndexBytes(const std::string &key);
+
+    const std::string _dir;
+    const std::size_t _max_size;
+    const std::size_t _segment_size;
+    const std::chrono::milliseconds _compaction_interval;
+
+    // Guards index, segments and active segment, writes are serialized by it
+    mutable std::mutex _mutex;
+    std::unordered_map<std::string, Location> _index;
+    std::size_t _index_bytes;
+    std::map<uint64_t, std::shared_ptr<Segment>> _segments;
+    std::shared_ptr<Segment> _active;
+
+    // Hint entries of the active segment
+    std::string _active_hints;
+
+    // Single merge at a time, Compact could be called while background one runs
+    std::mutex _compaction_mutex;
+
+    std::thread _thread;
+    std::mutex _stop_mutex;
+    std::condition_variable _stop_cv;
+    bool _stopping;
+
+    std::atomic<uint64_t> _compactions;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_BITCASK_STORAGE_H
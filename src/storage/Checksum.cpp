@@ -0,0 +1,62 @@
+#include "Checksum.h"
+
+#include <cstring>
+
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+namespace Afina {
+namespace Backend {
+
+#ifndef __SSE4_2__
+namespace {
+
+// Reflected Castagnoli polynomial
+constexpr uint32_t kPolynomial = 0x82F63B78;
+
+struct Table {
+    uint32_t entries[256];
+
+    Table() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ ((crc & 1) != 0 ? kPolynomial : 0);
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+} // namespace
+#endif
+
+// See Checksum.h
+uint32_t Crc32c(const void *data, std::size_t size, uint32_t crc) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    crc = ~crc;
+
+#ifdef __SSE4_2__
+    uint64_t crc64 = crc;
+    for (; size >= 8; p += 8, size -= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = static_cast<uint32_t>(crc64);
+    for (; size > 0; p++, size--) {
+        crc = _mm_crc32_u8(crc, *p);
+    }
+#else
+    static const Table table;
+    for (; size > 0; p++, size--) {
+        crc = table.entries[(crc ^ *p) & 0xFF] ^ (crc >> 8);
+    }
+#endif
+
+    return ~crc;
+}
+
+} // namespace Backend
+} // namespace Afina
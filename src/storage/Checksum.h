@@ -0,0 +1,19 @@
+#ifndef AFINA_STORAGE_CHECKSUM_H
+#define AFINA_STORAGE_CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * CRC-32C of the data, crc of the preceding data allows to checksum it piece by piece. Uses SSE 4.2
+ * instruction once compiler is allowed to
+ */
+uint32_t Crc32c(const void *data, std::size_t size, uint32_t crc = 0);
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_CHECKSUM_H
@@ -0,0 +1,76 @@
+#include "File.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+// See File.h
+void write_all(int fd, const void *data, std::size_t size, const std::string &path) {
+    const char *p = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t written = write(fd, p, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to write " + path + ": " + strerror(errno));
+        }
+        p += written;
+        size -= written;
+    }
+}
+
+// See File.h
+void pwrite_all(int fd, const void *data, std::size_t size, uint64_t offset, const std::string &path) {
+    const char *p = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t written = pwrite(fd, p, size, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to write " + path + ": " + strerror(errno));
+        }
+        p += written;
+        size -= written;
+        offset += written;
+    }
+}
+
+// See File.h
+bool pread_all(int fd, void *data, std::size_t size, uint64_t offset) {
+    char *p = static_cast<char *>(data);
+    while (size > 0) {
+        ssize_t n = pread(fd, p, size, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+        offset += n;
+    }
+    return true;
+}
+
+// See File.h
+void sync_directory(const std::string &path) {
+    std::size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
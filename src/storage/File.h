@@ -0,0 +1,34 @@
+#ifndef AFINA_STORAGE_FILE_H
+#define AFINA_STORAGE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * Writes all the data, path is used in error message. Throws std::runtime_error on failure
+ */
+void write_all(int fd, const void *data, std::size_t size, const std::string &path);
+
+/**
+ * Writes all the data at the given offset, path is used in error message. Throws std::runtime_error on failure
+ */
+void pwrite_all(int fd, const void *data, std::size_t size, uint64_t offset, const std::string &path);
+
+/**
+ * Reads exactly size bytes at the given offset. Returns false on error or end of file, errno tells which
+ */
+bool pread_all(int fd, void *data, std::size_t size, uint64_t offset);
+
+/**
+ * Makes creation, rename or removal of the file durable, errors are ignored
+ */
+void sync_directory(const std::string &path);
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_FILE_H
@@ -0,0 +1,97 @@
+#include "ShardedSlabLRU.h"
+
+#include <functional>
+#include <stdexcept>
+
+#include <afina/Metrics.h>
+
+namespace Afina {
+namespace Backend {
+
+// See ShardedSlabLRU.h
+ShardedSlabLRU::ShardedSlabLRU(std::size_t max_size, unsigned map_flags, const std::vector<int> &nodes)
+    : _max_size(max_size) {
+    if (nodes.empty()) {
+        throw std::runtime_error("Sharded storage needs at least one shard");
+    }
+
+    _shards.reserve(nodes.size());
+    for (int node : nodes) {
+        _shards.emplace_back(new ThreadSafeSlabLRU(max_size / nodes.size(), map_flags, node));
+    }
+}
+
+// See ShardedSlabLRU.h
+void ShardedSlabLRU::Start() {
+    Metrics &metrics = Metrics::Instance();
+    metrics.Register("storage_physical_bytes", [this] { return physical_size(); });
+    metrics.Register("storage_logical_bytes", [this] { return logical_size(); });
+    metrics.Register("limit_maxbytes", [this] { return _max_size; });
+    metrics.Register("storage_shards", [this] { return _shards.size(); });
+}
+
+// See ShardedSlabLRU.h
+void ShardedSlabLRU::Stop() {
+    Metrics &metrics = Metrics::Instance();
+    metrics.Unregister("storage_physical_bytes");
+    metrics.Unregister("storage_logical_bytes");
+    metrics.Unregister("limit_maxbytes");
+    metrics.Unregister("storage_shards");
+}
+
+// See ShardedSlabLRU.h
+bool ShardedSlabLRU::Scan(std::string &cursor, std::size_t batch, const Visitor &visit) {
+    // Cursor is shard number and cursor inside of the shard separated by colon
+    std::size_t shard = 0;
+    std::string inner;
+    if (!cursor.empty()) {
+        std::size_t colon = cursor.find(':');
+        shard = std::stoull(cursor.substr(0, colon));
+        inner = cursor.substr(colon + 1);
+    }
+
+    if (!_shards[shard]->Scan(inner, batch, visit)) {
+        shard++;
+        inner.clear();
+    }
+    cursor = std::to_string(shard) + ":" + inner;
+    return shard < _shards.size();
+}
+
+// See ShardedSlabLRU.h
+std::size_t ShardedSlabLRU::shard_of(const std::string &key) const {
+    // Shard takes high bits of the mixed hash, index buckets inside of the shard use low ones, so that
+    // keys of the shard are still spread over all of its buckets
+    uint64_t hash = std::hash<std::string>()(key) * 0x9E3779B97F4A7C15ULL;
+    return (hash >> 32) % _shards.size();
+}
+
+// See ShardedSlabLRU.h
+std::size_t ShardedSlabLRU::size() const {
+    std::size_t total = 0;
+    for (auto &shard : _shards) {
+        total += shard->size();
+    }
+    return total;
+}
+
+// See ShardedSlabLRU.h
+std::size_t ShardedSlabLRU::physical_size() const {
+    std::size_t total = 0;
+    for (auto &shard : _shards) {
+        total += shard->physical_size();
+    }
+    return total;
+}
+
+// See ShardedSlabLRU.h
+std::size_t ShardedSlabLRU::logical_size() const {
+    std::size_t total = 0;
+    for (auto &shard : _shards) {
+        total += shard->logical_size();
+    }
+    return total;
+}
+
+} // namespace Backend
+} // namespace Afina
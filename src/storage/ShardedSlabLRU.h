@@ -0,0 +1,84 @@
+#ifndef AFINA_STORAGE_SHARDED_SLAB_LRU_H
+#define AFINA_STORAGE_SHARDED_SLAB_LRU_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/Storage.h>
+
+#include "ThreadSafeSlabLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # ThreadSafeSlabLRU split into shards placed on NUMA nodes
+ * Each shard is a separate cache with its own lock, its area is bound to the node given for it, so
+ * items of the shard are local to workers pinned to that node. Key is owned by exactly one shard
+ * chosen by key hash: Set and Delete must see the same item whichever worker executes them, so key
+ * can't be moved closer to the worker that asks for it. Workers get local access to the share of
+ * keys their node owns, and shards don't contend for the same lock.
+ *
+ * Memory limit is split evenly between shards, each one evicts on its own
+ */
+class ShardedSlabLRU : public Afina::Storage {
+public:
+    /**
+     * @param nodes NUMA node of each shard, -1 to leave shard placement to the kernel
+     */
+    ShardedSlabLRU(std::size_t max_size, unsigned map_flags, const std::vector<int> &nodes);
+
+    // Implements Afina::Storage interface, registers memory gauges summed over shards
+    void Start() override;
+
+    // Implements Afina::Storage interface
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override { return Shard(key).Put(key, value); }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        return Shard(key).PutIfAbsent(key, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override { return Shard(key).Set(key, value); }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override { return Shard(key).Delete(key); }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return Shard(key).Get(key, value); }
+
+    // Implements Afina::Storage interface, shards are visited one after another
+    bool Scan(std::string &cursor, std::size_t batch, const Visitor &visit) override;
+
+    /**
+     * Number of shards and shard that owns the key
+     */
+    std::size_t shards() const { return _shards.size(); }
+    std::size_t shard_of(const std::string &key) const;
+
+    const SlabLRU &shard(std::size_t i) const { return *_shards[i]; }
+
+    /**
+     * Totals over all shards, see SlabLRU
+     */
+    std::size_t size() const;
+    std::size_t physical_size() const;
+    std::size_t logical_size() const;
+
+private:
+    ThreadSafeSlabLRU &Shard(const std::string &key) { return *_shards[shard_of(key)]; }
+
+    const std::size_t _max_size;
+    std::vector<std::unique_ptr<ThreadSafeSlabLRU>> _shards;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SHARDED_SLAB_LRU_H
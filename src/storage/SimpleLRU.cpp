@@ -1,11 +1,64 @@
 #include "SimpleLRU.h"
 
+#include <algorithm>
+
+#include <afina/Metrics.h>
+
 namespace Afina {
 namespace Backend {
 
+// Heap block malloc takes for the given request: 8 bytes of header, 16 bytes granularity
+static std::size_t heap_block(std::size_t size) { return std::max<std::size_t>(32, (size + 8 + 15) & ~std::size_t(15)); }
+
+// Heap block string has, if it doesn't fit inline
+static std::size_t string_block(std::size_t capacity) {
+    static const std::size_t inline_capacity = std::string().capacity();
+    return capacity > inline_capacity ? heap_block(capacity + 1) : 0;
+}
+
+// See SimpleLRU.h
+void SimpleLRU::Start() {
+    Metrics &metrics = Metrics::Instance();
+    metrics.Register("storage_physical_bytes", [this] { return physical_size(); });
+    metrics.Register("storage_logical_bytes", [this] { return logical_size(); });
+    metrics.Register("limit_maxbytes", [this] { return _max_size; });
+}
+
+// See SimpleLRU.h
+void SimpleLRU::Stop() {
+    Metrics &metrics = Metrics::Instance();
+    metrics.Unregister("storage_physical_bytes");
+    metrics.Unregister("storage_logical_bytes");
+    metrics.Unregister("limit_maxbytes");
+}
+
+// See SimpleLRU.h
+std::size_t SimpleLRU::Footprint(const std::string &key, const std::string &value) {
+    // Strings copied into node get exactly the capacity they need
+    return _footprint(key.size(), value.size());
+}
+
+std::size_t SimpleLRU::_footprint(std::size_t key_capacity, std::size_t value_capacity) {
+    // Red-black tree node: color and three links followed by the value
+    static const std::size_t map_node = heap_block(4 * sizeof(void *) + sizeof(decltype(_lru_index)::value_type));
+    return heap_block(sizeof(lru_node)) + map_node + string_block(key_capacity) + string_block(value_capacity);
+}
+
+void SimpleLRU::_account(const lru_node *node, bool add) {
+    std::size_t physical = _footprint(node->key.capacity(), node->value.capacity());
+    std::size_t logical = node->key.size() + node->value.size();
+    if (add) {
+        _cur_size.fetch_add(physical, std::memory_order_relaxed);
+        _logical_size.fetch_add(logical, std::memory_order_relaxed);
+    } else {
+        _cur_size.fetch_sub(physical, std::memory_order_relaxed);
+        _logical_size.fetch_sub(logical, std::memory_order_relaxed);
+    }
+}
+
 
 void SimpleLRU::_cut_node(lru_node *cut_node) {
-    _cur_size -= cut_node->value.size() + cut_node->key.size();
+    _account(cut_node, false);
     if (cut_node->next != nullptr) {
         cut_node->next->prev = cut_node->prev;
     } else {
@@ -35,9 +88,8 @@ bool SimpleLRU::_erase_from_storage() {
     return _erase_from_list(_lru_tail);
 }
 
-bool SimpleLRU::_free_space_for_node(const std::string &key, const std::string &value)
+bool SimpleLRU::_free_space_for_node(std::size_t size_of_node)
 {
-    std::size_t size_of_node = key.size() + value.size();
     if (size_of_node > _max_size) {
         return false;
     }
@@ -49,7 +101,7 @@ bool SimpleLRU::_free_space_for_node(const std::string &key, const std::string &
     return true;
 }
 bool SimpleLRU::_push_node(lru_node *push_node) {
-    _cur_size += push_node->key.size() + push_node->value.size();;
+    _account(push_node, true);
     if (_lru_head == nullptr) {
         _lru_head.swap(push_node->next);
         _lru_tail = _lru_head.get();
@@ -61,7 +113,7 @@ bool SimpleLRU::_push_node(lru_node *push_node) {
 }
 
 bool SimpleLRU::_insert_to_list(const std::string &key, const std::string &value) {
-    if (!_free_space_for_node(key, value))
+    if (!_free_space_for_node(Footprint(key, value)))
     {
         return false;
     }
@@ -81,14 +133,17 @@ void SimpleLRU::_insert_to_map() {
 bool SimpleLRU::_change_value_in_list(lru_node *change_node, const std::string &value) {
     _cut_node(change_node);
     change_node->value = value;
-    if (!_free_space_for_node(change_node->key, value))
+    if (!_free_space_for_node(_footprint(change_node->key.capacity(), change_node->value.capacity())))
     {
+        // Node is out of the list already, it owns itself now
+        _lru_index.erase(change_node->key);
+        change_node->next.reset();
         return false;
     }
     return _push_node(change_node);
 }
 
-// See MapBasedGlobalLockImpl.h
+// See SimpleLRU.h
 bool SimpleLRU::Put(const std::string &key, const std::string &value) {
     auto it_find = _lru_index.find(key);
     if (it_find != _lru_index.end()) {
@@ -104,7 +159,7 @@ bool SimpleLRU::Put(const std::string &key, const std::string &value) {
     return true;
 }
 
-// See MapBasedGlobalLockImpl.h
+// See SimpleLRU.h
 bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
     auto it_find = _lru_index.find(key);
     if (it_find != _lru_index.end()) {
@@ -117,7 +172,7 @@ bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
     return true;
 }
 
-// See MapBasedGlobalLockImpl.h
+// See SimpleLRU.h
 bool SimpleLRU::Set(const std::string &key, const std::string &value) {
     auto it_find = _lru_index.find(key);
     if (it_find == _lru_index.end()) {
@@ -129,7 +184,7 @@ bool SimpleLRU::Set(const std::string &key, const std::string &value) {
     return true;
 }
 
-// See MapBasedGlobalLockImpl.h
+// See SimpleLRU.h
 bool SimpleLRU::Delete(const std::string &key) {
     auto it_find = _lru_index.find(key);
     if (it_find == _lru_index.end()) {
@@ -141,7 +196,7 @@ bool SimpleLRU::Delete(const std::string &key) {
     return _erase_from_list(erase_node);
 }
 
-// See MapBasedGlobalLockImpl.h
+// See SimpleLRU.h
 bool SimpleLRU::Get(const std::string &key, std::string &value) {
     auto it_find = _lru_index.find(key);
     if (it_find == _lru_index.end()) {
@@ -154,5 +209,22 @@ bool SimpleLRU::Get(const std::string &key, std::string &value) {
     return _push_node(cur_node);
 }
 
+// See SimpleLRU.h
+bool SimpleLRU::Scan(std::string &cursor, std::size_t batch, const Visitor &visit) {
+    // Cursor is the last visited key, prefixed so that it differs from the initial one even for empty key
+    auto it = _lru_index.begin();
+    if (!cursor.empty()) {
+        std::string last = cursor.substr(1);
+        it = _lru_index.upper_bound(last);
+    }
+
+    for (std::size_t i = 0; i < batch && it != _lru_index.end(); i++, it++) {
+        const lru_node &node = it->second.get();
+        visit(node.key, node.value);
+        cursor = "k" + node.key;
+    }
+    return it != _lru_index.end();
+}
+
 } // namespace Backend
 } // namespace Afina
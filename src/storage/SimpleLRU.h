@@ -1,6 +1,7 @@
 #ifndef AFINA_STORAGE_SIMPLE_LRU_H
 #define AFINA_STORAGE_SIMPLE_LRU_H
 
+#include <atomic>
 #include <exception>
 #include <iostream>
 #include <map>
@@ -16,6 +17,10 @@ namespace Backend {
 
 /**
  * # Map based implementation
+ * max_size limits memory cache really takes: besides keys and values each item costs list node, map
+ * node and heap blocks of strings that don't fit inline, see Footprint. Both that and total size of
+ * keys and values are reported by stats once storage is started.
+ *
  * That is NOT thread safe implementaiton!!
  */
 class SimpleLRU : public Afina::Storage {
@@ -23,6 +28,7 @@ public:
     // 1024
     explicit SimpleLRU(size_t max_size = 1024) : _max_size(max_size),
         _cur_size(0),
+        _logical_size(0),
         _lru_head(nullptr),
         _lru_tail(nullptr) {}
 
@@ -36,6 +42,12 @@ public:
         _lru_head.reset();
     }
 
+    // Implements Afina::Storage interface, registers memory gauges
+    void Start() override;
+
+    // Implements Afina::Storage interface
+    void Stop() override;
+
     // Implements Afina::Storage interface
     bool Put(const std::string &key, const std::string &value) override;
 
@@ -51,6 +63,24 @@ public:
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override;
 
+    // Implements Afina::Storage interface, items are visited in key order
+    bool Scan(std::string &cursor, std::size_t batch, const Visitor &visit) override;
+
+    /**
+     * Bytes item with given key and value takes in cache: list node, map node and heap blocks of
+     * strings, all including malloc overhead
+     */
+    static std::size_t Footprint(const std::string &key, const std::string &value);
+
+    /**
+     * Bytes cache takes, the figure limited by max_size
+     */
+    std::size_t physical_size() const { return _cur_size.load(std::memory_order_relaxed); }
+
+    /**
+     * Total size of keys and values stored
+     */
+    std::size_t logical_size() const { return _logical_size.load(std::memory_order_relaxed); }
 
 private:
     struct cmp_for_wraper {
@@ -73,9 +103,13 @@ private:
 
 
     // Maximum number of bytes could be stored in this cache.
-    // i.e all (keys+values) must be less the _max_size
+    // i.e footprints of all items must be less the _max_size
     std::size_t _max_size;
-    std::size_t _cur_size;
+
+    // Sum of footprints and sum of key and value sizes. Atomic, so that stats could read them while
+    // other thread changes cache
+    std::atomic<std::size_t> _cur_size;
+    std::atomic<std::size_t> _logical_size;
     // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
     // element that wasn't used for longest time.
     //
@@ -103,7 +137,13 @@ private:
 
     bool _push_node(lru_node* push_node);
 
-    bool _free_space_for_node(const std::string &key, const std::string &value);
+    bool _free_space_for_node(std::size_t size_of_node);
+
+    // Footprint of the node with strings of given capacities. Strings of existing node might have
+    // grown beyond their sizes
+    static std::size_t _footprint(std::size_t key_capacity, std::size_t value_capacity);
+
+    void _account(const lru_node *node, bool add);
 
 
 
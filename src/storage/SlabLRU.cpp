@@ -0,0 +1,366 @@
+#include "SlabLRU.h"
+
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include <afina/Metrics.h>
+
+namespace Afina {
+namespace Backend {
+
+// Small caches still get a few pages, so that classes could share memory
+static constexpr std::size_t kMinPageSize = 4096;
+static constexpr std::size_t kMinPages = 16;
+
+// Expected size of a chunk, defines initial number of index buckets
+static constexpr std::size_t kAverageItem = 256;
+
+// The smallest average chunk index is grown for, caches of smaller items get longer chains
+static constexpr std::size_t kMinAverageItem = 128;
+
+// Area layout version, must change with State, Item or Slab state layout
+static constexpr uint64_t kLayout = 0x31303055524C5341ULL;
+
+static std::size_t page_size(std::size_t max_size) {
+    std::size_t page = Afina::Allocator::Slab::kDefaultPageSize;
+    while (page > kMinPageSize && max_size / page < kMinPages) {
+        page /= 2;
+    }
+    return page;
+}
+
+static std::size_t round_to_power(std::size_t n) {
+    std::size_t result = 16;
+    while (result < n) {
+        result *= 2;
+    }
+    return result;
+}
+
+// See SlabLRU.h
+std::size_t SlabLRU::MaxBuckets(std::size_t max_size) { return round_to_power(max_size / kMinAverageItem); }
+
+// See SlabLRU.h
+std::size_t SlabLRU::SlabOffset(std::size_t max_size) {
+    std::size_t offset = sizeof(State) + MaxBuckets(max_size) * sizeof(Item *);
+    return (offset + kMinPageSize - 1) / kMinPageSize * kMinPageSize;
+}
+
+// See SlabLRU.h
+void *SlabLRU::SharedBase(int memory_fd) {
+    uint64_t header[2];
+    if (pread(memory_fd, header, sizeof(header), 0) != sizeof(header) || header[0] != kLayout) {
+        close(memory_fd);
+        throw std::runtime_error("Memory file isn't a cache area");
+    }
+    return reinterpret_cast<void *>(header[1]);
+}
+
+// See SlabLRU.h
+SlabLRU::SlabLRU(std::size_t max_size, unsigned map_flags, int numa_node)
+    : _memory(SlabOffset(max_size) + max_size, map_flags, numa_node), _state(static_cast<State *>(_memory.data())),
+      _buckets(reinterpret_cast<Item **>(_state + 1)), _max_size(max_size),
+      _slab(Afina::Allocator::Slab::Embedded(static_cast<char *>(_memory.data()) + SlabOffset(max_size), max_size,
+                                             page_size(max_size))) {
+    if (_slab.classes() > kMaxClasses) {
+        throw std::runtime_error("Too many size classes");
+    }
+
+    // Fresh area is zeroed, so buckets and LRU lists are empty
+    _state->base = _memory.data();
+    _state->max_size = max_size;
+    _state->buckets.store(round_to_power(max_size / kAverageItem), std::memory_order_relaxed);
+    _state->max_buckets = MaxBuckets(max_size);
+    _state->layout = kLayout;
+}
+
+// See SlabLRU.h
+SlabLRU::SlabLRU(MemoryFile file)
+    : _memory(file.fd, SharedBase(file.fd)), _state(static_cast<State *>(_memory.data())),
+      _buckets(reinterpret_cast<Item **>(_state + 1)), _max_size(_state->max_size),
+      _slab(Afina::Allocator::Slab::Attach(static_cast<char *>(_memory.data()) + SlabOffset(_max_size), _max_size)) {
+    if (_memory.size() < SlabOffset(_max_size) + _max_size) {
+        throw std::runtime_error("Memory file is smaller than cache area");
+    }
+}
+
+// See SlabLRU.h
+void SlabLRU::Start() {
+    Metrics &metrics = Metrics::Instance();
+    metrics.Register("storage_physical_bytes", [this] { return physical_size(); });
+    metrics.Register("storage_logical_bytes", [this] { return logical_size(); });
+    metrics.Register("limit_maxbytes", [this] { return _max_size; });
+}
+
+// See SlabLRU.h
+void SlabLRU::Stop() {
+    Metrics &metrics = Metrics::Instance();
+    metrics.Unregister("storage_physical_bytes");
+    metrics.Unregister("storage_logical_bytes");
+    metrics.Unregister("limit_maxbytes");
+}
+
+// See SlabLRU.h
+bool SlabLRU::Put(const std::string &key, const std::string &value) {
+    uint32_t hash = Hash(key);
+    Item *item = Find(key, hash);
+    if (item != nullptr) {
+        return Update(item, key, value);
+    }
+    return Insert(key, hash, value);
+}
+
+// See SlabLRU.h
+bool SlabLRU::PutIfAbsent(const std::string &key, const std::string &value) {
+    uint32_t hash = Hash(key);
+    if (Find(key, hash) != nullptr) {
+        return false;
+    }
+    return Insert(key, hash, value);
+}
+
+// See SlabLRU.h
+bool SlabLRU::Set(const std::string &key, const std::string &value) {
+    Item *item = Find(key, Hash(key));
+    if (item == nullptr) {
+        return false;
+    }
+    return Update(item, key, value);
+}
+
+// See SlabLRU.h
+bool SlabLRU::Delete(const std::string &key) {
+    Item *item = Find(key, Hash(key));
+    if (item == nullptr) {
+        return false;
+    }
+    Erase(item);
+    return true;
+}
+
+// See SlabLRU.h
+bool SlabLRU::Get(const std::string &key, std::string &value) {
+    Item *item = Find(key, Hash(key));
+    if (item == nullptr) {
+        return false;
+    }
+    value.assign(item->value(), item->value_size);
+    Touch(item);
+    return true;
+}
+
+// See SlabLRU.h
+bool SlabLRU::Scan(std::string &cursor, std::size_t batch, const Visitor &visit) {
+    // Cursor is the next bucket to visit, whole bucket is visited at once
+    std::size_t bucket = cursor.empty() ? 0 : std::stoull(cursor);
+    std::size_t buckets = _state->buckets.load(std::memory_order_relaxed);
+    std::size_t visited = 0;
+    std::string key, value;
+    for (; bucket < buckets && visited < batch; bucket++) {
+        for (Item *item = _buckets[bucket]; item != nullptr; item = item->hnext) {
+            key.assign(item->key(), item->key_size);
+            value.assign(item->value(), item->value_size);
+            visit(key, value);
+            visited++;
+        }
+    }
+
+    cursor = std::to_string(bucket);
+    return bucket < buckets;
+}
+
+// See SlabLRU.h
+uint32_t SlabLRU::Hash(const std::string &key) {
+    std::size_t hash = std::hash<std::string>()(key);
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+// See SlabLRU.h
+SlabLRU::Item *SlabLRU::Find(const std::string &key, uint32_t hash) {
+    std::size_t bucket = hash & (_state->buckets.load(std::memory_order_relaxed) - 1);
+    for (Item *item = _buckets[bucket]; item != nullptr; item = item->hnext) {
+        if (item->hash == hash && item->key_size == key.size() && memcmp(item->key(), key.data(), key.size()) == 0) {
+            return item;
+        }
+    }
+    return nullptr;
+}
+
+// See SlabLRU.h
+bool SlabLRU::Insert(const std::string &key, uint32_t hash, const std::string &value) {
+    std::size_t size = sizeof(Item) + key.size() + value.size();
+    if (size > _slab.chunk_size(_slab.classes() - 1)) {
+        return false;
+    }
+
+    unsigned cls = _slab.class_of(size);
+    Item *item = Allocate(cls);
+    if (item == nullptr) {
+        return false;
+    }
+    Store(item, cls, key, hash, value);
+    return true;
+}
+
+// See SlabLRU.h
+void SlabLRU::Store(Item *item, unsigned cls, const std::string &key, uint32_t hash, const std::string &value) {
+    item->hash = hash;
+    item->key_size = key.size();
+    item->value_size = value.size();
+    item->cls = cls;
+    memcpy(item->key(), key.data(), key.size());
+    memcpy(item->value(), value.data(), value.size());
+
+    if (_state->size.load(std::memory_order_relaxed) >= _state->buckets.load(std::memory_order_relaxed)) {
+        Grow();
+    }
+    Item *&bucket = _buckets[hash & (_state->buckets.load(std::memory_order_relaxed) - 1)];
+    item->hnext = bucket;
+    bucket = item;
+    _state->size.fetch_add(1, std::memory_order_relaxed);
+    _state->chunk_bytes.fetch_add(_slab.chunk_size(cls), std::memory_order_relaxed);
+    _state->logical_size.fetch_add(key.size() + value.size(), std::memory_order_relaxed);
+
+    Link(item);
+}
+
+// See SlabLRU.h
+bool SlabLRU::Update(Item *item, const std::string &key, const std::string &value) {
+    std::size_t size = sizeof(Item) + key.size() + value.size();
+    if (size <= _slab.chunk_size(item->cls) && (item->cls == 0 || size > _slab.chunk_size(item->cls - 1))) {
+        _state->logical_size.fetch_add(value.size() - item->value_size, std::memory_order_relaxed);
+        item->value_size = value.size();
+        memcpy(item->value(), value.data(), value.size());
+        Touch(item);
+        return true;
+    }
+
+    // Item moves to another class. Old one is dropped only once the new chunk is there, so failed update
+    // leaves the key as it was. Allocation could evict the old item itself as the least recently used one
+    if (size > _slab.chunk_size(_slab.classes() - 1)) {
+        return false;
+    }
+    uint32_t hash = item->hash;
+    unsigned cls = _slab.class_of(size);
+    Item *moved = Allocate(cls);
+    if (moved == nullptr) {
+        return false;
+    }
+    item = Find(key, hash);
+    if (item != nullptr) {
+        Erase(item);
+    }
+    Store(moved, cls, key, hash, value);
+    return true;
+}
+
+// See SlabLRU.h
+SlabLRU::Item *SlabLRU::Allocate(unsigned cls) {
+    while (true) {
+        void *chunk = _slab.alloc(cls);
+        if (chunk != nullptr) {
+            return static_cast<Item *>(chunk);
+        }
+
+        // Page of other class is taken if that class has older items, so that memory follows the load
+        Item *victim = _state->lru[cls].tail;
+        for (unsigned i = 0; i < _slab.classes(); i++) {
+            const Lru &lru = _state->lru[i];
+            if (lru.tail != nullptr && (victim == nullptr || lru.tail->stamp < victim->stamp)) {
+                victim = lru.tail;
+            }
+        }
+        if (victim == nullptr) {
+            return nullptr;
+        }
+
+        if (victim->cls == cls) {
+            Erase(victim);
+            continue;
+        }
+        _slab.reassign(victim, cls, [this](void *chunk) { Forget(static_cast<Item *>(chunk)); });
+    }
+}
+
+// See SlabLRU.h
+void SlabLRU::Forget(Item *item) {
+    Item **link = &_buckets[item->hash & (_state->buckets.load(std::memory_order_relaxed) - 1)];
+    while (*link != item) {
+        link = &(*link)->hnext;
+    }
+    *link = item->hnext;
+    _state->size.fetch_sub(1, std::memory_order_relaxed);
+    _state->chunk_bytes.fetch_sub(_slab.chunk_size(item->cls), std::memory_order_relaxed);
+    _state->logical_size.fetch_sub(item->key_size + item->value_size, std::memory_order_relaxed);
+    Unlink(item);
+}
+
+// See SlabLRU.h
+void SlabLRU::Erase(Item *item) {
+    Forget(item);
+    _slab.free(item);
+}
+
+// See SlabLRU.h
+void SlabLRU::Touch(Item *item) {
+    Unlink(item);
+    Link(item);
+}
+
+// See SlabLRU.h
+void SlabLRU::Link(Item *item) {
+    Lru &lru = _state->lru[item->cls];
+    item->stamp = _state->clock++;
+    item->prev = nullptr;
+    item->next = lru.head;
+    if (lru.head != nullptr) {
+        lru.head->prev = item;
+    } else {
+        lru.tail = item;
+    }
+    lru.head = item;
+}
+
+// See SlabLRU.h
+void SlabLRU::Unlink(Item *item) {
+    Lru &lru = _state->lru[item->cls];
+    if (item->prev != nullptr) {
+        item->prev->next = item->next;
+    } else {
+        lru.head = item->next;
+    }
+    if (item->next != nullptr) {
+        item->next->prev = item->prev;
+    } else {
+        lru.tail = item->prev;
+    }
+}
+
+// See SlabLRU.h
+void SlabLRU::Grow() {
+    // Index grows in place: each bucket splits into itself and the one of the new half
+    std::size_t buckets = _state->buckets.load(std::memory_order_relaxed);
+    if (buckets >= _state->max_buckets) {
+        return;
+    }
+    for (std::size_t i = 0; i < buckets; i++) {
+        Item **link = &_buckets[i];
+        while (*link != nullptr) {
+            Item *item = *link;
+            if ((item->hash & (2 * buckets - 1)) == i) {
+                link = &item->hnext;
+                continue;
+            }
+            *link = item->hnext;
+            item->hnext = _buckets[i + buckets];
+            _buckets[i + buckets] = item;
+        }
+    }
+    _state->buckets.store(2 * buckets, std::memory_order_relaxed);
+}
+
+} // namespace Backend
+} // namespace Afina
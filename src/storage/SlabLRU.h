@@ -0,0 +1,255 @@
+#ifndef AFINA_STORAGE_SLAB_LRU_H
+#define AFINA_STORAGE_SLAB_LRU_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <afina/Storage.h>
+#include <afina/allocator/Mapping.h>
+#include <afina/allocator/Slab.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # LRU cache on top of slab allocator
+ * Memory of the whole cache is mapped once on construction and given to Allocator::Slab, each item
+ * (key, value and links) lives in a single chunk of the size class that fits it. Everything else,
+ * allocator state, LRU lists and the index, is kept in the same area, there are no other allocations.
+ * Index space is reserved for the largest number of items area could have and committed as index
+ * grows.
+ *
+ * Area mapped with Mapping::kShared is a memory file, which holds the complete cache. Another process
+ * that gets its descriptor continues with the same items right away, see SlabLRU(MemoryFile). Items link to
+ * each other by pointers, so the area is mapped at the same address there, and both processes must
+ * be built with the same layout of the area, which kLayout marks.
+ *
+ * Each size class has its own LRU list, once class runs out of chunks the least recently used items
+ * of that class are evicted, so that eviction frees exactly the memory that is needed. Unless some
+ * other class has older items: then the class takes the page of the oldest one, evicting everything
+ * on that page.
+ *
+ * max_size is the size of the area, so it limits everything cache takes except for the index. Stats
+ * report chunks taken by items along with the index as physical size, and total size of keys and
+ * values as logical one.
+ *
+ * That is NOT thread safe implementaiton!!
+ */
+class SlabLRU : public Afina::Storage {
+public:
+    static constexpr std::size_t kDefaultSize = 64 * 1024 * 1024;
+
+    /**
+     * @param map_flags how to map the area, see Allocator::Mapping. Area is committed lazily by default,
+     * so cache takes memory as it fills
+     * @param numa_node node the area should be placed on, -1 to leave it to the kernel
+     */
+    explicit SlabLRU(std::size_t max_size = kDefaultSize, unsigned map_flags = 0, int numa_node = -1);
+
+    /**
+     * Descriptor of the memory file of a shared area
+     */
+    struct MemoryFile {
+        int fd;
+    };
+
+    /**
+     * Cache in the shared area of other instance, possibly of other process, takes ownership of the
+     * memory file. Instance the area came from must not be used anymore. Throws std::runtime_error if
+     * file isn't a cache area of this layout or its address is taken in this process
+     */
+    explicit SlabLRU(MemoryFile file);
+
+    // Implements Afina::Storage interface, registers memory gauges
+    void Start() override;
+
+    // Implements Afina::Storage interface
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override;
+
+    // Implements Afina::Storage interface, goes over index buckets. Buckets are only added, item of
+    // a visited bucket could move to one that is ahead of the cursor, but never the other way round
+    bool Scan(std::string &cursor, std::size_t batch, const Visitor &visit) override;
+
+    /**
+     * Number of items stored
+     */
+    std::size_t size() const { return _state->size.load(std::memory_order_relaxed); }
+
+    /**
+     * Bytes of chunks items take along with the index
+     */
+    std::size_t physical_size() const {
+        return _state->chunk_bytes.load(std::memory_order_relaxed) +
+               _state->buckets.load(std::memory_order_relaxed) * sizeof(Item *);
+    }
+
+    /**
+     * Total size of keys and values stored
+     */
+    std::size_t logical_size() const { return _state->logical_size.load(std::memory_order_relaxed); }
+
+    const Afina::Allocator::Slab &allocator() const { return _slab; }
+
+    /**
+     * Memory file of the shared area, -1 if area isn't shared
+     */
+    int memory_fd() const { return _memory.fd(); }
+
+private:
+    SlabLRU(const SlabLRU &) = delete;
+    SlabLRU &operator=(const SlabLRU &) = delete;
+
+    /**
+     * Header of the chunk, key and value follow it
+     */
+    struct Item {
+        // LRU list of the class, prev is more recently used
+        Item *prev;
+        Item *next;
+
+        // Next item in the same index bucket
+        Item *hnext;
+
+        // Last access, items of different classes are compared by that
+        uint64_t stamp;
+
+        uint32_t hash;
+        uint32_t key_size;
+        uint32_t value_size;
+        uint32_t cls;
+
+        char *key() { return reinterpret_cast<char *>(this + 1); }
+        char *value() { return key() + key_size; }
+    };
+
+    struct Lru {
+        Item *head;
+        Item *tail;
+    };
+
+    static constexpr unsigned kMaxClasses = 64;
+
+    /**
+     * Cache state at the beginning of the area, index follows it
+     */
+    struct State {
+        uint64_t layout;
+
+        // Area address, the same in every process using it
+        void *base;
+        std::size_t max_size;
+
+        // Number of items. Fields stats read are atomic, so that they could be read while other thread
+        // changes cache, the one that changes them holds the storage lock
+        std::atomic<std::size_t> size;
+
+        // Source of access stamps
+        uint64_t clock;
+
+        // Sizes of chunks of items and total size of keys and values
+        std::atomic<std::size_t> chunk_bytes;
+        std::atomic<std::size_t> logical_size;
+
+        // Index buckets in use and reserved, both are powers of two
+        std::atomic<std::size_t> buckets;
+        std::size_t max_buckets;
+
+        // LRU list per size class
+        Lru lru[kMaxClasses];
+    };
+
+    /**
+     * Index buckets reserved for the cache of given size
+     */
+    static std::size_t MaxBuckets(std::size_t max_size);
+
+    /**
+     * Offset of the slab from the area beginning, state and index go before it
+     */
+    static std::size_t SlabOffset(std::size_t max_size);
+
+    /**
+     * Address shared area must be mapped at, closes the file if it isn't a cache area
+     */
+    static void *SharedBase(int memory_fd);
+
+    static uint32_t Hash(const std::string &key);
+
+    /**
+     * Item with the given key, nullptr if there is none
+     */
+    Item *Find(const std::string &key, uint32_t hash);
+
+    /**
+     * Allocates and stores new item, evicting others if needed. Returns false if item doesn't fit
+     */
+    bool Insert(const std::string &key, uint32_t hash, const std::string &value);
+
+    /**
+     * Fills allocated chunk and links it into the index and LRU
+     */
+    void Store(Item *item, unsigned cls, const std::string &key, uint32_t hash, const std::string &value);
+
+    /**
+     * Replaces value of the item, in place if it fits the same class. Item is kept if value doesn't fit
+     */
+    bool Update(Item *item, const std::string &key, const std::string &value);
+
+    /**
+     * Chunk for a new item of the class, nullptr if there is no way to get it
+     */
+    Item *Allocate(unsigned cls);
+
+    /**
+     * Removes item from the index and LRU, doesn't release its memory
+     */
+    void Forget(Item *item);
+
+    /**
+     * Removes item and releases its memory
+     */
+    void Erase(Item *item);
+
+    /**
+     * Makes item the most recently used one of its class
+     */
+    void Touch(Item *item);
+
+    void Link(Item *item);
+    void Unlink(Item *item);
+
+    /**
+     * Doubles number of index buckets
+     */
+    void Grow();
+
+    // Area of the whole cache
+    Afina::Allocator::Mapping _memory;
+    State *_state;
+    Item **_buckets;
+    const std::size_t _max_size;
+
+    Afina::Allocator::Slab _slab;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SLAB_LRU_H
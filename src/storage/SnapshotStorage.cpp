@@ -0,0 +1,297 @@
+#include "SnapshotStorage.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <afina/Metrics.h>
+
+#include "Checksum.h"
+#include "File.h"
+#include "Varint.h"
+
+namespace Afina {
+namespace Backend {
+
+static constexpr char kMagic[8] = {'A', 'F', 'S', 'N', 'A', 'P', '0', '1'};
+
+// Items copied from the storage under its lock at once
+static constexpr std::size_t kScanBatch = 256;
+
+// See SnapshotStorage.h
+SnapshotStorage::SnapshotStorage(std::shared_ptr<Afina::Storage> storage, const std::string &path,
+                                 std::chrono::milliseconds interval, bool load, unsigned load_threads)
+    : _storage(std::move(storage)), _path(path), _interval(interval), _load(load),
+      _load_threads(std::max(load_threads, 1u)), _stopping(false), _dumps(0), _errors(0), _last_items(0),
+      _last_duration(0), _loaded_items(0) {}
+
+// See SnapshotStorage.h
+SnapshotStorage::~SnapshotStorage() {
+    if (_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _stop_cv.notify_all();
+        _thread.join();
+    }
+}
+
+// See SnapshotStorage.h
+void SnapshotStorage::Start() {
+    _storage->Start();
+
+    // Damaged snapshot shouldn't prevent server from starting, cache just stays cold
+    if (_load) {
+        try {
+            LoadStats stats = Load(_path, *_storage, _load_threads);
+            _loaded_items = stats.items;
+            if (stats.bad_blocks > 0 || (stats.blocks > 0 && !stats.complete)) {
+                _errors++;
+            }
+        } catch (std::exception &) {
+            _errors++;
+        }
+    }
+
+    Metrics &metrics = Metrics::Instance();
+    metrics.Register("snapshot_dumps", [this] { return _dumps.load(); });
+    metrics.Register("snapshot_errors", [this] { return _errors.load(); });
+    metrics.Register("snapshot_last_items", [this] { return _last_items.load(); });
+    metrics.Register("snapshot_last_duration_ms", [this] { return _last_duration.load(); });
+    metrics.Register("snapshot_loaded_items", [this] { return _loaded_items.load(); });
+
+    if (_interval.count() > 0) {
+        _stopping = false;
+        _thread = std::thread(&SnapshotStorage::OnRun, this);
+    }
+}
+
+// See SnapshotStorage.h
+void SnapshotStorage::Stop() {
+    if (_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _stop_cv.notify_all();
+        _thread.join();
+    }
+
+    Save();
+
+    Metrics &metrics = Metrics::Instance();
+    metrics.Unregister("snapshot_dumps");
+    metrics.Unregister("snapshot_errors");
+    metrics.Unregister("snapshot_last_items");
+    metrics.Unregister("snapshot_last_duration_ms");
+    metrics.Unregister("snapshot_loaded_items");
+
+    _storage->Stop();
+}
+
+// See SnapshotStorage.h
+void SnapshotStorage::OnRun() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stop_cv.wait_for(lock, _interval, [this] { return _stopping; })) {
+        lock.unlock();
+        Save();
+        lock.lock();
+    }
+}
+
+// See SnapshotStorage.h
+void SnapshotStorage::Save() {
+    std::lock_guard<std::mutex> lock(_dump_mutex);
+    auto start = std::chrono::steady_clock::now();
+    try {
+        _last_items = Dump(*_storage, _path);
+        _dumps++;
+    } catch (std::exception &) {
+        _errors++;
+    }
+    auto duration = std::chrono::steady_clock::now() - start;
+    _last_duration = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
+
+// See SnapshotStorage.h
+std::size_t SnapshotStorage::Dump(Afina::Storage &storage, const std::string &path) {
+    std::string tmp = path + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create " + tmp + ": " + strerror(errno));
+    }
+
+    std::size_t total = 0;
+    try {
+        write_all(fd, kMagic, sizeof(kMagic), tmp);
+
+        // Items are copied into block under storage lock, block is written once lock is released
+        std::string payload;
+        payload.reserve(kBlockSize + kBlockSize / 4);
+        uint32_t items = 0, blocks = 0;
+        auto flush = [&] {
+            Block block{static_cast<uint32_t>(payload.size()), items, Crc32c(payload.data(), payload.size()), 0};
+            write_all(fd, &block, sizeof(block), tmp);
+            write_all(fd, payload.data(), payload.size(), tmp);
+            payload.clear();
+            items = 0;
+            blocks++;
+        };
+
+        std::string cursor;
+        bool more = true;
+        while (more) {
+            more = storage.Scan(cursor, kScanBatch, [&](const std::string &key, const std::string &value) {
+                put_varint(payload, key.size());
+                put_varint(payload, value.size());
+                payload.append(key);
+                payload.append(value);
+                items++;
+                total++;
+            });
+            if (payload.size() >= kBlockSize) {
+                flush();
+            }
+        }
+        if (items > 0) {
+            flush();
+        }
+
+        Block end{0, blocks, 0, 0};
+        write_all(fd, &end, sizeof(end), tmp);
+        if (fdatasync(fd) != 0) {
+            throw std::runtime_error("Failed to sync " + tmp + ": " + strerror(errno));
+        }
+    } catch (...) {
+        close(fd);
+        unlink(tmp.c_str());
+        throw;
+    }
+
+    close(fd);
+    if (rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        throw std::runtime_error("Failed to replace " + path + ": " + strerror(errno));
+    }
+    sync_directory(path);
+    return total;
+}
+
+// See SnapshotStorage.h
+SnapshotStorage::LoadStats SnapshotStorage::Load(const std::string &path, Afina::Storage &storage,
+                                                 unsigned threads) {
+    LoadStats stats;
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return stats;
+        }
+        throw std::runtime_error("Failed to open " + path + ": " + strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(kMagic))) {
+        close(fd);
+        throw std::runtime_error(path + " isn't a snapshot");
+    }
+
+    std::size_t size = st.st_size;
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Failed to map " + path + ": " + strerror(errno));
+    }
+    madvise(mapping, size, MADV_WILLNEED);
+
+    const char *begin = static_cast<const char *>(mapping);
+    const char *end = begin + size;
+    if (memcmp(begin, kMagic, sizeof(kMagic)) != 0) {
+        munmap(mapping, size);
+        throw std::runtime_error(path + " isn't a snapshot");
+    }
+
+    // Headers are walked sequentially, that is cheap. Truncated tail is dropped
+    std::vector<const char *> blocks;
+    for (const char *p = begin + sizeof(kMagic); end - p >= static_cast<ptrdiff_t>(sizeof(Block));) {
+        Block block;
+        memcpy(&block, p, sizeof(block));
+        if (block.size == 0) {
+            stats.complete = block.items == blocks.size();
+            break;
+        }
+        if (static_cast<std::size_t>(end - p) - sizeof(Block) < block.size) {
+            break;
+        }
+        blocks.push_back(p);
+        p += sizeof(Block) + block.size;
+    }
+    stats.blocks = blocks.size();
+
+    std::atomic<std::size_t> next(0), items(0), bad(0);
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto decode = [&] {
+        std::string key, value;
+        for (std::size_t i = next++; i < blocks.size(); i = next++) {
+            Block block;
+            memcpy(&block, blocks[i], sizeof(block));
+            const char *p = blocks[i] + sizeof(Block);
+            const char *block_end = p + block.size;
+            if (Crc32c(p, block.size) != block.crc) {
+                bad++;
+                continue;
+            }
+
+            try {
+                for (uint32_t j = 0; j < block.items; j++) {
+                    uint64_t key_size, value_size;
+                    if (!get_varint(p, block_end, key_size) || !get_varint(p, block_end, value_size) ||
+                        static_cast<uint64_t>(block_end - p) < key_size + value_size) {
+                        bad++;
+                        break;
+                    }
+                    key.assign(p, key_size);
+                    value.assign(p + key_size, value_size);
+                    p += key_size + value_size;
+                    storage.Put(key, value);
+                    items++;
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                return;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < std::min<std::size_t>(threads, blocks.size()); i++) {
+        workers.emplace_back(decode);
+    }
+    decode();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    munmap(mapping, size);
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    stats.items = items;
+    stats.bad_blocks = bad;
+    return stats;
+}
+
+} // namespace Backend
+} // namespace Afina
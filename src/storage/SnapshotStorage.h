@@ -0,0 +1,148 @@
+#ifndef AFINA_STORAGE_SNAPSHOT_STORAGE_H
+#define AFINA_STORAGE_SNAPSHOT_STORAGE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Storage that survives restarts
+ * Decorator that dumps items of the wrapped storage to a file once in a while and on stop, and loads
+ * them back on start, so that restarted server doesn't begin with empty cache.
+ *
+ * Dump goes over the storage with Storage::Scan batch by batch, so workers are blocked only while a
+ * batch is copied, no fork and no global pause. Snapshot is fuzzy: items changed during the dump may
+ * appear in it with either value. It is written to a temporary file that replaces the previous
+ * snapshot only once complete.
+ *
+ * File layout, integers are in host byte order:
+ *  - header: magic "AFSNAP01"
+ *  - blocks of about kBlockSize: Block header, then items, each one is varint key size, varint value
+ *    size, key and value
+ *  - end marker: Block header of zero size, items field holds number of blocks
+ *
+ * Each block has its own checksum, so blocks are verified and decoded in parallel on load, and a
+ * damaged block costs its items only.
+ *
+ * Wrapped storage must be thread safe, dump runs on its own thread
+ */
+class SnapshotStorage : public Afina::Storage {
+public:
+    static constexpr std::size_t kBlockSize = 1024 * 1024;
+
+    struct Block {
+        uint32_t size;
+        uint32_t items;
+        uint32_t crc;
+        uint32_t reserved;
+    };
+
+    /**
+     * Result of Load
+     */
+    struct LoadStats {
+        std::size_t items = 0;
+        std::size_t blocks = 0;
+
+        // Blocks dropped because of checksum mismatch
+        std::size_t bad_blocks = 0;
+
+        // File has end marker, i.e it wasn't truncated
+        bool complete = false;
+    };
+
+    /**
+     * @param interval time between dumps, zero to dump on stop only
+     * @param load restore items from the file on start
+     * @param load_threads threads decoding the file
+     */
+    SnapshotStorage(std::shared_ptr<Afina::Storage> storage, const std::string &path,
+                    std::chrono::milliseconds interval, bool load, unsigned load_threads = 4);
+    ~SnapshotStorage();
+
+    // Implements Afina::Storage interface: starts wrapped storage, loads snapshot into it, starts
+    // periodic dumps
+    void Start() override;
+
+    // Implements Afina::Storage interface: stops dumps, writes the final snapshot
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override { return _storage->Put(key, value); }
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        return _storage->PutIfAbsent(key, value);
+    }
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override { return _storage->Set(key, value); }
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override { return _storage->Delete(key); }
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return _storage->Get(key, value); }
+
+    // Implements Afina::Storage interface
+    bool Scan(std::string &cursor, std::size_t batch, const Visitor &visit) override {
+        return _storage->Scan(cursor, batch, visit);
+    }
+
+    /**
+     * Writes snapshot of the storage to path, returns number of items written. Throws
+     * std::runtime_error on I/O errors, previous snapshot is kept then
+     */
+    static std::size_t Dump(Afina::Storage &storage, const std::string &path);
+
+    /**
+     * Puts items from the snapshot into storage using given number of threads. Missing file isn't an
+     * error, damaged blocks are skipped. Throws std::runtime_error if file can't be read or it isn't
+     * a snapshot
+     */
+    static LoadStats Load(const std::string &path, Afina::Storage &storage, unsigned threads);
+
+private:
+    void OnRun();
+
+    /**
+     * Dump that updates stats instead of throwing
+     */
+    void Save();
+
+    std::shared_ptr<Afina::Storage> _storage;
+    const std::string _path;
+    const std::chrono::milliseconds _interval;
+    const bool _load;
+    const unsigned _load_threads;
+
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _stop_cv;
+    bool _stopping;
+
+    // Serializes dumps of the thread and the final one
+    std::mutex _dump_mutex;
+
+    std::atomic<uint64_t> _dumps;
+    std::atomic<uint64_t> _errors;
+    std::atomic<uint64_t> _last_items;
+    std::atomic<uint64_t> _last_duration;
+    std::atomic<uint64_t> _loaded_items;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SNAPSHOT_STORAGE_H
@@ -50,6 +50,12 @@ public:
         return SimpleLRU::Get(key, value);
     }
 
+    // see SimpleLRU.h
+    bool Scan(std::string &cursor, std::size_t batch, const Visitor &visit) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return SimpleLRU::Scan(cursor, batch, visit);
+    }
+
 private:
     mutable std::mutex _mutex;
 };
@@ -0,0 +1,66 @@
+#ifndef AFINA_STORAGE_THREAD_SAFE_SLAB_LRU_H
+#define AFINA_STORAGE_THREAD_SAFE_SLAB_LRU_H
+
+#include <mutex>
+#include <string>
+
+#include "SlabLRU.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # SlabLRU thread safe version
+ * Single lock around the whole cache, just like ThreadSafeSimplLRU
+ */
+class ThreadSafeSlabLRU : public SlabLRU {
+public:
+    explicit ThreadSafeSlabLRU(std::size_t max_size = kDefaultSize, unsigned map_flags = 0, int numa_node = -1)
+        : SlabLRU(max_size, map_flags, numa_node) {}
+
+    explicit ThreadSafeSlabLRU(MemoryFile file) : SlabLRU(file) {}
+
+    // see SlabLRU.h
+    bool Put(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return SlabLRU::Put(key, value);
+    }
+
+    // see SlabLRU.h
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return SlabLRU::PutIfAbsent(key, value);
+    }
+
+    // see SlabLRU.h
+    bool Set(const std::string &key, const std::string &value) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return SlabLRU::Set(key, value);
+    }
+
+    // see SlabLRU.h
+    bool Delete(const std::string &key) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return SlabLRU::Delete(key);
+    }
+
+    // see SlabLRU.h
+    bool Get(const std::string &key, std::string &value) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return SlabLRU::Get(key, value);
+    }
+
+    // see SlabLRU.h
+    bool Scan(std::string &cursor, std::size_t batch, const Visitor &visit) override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return SlabLRU::Scan(cursor, batch, visit);
+    }
+
+private:
+    mutable std::mutex _mutex;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_THREAD_SAFE_SLAB_LRU_H
@@ -0,0 +1,39 @@
+#ifndef AFINA_STORAGE_VARINT_H
+#define AFINA_STORAGE_VARINT_H
+
+#include <cstdint>
+#include <string>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * Appends number in LEB128 encoding: 7 bits per byte, the highest bit tells that more bytes follow
+ */
+inline void put_varint(std::string &out, uint64_t n) {
+    while (n >= 0x80) {
+        out.push_back(static_cast<char>(n | 0x80));
+        n >>= 7;
+    }
+    out.push_back(static_cast<char>(n));
+}
+
+/**
+ * Decodes number written by put_varint and moves p past it, returns false if data ends before it
+ */
+inline bool get_varint(const char *&p, const char *end, uint64_t &n) {
+    n = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*p++);
+        n |= uint64_t(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_VARINT_H
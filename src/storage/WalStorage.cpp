@@ -0,0 +1,369 @@
+#include "WalStorage.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <afina/Metrics.h>
+
+#include "Checksum.h"
+#include "File.h"
+#include "Varint.h"
+
+namespace Afina {
+namespace Backend {
+
+static constexpr char kMagic[8] = {'A', 'F', 'W', 'A', 'L', '0', '0', '1'};
+
+// Items copied from the storage under its lock at once on rewrite
+static constexpr std::size_t kScanBatch = 256;
+
+static void encode(std::string &out, WalStorage::Op op, const std::string &key, const std::string &value) {
+    std::size_t begin = out.size();
+    out.resize(begin + sizeof(WalStorage::Record));
+    out.push_back(static_cast<char>(op));
+    put_varint(out, key.size());
+    out.append(key);
+    if (op == WalStorage::Op::Put) {
+        out.append(value);
+    }
+
+    std::size_t size = out.size() - begin - sizeof(WalStorage::Record);
+    WalStorage::Record record{static_cast<uint32_t>(size), Crc32c(&out[begin + sizeof(record)], size)};
+    memcpy(&out[begin], &record, sizeof(record));
+}
+
+// See WalStorage.h
+WalStorage::WalStorage(std::shared_ptr<Afina::Storage> storage, const std::string &path,
+                       std::chrono::microseconds interval, std::size_t batch)
+    : _storage(std::move(storage)), _path(path), _interval(interval), _batch(batch), _fd(-1), _next_lsn(1),
+      _stopping(false), _failed(false), _durable_lsn(0), _records(0), _bytes(0), _syncs(0), _errors(0),
+      _replayed(0) {}
+
+// See WalStorage.h
+WalStorage::~WalStorage() {
+    if (_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _flush_cv.notify_all();
+        _thread.join();
+    }
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+// See WalStorage.h
+void WalStorage::Start() {
+    _storage->Start();
+
+    // Storage that keeps data on disk by itself has replayed changes durable after checkpoint, log
+    // starts empty then rather than copies the whole dataset
+    _replayed = Replay(_path, *_storage).records;
+    Rewrite(!_storage->Checkpoint());
+    _fd = open(_path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (_fd < 0) {
+        throw std::runtime_error("Failed to open " + _path + ": " + strerror(errno));
+    }
+
+    Metrics &metrics = Metrics::Instance();
+    metrics.Register("wal_records", [this] { return _records.load(); });
+    metrics.Register("wal_bytes", [this] { return _bytes.load(); });
+    metrics.Register("wal_syncs", [this] { return _syncs.load(); });
+    metrics.Register("wal_errors", [this] { return _errors.load(); });
+    metrics.Register("wal_durable_lsn", [this] { return _durable_lsn.load(); });
+    metrics.Register("wal_replayed_records", [this] { return _replayed.load(); });
+
+    _stopping = false;
+    _failed = false;
+    _thread = std::thread(&WalStorage::OnRun, this);
+}
+
+// See WalStorage.h
+void WalStorage::Stop() {
+    // Flusher syncs whatever is buffered before it exits
+    if (_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _flush_cv.notify_all();
+        _thread.join();
+    }
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+
+    Metrics &metrics = Metrics::Instance();
+    metrics.Unregister("wal_records");
+    metrics.Unregister("wal_bytes");
+    metrics.Unregister("wal_syncs");
+    metrics.Unregister("wal_errors");
+    metrics.Unregister("wal_durable_lsn");
+    metrics.Unregister("wal_replayed_records");
+
+    _storage->Stop();
+}
+
+// See WalStorage.h
+bool WalStorage::Put(const std::string &key, const std::string &value) {
+    uint64_t lsn;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        CheckWritable();
+        if (!_storage->Put(key, value)) {
+            return false;
+        }
+        lsn = Append(Op::Put, key, value);
+    }
+    WaitDurable(lsn);
+    return true;
+}
+
+// See WalStorage.h
+bool WalStorage::PutIfAbsent(const std::string &key, const std::string &value) {
+    uint64_t lsn;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        CheckWritable();
+        if (!_storage->PutIfAbsent(key, value)) {
+            return false;
+        }
+        lsn = Append(Op::Put, key, value);
+    }
+    WaitDurable(lsn);
+    return true;
+}
+
+// See WalStorage.h
+bool WalStorage::Set(const std::string &key, const std::string &value) {
+    uint64_t lsn;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        CheckWritable();
+        if (!_storage->Set(key, value)) {
+            return false;
+        }
+        lsn = Append(Op::Put, key, value);
+    }
+    WaitDurable(lsn);
+    return true;
+}
+
+// See WalStorage.h
+bool WalStorage::Delete(const std::string &key) {
+    uint64_t lsn;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        CheckWritable();
+        if (!_storage->Delete(key)) {
+            return false;
+        }
+        lsn = Append(Op::Delete, key, std::string());
+    }
+    WaitDurable(lsn);
+    return true;
+}
+
+// See WalStorage.h
+uint64_t WalStorage::Append(Op op, const std::string &key, const std::string &value) {
+    bool was_empty = _buffer.empty();
+    encode(_buffer, op, key, value);
+    _records++;
+
+    // Flusher sleeps on empty buffer or waits for the batch to fill up
+    if (was_empty || _buffer.size() >= _batch) {
+        _flush_cv.notify_one();
+    }
+    return _next_lsn++;
+}
+
+// See WalStorage.h
+void WalStorage::WaitDurable(uint64_t lsn) {
+    if (!_failed.load() && _durable_lsn.load() >= lsn) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    _durable_cv.wait(lock, [this, lsn] { return _failed.load() || _durable_lsn.load() >= lsn; });
+    if (_failed.load()) {
+        throw std::runtime_error("Failed to write log");
+    }
+}
+
+// See WalStorage.h
+void WalStorage::CheckWritable() const {
+    if (_failed) {
+        throw std::runtime_error("Log is broken, changes are refused");
+    }
+    if (_fd < 0) {
+        throw std::runtime_error("Log isn't open");
+    }
+}
+
+// See WalStorage.h
+void WalStorage::OnRun() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _flush_cv.wait(lock, [this] { return !_buffer.empty() || _stopping; });
+        if (_buffer.empty()) {
+            break;
+        }
+        if (_interval.count() > 0 && !_stopping) {
+            _flush_cv.wait_for(lock, _interval, [this] { return _buffer.size() >= _batch || _stopping; });
+        }
+
+        // Records keep coming into the other buffer while these are written
+        _writing.swap(_buffer);
+        uint64_t lsn = _next_lsn - 1;
+        lock.unlock();
+
+        bool written = true;
+        try {
+            write_all(_fd, _writing.data(), _writing.size(), _path);
+            if (fdatasync(_fd) != 0) {
+                throw std::runtime_error("Failed to sync " + _path + ": " + strerror(errno));
+            }
+            _bytes += _writing.size();
+            _syncs++;
+        } catch (std::exception &) {
+            written = false;
+            _errors++;
+        }
+        _writing.clear();
+
+        lock.lock();
+        if (!written) {
+            // Records after the failed ones would be lost on replay anyway, so nothing is written
+            // and acknowledged anymore, waiters of what is buffered get the error
+            _failed = true;
+            _buffer.clear();
+            _durable_cv.notify_all();
+            break;
+        }
+        _durable_lsn = lsn;
+        _durable_cv.notify_all();
+    }
+}
+
+// See WalStorage.h
+void WalStorage::Rewrite(bool items) {
+    std::string tmp = _path + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create " + tmp + ": " + strerror(errno));
+    }
+
+    try {
+        std::string out(kMagic, sizeof(kMagic));
+        std::string cursor;
+        bool more = items;
+        while (more) {
+            more = _storage->Scan(cursor, kScanBatch, [&out](const std::string &key, const std::string &value) {
+                encode(out, Op::Put, key, value);
+            });
+            if (out.size() >= 1024 * 1024) {
+                write_all(fd, out.data(), out.size(), tmp);
+                out.clear();
+            }
+        }
+        write_all(fd, out.data(), out.size(), tmp);
+        if (fdatasync(fd) != 0) {
+            throw std::runtime_error("Failed to sync " + tmp + ": " + strerror(errno));
+        }
+    } catch (...) {
+        close(fd);
+        unlink(tmp.c_str());
+        throw;
+    }
+
+    close(fd);
+    if (rename(tmp.c_str(), _path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        throw std::runtime_error("Failed to replace " + _path + ": " + strerror(errno));
+    }
+    sync_directory(_path);
+}
+
+// See WalStorage.h
+WalStorage::ReplayStats WalStorage::Replay(const std::string &path, Afina::Storage &storage) {
+    ReplayStats stats;
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return stats;
+        }
+        throw std::runtime_error("Failed to open " + path + ": " + strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(kMagic))) {
+        close(fd);
+        throw std::runtime_error(path + " isn't a log");
+    }
+
+    std::size_t size = st.st_size;
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Failed to map " + path + ": " + strerror(errno));
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    const char *begin = static_cast<const char *>(mapping);
+    const char *end = begin + size;
+    if (memcmp(begin, kMagic, sizeof(kMagic)) != 0) {
+        munmap(mapping, size);
+        throw std::runtime_error(path + " isn't a log");
+    }
+
+    const char *p = begin + sizeof(kMagic);
+    try {
+        std::string key, value;
+        while (end - p >= static_cast<ptrdiff_t>(sizeof(Record))) {
+            Record record;
+            memcpy(&record, p, sizeof(record));
+            const char *data = p + sizeof(Record);
+            if (static_cast<std::size_t>(end - data) < record.size || record.size == 0 ||
+                Crc32c(data, record.size) != record.crc) {
+                break;
+            }
+
+            const char *q = data + 1;
+            const char *record_end = data + record.size;
+            uint64_t key_size;
+            Op op = static_cast<Op>(*data);
+            if (!get_varint(q, record_end, key_size) || static_cast<uint64_t>(record_end - q) < key_size ||
+                (op != Op::Put && op != Op::Delete)) {
+                break;
+            }
+            key.assign(q, key_size);
+            if (op == Op::Put) {
+                value.assign(q + key_size, record_end);
+                storage.Put(key, value);
+            } else {
+                storage.Delete(key);
+            }
+            stats.records++;
+            p = record_end;
+        }
+    } catch (...) {
+        munmap(mapping, size);
+        throw;
+    }
+
+    stats.bytes = p - begin;
+    stats.torn = p != end;
+    munmap(mapping, size);
+    return stats;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,170 @@
+#ifndef AFINA_STORAGE_WAL_STORAGE_H
+#define AFINA_STORAGE_WAL_STORAGE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Durable storage
+ * Decorator that appends every change of the wrapped storage to a write-ahead log and returns from
+ * Put, PutIfAbsent, Set and Delete only once the change is on disk. On start the log is replayed, so
+ * acknowledged changes survive crash of the process or the machine.
+ *
+ * Changes are numbered by log sequence number (LSN) and appended to the in-memory buffer under the
+ * same lock they are applied to the storage with, so log order is the order the storage has seen.
+ * Flusher thread takes the whole buffer, writes it and calls fdatasync once for all of its records:
+ * callers arrived while previous sync was running are committed together (group commit). Flusher
+ * waits up to interval for the buffer to reach batch bytes, that trades latency for fewer syncs.
+ *
+ * File layout, integers are in host byte order:
+ *  - header: magic "AFWAL001"
+ *  - records: Record header, then operation byte, varint key size, key and value for Put
+ *
+ * Replay stops at the first record that is truncated or doesn't match its checksum, i.e torn by
+ * crash in the middle of the write: it was never acknowledged. Then live items are written as a new
+ * log, so the log size is bounded by the data on each start. Storage that persists data by itself,
+ * see Storage::Checkpoint, is checkpointed instead and the log starts empty.
+ *
+ * Once write or sync fails, flusher stops and changes are refused with std::runtime_error: state on
+ * disk is unknown. Changes waiting for sync at that moment get the error as well.
+ *
+ * Wrapped storage must be thread safe
+ */
+class WalStorage : public Afina::Storage {
+public:
+    enum class Op : uint8_t { Put = 1, Delete = 2 };
+
+    struct Record {
+        uint32_t size;
+        uint32_t crc;
+    };
+
+    /**
+     * Result of Replay
+     */
+    struct ReplayStats {
+        std::size_t records = 0;
+
+        // Length of the valid part of the log
+        std::size_t bytes = 0;
+
+        // Log has garbage after the last valid record
+        bool torn = false;
+    };
+
+    /**
+     * @param interval time flusher waits for more records, zero to sync as soon as previous sync ends
+     * @param batch buffer size that is synced without waiting for interval
+     */
+    WalStorage(std::shared_ptr<Afina::Storage> storage, const std::string &path,
+               std::chrono::microseconds interval = std::chrono::microseconds(0), std::size_t batch = 1024 * 1024);
+    ~WalStorage();
+
+    // Implements Afina::Storage interface: starts wrapped storage, replays and rewrites the log,
+    // starts flusher. Throws std::runtime_error if the log can't be read or written
+    void Start() override;
+
+    // Implements Afina::Storage interface: syncs pending records, stops flusher
+    void Stop() override;
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) override { return _storage->Get(key, value); }
+
+    // Implements Afina::Storage interface
+    bool Scan(std::string &cursor, std::size_t batch, const Visitor &visit) override {
+        return _storage->Scan(cursor, batch, visit);
+    }
+
+    /**
+     * Applies changes from the log to storage. Missing file isn't an error. Throws std::runtime_error
+     * if file can't be read or it isn't a log
+     */
+    static ReplayStats Replay(const std::string &path, Afina::Storage &storage);
+
+    /**
+     * LSN of the last change on disk
+     */
+    uint64_t durable_lsn() const { return _durable_lsn.load(); }
+
+private:
+    void OnRun();
+
+    /**
+     * Appends record to the buffer, must be called under _mutex right after the change is applied.
+     * Returns its LSN
+     */
+    uint64_t Append(Op op, const std::string &key, const std::string &value);
+
+    /**
+     * Blocks until change of the given LSN is on disk, throws std::runtime_error if log has failed
+     */
+    void WaitDurable(uint64_t lsn);
+
+    /**
+     * Throws std::runtime_error if log can't take changes, must be called under _mutex
+     */
+    void CheckWritable() const;
+
+    /**
+     * Replaces the log by records of the items storage has, by empty log if items is false
+     */
+    void Rewrite(bool items);
+
+    std::shared_ptr<Afina::Storage> _storage;
+    const std::string _path;
+    const std::chrono::microseconds _interval;
+    const std::size_t _batch;
+
+    int _fd;
+    std::thread _thread;
+
+    // Guards buffer, LSN counters and state, serializes changes of the storage
+    std::mutex _mutex;
+    std::condition_variable _flush_cv;
+    std::condition_variable _durable_cv;
+    std::string _buffer;
+    uint64_t _next_lsn;
+    bool _stopping;
+
+    // Set once write or sync has failed, LSN isn't advanced since then
+    std::atomic<bool> _failed;
+
+    // Buffer being written, swapped with _buffer to keep both allocated
+    std::string _writing;
+
+    std::atomic<uint64_t> _durable_lsn;
+    std::atomic<uint64_t> _records;
+    std::atomic<uint64_t> _bytes;
+    std::atomic<uint64_t> _syncs;
+    std::atomic<uint64_t> _errors;
+    std::atomic<uint64_t> _replayed;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_WAL_STORAGE_H
@@ -0,0 +1,31 @@
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
+
+#include <afina/allocator/Mapping.h>
+
+using namespace Afina::Allocator;
+
+TEST(MappingTest, Plain) {
+    Mapping memory(100000);
+    ASSERT_NE(memory.data(), nullptr);
+    EXPECT_EQ(memory.size(), 100000);
+    EXPECT_FALSE(memory.hugetlb());
+
+    // Anonymous memory is zeroed
+    const char *p = static_cast<const char *>(memory.data());
+    EXPECT_EQ(p[0], 0);
+    EXPECT_EQ(p[99999], 0);
+    memset(memory.data(), 'x', memory.size());
+}
+
+TEST(MappingTest, HugePages) {
+    // Works whether or not system has reserved huge pages
+    const std::size_t huge = 2 * 1024 * 1024;
+    Mapping memory(huge + 1, Mapping::kHugePages | Mapping::kPopulate);
+    EXPECT_EQ(memory.size(), 2 * huge);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(memory.data()) % huge, 0);
+
+    memset(memory.data(), 'x', memory.size());
+    EXPECT_EQ(static_cast<const char *>(memory.data())[memory.size() - 1], 'x');
+}
@@ -0,0 +1,203 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/Arena.h>
+#include <afina/allocator/Mempool.h>
+#include <afina/allocator/SlabCache.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+TEST(ArenaTest, MapUnmap) {
+    Arena arena(16 * 64 * 1024);
+    ASSERT_EQ(arena.capacity(), 16);
+
+    set<void *> slabs;
+    for (void *slab = arena.map(); slab != nullptr; slab = arena.map()) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(slab) % arena.slab_size(), 0);
+        EXPECT_EQ(arena.slab_of(static_cast<char *>(slab) + 1000), slab);
+        memset(slab, 0xff, arena.slab_size());
+        EXPECT_TRUE(slabs.insert(slab).second);
+    }
+    EXPECT_EQ(slabs.size(), 16);
+    EXPECT_EQ(arena.used(), 16);
+
+    // Returned slabs are reused
+    arena.unmap(*slabs.begin());
+    arena.unmap(*slabs.rbegin());
+    EXPECT_EQ(arena.used(), 14);
+    EXPECT_EQ(arena.map(), *slabs.rbegin());
+    EXPECT_EQ(arena.map(), *slabs.begin());
+    EXPECT_EQ(arena.map(), nullptr);
+}
+
+TEST(ArenaTest, Concurrent) {
+    Arena arena(64 * 64 * 1024);
+
+    // Each thread holds a few slabs at a time, arena is large enough for all of them
+    vector<thread> threads;
+    atomic<int> errors(0);
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&arena, &errors, t]() {
+            vector<void *> slabs;
+            for (int i = 0; i < 20000; i++) {
+                if (slabs.size() < 8 && (i % 3 != 0 || slabs.empty())) {
+                    void *slab = arena.map();
+                    if (slab == nullptr) {
+                        errors++;
+                        continue;
+                    }
+                    // Slab must not be shared with anybody
+                    *static_cast<int *>(slab) = t;
+                    slabs.push_back(slab);
+                } else {
+                    void *slab = slabs.back();
+                    slabs.pop_back();
+                    if (*static_cast<int *>(slab) != t) {
+                        errors++;
+                    }
+                    arena.unmap(slab);
+                }
+            }
+            for (void *slab : slabs) {
+                arena.unmap(slab);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(errors.load(), 0);
+    EXPECT_EQ(arena.used(), 0);
+}
+
+TEST(MempoolTest, AllocFree) {
+    Arena arena(1024 * 1024);
+    SlabCache cache(arena, 1);
+    Mempool pool(cache, 100);
+    EXPECT_EQ(pool.object_size() % alignof(std::max_align_t), 0);
+
+    // Enough objects to take several slabs
+    vector<char *> objects;
+    set<void *> slabs;
+    for (int i = 0; i < 2000; i++) {
+        char *p = static_cast<char *>(pool.alloc());
+        ASSERT_NE(p, nullptr);
+        memset(p, i, 100);
+        objects.push_back(p);
+        slabs.insert(arena.slab_of(p));
+    }
+    EXPECT_EQ(pool.used(), 2000);
+    EXPECT_EQ(pool.slabs(), slabs.size());
+    EXPECT_GT(pool.slabs(), 2);
+
+    for (size_t i = 0; i < objects.size(); i++) {
+        EXPECT_EQ(objects[i][0], static_cast<char>(i));
+        EXPECT_EQ(objects[i][99], static_cast<char>(i));
+    }
+
+    // Freed object is reused first
+    pool.free(objects[10]);
+    EXPECT_EQ(pool.alloc(), objects[10]);
+
+    // Empty slabs go back, one is kept by the pool
+    for (char *p : objects) {
+        pool.free(p);
+    }
+    EXPECT_EQ(pool.used(), 0);
+    EXPECT_EQ(pool.slabs(), 1);
+    EXPECT_EQ(cache.slabs(), 2);
+    EXPECT_EQ(arena.used(), 2);
+}
+
+TEST(MempoolTest, Exhaustion) {
+    Arena arena(2 * 64 * 1024);
+    SlabCache cache(arena);
+    Mempool pool(cache, 1024);
+
+    size_t count = 0;
+    while (pool.alloc() != nullptr) {
+        count++;
+    }
+    EXPECT_EQ(count, pool.slabs() * (64 * 1024 / 1024 - 1));
+    EXPECT_EQ(pool.slabs(), 2);
+}
+
+TEST(MempoolTest, FreeFromOtherThread) {
+    Arena arena(16 * 64 * 1024);
+    SlabCache cache(arena);
+    Mempool pool(cache, 64);
+    const size_t capacity = 16 * ((64 * 1024 - 64) / 64);
+
+    // Owner allocates, consumer frees whatever it gets. That is way more than arena holds
+    const int count = 200000;
+    mutex lock;
+    vector<void *> queue;
+    atomic<bool> done(false);
+
+    thread consumer([&]() {
+        while (true) {
+            // Checked before taking the queue, so that whatever was pushed before done is freed
+            bool last = done;
+            vector<void *> batch;
+            {
+                lock_guard<mutex> guard(lock);
+                batch.swap(queue);
+            }
+            for (void *p : batch) {
+                pool.free(p);
+            }
+            if (last) {
+                return;
+            }
+        }
+    });
+
+    for (int i = 0; i < count; i++) {
+        void *p = pool.alloc();
+        if (p == nullptr) {
+            // Consumer is behind
+            this_thread::yield();
+            i--;
+            continue;
+        }
+        lock_guard<mutex> guard(lock);
+        queue.push_back(p);
+    }
+    done = true;
+    consumer.join();
+
+    // Everything freed by consumer is back once owner needs it
+    size_t allocated = 0;
+    while (pool.alloc() != nullptr) {
+        allocated++;
+    }
+    EXPECT_EQ(allocated, capacity);
+    EXPECT_EQ(pool.used(), capacity);
+}
+
+TEST(MempoolTest, ObjectPool) {
+    Arena arena(1024 * 1024);
+    SlabCache cache(arena);
+    ObjectPool<std::string> pool(cache);
+
+    vector<std::string *> strings;
+    for (int i = 0; i < 100; i++) {
+        strings.push_back(pool.create(100, static_cast<char>('a' + i % 26)));
+    }
+    EXPECT_EQ(pool.used(), 100);
+    EXPECT_EQ(*strings[27], std::string(100, 'b'));
+
+    for (std::string *s : strings) {
+        pool.destroy(s);
+    }
+    EXPECT_EQ(pool.used(), 0);
+}
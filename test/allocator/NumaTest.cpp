@@ -0,0 +1,63 @@
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include <sched.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <afina/allocator/Mapping.h>
+#include <afina/allocator/Numa.h>
+
+using namespace Afina::Allocator;
+
+static void write_node(const std::string &root, const std::string &node, const std::string &cpulist) {
+    mkdir((root + "/" + node).c_str(), 0700);
+    std::ofstream(root + "/" + node + "/cpulist") << cpulist << std::endl;
+}
+
+TEST(NumaTest, Topology) {
+    char root[] = "/tmp/afina_numa_XXXXXX";
+    ASSERT_NE(mkdtemp(root), nullptr);
+    write_node(root, "node0", "0-3,8-11");
+    write_node(root, "node2", "4-7,12");
+    write_node(root, "node3", "");
+    write_node(root, "possible", "0-3");
+
+    NumaTopology topology(root);
+    ASSERT_EQ(topology.nodes().size(), 2);
+    EXPECT_EQ(topology.nodes()[0], 0);
+    EXPECT_EQ(topology.nodes()[1], 2);
+    EXPECT_EQ(topology.cpus(0), std::vector<int>({0, 1, 2, 3, 8, 9, 10, 11}));
+    EXPECT_EQ(topology.cpus(2), std::vector<int>({4, 5, 6, 7, 12}));
+    EXPECT_TRUE(topology.cpus(1).empty());
+    EXPECT_EQ(topology.node_of(9), 0);
+    EXPECT_EQ(topology.node_of(12), 2);
+    EXPECT_EQ(topology.node_of(13), -1);
+
+    system((std::string("rm -rf ") + root).c_str());
+}
+
+TEST(NumaTest, NoSysfs) {
+    // Kernel without NUMA: single node with all cpus
+    NumaTopology topology("/nonexistent");
+    ASSERT_EQ(topology.nodes().size(), 1);
+    EXPECT_EQ(topology.cpus(0).size(), sysconf(_SC_NPROCESSORS_ONLN));
+}
+
+TEST(NumaTest, BindAndPin) {
+    const NumaTopology &topology = NumaTopology::System();
+    int node = topology.nodes().back();
+
+    Mapping memory(1024 * 1024, Mapping::kPopulate, node);
+    memset(memory.data(), 'x', memory.size());
+
+    cpu_set_t saved;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(saved), &saved), 0);
+    pin_thread(node);
+    EXPECT_EQ(current_numa_node(), node);
+    EXPECT_EQ(topology.node_of(sched_getcpu()), node);
+    sched_setaffinity(0, sizeof(saved), &saved);
+}
@@ -1,4 +1,6 @@
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <set>
 #include <vector>
@@ -322,3 +324,89 @@ TEST(SimpleTest, ReallocGrow) {
     a.free(p);
     a.free(p2);
 }
+
+TEST(SimpleTest, InvalidFree) {
+    Simple a(buf, sizeof(buf));
+
+    Pointer p = a.alloc(100);
+    Pointer copy = p;
+    a.free(p);
+
+    try {
+        a.free(copy);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+
+    // Empty pointer is fine
+    a.free(p);
+}
+
+TEST(SimpleTest, RandomWorkload) {
+    Simple a(buf, sizeof(buf));
+
+    // Each live pointer keeps its size and fill byte, content is checked after every move
+    struct Entry {
+        Pointer p;
+        size_t size;
+        char fill;
+    };
+    vector<Entry> live;
+    auto check = [&live]() {
+        for (Entry &e : live) {
+            char *v = reinterpret_cast<char *>(e.p.get());
+            ASSERT_TRUE(v >= buf && v + e.size <= buf + sizeof(buf));
+            for (size_t i = 0; i < e.size; i++) {
+                ASSERT_EQ(e.fill, v[i]);
+            }
+        }
+    };
+
+    unsigned seed = 42;
+    for (int step = 0; step < 20000; step++) {
+        seed = seed * 1103515245 + 12345;
+        unsigned action = (seed >> 16) % 8;
+        size_t size = 1 + (seed >> 8) % 700;
+        char fill = static_cast<char>(step);
+
+        try {
+            if (action < 4 || live.empty()) {
+                live.push_back(Entry{a.alloc(size), size, fill});
+            } else if (action < 6) {
+                Entry &e = live[seed % live.size()];
+                a.realloc(e.p, size);
+                std::memset(e.p.get(), fill, size);
+                e.size = size;
+                e.fill = fill;
+                continue;
+            } else {
+                size_t i = seed % live.size();
+                a.free(live[i].p);
+                live.erase(live.begin() + i);
+                continue;
+            }
+            std::memset(live.back().p.get(), fill, size);
+        } catch (AllocError &e) {
+            ASSERT_EQ(e.getType(), AllocErrorType::NoMemory);
+            a.defrag();
+            check();
+
+            // Make room
+            for (size_t i = 0; i < live.size() / 2; i++) {
+                a.free(live.back().p);
+                live.pop_back();
+            }
+        }
+    }
+
+    check();
+    for (Entry &e : live) {
+        a.free(e.p);
+    }
+
+    // Everything is free again, so the whole area is one piece
+    a.defrag();
+    Pointer all = a.alloc(sizeof(buf) / 2);
+    a.free(all);
+}
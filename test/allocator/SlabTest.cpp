@@ -0,0 +1,161 @@
+#include "gtest/gtest.h"
+#include <cstring>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Slab.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+static char area[64 * 1024];
+
+TEST(SlabTest, Classes) {
+    Slab a(area, sizeof(area), 4096, 64, 1.25);
+
+    ASSERT_GT(a.classes(), 2);
+    EXPECT_EQ(a.chunk_size(0), 64);
+    EXPECT_EQ(a.chunk_size(a.classes() - 1), 4096);
+    for (unsigned i = 1; i < a.classes(); i++) {
+        EXPECT_GT(a.chunk_size(i), a.chunk_size(i - 1));
+    }
+
+    EXPECT_EQ(a.class_of(size_t(1)), 0);
+    EXPECT_EQ(a.class_of(size_t(64)), 0);
+    EXPECT_EQ(a.class_of(size_t(65)), 1);
+    EXPECT_EQ(a.class_of(size_t(4096)), a.classes() - 1);
+
+    try {
+        a.class_of(size_t(4097));
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::NoMemory);
+    }
+}
+
+TEST(SlabTest, AllocFree) {
+    Slab a(area, sizeof(area), 4096);
+    unsigned cls = a.class_of(size_t(100));
+
+    set<char *> chunks;
+    for (int i = 0; i < 100; i++) {
+        char *p = static_cast<char *>(a.alloc(cls));
+        ASSERT_NE(p, nullptr);
+        EXPECT_GE(p, area);
+        EXPECT_LE(p + a.chunk_size(cls), area + sizeof(area));
+        EXPECT_EQ(a.class_of(static_cast<void *>(p)), cls);
+        memset(p, i, a.chunk_size(cls));
+        EXPECT_TRUE(chunks.insert(p).second);
+    }
+
+    // Chunks don't overlap
+    char *prev = nullptr;
+    for (char *p : chunks) {
+        if (prev != nullptr) {
+            EXPECT_GE(p, prev + a.chunk_size(cls));
+        }
+        prev = p;
+    }
+
+    EXPECT_EQ(a.used(cls), 100);
+    for (char *p : chunks) {
+        a.free(p);
+    }
+    EXPECT_EQ(a.used(cls), 0);
+
+    try {
+        a.free(*chunks.begin());
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+}
+
+TEST(SlabTest, Exhaustion) {
+    Slab a(area, sizeof(area), 4096);
+    unsigned big = a.classes() - 1;
+
+    vector<void *> pages;
+    for (void *p = a.alloc(big); p != nullptr; p = a.alloc(big)) {
+        pages.push_back(p);
+    }
+    EXPECT_EQ(pages.size(), sizeof(area) / 4096);
+    EXPECT_EQ(a.spare_pages(), 0);
+
+    // Memory of the other class is not available
+    EXPECT_EQ(a.alloc(0), nullptr);
+
+    // Freed chunk goes back to its own class only
+    a.free(pages.back());
+    EXPECT_EQ(a.alloc(0), nullptr);
+    EXPECT_EQ(a.alloc(big), pages.back());
+}
+
+TEST(SlabTest, Reassign) {
+    Slab a(area, sizeof(area), 4096);
+    unsigned small = 0, big = a.classes() - 1;
+
+    vector<void *> chunks;
+    for (void *p = a.alloc(small); p != nullptr; p = a.alloc(small)) {
+        chunks.push_back(p);
+    }
+    ASSERT_EQ(a.alloc(big), nullptr);
+
+    // Free some chunks of the first page, the rest is evicted by reassign
+    size_t per_page = 4096 / a.chunk_size(small);
+    a.free(chunks[0]);
+    a.free(chunks[per_page / 2]);
+
+    set<void *> evicted;
+    a.reassign(chunks[1], big, [&evicted](void *p) { evicted.insert(p); });
+    EXPECT_EQ(evicted.size(), per_page - 2);
+    EXPECT_EQ(evicted.count(chunks[0]), 0);
+    EXPECT_EQ(evicted.count(chunks[1]), 1);
+
+    EXPECT_EQ(a.pages(big), 1);
+    EXPECT_EQ(a.used(small), chunks.size() - per_page);
+    EXPECT_EQ(a.alloc(small), nullptr);
+
+    void *page = a.alloc(big);
+    ASSERT_NE(page, nullptr);
+    memset(page, 0, 4096);
+    EXPECT_EQ(a.alloc(big), nullptr);
+
+    // The rest of small chunks is intact
+    for (size_t i = per_page; i < chunks.size(); i++) {
+        a.free(chunks[i]);
+    }
+    EXPECT_EQ(a.used(small), 0);
+}
+
+TEST(SlabTest, EmbeddedAttach) {
+    static char shared[256 * 1024];
+    set<void *> chunks;
+    {
+        Slab a = Slab::Embedded(shared, sizeof(shared), 4096);
+        unsigned cls = a.class_of(size_t(100));
+        for (int i = 0; i < 100; i++) {
+            void *p = a.alloc(cls);
+            ASSERT_NE(p, nullptr);
+            chunks.insert(p);
+        }
+    }
+
+    // State is in the area, chunks allocated before are kept
+    Slab b = Slab::Attach(shared, sizeof(shared));
+    unsigned cls = b.class_of(size_t(100));
+    for (void *p : chunks) {
+        EXPECT_EQ(b.class_of(p), cls);
+    }
+    void *p = b.alloc(cls);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(chunks.count(p), 0);
+    for (void *chunk : chunks) {
+        b.free(chunk);
+    }
+
+    EXPECT_THROW(Slab::Attach(shared, sizeof(shared) / 2), std::runtime_error);
+    EXPECT_THROW(Slab::Attach(area, sizeof(area)), std::runtime_error);
+}
@@ -0,0 +1,92 @@
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <afina/allocator/Resource.h>
+#include <afina/allocator/StdAllocator.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+static char area[1024 * 1024];
+
+using String = basic_string<char, char_traits<char>, PolymorphicAllocator<char>>;
+
+TEST(StdAllocatorTest, Containers) {
+    SlabResource resource(area, sizeof(area), 64 * 1024);
+    PolymorphicAllocator<char> alloc(&resource);
+
+    {
+        vector<String, PolymorphicAllocator<String>> strings(alloc);
+        for (int i = 0; i < 1000; i++) {
+            strings.emplace_back(100, static_cast<char>('a' + i % 26));
+        }
+        EXPECT_EQ(strings[27], String(100, 'b', alloc));
+        EXPECT_GE(resource.used(), 1000 * 100);
+
+        // Everything is inside of the area
+        for (String &s : strings) {
+            EXPECT_EQ(s.get_allocator(), alloc);
+            EXPECT_GE(s.data(), area);
+            EXPECT_LT(s.data(), area + sizeof(area));
+        }
+
+        using Map = map<String, int, less<String>, PolymorphicAllocator<pair<const String, int>>>;
+        Map index(alloc);
+        for (int i = 0; i < 1000; i++) {
+            index.emplace(String(to_string(i).c_str(), alloc), i);
+        }
+        EXPECT_EQ(index.at(String("500", alloc)), 500);
+
+        // Copy stays in the same resource
+        Map copy(index);
+        EXPECT_EQ(copy.get_allocator(), index.get_allocator());
+    }
+    EXPECT_EQ(resource.used(), 0);
+}
+
+TEST(StdAllocatorTest, Bounded) {
+    SlabResource resource(area, sizeof(area), 64 * 1024);
+    StdAllocator<int64_t, SlabResource> alloc(&resource);
+
+    // Vector can't grow beyond the page
+    vector<int64_t, StdAllocator<int64_t, SlabResource>> values(alloc);
+    try {
+        for (int i = 0; i < 1000000; i++) {
+            values.push_back(i);
+        }
+        EXPECT_TRUE(false);
+    } catch (std::bad_alloc &) {
+    }
+    EXPECT_LE(values.size() * sizeof(int64_t), 64 * 1024);
+
+    // Nor could lists take more than the area
+    size_t count = 0;
+    try {
+        vector<vector<int64_t, StdAllocator<int64_t, SlabResource>>> chunks;
+        while (true) {
+            chunks.emplace_back(1000, 0, alloc);
+            count++;
+        }
+    } catch (std::bad_alloc &) {
+    }
+    EXPECT_GT(count, 0);
+    EXPECT_LE(count * 8000, sizeof(area));
+}
+
+TEST(StdAllocatorTest, Upstream) {
+    SlabResource resource(area, sizeof(area), 64 * 1024, new_delete_resource());
+    PolymorphicAllocator<int> alloc(&resource);
+
+    // Large blocks come from heap, small ones from the area
+    vector<int, PolymorphicAllocator<int>> large(1000000, 1, alloc);
+    vector<int, PolymorphicAllocator<int>> small(10, 2, alloc);
+    EXPECT_TRUE(reinterpret_cast<char *>(large.data()) < area ||
+                reinterpret_cast<char *>(large.data()) >= area + sizeof(area));
+    EXPECT_GE(reinterpret_cast<char *>(small.data()), area);
+    EXPECT_EQ(resource.used(), 1000000 * sizeof(int) + resource.slab().chunk_size(resource.slab().class_of(size_t(40))));
+}
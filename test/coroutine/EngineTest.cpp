@@ -1,7 +1,14 @@
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <cfenv>
+#include <fstream>
+#include <iterator>
 #include <iostream>
+#include <stdexcept>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include <afina/coroutine/Engine.h>
 
@@ -69,3 +76,166 @@ TEST(CoroutineTest, Printer) {
     engine.start(_printer, engine, result);
     ASSERT_STREQ("A1 B1 A2 B2 A3 B3 END", result.c_str());
 }
+
+void _counter(Afina::Coroutine::Engine &pe, int &counter, int rounds) {
+    for (int i = 0; i < rounds; i++) {
+        counter++;
+        pe.yield();
+    }
+}
+
+void _spawner(Afina::Coroutine::Engine &pe, int &counter, int routines) {
+    for (int i = 0; i < routines; i++) {
+        ASSERT_NE(nullptr, pe.run(_counter, pe, counter, 10));
+    }
+}
+
+TEST(CoroutineTest, ManyRoutines) {
+    Afina::Coroutine::Engine engine;
+    int unused = 0;
+    EXPECT_EQ(nullptr, engine.run(_counter, engine, unused, 0));
+
+    // Engine could be started again once previous run is over, stacks are reused
+    for (int round = 0; round < 3; round++) {
+        int counter = 0;
+        engine.start(_spawner, engine, counter, 1000);
+        EXPECT_EQ(10000, counter);
+    }
+}
+
+void _yielder(Afina::Coroutine::Engine &pe, std::string &trace, char name) {
+    for (int i = 0; i < 3; i++) {
+        trace += name;
+        pe.yield();
+    }
+}
+
+void _yield_main(Afina::Coroutine::Engine &pe, std::string &trace) {
+    pe.run(_yielder, pe, trace, 'a');
+    pe.run(_yielder, pe, trace, 'b');
+    pe.run(_yielder, pe, trace, 'c');
+}
+
+TEST(CoroutineTest, YieldRoundRobin) {
+    Afina::Coroutine::Engine engine;
+    std::string trace;
+    engine.start(_yield_main, engine, trace);
+    EXPECT_EQ("cbacbacba", trace);
+}
+
+// Recursion that puts about depth kilobytes on stack
+int _deep(int depth) {
+    volatile char buffer[1024];
+    buffer[0] = 1;
+    return depth == 0 ? 0 : _deep(depth - 1) + depth * buffer[0];
+}
+
+void _deep_main(int depth, int &result) { result = _deep(depth); }
+
+TEST(CoroutineTest, StackSize) {
+    Afina::Coroutine::Engine engine(256 * 1024);
+    int result = 0;
+    engine.start(_deep_main, 200, result);
+    EXPECT_EQ(200 * 201 / 2, result);
+
+    // Overflow hits guard page instead of memory below stack
+    EXPECT_DEATH(engine.start(_deep_main, 1000, result), "");
+}
+
+void _thrower(int &before) {
+    before++;
+    throw std::runtime_error("failed");
+}
+
+void _throw_main(Afina::Coroutine::Engine &pe, int &before, int &after) {
+    pe.run(_thrower, before);
+    pe.yield();
+    after++;
+}
+
+TEST(CoroutineTest, ExceptionRethrown) {
+    Afina::Coroutine::Engine engine;
+    int before = 0, after = 0;
+
+    // Other routines keep running, exception comes out of start once everything is done
+    EXPECT_THROW(engine.start(_throw_main, engine, before, after), std::runtime_error);
+    EXPECT_EQ(1, before);
+    EXPECT_EQ(1, after);
+}
+
+void _rounding(Afina::Coroutine::Engine &pe, int mode, int &seen) {
+    std::fesetround(mode);
+    pe.yield();
+    seen = std::fegetround();
+}
+
+void _rounding_main(Afina::Coroutine::Engine &pe, int &up, int &down) {
+    pe.run(_rounding, pe, FE_UPWARD, up);
+    pe.run(_rounding, pe, FE_DOWNWARD, down);
+}
+
+TEST(CoroutineTest, FloatingPointControl) {
+    // Rounding mode belongs to routine, as any other callee saved register
+    Afina::Coroutine::Engine engine;
+    int up = 0, down = 0;
+    engine.start(_rounding_main, engine, up, down);
+    EXPECT_EQ(FE_UPWARD, up);
+    EXPECT_EQ(FE_DOWNWARD, down);
+    std::fesetround(FE_TONEAREST);
+}
+
+void _waiter(Afina::Coroutine::Engine &pe, std::vector<void *> &waiting, std::string &trace, char name) {
+    waiting.push_back(pe.current());
+    pe.block();
+    trace += name;
+}
+
+void _wait_main(Afina::Coroutine::Engine &pe, std::vector<void *> &waiting, std::string &trace) {
+    pe.run(_waiter, pe, waiting, trace, 'a');
+    pe.run(_waiter, pe, waiting, trace, 'b');
+    pe.yield();
+    trace += 'm';
+}
+
+TEST(CoroutineTest, BlockUnblock) {
+    // Idle hook plays the role of event loop: wakes routines up one by one
+    std::vector<void *> waiting;
+    std::string trace;
+    int idle = 0;
+    Afina::Coroutine::Engine engine(Afina::Coroutine::Engine::kDefaultStackSize, [&] {
+        idle++;
+        ASSERT_EQ(nullptr, engine.current());
+        ASSERT_FALSE(waiting.empty());
+        engine.unblock(waiting.front());
+        waiting.erase(waiting.begin());
+    });
+    engine.start(_wait_main, engine, waiting, trace);
+
+    EXPECT_EQ(2, idle);
+    EXPECT_EQ(3, trace.size());
+    EXPECT_EQ('m', trace[0]);
+    EXPECT_TRUE(waiting.empty());
+}
+
+void _blocker(Afina::Coroutine::Engine &pe) { pe.block(); }
+
+static std::size_t _mappings() {
+    std::ifstream maps("/proc/self/maps");
+    return std::count(std::istreambuf_iterator<char>(maps), std::istreambuf_iterator<char>(), '\n');
+}
+
+TEST(CoroutineTest, BlockedWithoutIdle) {
+    Afina::Coroutine::Engine engine;
+    EXPECT_THROW(engine.start(_blocker, engine), std::runtime_error);
+
+    // Stacks of routines left blocked are released, engine could run again
+    std::size_t mappings = _mappings();
+    for (int i = 0; i < 200; i++) {
+        EXPECT_THROW(engine.start(_blocker, engine), std::runtime_error);
+    }
+    EXPECT_LT(_mappings(), mappings + 10);
+
+    int result = 0;
+    engine.start(_calculator_add, result, 1, 2);
+    EXPECT_EQ(3, result);
+}
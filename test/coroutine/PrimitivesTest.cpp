@@ -0,0 +1,238 @@
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <afina/coroutine/Channel.h>
+#include <afina/coroutine/Engine.h>
+#include <afina/coroutine/Mutex.h>
+#include <afina/coroutine/Poller.h>
+#include <afina/coroutine/WaitList.h>
+
+using namespace Afina::Coroutine;
+
+void _producer(Channel<int> &channel, int count) {
+    for (int i = 0; i < count; i++) {
+        ASSERT_TRUE(channel.send(i));
+    }
+    channel.close();
+}
+
+void _consumer(Channel<int> &channel, std::vector<int> &received, std::size_t &max_size) {
+    int value;
+    while (channel.recv(value)) {
+        received.push_back(value);
+        max_size = std::max(max_size, channel.size());
+    }
+}
+
+void _channel_main(Engine &engine, Channel<int> &channel, std::vector<int> &received, std::size_t &max_size) {
+    engine.run(_consumer, channel, received, max_size);
+    engine.run(_producer, channel, 100);
+}
+
+TEST(PrimitivesTest, ChannelOrder) {
+    Engine engine;
+    Channel<int> channel(engine, 3);
+    std::vector<int> received;
+    std::size_t max_size = 0;
+    engine.start(_channel_main, engine, channel, received, max_size);
+
+    ASSERT_EQ(100, received.size());
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(i, received[i]);
+    }
+    EXPECT_LE(max_size, channel.capacity());
+    EXPECT_FALSE(channel.send(1));
+}
+
+void _blocked_sender(Channel<std::string> &channel, int &failed) {
+    while (channel.send("value")) {
+    }
+    failed++;
+}
+
+void _blocked_receiver(Channel<std::string> &channel, int &failed) {
+    std::string value;
+    if (!channel.recv(value)) {
+        failed++;
+    }
+}
+
+void _closer(Engine &engine, Channel<std::string> &full, Channel<std::string> &empty) {
+    // Let others run till they block
+    while (full.size() < full.capacity()) {
+        engine.yield();
+    }
+    full.close();
+    empty.close();
+}
+
+void _close_main(Engine &engine, Channel<std::string> &full, Channel<std::string> &empty, int &failed) {
+    engine.run(_blocked_sender, full, failed);
+    engine.run(_blocked_receiver, empty, failed);
+    engine.run(_closer, engine, full, empty);
+}
+
+TEST(PrimitivesTest, ChannelClose) {
+    Engine engine;
+    Channel<std::string> full(engine, 2), empty(engine, 2);
+    int failed = 0;
+    engine.start(_close_main, engine, full, empty, failed);
+
+    EXPECT_EQ(2, failed);
+
+    // What has been sent is still there
+    std::string value;
+    EXPECT_TRUE(full.try_recv(value));
+    EXPECT_EQ("value", value);
+}
+
+void _locker(Engine &engine, Mutex &mutex, int &inside, int &max_inside, std::string &trace, char name) {
+    for (int i = 0; i < 3; i++) {
+        std::lock_guard<Mutex> lock(mutex);
+        inside++;
+        max_inside = std::max(max_inside, inside);
+        trace += name;
+        engine.yield();
+        inside--;
+    }
+}
+
+void _mutex_main(Engine &engine, Mutex &mutex, int &inside, int &max_inside, std::string &trace) {
+    engine.run(_locker, engine, mutex, inside, max_inside, trace, 'a');
+    engine.run(_locker, engine, mutex, inside, max_inside, trace, 'b');
+}
+
+TEST(PrimitivesTest, Mutex) {
+    Engine engine;
+    Mutex mutex(engine);
+    int inside = 0, max_inside = 0;
+    std::string trace;
+    engine.start(_mutex_main, engine, mutex, inside, max_inside, trace);
+
+    EXPECT_EQ(1, max_inside);
+
+    // Unlock hands mutex over to the waiting routine
+    EXPECT_EQ("bababa", trace);
+}
+
+void _waiter(Mutex &mutex, ConditionVariable &cv, std::vector<int> &queue, std::vector<int> &taken) {
+    std::unique_lock<Mutex> lock(mutex);
+    cv.wait(mutex, [&] { return !queue.empty(); });
+    taken.push_back(queue.back());
+    queue.pop_back();
+}
+
+void _notifier(Engine &engine, Mutex &mutex, ConditionVariable &cv, std::vector<int> &queue) {
+    for (int i = 0; i < 3; i++) {
+        engine.yield();
+        std::lock_guard<Mutex> lock(mutex);
+        queue.push_back(i);
+        cv.notify_one();
+    }
+}
+
+void _cv_main(Engine &engine, Mutex &mutex, ConditionVariable &cv, std::vector<int> &queue, std::vector<int> &taken) {
+    for (int i = 0; i < 3; i++) {
+        engine.run(_waiter, mutex, cv, queue, taken);
+    }
+    engine.run(_notifier, engine, mutex, cv, queue);
+}
+
+TEST(PrimitivesTest, ConditionVariable) {
+    Engine engine;
+    Mutex mutex(engine);
+    ConditionVariable cv(engine);
+    std::vector<int> queue, taken;
+    engine.start(_cv_main, engine, mutex, cv, queue, taken);
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(3, taken.size());
+}
+
+void _sleeper(Poller &poller, std::string &trace, char name, uint32_t timeout) {
+    poller.sleep(timeout);
+    trace += name;
+}
+
+void _sleep_main(Engine &engine, Poller &poller, std::string &trace) {
+    engine.run(_sleeper, poller, trace, 'a', 60u);
+    engine.run(_sleeper, poller, trace, 'b', 20u);
+    engine.run(_sleeper, poller, trace, 'c', 40u);
+}
+
+TEST(PrimitivesTest, Sleep) {
+    Engine engine;
+    Poller poller(engine);
+    std::string trace;
+    auto start = std::chrono::steady_clock::now();
+    engine.start(_sleep_main, engine, poller, trace);
+
+    EXPECT_EQ("bca", trace);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(60));
+}
+
+void _reader(Poller &poller, int fd, uint32_t &events, std::string &data) {
+    events = poller.wait(fd, EPOLLIN);
+    char buffer[16];
+    ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n > 0) {
+        data.assign(buffer, n);
+    }
+}
+
+void _writer(Poller &poller, int fd) {
+    poller.sleep(50);
+    ASSERT_EQ(4, write(fd, "ping", 4));
+}
+
+void _timed_reader(Poller &poller, int fd, uint32_t &events) { events = poller.wait(fd, EPOLLIN, 20); }
+
+void _fd_main(Engine &engine, Poller &poller, int *fds, uint32_t &events, uint32_t &timed_events, std::string &data) {
+    engine.run(_reader, poller, static_cast<int>(fds[0]), events, data);
+    engine.run(_timed_reader, poller, static_cast<int>(fds[0]), timed_events);
+    engine.run(_writer, poller, static_cast<int>(fds[1]));
+}
+
+TEST(PrimitivesTest, WaitDescriptor) {
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+
+    // Two routines wait for the same descriptor, one of them gives up before data arrives
+    Engine engine;
+    Poller poller(engine);
+    uint32_t events = 0, timed_events = EPOLLIN;
+    std::string data;
+    engine.start(_fd_main, engine, poller, static_cast<int *>(fds), events, timed_events, data);
+    close(fds[0]);
+    close(fds[1]);
+
+    EXPECT_EQ(0, timed_events);
+    EXPECT_EQ(EPOLLIN, events);
+    EXPECT_EQ("ping", data);
+}
+
+void _deadlock(Engine &engine) { engine.block(); }
+
+TEST(PrimitivesTest, Deadlock) {
+    Engine engine;
+    Poller poller(engine);
+    EXPECT_THROW(engine.start(_deadlock, engine), std::runtime_error);
+}
+
+TEST(PrimitivesTest, WaitOutsideRoutine) {
+    Engine engine;
+    WaitList waiters(engine);
+    Mutex mutex(engine);
+    EXPECT_THROW(waiters.wait(), std::logic_error);
+    EXPECT_THROW(mutex.lock(), std::logic_error);
+    EXPECT_THROW(mutex.try_lock(), std::logic_error);
+    EXPECT_TRUE(waiters.empty());
+}
@@ -0,0 +1,38 @@
+#include "gtest/gtest.h"
+#include <string>
+
+#include <afina/Metrics.h>
+#include <afina/execute/Stats.h>
+
+#include "storage/SimpleLRU.h"
+
+using namespace Afina;
+using namespace Afina::Execute;
+
+TEST(StatsTest, Empty) {
+    Backend::SimpleLRU storage;
+    Stats cmd;
+
+    std::string out;
+    cmd.Execute(storage, "", out);
+    EXPECT_EQ("END", out);
+}
+
+TEST(StatsTest, ReportsGauges) {
+    Backend::SimpleLRU storage;
+    Stats cmd;
+
+    uint64_t value = 1;
+    Metrics::Instance().Register("test_b", [&value] { return value; });
+    Metrics::Instance().Register("test_a", [] { return uint64_t(42); });
+
+    std::string out;
+    value = 7;
+    cmd.Execute(storage, "", out);
+    EXPECT_EQ("STAT test_a 42\r\nSTAT test_b 7\r\nEND", out);
+
+    Metrics::Instance().Unregister("test_a");
+    Metrics::Instance().Unregister("test_b");
+    cmd.Execute(storage, "", out);
+    EXPECT_EQ("END", out);
+}
@@ -0,0 +1,200 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <afina/network/Config.h>
+
+#include "logging/ServiceImpl.h"
+#include "network/coro/ServerImpl.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina;
+
+class CoroServerTest : public ::testing::Test {
+public:
+    // Logging service is shared by all tests of the fixture
+    static void SetUpTestCase() {
+        auto log_config = std::make_shared<Logging::Config>();
+        Logging::Appender &console = log_config->appenders["console"];
+        console.type = Logging::Appender::Type::STDERR;
+        Logging::Logger &logger = log_config->loggers["root"];
+        logger.level = Logging::Logger::Level::ERROR;
+        logger.appenders.push_back("console");
+
+        logging = std::make_shared<Logging::ServiceImpl>(log_config);
+        logging->Start();
+    }
+
+    static void TearDownTestCase() {
+        logging->Stop();
+        logging.reset();
+    }
+
+protected:
+    void SetUp() override { Start(Network::Config()); }
+
+    void TearDown() override {
+        server->Stop();
+        server->Join();
+    }
+
+    void Start(const Network::Config &config) {
+        storage = std::make_shared<Backend::ThreadSafeSimplLRU>(16 * 1024 * 1024);
+        server = std::make_shared<Network::Coro::ServerImpl>(storage, logging, config);
+        server->Start(kPort, 1, 2);
+    }
+
+    int Connect() {
+        int sfd = socket(AF_INET, SOCK_STREAM, 0);
+        EXPECT_NE(-1, sfd);
+        struct timeval tv = {5, 0};
+        setsockopt(sfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(kPort);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        EXPECT_EQ(0, connect(sfd, (struct sockaddr *)&addr, sizeof(addr)));
+        return sfd;
+    }
+
+    // Reads exactly size bytes, returns what has been read before timeout otherwise
+    std::string Read(int sfd, std::size_t size) {
+        std::string result;
+        char buffer[4096];
+        while (result.size() < size) {
+            ssize_t n = recv(sfd, buffer, std::min(sizeof(buffer), size - result.size()), 0);
+            if (n <= 0) {
+                break;
+            }
+            result.append(buffer, n);
+        }
+        return result;
+    }
+
+    static constexpr uint16_t kPort = 18113;
+
+    static std::shared_ptr<Logging::ServiceImpl> logging;
+    std::shared_ptr<Backend::ThreadSafeSimplLRU> storage;
+    std::shared_ptr<Network::Coro::ServerImpl> server;
+};
+
+std::shared_ptr<Logging::ServiceImpl> CoroServerTest::logging;
+
+TEST_F(CoroServerTest, SetGet) {
+    int sfd = Connect();
+    std::string request = "set foo 0 0 6\r\nfooval\r\n";
+    ASSERT_EQ(request.size(), send(sfd, request.data(), request.size(), 0));
+    EXPECT_EQ("STORED\r\n", Read(sfd, 8));
+
+    // Command split into pieces makes coroutine block in the middle of it
+    std::string get = "get foo\r\n";
+    for (char c : get) {
+        ASSERT_EQ(1, send(sfd, &c, 1, 0));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::string expected = "VALUE foo 0 8\r\nfooval\r\n\r\nEND\r\n";
+    EXPECT_EQ(expected, Read(sfd, expected.size()));
+    close(sfd);
+}
+
+TEST_F(CoroServerTest, ManyConnections) {
+    // Every connection is a coroutine blocked on read while the others are served
+    std::vector<int> sockets;
+    for (int i = 0; i < 200; i++) {
+        sockets.push_back(Connect());
+    }
+    for (std::size_t i = 0; i < sockets.size(); i++) {
+        std::string value = std::to_string(i);
+        std::string request = "set key" + value + " 0 0 " + std::to_string(value.size()) + "\r\n" + value + "\r\n";
+        ASSERT_EQ(request.size(), send(sockets[i], request.data(), request.size(), 0));
+    }
+    for (std::size_t i = 0; i < sockets.size(); i++) {
+        EXPECT_EQ("STORED\r\n", Read(sockets[i], 8));
+        close(sockets[i]);
+    }
+}
+
+TEST_F(CoroServerTest, Pipeline) {
+    std::string request, expected;
+    for (int i = 0; i < 2000; i++) {
+        std::string key = "key" + std::to_string(i % 50);
+        std::string value(1 + (i * 37) % 3000, 'a' + i % 26);
+        request += "set " + key + " 0 0 " + std::to_string(value.size()) + "\r\n" + value + "\r\n";
+        request += "get " + key + "\r\n";
+
+        // Stored value keeps trailing \r\n
+        expected += "STORED\r\n";
+        expected += "VALUE " + key + " 0 " + std::to_string(value.size() + 2) + "\r\n" + value + "\r\n\r\nEND\r\n";
+    }
+
+    // Server blocks on write once client doesn't read responses, so they are read concurrently
+    int sfd = Connect();
+    std::string response;
+    std::thread reader([&] { response = Read(sfd, expected.size()); });
+
+    std::size_t sent = 0;
+    while (sent < request.size()) {
+        ssize_t n = send(sfd, request.data() + sent, request.size() - sent, 0);
+        if (n <= 0) {
+            break;
+        }
+        sent += n;
+    }
+    reader.join();
+    close(sfd);
+
+    EXPECT_EQ(request.size(), sent);
+    EXPECT_EQ(expected.size(), response.size());
+    EXPECT_TRUE(expected == response);
+}
+
+TEST_F(CoroServerTest, DrainOnStop) {
+    int sfd = Connect();
+    std::string request;
+    for (int i = 0; i < 100; i++) {
+        request += "get missing\r\n";
+    }
+    ASSERT_EQ(request.size(), send(sfd, request.data(), request.size(), 0));
+
+    // First response means all commands have been read, the rest must be sent before server stops
+    EXPECT_EQ("END\r\n", Read(sfd, 5));
+    server->Stop();
+
+    std::string expected;
+    for (int i = 1; i < 100; i++) {
+        expected += "END\r\n";
+    }
+    EXPECT_EQ(expected, Read(sfd, expected.size()));
+
+    // Idle connection is closed
+    char c;
+    EXPECT_EQ(0, recv(sfd, &c, 1, 0));
+    close(sfd);
+}
+
+TEST_F(CoroServerTest, IdleTimeout) {
+    server->Stop();
+    server->Join();
+
+    Network::Config config;
+    config.idle_timeout = 200;
+    Start(config);
+
+    int sfd = Connect();
+    auto start = std::chrono::steady_clock::now();
+    char c;
+    EXPECT_EQ(0, recv(sfd, &c, 1, 0));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(200));
+    close(sfd);
+}
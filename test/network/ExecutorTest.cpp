@@ -0,0 +1,195 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <afina/Executor.h>
+#include <afina/Metrics.h>
+
+using namespace Afina;
+
+TEST(ExecutorTest, ExecuteAll) {
+    const int n = 100000;
+    std::atomic<int> done(0);
+    {
+        Executor executor("test", 2, 4, n, 1000);
+        for (int i = 0; i < n; i++) {
+            ASSERT_TRUE(executor.Execute([&done] { done++; }));
+        }
+        executor.Stop(true);
+        EXPECT_FALSE(executor.Execute([&done] { done++; }));
+    }
+    EXPECT_EQ(n, done.load());
+}
+
+TEST(ExecutorTest, TaskStorage) {
+    int calls = 0;
+    char large[Task::kInlineSize] = {1};
+    auto small_func = [&calls] { calls++; };
+    auto large_func = [&calls, large] { calls += large[0]; };
+    EXPECT_TRUE(Task::IsInline<decltype(small_func)>());
+    EXPECT_FALSE(Task::IsInline<decltype(large_func)>());
+
+    Task small(small_func);
+    Task heap(large_func);
+    Task moved(std::move(small));
+    EXPECT_FALSE(small);
+    moved();
+    heap = std::move(moved);
+    EXPECT_FALSE(moved);
+    heap();
+    EXPECT_EQ(2, calls);
+
+    // Captures are destroyed along with task
+    std::shared_ptr<int> counter = std::make_shared<int>(0);
+    {
+        Task task([counter] { (*counter)++; });
+        EXPECT_EQ(2, counter.use_count());
+        task();
+    }
+    EXPECT_EQ(1, counter.use_count());
+    EXPECT_EQ(1, *counter);
+}
+
+TEST(ExecutorTest, MoveOnlyTask) {
+    std::atomic<int> done(0);
+    Executor executor("test", 1, 2, 16, 1000);
+    std::unique_ptr<int> value(new int(42));
+    ASSERT_TRUE(executor.Execute([&done](std::unique_ptr<int> &v) { done += *v; }, std::move(value)));
+    executor.Stop(true);
+    EXPECT_EQ(42, done.load());
+}
+
+TEST(ExecutorTest, NestedTasks) {
+    // Tasks submitted from pool threads go to their own deques and get stolen by others
+    std::atomic<int> done(0);
+    Executor executor("test", 4, 4, 1 << 16, 1000);
+    std::function<void(int)> spread = [&](int depth) {
+        done++;
+        if (depth > 0) {
+            executor.Execute(spread, depth - 1);
+            executor.Execute(spread, depth - 1);
+        }
+    };
+    ASSERT_TRUE(executor.Execute(spread, 14));
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (done.load() < (1 << 15) - 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    executor.Stop(true);
+    EXPECT_EQ((1 << 15) - 1, done.load());
+}
+
+TEST(ExecutorTest, Watermarks) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool release = false;
+    int running = 0;
+
+    // Pool grows up to high watermark, the rest waits in queue and anything above queue limit is refused
+    Executor executor("test", 1, 3, 5, 100);
+    auto task = [&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        running++;
+        cv.notify_all();
+        cv.wait(lock, [&] { return release; });
+    };
+    for (int i = 0; i < 5; i++) {
+        ASSERT_TRUE(executor.Execute(task));
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&] { return running == 3; }));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        EXPECT_EQ(3, running);
+    }
+
+    EXPECT_TRUE(executor.Execute(task));
+    EXPECT_TRUE(executor.Execute(task));
+    EXPECT_TRUE(executor.Execute(task));
+    EXPECT_FALSE(executor.Execute(task));
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        release = true;
+        cv.notify_all();
+    }
+    executor.Stop(true);
+    EXPECT_EQ(8, running);
+}
+
+TEST(ExecutorTest, IdleThreadsExit) {
+    // Threads above low watermark exit after idle time and pool grows back once there is work
+    std::atomic<int> done(0);
+    Executor executor("test", 0, 2, 100, 10);
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 10; i++) {
+            ASSERT_TRUE(executor.Execute([&done] { done++; }));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT_EQ(10 * (round + 1), done.load());
+    }
+    executor.Stop(true);
+}
+
+TEST(ExecutorTest, PublishMetrics) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool release = false;
+
+    auto stat = [](const std::string &name) -> uint64_t {
+        for (auto &s : Metrics::Instance().Collect()) {
+            if (s.first == name) {
+                return s.second;
+            }
+        }
+        return UINT64_MAX;
+    };
+
+    {
+        Executor executor("test", 1, 1, 2, 1000);
+        executor.PublishMetrics("test_pool");
+        EXPECT_EQ(1, stat("test_pool_threads_high_watermark"));
+        EXPECT_EQ(2, stat("test_pool_queue_limit"));
+
+        // The first task holds the only thread, two more wait in queue and the last one is refused
+        auto task = [&] {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return release; });
+        };
+        for (int i = 0; i < 4; i++) {
+            executor.Execute(task);
+            if (i == 0) {
+                while (stat("test_pool_queue_length") != 0) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        EXPECT_EQ(2, stat("test_pool_queue_length"));
+        EXPECT_EQ(2, stat("test_pool_queue_length_max"));
+        EXPECT_EQ(1, stat("test_pool_rejected"));
+        EXPECT_EQ(1, stat("test_pool_threads"));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            release = true;
+            cv.notify_all();
+        }
+        executor.Stop(true);
+
+        EXPECT_EQ(0, stat("test_pool_queue_length"));
+        EXPECT_EQ(3, stat("test_pool_wait_count"));
+        EXPECT_EQ(3, stat("test_pool_run_count"));
+        EXPECT_LE(20000000, stat("test_pool_wait_ns_max"));
+        EXPECT_LE(20000000, stat("test_pool_run_ns_max"));
+        EXPECT_LE(stat("test_pool_run_ns_p50"), stat("test_pool_run_ns_max"));
+    }
+    EXPECT_EQ(UINT64_MAX, stat("test_pool_threads"));
+}
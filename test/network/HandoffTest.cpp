@@ -0,0 +1,90 @@
+#include "gtest/gtest.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <afina/network/Config.h>
+
+#include "network/Handoff.h"
+#include "network/Socket.h"
+
+using namespace Afina::Network;
+
+static constexpr uint16_t kPort = 18114;
+
+TEST(HandoffTest, PassDescriptors) {
+    int channel[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, channel));
+    int pipe_fds[2];
+    ASSERT_EQ(0, pipe(pipe_fds));
+
+    send_handoff(channel[0], "takeover", {pipe_fds[1]});
+    send_handoff(channel[0], "");
+    close(pipe_fds[1]);
+
+    std::string message;
+    std::vector<int> fds;
+    ASSERT_TRUE(recv_handoff(channel[1], message, fds, 1000));
+    EXPECT_EQ(message, "takeover");
+    ASSERT_EQ(fds.size(), 1);
+
+    // Received descriptor refers to the same pipe
+    ASSERT_EQ(1, write(fds[0], "x", 1));
+    char c = 0;
+    ASSERT_EQ(1, read(pipe_fds[0], &c, 1));
+    EXPECT_EQ(c, 'x');
+    close(fds[0]);
+
+    ASSERT_TRUE(recv_handoff(channel[1], message, fds, 1000));
+    EXPECT_EQ(message, "");
+    EXPECT_TRUE(fds.empty());
+
+    // Nothing comes, then the peer is gone
+    EXPECT_FALSE(recv_handoff(channel[1], message, fds, 10));
+    close(channel[0]);
+    EXPECT_FALSE(recv_handoff(channel[1], message, fds, 1000));
+
+    close(channel[1]);
+    close(pipe_fds[0]);
+}
+
+TEST(HandoffTest, ListenSocketsSurvive) {
+    Config config;
+    std::vector<int> sockets = open_listen_sockets(kPort, config, true);
+    ASSERT_EQ(sockets.size(), 1);
+
+    // Connection queued before the handover
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(0, connect(client, (struct sockaddr *)&addr, sizeof(addr)));
+
+    std::vector<int> copies = handover_listen_sockets();
+    ASSERT_EQ(copies.size(), 1);
+    close_listen_sockets(sockets, config);
+
+    // New server takes the socket instead of binding the port once again
+    inherit_listen_sockets(copies);
+    sockets = open_listen_sockets(kPort, config, false);
+    ASSERT_EQ(sockets.size(), 1);
+    EXPECT_EQ(sockets[0], copies[0]);
+    close_inherited_sockets();
+
+    int accepted = accept(sockets[0], nullptr, nullptr);
+    ASSERT_NE(accepted, -1);
+    ASSERT_EQ(5, write(client, "hello", 5));
+    char buf[8] = {0};
+    ASSERT_EQ(5, read(accepted, buf, sizeof(buf)));
+    EXPECT_STREQ(buf, "hello");
+
+    close(accepted);
+    close(client);
+    close_listen_sockets(sockets, config);
+}
@@ -0,0 +1,70 @@
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <afina/Histogram.h>
+
+using namespace Afina;
+
+TEST(HistogramTest, Percentiles) {
+    Histogram histogram;
+    EXPECT_EQ(0, histogram.Percentile(0.5));
+
+    // Small values are exact
+    for (uint64_t i = 1; i <= 10; i++) {
+        histogram.Record(i);
+    }
+    EXPECT_EQ(10, histogram.count());
+    EXPECT_EQ(5, histogram.Percentile(0.5));
+    EXPECT_EQ(10, histogram.Percentile(1.0));
+    EXPECT_EQ(10, histogram.max());
+
+    // Large ones are within relative precision
+    histogram.Reset();
+    for (uint64_t i = 1; i <= 100000; i++) {
+        histogram.Record(i * 1000);
+    }
+    for (double p : {0.5, 0.9, 0.99, 0.999}) {
+        double expected = p * 100000 * 1000;
+        EXPECT_NEAR(expected, histogram.Percentile(p), expected / Histogram::kSubBuckets) << p;
+    }
+    EXPECT_EQ(100000000, histogram.Percentile(1.0));
+
+    // Values above the range are kept in the last bucket
+    histogram.Record(UINT64_MAX);
+    EXPECT_EQ(UINT64_MAX, histogram.max());
+}
+
+TEST(HistogramTest, Merge) {
+    Histogram a, b;
+    for (uint64_t i = 0; i < 100; i++) {
+        a.Record(100);
+        b.Record(10000);
+    }
+
+    Histogram merged(a);
+    merged.Merge(b);
+    EXPECT_EQ(200, merged.count());
+    EXPECT_EQ(10000, merged.max());
+    EXPECT_NEAR(100, merged.Percentile(0.5), 100 / Histogram::kSubBuckets);
+    EXPECT_NEAR(10000, merged.Percentile(0.99), 10000 / Histogram::kSubBuckets);
+    EXPECT_EQ(100, a.count());
+}
+
+TEST(HistogramTest, ConcurrentMax) {
+    Histogram histogram;
+    std::vector<std::thread> recorders;
+    for (uint64_t t = 0; t < 4; t++) {
+        recorders.emplace_back([&histogram, t] {
+            for (uint64_t i = 0; i < 100000; i++) {
+                histogram.Record(i * 4 + t);
+            }
+        });
+    }
+    for (auto &recorder : recorders) {
+        recorder.join();
+    }
+    EXPECT_EQ(400000, histogram.count());
+    EXPECT_EQ(399999, histogram.max());
+}
@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <afina/MpmcQueue.h>
+
+using namespace Afina;
+
+TEST(MpmcQueueTest, PushPop) {
+    MpmcQueue<int> queue(3);
+    EXPECT_EQ(4, queue.capacity());
+
+    int value;
+    EXPECT_FALSE(queue.Pop(value));
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.Push(i));
+    }
+    EXPECT_FALSE(queue.Push(4));
+    EXPECT_EQ(4, queue.size());
+
+    EXPECT_TRUE(queue.Pop(value));
+    EXPECT_EQ(0, value);
+    EXPECT_TRUE(queue.Push(4));
+
+    for (int i = 1; i < 5; i++) {
+        EXPECT_TRUE(queue.Pop(value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_FALSE(queue.Pop(value));
+    EXPECT_EQ(0, queue.size());
+}
+
+TEST(MpmcQueueTest, ConcurrentProducersConsumers) {
+    const int producers = 4;
+    const int consumers = 4;
+    const int n = 200000;
+    MpmcQueue<int> queue(64);
+    std::vector<std::atomic<int>> seen(producers * n);
+    for (auto &s : seen) {
+        s = 0;
+    }
+
+    std::atomic<int> popped(0);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, p, n] {
+            for (int i = 0; i < n; i++) {
+                while (!queue.Push(p * n + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Elements of each producer come out in the order they were pushed
+    std::vector<std::vector<int>> last(consumers, std::vector<int>(producers, -1));
+    std::atomic<bool> ordered(true);
+    for (int c = 0; c < consumers; c++) {
+        threads.emplace_back([&, c] {
+            while (popped.load() < producers * n) {
+                int value;
+                if (!queue.Pop(value)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                seen[value]++;
+                if (value % n <= last[c][value / n]) {
+                    ordered = false;
+                }
+                last[c][value / n] = value % n;
+                popped++;
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    EXPECT_TRUE(ordered.load());
+    for (int i = 0; i < producers * n; i++) {
+        ASSERT_EQ(1, seen[i].load()) << "element " << i;
+    }
+}
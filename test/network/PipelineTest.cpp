@@ -0,0 +1,150 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <afina/network/Config.h>
+
+#include "logging/ServiceImpl.h"
+#include "network/mt_nonblocking/ServerImpl.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+
+using namespace Afina;
+
+// Parameter is number of executor threads
+class PipelineTest : public ::testing::TestWithParam<uint32_t> {
+public:
+    // Logging service is shared by all tests of the fixture
+    static void SetUpTestCase() {
+        auto log_config = std::make_shared<Logging::Config>();
+        Logging::Appender &console = log_config->appenders["console"];
+        console.type = Logging::Appender::Type::STDERR;
+        Logging::Logger &logger = log_config->loggers["root"];
+        logger.level = Logging::Logger::Level::ERROR;
+        logger.appenders.push_back("console");
+
+        logging = std::make_shared<Logging::ServiceImpl>(log_config);
+        logging->Start();
+    }
+
+    static void TearDownTestCase() {
+        logging->Stop();
+        logging.reset();
+    }
+
+protected:
+    void SetUp() override {
+        Network::Config config;
+        config.executor_threads = GetParam();
+
+        storage = std::make_shared<Backend::ThreadSafeSimplLRU>(16 * 1024 * 1024);
+        server = std::make_shared<Network::MTnonblock::ServerImpl>(storage, logging, config);
+        server->Start(kPort, 1, 2);
+    }
+
+    void TearDown() override {
+        server->Stop();
+        server->Join();
+    }
+
+    int Connect() {
+        int sfd = socket(AF_INET, SOCK_STREAM, 0);
+        EXPECT_NE(-1, sfd);
+        struct timeval tv = {5, 0};
+        setsockopt(sfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(kPort);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        EXPECT_EQ(0, connect(sfd, (struct sockaddr *)&addr, sizeof(addr)));
+        return sfd;
+    }
+
+    // Reads exactly size bytes, returns what has been read before timeout otherwise
+    std::string Read(int sfd, std::size_t size) {
+        std::string result;
+        char buffer[4096];
+        while (result.size() < size) {
+            ssize_t n = recv(sfd, buffer, std::min(sizeof(buffer), size - result.size()), 0);
+            if (n <= 0) {
+                break;
+            }
+            result.append(buffer, n);
+        }
+        return result;
+    }
+
+    static constexpr uint16_t kPort = 18112;
+
+    static std::shared_ptr<Logging::ServiceImpl> logging;
+    std::shared_ptr<Backend::ThreadSafeSimplLRU> storage;
+    std::shared_ptr<Network::MTnonblock::ServerImpl> server;
+};
+
+std::shared_ptr<Logging::ServiceImpl> PipelineTest::logging;
+
+TEST_P(PipelineTest, ResponsesInOrder) {
+    // Values grow, so commands take different time and could complete out of order
+    std::string request, expected;
+    for (int i = 0; i < 2000; i++) {
+        std::string key = "key" + std::to_string(i % 50);
+        std::string value(1 + (i * 37) % 3000, 'a' + i % 26);
+        request += "set " + key + " 0 0 " + std::to_string(value.size()) + "\r\n" + value + "\r\n";
+        request += "get " + key + "\r\n";
+
+        // Stored value keeps trailing \r\n
+        expected += "STORED\r\n";
+        expected += "VALUE " + key + " 0 " + std::to_string(value.size() + 2) + "\r\n" + value + "\r\n\r\nEND\r\n";
+    }
+
+    // Server stops reading once client doesn't read responses, so they are read concurrently
+    int sfd = Connect();
+    std::string response;
+    std::thread reader([&] { response = Read(sfd, expected.size()); });
+
+    std::size_t sent = 0;
+    while (sent < request.size()) {
+        ssize_t n = send(sfd, request.data() + sent, request.size() - sent, 0);
+        if (n <= 0) {
+            break;
+        }
+        sent += n;
+    }
+    reader.join();
+    close(sfd);
+
+    EXPECT_EQ(request.size(), sent);
+    EXPECT_EQ(expected.size(), response.size());
+    EXPECT_TRUE(expected == response);
+}
+
+TEST_P(PipelineTest, DrainOnStop) {
+    int sfd = Connect();
+    std::string request;
+    for (int i = 0; i < 100; i++) {
+        request += "get missing\r\n";
+    }
+    ASSERT_EQ(request.size(), send(sfd, request.data(), request.size(), 0));
+
+    // First response means all commands have been read, the rest must be sent before server stops
+    EXPECT_EQ("END\r\n", Read(sfd, 5));
+    server->Stop();
+
+    std::string expected;
+    for (int i = 1; i < 100; i++) {
+        expected += "END\r\n";
+    }
+    EXPECT_EQ(expected, Read(sfd, expected.size()));
+    close(sfd);
+}
+
+INSTANTIATE_TEST_CASE_P(Executor, PipelineTest, ::testing::Values(0, 1, 4));
@@ -0,0 +1,53 @@
+#include "gtest/gtest.h"
+#include <thread>
+
+#include "network/SpscQueue.h"
+
+using namespace Afina::Network;
+
+TEST(SpscQueueTest, PushPop) {
+    SpscQueue<int> queue(3);
+    EXPECT_EQ(4, queue.capacity());
+
+    int value;
+    EXPECT_FALSE(queue.Pop(value));
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.Push(i));
+    }
+    EXPECT_FALSE(queue.Push(4));
+
+    EXPECT_TRUE(queue.Pop(value));
+    EXPECT_EQ(0, value);
+    EXPECT_TRUE(queue.Push(4));
+
+    for (int i = 1; i < 5; i++) {
+        EXPECT_TRUE(queue.Pop(value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_FALSE(queue.Pop(value));
+}
+
+TEST(SpscQueueTest, ConcurrentOrder) {
+    const int n = 1000000;
+    SpscQueue<int> queue(64);
+
+    std::thread producer([&queue, n] {
+        for (int i = 0; i < n; i++) {
+            while (!queue.Push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int expected = 0;
+    while (expected < n) {
+        int value;
+        if (queue.Pop(value)) {
+            ASSERT_EQ(expected, value);
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+}
@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "network/TimerWheel.h"
+
+using namespace Afina::Network;
+
+static std::vector<TimerWheel::Timer *> advance(TimerWheel &wheel) {
+    std::vector<TimerWheel::Timer *> expired;
+    wheel.Advance([&expired](TimerWheel::Timer *timer) { expired.push_back(timer); });
+    return expired;
+}
+
+TEST(TimerWheelTest, Empty) {
+    TimerWheel wheel(10, 8);
+    EXPECT_EQ(-1, wheel.NextTimeout());
+    EXPECT_TRUE(advance(wheel).empty());
+}
+
+TEST(TimerWheelTest, Expire) {
+    TimerWheel wheel(10, 8);
+    TimerWheel::Timer fast, slow;
+    wheel.Schedule(&fast, 20);
+    wheel.Schedule(&slow, 1000);
+    EXPECT_EQ(2, wheel.size());
+    EXPECT_GE(wheel.NextTimeout(), 0);
+    EXPECT_TRUE(advance(wheel).empty());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto expired = advance(wheel);
+    ASSERT_EQ(1, expired.size());
+    EXPECT_EQ(&fast, expired[0]);
+    EXPECT_FALSE(fast.linked);
+    EXPECT_TRUE(slow.linked);
+    EXPECT_EQ(1, wheel.size());
+}
+
+TEST(TimerWheelTest, MultipleRounds) {
+    // Deadline is farther than single wheel rotation
+    TimerWheel wheel(5, 4);
+    TimerWheel::Timer timer;
+    wheel.Schedule(&timer, 60);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_TRUE(advance(wheel).empty());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(1, advance(wheel).size());
+}
+
+TEST(TimerWheelTest, RescheduleAndCancel) {
+    TimerWheel wheel(10, 8);
+    TimerWheel::Timer a, b;
+    wheel.Schedule(&a, 20);
+    wheel.Schedule(&b, 20);
+    wheel.Schedule(&a, 1000);
+    wheel.Cancel(&b);
+    wheel.Cancel(&b);
+    EXPECT_EQ(1, wheel.size());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_TRUE(advance(wheel).empty());
+
+    wheel.Cancel(&a);
+    EXPECT_EQ(0, wheel.size());
+    EXPECT_EQ(-1, wheel.NextTimeout());
+}
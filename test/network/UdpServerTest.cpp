@@ -0,0 +1,181 @@
+#include "gtest/gtest.h"
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <afina/network/Config.h>
+
+#include "logging/ServiceImpl.h"
+#include "network/udp/Frame.h"
+#include "network/udp/ServerImpl.h"
+#include "storage/SimpleLRU.h"
+
+using namespace Afina;
+using namespace Afina::Network::UDP;
+
+class UdpServerTest : public ::testing::Test {
+protected:
+    // Logging service is shared by all tests of the fixture
+    static void SetUpTestCase() {
+        auto log_config = std::make_shared<Logging::Config>();
+        Logging::Appender &console = log_config->appenders["console"];
+        console.type = Logging::Appender::Type::STDERR;
+        Logging::Logger &logger = log_config->loggers["root"];
+        logger.level = Logging::Logger::Level::ERROR;
+        logger.appenders.push_back("console");
+
+        logging = std::make_shared<Logging::ServiceImpl>(log_config);
+        logging->Start();
+    }
+
+    static void TearDownTestCase() {
+        logging->Stop();
+        logging.reset();
+    }
+
+    void SetUp() override {
+        storage = std::make_shared<Backend::SimpleLRU>(16 * 1024 * 1024);
+        server = std::make_shared<ServerImpl>(storage, logging, Network::Config());
+        server->Start(kPort, 1, 1);
+
+        client = socket(AF_INET, SOCK_DGRAM, 0);
+        ASSERT_NE(-1, client);
+        struct timeval tv = {2, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(kPort);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ASSERT_EQ(0, connect(client, (struct sockaddr *)&addr, sizeof(addr)));
+    }
+
+    void TearDown() override {
+        close(client);
+        server->Stop();
+        server->Join();
+    }
+
+    void Send(uint16_t request_id, const std::string &payload, uint16_t total = 1) {
+        FrameHeader header;
+        header.request_id = request_id;
+        header.total = total;
+
+        std::string datagram(FrameHeader::kSize, '\0');
+        header.Write(&datagram[0]);
+        datagram += payload;
+        ASSERT_EQ(datagram.size(), send(client, datagram.data(), datagram.size(), 0));
+    }
+
+    // Reads all frames of response and glues them together in sequence order
+    std::string Receive(uint16_t request_id) {
+        std::vector<std::string> frames;
+        std::size_t received = 0;
+        do {
+            char buffer[2048];
+            ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+            if (n == -1) {
+                ADD_FAILURE() << "Response timed out";
+                return "";
+            }
+
+            FrameHeader header;
+            EXPECT_TRUE(header.Read(buffer, n));
+            EXPECT_LE(n, kMaxFrameSize);
+            EXPECT_EQ(request_id, header.request_id);
+            EXPECT_EQ(0, header.reserved);
+            if (frames.empty()) {
+                frames.resize(header.total);
+            }
+            EXPECT_EQ(frames.size(), header.total);
+            EXPECT_LT(header.sequence, frames.size());
+            EXPECT_TRUE(frames[header.sequence].empty());
+            frames[header.sequence].assign(buffer + FrameHeader::kSize, n - FrameHeader::kSize);
+            received++;
+        } while (received < frames.size());
+
+        std::string result;
+        for (auto &frame : frames) {
+            result += frame;
+        }
+        return result;
+    }
+
+    static constexpr uint16_t kPort = 18111;
+
+    static std::shared_ptr<Logging::ServiceImpl> logging;
+    std::shared_ptr<Backend::SimpleLRU> storage;
+    std::shared_ptr<ServerImpl> server;
+    int client;
+};
+
+std::shared_ptr<Logging::ServiceImpl> UdpServerTest::logging;
+
+TEST(UdpFrameTest, Header) {
+    FrameHeader header;
+    header.request_id = 0x1234;
+    header.sequence = 2;
+    header.total = 0xabcd;
+
+    char data[FrameHeader::kSize];
+    header.Write(data);
+    EXPECT_EQ(0, std::memcmp(data, "\x12\x34\x00\x02\xab\xcd\x00\x00", sizeof(data)));
+
+    FrameHeader read;
+    EXPECT_FALSE(read.Read(data, sizeof(data) - 1));
+    EXPECT_TRUE(read.Read(data, sizeof(data)));
+    EXPECT_EQ(0x1234, read.request_id);
+    EXPECT_EQ(2, read.sequence);
+    EXPECT_EQ(0xabcd, read.total);
+
+    EXPECT_EQ(1, frames_count(0));
+    EXPECT_EQ(1, frames_count(kMaxFramePayload));
+    EXPECT_EQ(2, frames_count(kMaxFramePayload + 1));
+}
+
+TEST_F(UdpServerTest, Get) {
+    storage->Put("k1", "v1");
+    storage->Put("k2", "value2");
+
+    Send(7, "get k1\r\n");
+    EXPECT_EQ("VALUE k1 0 2\r\nv1\r\nEND\r\n", Receive(7));
+
+    Send(8, "get k1 missing k2\r\nget k2\r\n");
+    EXPECT_EQ("VALUE k1 0 2\r\nv1\r\nVALUE k2 0 6\r\nvalue2\r\nEND\r\nVALUE k2 0 6\r\nvalue2\r\nEND\r\n", Receive(8));
+}
+
+TEST_F(UdpServerTest, LargeValue) {
+    std::string value;
+    for (int i = 0; value.size() < 10 * kMaxFramePayload; i++) {
+        value += std::to_string(i) + ",";
+    }
+    storage->Put("large", value);
+
+    Send(0xfffe, "get large\r\n");
+    EXPECT_EQ("VALUE large 0 " + std::to_string(value.size()) + "\r\n" + value + "\r\nEND\r\n", Receive(0xfffe));
+}
+
+TEST_F(UdpServerTest, Errors) {
+    Send(1, "set k 0 0 1\r\nv\r\n");
+    EXPECT_EQ("CLIENT_ERROR only get is supported over UDP\r\n", Receive(1));
+
+    Send(2, "get k");
+    EXPECT_EQ("CLIENT_ERROR incomplete command\r\n", Receive(2));
+
+    Send(3, "bogus\r\n");
+    EXPECT_EQ("ERROR\r\n", Receive(3));
+
+    // Multi frame requests and garbage are dropped, server keeps serving after that
+    Send(4, "get k\r\n", 2);
+    ASSERT_EQ(3, send(client, "abc", 3, 0));
+    storage->Put("k", "v");
+    Send(5, "get k\r\n");
+    EXPECT_EQ("VALUE k 0 1\r\nv\r\nEND\r\n", Receive(5));
+}
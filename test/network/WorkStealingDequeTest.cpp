@@ -0,0 +1,77 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <afina/WorkStealingDeque.h>
+
+using namespace Afina;
+
+TEST(WorkStealingDequeTest, OwnerLifoThiefFifo) {
+    WorkStealingDeque<int> deque(3);
+    EXPECT_EQ(4, deque.capacity());
+
+    int values[5] = {0, 1, 2, 3, 4};
+    EXPECT_EQ(nullptr, deque.Take());
+    EXPECT_EQ(nullptr, deque.Steal());
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(deque.Push(&values[i]));
+    }
+    EXPECT_FALSE(deque.Push(&values[4]));
+    EXPECT_EQ(4, deque.size());
+
+    EXPECT_EQ(&values[3], deque.Take());
+    EXPECT_EQ(&values[0], deque.Steal());
+    EXPECT_EQ(&values[2], deque.Take());
+    EXPECT_EQ(&values[1], deque.Steal());
+    EXPECT_EQ(nullptr, deque.Take());
+    EXPECT_EQ(nullptr, deque.Steal());
+    EXPECT_EQ(0, deque.size());
+}
+
+TEST(WorkStealingDequeTest, ConcurrentSteal) {
+    const int n = 200000;
+    const int thieves = 3;
+    WorkStealingDeque<int> deque(256);
+    std::vector<int> values(n);
+    std::vector<std::atomic<int>> seen(n);
+    for (int i = 0; i < n; i++) {
+        values[i] = i;
+        seen[i] = 0;
+    }
+
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thieves; t++) {
+        threads.emplace_back([&] {
+            while (!done || deque.size() > 0) {
+                int *value = deque.Steal();
+                if (value != nullptr) {
+                    seen[*value]++;
+                }
+            }
+        });
+    }
+
+    // Owner pushes everything and takes some elements itself
+    for (int i = 0; i < n; i++) {
+        while (!deque.Push(&values[i])) {
+            int *value = deque.Take();
+            if (value != nullptr) {
+                seen[*value]++;
+            }
+        }
+    }
+    int *value;
+    while ((value = deque.Take()) != nullptr) {
+        seen[*value]++;
+    }
+    done = true;
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    for (int i = 0; i < n; i++) {
+        ASSERT_EQ(1, seen[i].load()) << "element " << i;
+    }
+}
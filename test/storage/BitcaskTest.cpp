@@ -0,0 +1,271 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include "storage/BitcaskStorage.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+class BitcaskTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char path[] = "/tmp/afina_bitcask_XXXXXX";
+        ASSERT_NE(mkdtemp(path), nullptr);
+        dir = path;
+    }
+
+    void TearDown() override {
+        for (auto &name : files()) {
+            unlink((dir + "/" + name).c_str());
+        }
+        rmdir(dir.c_str());
+    }
+
+    vector<string> files(const string &suffix = "") const {
+        vector<string> result;
+        DIR *d = opendir(dir.c_str());
+        for (struct dirent *entry = readdir(d); entry != nullptr; entry = readdir(d)) {
+            string name = entry->d_name;
+            if (name != "." && name != ".." && name.size() >= suffix.size() &&
+                name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+                result.push_back(name);
+            }
+        }
+        closedir(d);
+        return result;
+    }
+
+    string dir;
+};
+
+TEST_F(BitcaskTest, PutGetDelete) {
+    {
+        BitcaskStorage storage(dir, 1024 * 1024);
+        storage.Start();
+        EXPECT_TRUE(storage.Put("KEY1", "val1"));
+        EXPECT_TRUE(storage.Put("KEY2", "val2"));
+        EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val3"));
+        EXPECT_TRUE(storage.PutIfAbsent("KEY3", "val3"));
+        EXPECT_FALSE(storage.Set("KEY4", "val4"));
+        EXPECT_TRUE(storage.Set("KEY2", "val22"));
+        EXPECT_TRUE(storage.Delete("KEY1"));
+        EXPECT_FALSE(storage.Delete("KEY1"));
+        EXPECT_TRUE(storage.Put("", "empty key"));
+        EXPECT_TRUE(storage.Put("empty value", ""));
+
+        string value;
+        EXPECT_FALSE(storage.Get("KEY1", value));
+        EXPECT_TRUE(storage.Get("KEY2", value));
+        EXPECT_EQ(value, "val22");
+        EXPECT_EQ(storage.size(), 4);
+        storage.Stop();
+    }
+
+    // Index is rebuilt from the hint
+    EXPECT_EQ(files(".hint").size(), 1);
+    BitcaskStorage storage(dir, 1024 * 1024);
+    storage.Start();
+    string value;
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ(value, "val22");
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_EQ(value, "val3");
+    EXPECT_TRUE(storage.Get("", value));
+    EXPECT_EQ(value, "empty key");
+    EXPECT_TRUE(storage.Get("empty value", value));
+    EXPECT_EQ(value, "");
+    EXPECT_EQ(storage.size(), 4);
+    storage.Stop();
+}
+
+TEST_F(BitcaskTest, TornSegment) {
+    {
+        BitcaskStorage storage(dir, 1024 * 1024);
+        storage.Start();
+        for (int i = 0; i < 100; i++) {
+            EXPECT_TRUE(storage.Put("key" + to_string(i), string(100, 'a' + i % 26)));
+        }
+        storage.Stop();
+    }
+
+    // Crashed process leaves no hint and half written record
+    for (auto &name : files(".hint")) {
+        unlink((dir + "/" + name).c_str());
+    }
+    vector<string> segments = files(".data");
+    ASSERT_EQ(segments.size(), 1);
+    {
+        ofstream file(dir + "/" + segments[0], ios::app | ios::binary);
+        file << "torn";
+    }
+
+    BitcaskStorage storage(dir, 1024 * 1024);
+    storage.Start();
+    EXPECT_EQ(storage.size(), 100);
+    string value;
+    EXPECT_TRUE(storage.Get("key99", value));
+    EXPECT_EQ(value, string(100, 'a' + 99 % 26));
+    EXPECT_EQ(files(".hint").size(), 1);
+    storage.Stop();
+}
+
+TEST_F(BitcaskTest, Compaction) {
+    BitcaskStorage storage(dir, 1024 * 1024, 4096, chrono::milliseconds(0));
+    storage.Start();
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 50; i++) {
+            ASSERT_TRUE(storage.Put("key" + to_string(i), to_string(round) + string(20, 'x')));
+        }
+    }
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(storage.Delete("key" + to_string(i)));
+    }
+    EXPECT_GT(storage.segments(), 10);
+    uint64_t before = storage.disk_bytes();
+    EXPECT_GT(storage.dead_bytes(), before / 2);
+
+    // Live records are copied once, dead ones are gone with their segments
+    EXPECT_EQ(storage.Compact(), 40);
+    EXPECT_LT(storage.disk_bytes(), before / 10);
+    EXPECT_EQ(storage.dead_bytes(), 0);
+    EXPECT_LE(storage.segments(), 3);
+    EXPECT_EQ(files(".data").size(), storage.segments());
+
+    string value;
+    for (int i = 0; i < 50; i++) {
+        EXPECT_EQ(storage.Get("key" + to_string(i), value), i >= 10);
+        if (i >= 10) {
+            EXPECT_EQ(value, "19" + string(20, 'x'));
+        }
+    }
+
+    // Writes after the merge are newer than merged records on restart
+    EXPECT_TRUE(storage.Put("key20", "new"));
+    EXPECT_TRUE(storage.Delete("key30"));
+    storage.Stop();
+
+    BitcaskStorage restarted(dir, 1024 * 1024, 4096, chrono::milliseconds(0));
+    restarted.Start();
+    EXPECT_EQ(restarted.size(), 39);
+    EXPECT_TRUE(restarted.Get("key20", value));
+    EXPECT_EQ(value, "new");
+    EXPECT_FALSE(restarted.Get("key30", value));
+    EXPECT_FALSE(restarted.Get("key5", value));
+    restarted.Stop();
+}
+
+TEST_F(BitcaskTest, CompactionWithWriters) {
+    BitcaskStorage storage(dir, 16 * 1024 * 1024, 16 * 1024, chrono::milliseconds(1));
+    storage.Start();
+
+    // Background merges run while keys are overwritten and read
+    atomic<bool> failed(false);
+    vector<thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&storage, &failed, t] {
+            string value;
+            for (int round = 0; round < 50; round++) {
+                for (int i = 0; i < 50; i++) {
+                    string key = "key" + to_string(t) + "_" + to_string(i);
+                    storage.Put(key, to_string(round));
+                    if (!storage.Get(key, value) || value != to_string(round)) {
+                        failed = true;
+                    }
+                }
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    EXPECT_FALSE(failed);
+    storage.Stop();
+
+    BitcaskStorage restarted(dir, 16 * 1024 * 1024, 16 * 1024, chrono::milliseconds(0));
+    restarted.Start();
+    EXPECT_EQ(restarted.size(), 200);
+    string value;
+    for (int t = 0; t < 4; t++) {
+        for (int i = 0; i < 50; i++) {
+            EXPECT_TRUE(restarted.Get("key" + to_string(t) + "_" + to_string(i), value));
+            EXPECT_EQ(value, "49");
+        }
+    }
+    restarted.Stop();
+}
+
+TEST_F(BitcaskTest, EmptySegment) {
+    {
+        BitcaskStorage storage(dir, 1024 * 1024);
+        storage.Start();
+        EXPECT_TRUE(storage.Put("KEY1", "val1"));
+        storage.Stop();
+    }
+
+    // Crash right after segment creation leaves files without magic
+    { ofstream file(dir + "/00000000000002097152.data", ios::binary); }
+    {
+        ofstream file(dir + "/00000000000003145728.data", ios::binary);
+        file << "AFB";
+    }
+
+    BitcaskStorage storage(dir, 1024 * 1024);
+    storage.Start();
+    EXPECT_EQ(storage.size(), 1);
+    EXPECT_EQ(storage.segments(), 2);
+    string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(value, "val1");
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    storage.Stop();
+    EXPECT_EQ(files(".data").size(), 2);
+}
+
+TEST_F(BitcaskTest, Scan) {
+    BitcaskStorage storage(dir, 16 * 1024 * 1024, 64 * 1024);
+    storage.Start();
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(storage.Put("key" + to_string(i), "value" + to_string(i)));
+    }
+    EXPECT_TRUE(storage.Delete("key0"));
+
+    // Keys added meanwhile rehash the index, keys present all the time are still visited
+    map<string, string> visited;
+    string cursor;
+    int added = 0;
+    while (storage.Scan(cursor, 10, [&visited](const string &key, const string &value) { visited[key] = value; })) {
+        EXPECT_TRUE(storage.Put("new" + to_string(added++), "value"));
+    }
+    for (int i = 1; i < 1000; i++) {
+        EXPECT_EQ(visited["key" + to_string(i)], "value" + to_string(i));
+    }
+    EXPECT_EQ(visited.count("key0"), 0);
+    storage.Stop();
+}
+
+TEST_F(BitcaskTest, MemoryLimit) {
+    BitcaskStorage storage(dir, 4096);
+    storage.Start();
+    int stored = 0;
+    while (storage.Put("key" + to_string(stored), "value") && stored < 1000) {
+        stored++;
+    }
+    EXPECT_GT(stored, 10);
+    EXPECT_LT(stored, 1000);
+
+    // Known keys are still updated and deleted
+    EXPECT_TRUE(storage.Put("key0", "other"));
+    EXPECT_TRUE(storage.Delete("key1"));
+    EXPECT_TRUE(storage.Put("key1", "value"));
+    storage.Stop();
+}
@@ -0,0 +1,207 @@
+#include "gtest/gtest.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "storage/ShardedSlabLRU.h"
+#include "storage/SlabLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(SlabLRUTest, PutGetDelete) {
+    SlabLRU storage(1024 * 1024);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.Put("KEY2", "val2"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY1", "val3"));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY3", "val3"));
+    EXPECT_FALSE(storage.Set("KEY4", "val4"));
+    EXPECT_TRUE(storage.Set("KEY2", "val22"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(value, "val1");
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ(value, "val22");
+    EXPECT_TRUE(storage.Get("KEY3", value));
+    EXPECT_EQ(value, "val3");
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_EQ(storage.size(), 2);
+}
+
+TEST(SlabLRUTest, ChangeClass) {
+    SlabLRU storage(1024 * 1024);
+
+    std::string value;
+    for (size_t size : {1, 100, 5000, 10, 20000, 0}) {
+        EXPECT_TRUE(storage.Put("KEY", std::string(size, 'x')));
+        EXPECT_TRUE(storage.Get("KEY", value));
+        EXPECT_EQ(value, std::string(size, 'x'));
+    }
+    EXPECT_EQ(storage.size(), 1);
+
+    // Larger than the page
+    EXPECT_FALSE(storage.Put("BIG", std::string(1024 * 1024, 'x')));
+    EXPECT_FALSE(storage.Get("BIG", value));
+
+    // Failed update keeps the old value
+    EXPECT_FALSE(storage.Put("KEY", std::string(1024 * 1024, 'x')));
+    EXPECT_FALSE(storage.Set("KEY", std::string(1024 * 1024, 'x')));
+    EXPECT_TRUE(storage.Get("KEY", value));
+    EXPECT_EQ(value, "");
+    EXPECT_EQ(storage.size(), 1);
+}
+
+TEST(SlabLRUTest, EvictsLeastRecentlyUsed) {
+    SlabLRU storage(1024 * 1024);
+
+    // Keys of the same length, so that all items are of the same class
+    auto key = [](int i) {
+        std::string s = std::to_string(i);
+        return "Key " + std::string(6 - s.size(), '0') + s;
+    };
+
+    const int count = 100000;
+    for (int i = 0; i < count; i++) {
+        ASSERT_TRUE(storage.Put(key(i), "Val " + key(i)));
+
+        // Keep the first key hot
+        std::string value;
+        ASSERT_TRUE(storage.Get(key(0), value));
+    }
+    ASSERT_LT(storage.size(), count);
+
+    std::string value;
+    EXPECT_TRUE(storage.Get(key(0), value));
+    EXPECT_EQ(value, "Val " + key(0));
+    EXPECT_FALSE(storage.Get(key(1), value));
+
+    // Whatever survived is the most recent ones
+    int first = count - storage.size() + 1;
+    for (int i = first; i < count; i++) {
+        ASSERT_TRUE(storage.Get(key(i), value));
+        EXPECT_EQ(value, "Val " + key(i));
+    }
+}
+
+TEST(SlabLRUTest, ClassesShareMemory) {
+    SlabLRU storage(1024 * 1024);
+
+    // Fill the whole cache with small items, large one still gets a page from them
+    for (int i = 0; i < 50000; i++) {
+        ASSERT_TRUE(storage.Put("Small " + std::to_string(i), "v"));
+    }
+    EXPECT_EQ(storage.allocator().spare_pages(), 0);
+    size_t small = storage.size();
+
+    std::string big(20000, 'x'), value;
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(storage.Put("Big " + std::to_string(i), big));
+    }
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(storage.Get("Big " + std::to_string(i), value));
+        EXPECT_EQ(value, big);
+    }
+
+    // Only the pages big ones took were evicted
+    EXPECT_GT(storage.size() - 10, small / 2);
+}
+
+TEST(SlabLRUTest, MemoryAccounting) {
+    SlabLRU storage(1024 * 1024);
+    size_t index = storage.physical_size();
+
+    storage.Put("KEY1", "v");
+    storage.Put("KEY2", std::string(1000, 'v'));
+    EXPECT_EQ(storage.logical_size(), 4 + 1 + 4 + 1000);
+    EXPECT_GT(storage.physical_size(), index + storage.logical_size());
+
+    storage.Put("KEY2", "v");
+    EXPECT_EQ(storage.logical_size(), 2 * 5);
+
+    storage.Delete("KEY1");
+    storage.Delete("KEY2");
+    EXPECT_EQ(storage.logical_size(), 0);
+    EXPECT_EQ(storage.physical_size(), index);
+}
+
+TEST(SlabLRUTest, Preallocated) {
+    SlabLRU storage(4 * 1024 * 1024, Afina::Allocator::Mapping::kPopulate | Afina::Allocator::Mapping::kHugePages);
+
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(storage.Put("key" + to_string(i), string(1000, 'a' + i % 26)));
+    }
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("key999", value));
+    EXPECT_EQ(value, string(1000, 'a' + 999 % 26));
+}
+
+TEST(SlabLRUTest, SharedArea) {
+    int fd;
+    size_t physical;
+    {
+        SlabLRU storage(4 * 1024 * 1024, Afina::Allocator::Mapping::kShared);
+        for (int i = 0; i < 3000; i++) {
+            ASSERT_TRUE(storage.Put("key" + to_string(i), string(i % 700, 'a' + i % 26)));
+        }
+        EXPECT_TRUE(storage.Delete("key0"));
+        physical = storage.physical_size();
+        fd = dup(storage.memory_fd());
+        ASSERT_NE(fd, -1);
+    }
+
+    // The area outlives the instance while its file is open
+    SlabLRU storage(SlabLRU::MemoryFile{fd});
+    EXPECT_EQ(storage.physical_size(), physical);
+    std::string value;
+    EXPECT_FALSE(storage.Get("key0", value));
+    for (int i = 1; i < 3000; i++) {
+        ASSERT_TRUE(storage.Get("key" + to_string(i), value));
+        EXPECT_EQ(value, string(i % 700, 'a' + i % 26));
+    }
+
+    // Allocator and LRU lists are usable after attach
+    for (int i = 3000; i < 6000; i++) {
+        EXPECT_TRUE(storage.Put("key" + to_string(i), string(i % 700, 'a' + i % 26)));
+    }
+    EXPECT_TRUE(storage.Get("key5999", value));
+    EXPECT_LE(storage.physical_size(), 4 * 1024 * 1024);
+
+    int file = open("/dev/null", O_RDWR);
+    EXPECT_THROW(SlabLRU(SlabLRU::MemoryFile{file}), std::runtime_error);
+}
+
+TEST(SlabLRUTest, Sharded) {
+    ShardedSlabLRU storage(4 * 1024 * 1024, 0, {-1, -1, -1});
+    ASSERT_EQ(storage.shards(), 3);
+
+    for (int i = 0; i < 3000; i++) {
+        EXPECT_TRUE(storage.Put("key" + to_string(i), "val" + to_string(i)));
+    }
+    EXPECT_EQ(storage.size(), 3000);
+
+    // Keys are spread evenly and each one is found in its shard only
+    for (std::size_t i = 0; i < storage.shards(); i++) {
+        EXPECT_GT(storage.shard(i).size(), 800);
+    }
+
+    std::string value;
+    for (int i = 0; i < 3000; i++) {
+        EXPECT_TRUE(storage.Get("key" + to_string(i), value));
+        EXPECT_EQ(value, "val" + to_string(i));
+    }
+    EXPECT_TRUE(storage.Set("key1", "new"));
+    EXPECT_TRUE(storage.Get("key1", value));
+    EXPECT_EQ(value, "new");
+    EXPECT_TRUE(storage.Delete("key1"));
+    EXPECT_FALSE(storage.Get("key1", value));
+    EXPECT_EQ(storage.size(), 2999);
+}
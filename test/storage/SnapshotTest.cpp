@@ -0,0 +1,177 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <unistd.h>
+
+#include "storage/Checksum.h"
+#include "storage/ShardedSlabLRU.h"
+#include "storage/SimpleLRU.h"
+#include "storage/SlabLRU.h"
+#include "storage/SnapshotStorage.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/ThreadSafeSlabLRU.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+static map<string, string> scan_all(Afina::Storage &storage, std::size_t batch) {
+    map<string, string> items;
+    string cursor;
+    while (storage.Scan(cursor, batch, [&](const string &key, const string &value) { items[key] = value; })) {
+    }
+    return items;
+}
+
+static string temp_path() {
+    char path[] = "/tmp/afina_snapshot_XXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+    unlink(path);
+    return path;
+}
+
+TEST(SnapshotTest, Crc32c) {
+    EXPECT_EQ(Crc32c("123456789", 9), 0xE3069283);
+    EXPECT_EQ(Crc32c("6789", 4, Crc32c("12345", 5)), 0xE3069283);
+    EXPECT_EQ(Crc32c("", 0), 0);
+}
+
+TEST(SnapshotTest, ScanVisitsEverything) {
+    SimpleLRU simple(1024 * 1024);
+    SlabLRU slab(4 * 1024 * 1024);
+    ShardedSlabLRU sharded(4 * 1024 * 1024, 0, {-1, -1});
+
+    map<string, string> expected;
+    expected[""] = "empty key";
+    for (int i = 0; i < 2000; i++) {
+        expected["key" + to_string(i)] = "value" + to_string(i);
+    }
+    for (Afina::Storage *storage : {static_cast<Afina::Storage *>(&simple), static_cast<Afina::Storage *>(&slab),
+                                    static_cast<Afina::Storage *>(&sharded)}) {
+        for (auto &item : expected) {
+            ASSERT_TRUE(storage->Put(item.first, item.second));
+        }
+        EXPECT_EQ(scan_all(*storage, 1), expected);
+        EXPECT_EQ(scan_all(*storage, 100), expected);
+    }
+}
+
+TEST(SnapshotTest, ScanWhileGrowing) {
+    SlabLRU storage(16 * 1024 * 1024);
+    for (int i = 0; i < 100; i++) {
+        storage.Put("old" + to_string(i), "v");
+    }
+
+    // Index grows under the cursor, items present from the beginning are still seen
+    map<string, string> items;
+    string cursor;
+    int added = 0;
+    while (storage.Scan(cursor, 10, [&](const string &key, const string &value) { items[key] = value; })) {
+        for (int i = 0; i < 1000 && added < 50000; i++) {
+            storage.Put("new" + to_string(added++), "v");
+        }
+    }
+    EXPECT_EQ(storage.size(), 50100);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(items.count("old" + to_string(i)), 1);
+    }
+}
+
+TEST(SnapshotTest, DumpLoad) {
+    string path = temp_path();
+    ThreadSafeSlabLRU source(64 * 1024 * 1024);
+    map<string, string> expected;
+    for (int i = 0; i < 20000; i++) {
+        string key = "key" + to_string(i);
+        expected[key] = string(i % 500, 'a' + i % 26);
+        ASSERT_TRUE(source.Put(key, expected[key]));
+    }
+
+    EXPECT_EQ(SnapshotStorage::Dump(source, path), expected.size());
+
+    // Several blocks decoded by several threads
+    ThreadSafeSimplLRU target(64 * 1024 * 1024);
+    SnapshotStorage::LoadStats stats = SnapshotStorage::Load(path, target, 4);
+    EXPECT_GT(stats.blocks, 2);
+    EXPECT_EQ(stats.items, expected.size());
+    EXPECT_EQ(stats.bad_blocks, 0);
+    EXPECT_TRUE(stats.complete);
+    EXPECT_EQ(scan_all(target, 1000), expected);
+
+    unlink(path.c_str());
+}
+
+TEST(SnapshotTest, DamagedFile) {
+    string path = temp_path();
+    ThreadSafeSlabLRU source(64 * 1024 * 1024);
+    for (int i = 0; i < 20000; i++) {
+        source.Put("key" + to_string(i), string(200, 'x'));
+    }
+    SnapshotStorage::Dump(source, path);
+
+    // Flip a byte inside of the first block
+    {
+        fstream file(path, ios::in | ios::out | ios::binary);
+        file.seekp(100);
+        file.put('#');
+    }
+    ThreadSafeSlabLRU target(64 * 1024 * 1024);
+    SnapshotStorage::LoadStats stats = SnapshotStorage::Load(path, target, 2);
+    EXPECT_EQ(stats.bad_blocks, 1);
+    EXPECT_TRUE(stats.complete);
+    EXPECT_GT(stats.items, 0);
+    EXPECT_LT(stats.items, 20000);
+
+    // Cut the file in the middle of the last block
+    ASSERT_EQ(truncate(path.c_str(), SnapshotStorage::kBlockSize * 2), 0);
+    ThreadSafeSlabLRU truncated(64 * 1024 * 1024);
+    stats = SnapshotStorage::Load(path, truncated, 2);
+    EXPECT_FALSE(stats.complete);
+    EXPECT_EQ(stats.blocks, 1);
+
+    // Not a snapshot at all
+    {
+        ofstream file(path, ios::trunc);
+        file << "garbage garbage garbage";
+    }
+    EXPECT_THROW(SnapshotStorage::Load(path, truncated, 2), std::runtime_error);
+
+    // Nothing to load on the first start
+    unlink(path.c_str());
+    stats = SnapshotStorage::Load(path, truncated, 2);
+    EXPECT_EQ(stats.items, 0);
+    EXPECT_EQ(stats.blocks, 0);
+}
+
+TEST(SnapshotTest, Restart) {
+    string path = temp_path();
+    {
+        SnapshotStorage storage(make_shared<ThreadSafeSlabLRU>(4 * 1024 * 1024), path, chrono::milliseconds(0), true);
+        storage.Start();
+        EXPECT_TRUE(storage.Put("KEY1", "val1"));
+        EXPECT_TRUE(storage.Put("KEY2", "val2"));
+        storage.Stop();
+    }
+    {
+        SnapshotStorage storage(make_shared<ThreadSafeSimplLRU>(1024 * 1024), path, chrono::milliseconds(10), true);
+        storage.Start();
+        string value;
+        EXPECT_TRUE(storage.Get("KEY1", value));
+        EXPECT_EQ(value, "val1");
+        EXPECT_TRUE(storage.Get("KEY2", value));
+        EXPECT_EQ(value, "val2");
+
+        // Periodic dump picks new items up
+        EXPECT_TRUE(storage.Put("KEY3", "val3"));
+        this_thread::sleep_for(chrono::milliseconds(100));
+        ThreadSafeSimplLRU copy(1024 * 1024);
+        EXPECT_EQ(SnapshotStorage::Load(path, copy, 1).items, 3);
+        storage.Stop();
+    }
+    unlink(path.c_str());
+}
@@ -64,7 +64,7 @@ std::string pad_space(const std::string &s, size_t length) {
 
 TEST(StorageTest, BigTest) {
     const size_t length = 20;
-    SimpleLRU storage(2 * 100000 * length);
+    SimpleLRU storage(100000 * SimpleLRU::Footprint(pad_space("Key", length), pad_space("Val", length)));
 
     for (long i = 0; i < 100000; ++i) {
         auto key = pad_space("Key " + std::to_string(i), length);
@@ -84,7 +84,7 @@ TEST(StorageTest, BigTest) {
 
 TEST(StorageTest, MinTest) {
     const size_t length = 20;
-    SimpleLRU storage(2 * 4 * length);
+    SimpleLRU storage(4 * SimpleLRU::Footprint(pad_space("Key", length), pad_space("Val", length)));
 
     for (long i = 0; i < 4; ++i) {
         auto key = pad_space("Key " + std::to_string(i), length);
@@ -103,7 +103,7 @@ TEST(StorageTest, MinTest) {
 
 TEST(StorageTest, MaxTest) {
     const size_t length = 20;
-    SimpleLRU storage(2 * 1000 * length);
+    SimpleLRU storage(1000 * SimpleLRU::Footprint(pad_space("Key", length), pad_space("Val", length)));
 
     std::stringstream ss;
 //    std::cout << "MAX SIZE = " << storage.get_max_size() << std::endl;
@@ -133,3 +133,26 @@ TEST(StorageTest, MaxTest) {
     }
 }
 
+
+TEST(StorageTest, MemoryAccounting) {
+    SimpleLRU storage(1024 * 1024);
+
+    std::string small_value = "v", large_value(1000, 'v');
+    storage.Put("KEY1", small_value);
+    storage.Put("KEY2", large_value);
+    EXPECT_EQ(storage.logical_size(), 4 + 1 + 4 + 1000);
+    EXPECT_EQ(storage.physical_size(),
+              SimpleLRU::Footprint("KEY1", small_value) + SimpleLRU::Footprint("KEY2", large_value));
+
+    // Small items cost way more than their keys and values
+    EXPECT_GT(SimpleLRU::Footprint("KEY1", small_value), 10 * 5);
+
+    storage.Put("KEY2", small_value);
+    EXPECT_EQ(storage.logical_size(), 2 * 5);
+    EXPECT_GE(storage.physical_size(), 2 * SimpleLRU::Footprint("KEY1", small_value));
+
+    storage.Delete("KEY1");
+    storage.Delete("KEY2");
+    EXPECT_EQ(storage.logical_size(), 0);
+    EXPECT_EQ(storage.physical_size(), 0);
+}
@@ -0,0 +1,275 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <afina/Metrics.h>
+
+#include "storage/BitcaskStorage.h"
+#include "storage/ThreadSafeSimpleLRU.h"
+#include "storage/ThreadSafeSlabLRU.h"
+#include "storage/WalStorage.h"
+
+using namespace Afina::Backend;
+using namespace std;
+
+static string temp_path() {
+    char path[] = "/tmp/afina_wal_XXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+    unlink(path);
+    return path;
+}
+
+static off_t file_size(const string &path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_size : -1;
+}
+
+// Descriptor the process has the file open with, -1 if there is none
+static int find_fd(const string &path) {
+    struct stat file;
+    if (stat(path.c_str(), &file) != 0) {
+        return -1;
+    }
+    int found = -1;
+    DIR *dir = opendir("/proc/self/fd");
+    for (struct dirent *entry = readdir(dir); entry != nullptr && found < 0; entry = readdir(dir)) {
+        struct stat st;
+        int fd = atoi(entry->d_name);
+        if (entry->d_name[0] != '.' && fd != dirfd(dir) && fstat(fd, &st) == 0 && st.st_dev == file.st_dev &&
+            st.st_ino == file.st_ino) {
+            found = fd;
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+TEST(WalTest, ReplayChanges) {
+    string path = temp_path();
+    {
+        WalStorage storage(make_shared<ThreadSafeSlabLRU>(4 * 1024 * 1024), path);
+        storage.Start();
+        EXPECT_TRUE(storage.Put("KEY1", "val1"));
+        EXPECT_TRUE(storage.Put("KEY2", "val2"));
+        EXPECT_TRUE(storage.PutIfAbsent("KEY3", "val3"));
+        EXPECT_FALSE(storage.PutIfAbsent("KEY3", "other"));
+        EXPECT_TRUE(storage.Set("KEY2", "val22"));
+        EXPECT_FALSE(storage.Set("KEY4", "val4"));
+        EXPECT_TRUE(storage.Delete("KEY1"));
+        EXPECT_TRUE(storage.Put("", "empty key"));
+
+        // Nothing is acknowledged before it is on disk, failed changes aren't logged
+        EXPECT_EQ(storage.durable_lsn(), 6);
+        storage.Stop();
+    }
+
+    // Process has gone without stop: records are on disk already
+    ThreadSafeSimplLRU copy(1024 * 1024);
+    WalStorage::ReplayStats stats = WalStorage::Replay(path, copy);
+    EXPECT_EQ(stats.records, 6);
+    EXPECT_FALSE(stats.torn);
+
+    {
+        WalStorage storage(make_shared<ThreadSafeSimplLRU>(1024 * 1024), path);
+        storage.Start();
+        string value;
+        EXPECT_FALSE(storage.Get("KEY1", value));
+        EXPECT_TRUE(storage.Get("KEY2", value));
+        EXPECT_EQ(value, "val22");
+        EXPECT_TRUE(storage.Get("KEY3", value));
+        EXPECT_EQ(value, "val3");
+        EXPECT_TRUE(storage.Get("", value));
+        EXPECT_EQ(value, "empty key");
+        storage.Stop();
+    }
+    unlink(path.c_str());
+}
+
+TEST(WalTest, TornTail) {
+    string path = temp_path();
+    {
+        WalStorage storage(make_shared<ThreadSafeSimplLRU>(1024 * 1024), path);
+        storage.Start();
+        for (int i = 0; i < 100; i++) {
+            EXPECT_TRUE(storage.Put("key" + to_string(i), string(100, 'a' + i % 26)));
+        }
+        storage.Stop();
+    }
+
+    // Crash in the middle of the last record
+    off_t size = file_size(path);
+    ASSERT_EQ(truncate(path.c_str(), size - 10), 0);
+    ThreadSafeSimplLRU copy(1024 * 1024);
+    WalStorage::ReplayStats stats = WalStorage::Replay(path, copy);
+    EXPECT_EQ(stats.records, 99);
+    EXPECT_TRUE(stats.torn);
+
+    // Log is cut to valid records on start, new ones follow them
+    {
+        WalStorage storage(make_shared<ThreadSafeSimplLRU>(1024 * 1024), path);
+        storage.Start();
+        EXPECT_TRUE(storage.Put("new", "value"));
+        storage.Stop();
+    }
+    ThreadSafeSimplLRU replayed(1024 * 1024);
+    stats = WalStorage::Replay(path, replayed);
+    EXPECT_EQ(stats.records, 100);
+    EXPECT_FALSE(stats.torn);
+    string value;
+    EXPECT_TRUE(replayed.Get("new", value));
+    EXPECT_FALSE(replayed.Get("key99", value));
+
+    // Not a log at all
+    {
+        ofstream file(path, ios::trunc);
+        file << "garbage garbage garbage";
+    }
+    EXPECT_THROW(WalStorage::Replay(path, replayed), std::runtime_error);
+    unlink(path.c_str());
+}
+
+TEST(WalTest, RewriteOnStart) {
+    string path = temp_path();
+    {
+        WalStorage storage(make_shared<ThreadSafeSimplLRU>(1024 * 1024), path);
+        storage.Start();
+        for (int i = 0; i < 1000; i++) {
+            EXPECT_TRUE(storage.Put("key", to_string(i)));
+        }
+        storage.Stop();
+    }
+    off_t before = file_size(path);
+
+    // Overwritten values don't take space after restart
+    WalStorage storage(make_shared<ThreadSafeSimplLRU>(1024 * 1024), path);
+    storage.Start();
+    EXPECT_LT(file_size(path), before / 100);
+    string value;
+    EXPECT_TRUE(storage.Get("key", value));
+    EXPECT_EQ(value, "999");
+    storage.Stop();
+    unlink(path.c_str());
+}
+
+TEST(WalTest, GroupCommit) {
+    string path = temp_path();
+    WalStorage storage(make_shared<ThreadSafeSlabLRU>(16 * 1024 * 1024), path, chrono::microseconds(200));
+    storage.Start();
+
+    vector<thread> writers;
+    for (int t = 0; t < 8; t++) {
+        writers.emplace_back([&storage, t] {
+            for (int i = 0; i < 200; i++) {
+                storage.Put("key" + to_string(t) + "_" + to_string(i), "value");
+            }
+        });
+    }
+    for (auto &writer : writers) {
+        writer.join();
+    }
+    EXPECT_EQ(storage.durable_lsn(), 1600);
+
+    // Concurrent writers share syncs
+    map<string, uint64_t> metrics;
+    for (auto &metric : Afina::Metrics::Instance().Collect()) {
+        metrics.insert(metric);
+    }
+    EXPECT_EQ(metrics["wal_records"], 1600);
+    EXPECT_LT(metrics["wal_syncs"], 1600);
+    storage.Stop();
+
+    ThreadSafeSimplLRU copy(16 * 1024 * 1024);
+    EXPECT_EQ(WalStorage::Replay(path, copy).records, 1600);
+    unlink(path.c_str());
+}
+
+TEST(WalTest, WriteError) {
+    string path = temp_path();
+    WalStorage storage(make_shared<ThreadSafeSlabLRU>(4 * 1024 * 1024), path, chrono::microseconds(200));
+    storage.Start();
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+
+    // Log descriptor is replaced by read only one, so the next write fails
+    int fd = find_fd(path);
+    ASSERT_GE(fd, 0);
+    int broken = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    ASSERT_EQ(dup2(broken, fd), fd);
+    close(broken);
+
+    // Nobody of the failed batch nor after it is acknowledged
+    atomic<int> failed(0);
+    vector<thread> writers;
+    for (int t = 0; t < 8; t++) {
+        writers.emplace_back([&storage, &failed, t] {
+            for (int i = 0; i < 10; i++) {
+                try {
+                    storage.Put("key" + to_string(t) + "_" + to_string(i), "value");
+                } catch (std::runtime_error &) {
+                    failed++;
+                }
+            }
+        });
+    }
+    for (auto &writer : writers) {
+        writer.join();
+    }
+    EXPECT_EQ(failed.load(), 80);
+    EXPECT_EQ(storage.durable_lsn(), 1);
+    EXPECT_THROW(storage.Delete("KEY1"), std::runtime_error);
+    storage.Stop();
+
+    ThreadSafeSimplLRU copy(4 * 1024 * 1024);
+    EXPECT_EQ(WalStorage::Replay(path, copy).records, 1);
+    unlink(path.c_str());
+}
+
+TEST(WalTest, BitcaskCheckpoint) {
+    char dir[] = "/tmp/afina_wal_bitcask_XXXXXX";
+    ASSERT_NE(mkdtemp(dir), nullptr);
+    string path = string(dir) + "/wal";
+    auto start = [&] {
+        auto bitcask = make_shared<BitcaskStorage>(string(dir) + "/data", 16 * 1024 * 1024);
+        auto storage = make_shared<WalStorage>(bitcask, path);
+        storage->Start();
+        return make_pair(bitcask, storage);
+    };
+
+    {
+        auto storages = start();
+        for (int i = 0; i < 100; i++) {
+            EXPECT_TRUE(storages.second->Put("key" + to_string(i), string(100, 'a' + i % 26)));
+        }
+        storages.second->Stop();
+    }
+
+    // Replayed changes are checkpointed by bitcask, restarts neither copy the data nor grow the log
+    uint64_t disk_bytes = 0;
+    off_t log_size = 0;
+    for (int restart = 0; restart < 3; restart++) {
+        auto storages = start();
+        if (restart == 0) {
+            disk_bytes = storages.first->disk_bytes();
+            log_size = file_size(path);
+        }
+        EXPECT_EQ(storages.first->disk_bytes(), disk_bytes);
+        EXPECT_EQ(file_size(path), log_size);
+        EXPECT_LE(log_size, 8);
+        string value;
+        EXPECT_TRUE(storages.second->Get("key99", value));
+        EXPECT_EQ(value, string(100, 'a' + 99 % 26));
+        storages.second->Stop();
+    }
+    EXPECT_EQ(system(("rm -rf " + string(dir)).c_str()), 0);
+}